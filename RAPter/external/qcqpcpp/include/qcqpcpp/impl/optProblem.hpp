@@ -152,6 +152,28 @@ OptProblem<_Scalar>::addQObjectives( SparseMatrix const& mx )
     return err;
 } // ...OptProblem::addQObjectives()
 
+template <typename _Scalar> int
+OptProblem<_Scalar>::addQObjectives( SparseEntries const& entries )
+{
+    const size_t varCount = this->getVarCount();
+    for ( size_t k = 0; k != entries.size(); ++k )
+        if ( (size_t(entries[k].row()) >= varCount) || (size_t(entries[k].col()) >= varCount) )
+        {
+            std::cerr << "[" << __func__ << "]: " << "i " << entries[k].row() << " or j " << entries[k].col() << " > " << varCount << ", please call addVariable() first! returning..." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+    // only lower triangle
+    _quadObjList.reserve( _quadObjList.size() + entries.size() );
+    for ( size_t k = 0; k != entries.size(); ++k )
+        if ( entries[k].col() > entries[k].row() )
+            _quadObjList.push_back( SparseEntry(entries[k].col(), entries[k].row(), entries[k].value()) );
+        else
+            _quadObjList.push_back( entries[k] );
+
+    return EXIT_SUCCESS;
+} // ...OptProblem::addQObjectives()
+
 template <typename _Scalar> int
 OptProblem<_Scalar>::setQObjectives( SparseMatrix const& mx )
 {
@@ -70,6 +70,17 @@ class OptProblem
         //! \brief Destructor unused for the moment. Declared virtual for inheritence.
         virtual                                  ~OptProblem             () { /*std::cout << "[" << __func__ << "][INFO]: " << "Empty destructor" << std::endl;*/ }
 
+        //! \brief Exchanges everything stored by this base class with \p other, without copying the problem. The implementation specific state of both stays.
+        inline void                              swap                   ( OptProblem &other )
+        {
+            _bkx.swap( other._bkx ); _blx.swap( other._blx ); _bux.swap( other._bux ); _type_x.swap( other._type_x ); _lin_x.swap( other._lin_x ); _names.swap( other._names );
+            std::swap( _cfix, other._cfix ); _linObjs.swap( other._linObjs ); _quadObjList.swap( other._quadObjList );
+            _bkc.swap( other._bkc ); _blc.swap( other._blc ); _buc.swap( other._buc ); _lin_c.swap( other._lin_c );
+            _linConstrList.swap( other._linConstrList ); _quadConstrList.swap( other._quadConstrList ); _hessians.swap( other._hessians ); _jacobian.swap( other._jacobian );
+            std::swap( _updated, other._updated ); _x.swap( other._x ); _x0.swap( other._x0 ); std::swap( _useStartingPoint, other._useStartingPoint );
+            std::swap( _time_limit, other._time_limit ); std::swap( _tol_rel_gap, other._tol_rel_gap );
+        }
+
         ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
         //// Variables ////////////////////////////////////////////////////////////////////////////////////////////////
         ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -115,6 +126,7 @@ class OptProblem
         // Quadratic Objecitve function (Q_o)
         inline int                               addQObjective                  ( size_t i, size_t j, Scalar coeff );          //!< \brief Adds input to quadratic objective matrix, duplicate entries get summed in a lazy fashion (when update() is called).
         inline int                               addQObjectives                 ( SparseMatrix const& mx );              //!< \brief Adds input matrix to quadratic objective matrix, duplicate entries get summed in a lazy fashion (when update() is called).
+        inline int                               addQObjectives                 ( SparseEntries const& entries );        //!< \brief Appends a list of (i,j,coeff) entries at once, same as calling addQObjective for each. Duplicate entries get summed in a lazy fashion.
         inline int                               setQObjectives                 ( SparseMatrix const& mx );              //!< \brief Clears current objectives, and sets input as quadratic objective matrix.
         inline SparseEntries              const& getQuadraticObjectives         ()        const { return _quadObjList; } //!< \brief Read-only getter for quadratic objective matrix's unordered entry set.
         inline SparseMatrix                      getQuadraticObjectivesMatrix   ()        const;                         //!< \brief Returns all Qo entries assembled to a Sparsematrix, temporarily.
@@ -5,6 +5,8 @@
 #include <Eigen/Dense>
 #include "pcl/point_cloud.h"
 #include <limits>
+#include <cmath>
+#include "gco/GCoptimization.h" // SparseDataCost
 
 namespace am
 {
@@ -26,6 +28,8 @@ namespace am
                         , max_pearl_iterations  ( 3 )
                         , pottsweight           ( 1.f )
                         , debug                 ( true )
+                        , sparse                ( false )
+                        , sparse_dist_mult      ( 5.f )
                     {
                         lambdas << 0.f, 0.f, 1.f, 0.f;
                     }
@@ -43,6 +47,22 @@ namespace am
 
                     float   pottsweight;               //!< \brief Unused.
                     bool    debug;
+
+                    bool    sparse;                    //!< \brief Sparse data costs: a point only evaluates the labels closer than sparse_dist_mult * scale.
+                    float   sparse_dist_mult;          //!< \brief Sparse mode distance cap in units of scale.
+            };
+
+            /*! \brief Sparse data costs of the last \ref expand() call, labels that did not change since are not recomputed.
+             *
+             *         A label changes, if its coefficients, or the extrema of its population change (i.e. after a refit).
+             */
+            struct SparseDataCache
+            {
+                    typedef gco::GCoptimization::SparseDataCost SparseDataCost;
+                    struct SiteLess { inline bool operator()( SparseDataCost const& a, SparseDataCost const& b ) const { return a.site < b.site; } };
+
+                    std::vector< std::vector<float> >           keys;   //!< \brief Coefficients and extrema per label, the costs were computed from.
+                    std::vector< std::vector<SparseDataCost> >  costs;  //!< \brief (point, cost) pairs of the points within the cap, ascending points per label.
             };
 
             template <class _PclCloudT, class _PointsContainerT, class _PrimitiveT>
@@ -77,6 +97,7 @@ namespace am
                     , Scalar             const  gammasqr
                     , Scalar             const  beta
                     , Params             const& params
+                    , SparseDataCache         * cache = NULL
                     );
 
             template <class PointsT, class TLine>
@@ -91,6 +112,43 @@ namespace am
             inline int
             getActiveLabelsCount( std::vector<int>         const& labels
                                   , std::vector<unsigned>       * active_labels_arg = NULL );
+
+        protected:
+            /*! \brief              Fills \p cache with the data costs of the points closer than params.sparse_dist_mult * params.scale to each label.
+             *
+             *                      Only labels, that changed since the last call are recomputed. Populated labels are finite (\p extrema), and are found
+             *                      through a bounding volume hierarchy over their extents, the rest is tested against every point.
+             *  \param[in] extrema  Extrema of each label, empty for unpopulated (infinite) labels.
+             */
+            template <class _PclCloudT, class _PrimitiveT>
+            static inline int
+            sparseDataCosts( SparseDataCache                                             & cache
+                           , _PclCloudT                                             const& cloud
+                           , std::vector<_PrimitiveT>                               const& lines
+                           , std::vector<typename _PrimitiveT::ExtremaT>            const& extrema
+                           , Params                                                 const& params );
+
+            //! \brief Unsigned distance of \p pos from \p line, finite, if \p extrema is not empty.
+            template <class _PrimitiveT, class _PositionT>
+            static inline float
+            pointDistance( _PrimitiveT const& line, typename _PrimitiveT::ExtremaT const& extrema, _PositionT const& pos )
+            {
+                return std::abs( extrema.empty() ? line.getDistance(pos) : line.getFiniteDistance(extrema, pos) );
+            }
+
+            //! \brief Data cost of a point at distance \p dist, clamped to params.data_max.
+            static inline float
+            dataCost( float const dist, Params const& params )
+            {
+                float cost = dist * dist * params.int_mult * params.int_mult;
+                if ( (cost != cost) || (cost < 0) || (cost > params.data_max) )
+                    cost = params.data_max;
+                return cost;
+            }
+
+            //! \brief Potts smooth cost for the sparse mode, scaled per neighbour pair by the weights.
+            static inline gco::GCoptimization::EnergyTermType
+            potts( int s1, int s2, int l1, int l2 ) { return l1 != l2; }
     };
 } // nsam
 
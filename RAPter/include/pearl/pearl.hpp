@@ -18,6 +18,7 @@
 #include "rapter/util/containers.hpp"   // containers::add
 #include "rapter/util/impl/pclUtil.hpp" // smartgeometry::
 #include "rapter/processing/util.hpp"   // processing::getNeighbourhoodIndices
+#include "rapter/processing/boxBvh.hpp" // processing::BoxBvh
 
 namespace am
 {
@@ -54,6 +55,7 @@ namespace am
 
         int iteration_id = 0;
         std::vector<int> prev_labels;
+        SparseDataCache  sparse_cache; // keeps the data costs of the labels, that the refit does not change
         do
         {
             std::cout << "\n[" << __func__ << "]: " << "iteration " << iteration_id << std::endl;
@@ -67,7 +69,8 @@ namespace am
                                 , /* [in]      primitives: */ lines
                                 , /* [in]        gammasqr: */ params.gammasqr // 50*50
                                 , /* [in]            beta: */ params.beta     // params.scale*100
-                                , /* [in]      parameters: */ params );
+                                , /* [in]      parameters: */ params
+                                , /* [in,out]       cache: */ params.sparse ? &sparse_cache : NULL );
             if ( err != EXIT_SUCCESS ) return err;
 
             if ( label_history )
@@ -188,7 +191,8 @@ namespace am
             , std::vector<_PrimitiveT>  const& lines
             , Scalar                    const  gammasqr
             , Scalar                    const  beta
-            , Params                    const& params )
+            , Params                    const& params
+            , SparseDataCache               * cache )
     {
         using rapter::PidT;
         using rapter::LidT;
@@ -224,47 +228,118 @@ namespace am
 
         const float intMultSqr = params.int_mult * params.int_mult;
         std::cout << "intMult: " << params.int_mult << std::endl;
-        Scalar *data = new Scalar[ num_pixels * num_labels ];
-        int data_zero_cnt = 0, data_max_cnt = 0;
-        for ( size_t pid = 0; pid != num_pixels; ++pid )
+
+        Scalar *data = NULL, *smooth = NULL;
+        SparseDataCache  local_cache;
+        SparseDataCache *sparse = cache ? cache : &local_cache;
+        std::vector< std::vector<SparseDataCache::SparseDataCost> > fallbacks; // sparse: labels of points, that are not listed otherwise
+        if ( params.sparse )
+        {
+            // extents of the populated labels, the rest stays infinite
+            std::vector<typename _PrimitiveT::ExtremaT> label_extrema( num_labels );
+            if ( !noAssignmentsYet )
+            {
+                std::vector<LidT> populated;
+                for ( rapter::GidPidVectorMap::const_iterator it = populations.begin(); it != populations.end(); ++it )
+                    if ( it->second.size() && (it->first >= 0) && (ULidT(it->first) < num_labels) )
+                        populated.push_back( it->first );
+
+                #pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) schedule(dynamic)
+                for ( LidT i = 0; i < LidT(populated.size()); ++i )
+                    lines[ populated[i] ].template getExtent<PointPrimitiveT>( label_extrema[populated[i]], points, params.scale, &populations.at(populated[i]), /* force_axis_aligned: */ true );
+            }
+
+            Pearl::sparseDataCosts( *sparse, cloud, lines, label_extrema, params );
+
+            // every point keeps its previous label, or gets the closest one, if no label is within the cap
+            std::vector<int> counts( num_pixels, 0 );
             for ( size_t line_id = 0; line_id != num_labels; ++line_id )
+                for ( size_t i = 0; i != sparse->costs[line_id].size(); ++i )
+                    ++counts[ sparse->costs[line_id][i].site ];
+
+            fallbacks.resize( num_labels );
+            LidT nnz = 0, fallback_cnt = 0;
+            for ( size_t pid = 0; pid != num_pixels; ++pid )
             {
-                //float dist = std::abs( lines[line_id].getDistance( /*     point: */ cloud->at( indices ? (*indices)[pid] : pid ).getVector3fMap() ) ); // abs() added by Aron 18/1/2015
-                float dist = std::numeric_limits<Scalar>::max();
-                if ( noAssignmentsYet || populations.find(line_id) == populations.end() || populations[line_id].size() == 0 )
+                nnz += counts[pid];
+                const Eigen::Vector3f pos = cloud->at( pid ).getVector3fMap();
+
+                int   line_id = -1;
+                float dist    = std::numeric_limits<float>::max();
+                if ( !noAssignmentsYet )
                 {
-                    dist = std::abs( lines[line_id].getDistance( /* point: */ cloud->at( indices ? (*indices)[pid] : pid ).getVector3fMap() ) ); // abs() added by Aron 18/1/2015
+                    std::vector<SparseDataCache::SparseDataCost> const& costs = sparse->costs[ labels[pid] ];
+                    SparseDataCache::SparseDataCost key; key.site = pid;
+                    if ( !std::binary_search(costs.begin(), costs.end(), key, SparseDataCache::SiteLess()) )
+                    {
+                        line_id = labels[pid];
+                        dist    = pointDistance( lines[line_id], label_extrema[line_id], pos );
+                    }
                 }
-                else
+                else if ( !counts[pid] )
                 {
-                    lines[line_id].template getExtent<PointPrimitiveT>( extrema, points, params.scale, &populations.at(line_id), /* force_axis_aligned: */ true );
-                    dist = std::abs( lines[line_id].getFiniteDistance( extrema,
-                                                                       cloud->at( indices ? (*indices)[pid] : pid ).getVector3fMap() ) ); // abs() added by Aron 18/1/2015
+                    for ( size_t lid = 0; lid != num_labels; ++lid )
+                    {
+                        const float d = pointDistance( lines[lid], label_extrema[lid], pos );
+                        if ( (line_id < 0) || (d < dist) ) { line_id = lid; dist = d; }
+                    }
                 }
 
-                //std::cout << "dist: " << dist;
-                dist *= dist * intMultSqr;
-                // std::cout << ", data: " << dist << std::endl;
-
-                if ( (dist != dist) || (dist < 0) || (dist > params.data_max) )
+                if ( line_id >= 0 )
                 {
-                    dist = params.data_max;
-                    ++data_max_cnt;
+                    SparseDataCache::SparseDataCost cost; cost.site = pid; cost.cost = dataCost( dist, params );
+                    fallbacks[ line_id ].push_back( cost );
+                    ++fallback_cnt;
                 }
-                else if (dist == 0)
-                    ++data_zero_cnt;
+            } //...for pid
 
-                data[ pid * num_labels + line_id ] = dist;
-            }
-        std::cout << "Zero datacosts: " << data_zero_cnt << "/" << num_pixels << "(" << Scalar(data_zero_cnt)/num_pixels*Scalar(100.) << "%)"
-                  << ", capped datacost: " << data_max_cnt << "/" << num_pixels << "(" << Scalar(data_max_cnt)/num_pixels*Scalar(100.) << "%)\n";
+            std::cout << "Sparse datacosts: " << nnz << "/" << num_pixels * num_labels << "(" << Scalar(nnz)/(num_pixels*num_labels)*Scalar(100.) << "%)"
+                      << ", outside cap: " << fallback_cnt << "/" << num_pixels << "\n";
+        }
+        else
+        {
+            data = new Scalar[ num_pixels * num_labels ];
+            int data_zero_cnt = 0, data_max_cnt = 0;
+            for ( size_t pid = 0; pid != num_pixels; ++pid )
+                for ( size_t line_id = 0; line_id != num_labels; ++line_id )
+                {
+                    //float dist = std::abs( lines[line_id].getDistance( /*     point: */ cloud->at( indices ? (*indices)[pid] : pid ).getVector3fMap() ) ); // abs() added by Aron 18/1/2015
+                    float dist = std::numeric_limits<Scalar>::max();
+                    if ( noAssignmentsYet || populations.find(line_id) == populations.end() || populations[line_id].size() == 0 )
+                    {
+                        dist = std::abs( lines[line_id].getDistance( /* point: */ cloud->at( indices ? (*indices)[pid] : pid ).getVector3fMap() ) ); // abs() added by Aron 18/1/2015
+                    }
+                    else
+                    {
+                        lines[line_id].template getExtent<PointPrimitiveT>( extrema, points, params.scale, &populations.at(line_id), /* force_axis_aligned: */ true );
+                        dist = std::abs( lines[line_id].getFiniteDistance( extrema,
+                                                                           cloud->at( indices ? (*indices)[pid] : pid ).getVector3fMap() ) ); // abs() added by Aron 18/1/2015
+                    }
 
-        // next set up the array for smooth costs
-        //const int smooth_2 = params.lambdas(2)/2;
-        Scalar *smooth = new Scalar[ num_labels * num_labels ];
-        for ( ULidT l1 = 0; l1 < num_labels; ++l1 )
-            for ( ULidT l2 = 0; l2 < num_labels; ++l2 )
-                smooth[l1+l2*num_labels] = /*smooth_2 * */ (l1 != l2); // dirac/potts
+                    //std::cout << "dist: " << dist;
+                    dist *= dist * intMultSqr;
+                    // std::cout << ", data: " << dist << std::endl;
+
+                    if ( (dist != dist) || (dist < 0) || (dist > params.data_max) )
+                    {
+                        dist = params.data_max;
+                        ++data_max_cnt;
+                    }
+                    else if (dist == 0)
+                        ++data_zero_cnt;
+
+                    data[ pid * num_labels + line_id ] = dist;
+                }
+            std::cout << "Zero datacosts: " << data_zero_cnt << "/" << num_pixels << "(" << Scalar(data_zero_cnt)/num_pixels*Scalar(100.) << "%)"
+                      << ", capped datacost: " << data_max_cnt << "/" << num_pixels << "(" << Scalar(data_max_cnt)/num_pixels*Scalar(100.) << "%)\n";
+
+            // next set up the array for smooth costs
+            //const int smooth_2 = params.lambdas(2)/2;
+            smooth = new Scalar[ num_labels * num_labels ];
+            for ( ULidT l1 = 0; l1 < num_labels; ++l1 )
+                for ( ULidT l2 = 0; l2 < num_labels; ++l2 )
+                    smooth[l1+l2*num_labels] = /*smooth_2 * */ (l1 != l2); // dirac/potts
+        } //...dense
 
         std::vector<std::vector<int  > > neighs;
         std::vector<std::vector<float> > sqr_dists;
@@ -278,8 +353,42 @@ namespace am
         try
         {
             gco::GCoptimizationGeneralGraph *gc = new gco::GCoptimizationGeneralGraph(num_pixels,num_labels);
-            gc->setDataCost  ( data   ); // unary
-            gc->setSmoothCost( smooth ); // pairwise labelwise
+            if ( params.sparse )
+            {
+                // start from the previous labels, or the cheapest ones, expansion never moves to a label, that is not listed for a point
+                std::vector<int>   start( num_pixels, -1 );
+                std::vector<float> start_cost( num_pixels, std::numeric_limits<float>::max() );
+                std::vector<SparseDataCache::SparseDataCost> merged;
+                for ( size_t line_id = 0; line_id != num_labels; ++line_id )
+                {
+                    std::vector<SparseDataCache::SparseDataCost> *costs = &sparse->costs[line_id];
+                    if ( fallbacks[line_id].size() )
+                    {
+                        merged = *costs;
+                        merged.insert( merged.end(), fallbacks[line_id].begin(), fallbacks[line_id].end() );
+                        std::sort( merged.begin(), merged.end(), SparseDataCache::SiteLess() );
+                        costs = &merged;
+                    }
+                    if ( costs->empty() ) continue;
+
+                    gc->setDataCost( line_id, &(*costs)[0], costs->size() ); // unary, copied by gco
+                    for ( size_t i = 0; i != costs->size(); ++i )
+                        if ( (*costs)[i].cost < start_cost[(*costs)[i].site] )
+                        {
+                            start     [ (*costs)[i].site ] = line_id;
+                            start_cost[ (*costs)[i].site ] = (*costs)[i].cost;
+                        }
+                }
+                gc->setSmoothCost( &Pearl::potts ); // pairwise labelwise
+
+                for ( size_t pid = 0; pid != num_pixels; ++pid )
+                    gc->setLabel( pid, noAssignmentsYet ? start[pid] : labels[pid] );
+            }
+            else
+            {
+                gc->setDataCost  ( data   ); // unary
+                gc->setSmoothCost( smooth ); // pairwise labelwise
+            }
             gc->setLabelCost ( beta   ); // complexity ( number of labels)
 
             // set neighbourhoods
@@ -357,6 +466,108 @@ namespace am
         return EXIT_SUCCESS;
     }
 
+    template <class _PclCloudT, class _PrimitiveT>
+    inline int
+    Pearl::sparseDataCosts( SparseDataCache                                   & cache
+                          , _PclCloudT                                   const& cloud
+                          , std::vector<_PrimitiveT>                     const& lines
+                          , std::vector<typename _PrimitiveT::ExtremaT>  const& extrema
+                          , Params                                       const& params )
+    {
+        using rapter::LidT;
+        typedef SparseDataCache::SparseDataCost         SparseDataCost;
+        typedef rapter::processing::BoxBvh<float>       BvhT;
+        typedef typename BvhT::BoxT                     BoxT;
+
+        const LidT  num_pixels = cloud->size();
+        const LidT  num_labels = lines.size();
+        const float max_dist   = params.sparse_dist_mult * params.scale;
+
+        if ( LidT(cache.costs.size()) != num_labels )
+        {
+            cache.keys .assign( num_labels, std::vector<float>() );
+            cache.costs.assign( num_labels, std::vector<SparseDataCost>() );
+        }
+
+        // find the labels, that changed since the last call
+        BvhT              finite;   // extents of changed populated labels, grown by the cap
+        std::vector<LidT> infinite; // changed unpopulated labels, tested against every point
+        std::vector<LidT> changed;
+        for ( LidT lid = 0; lid != num_labels; ++lid )
+        {
+            std::vector<float> key( lines[lid].coeffs().data(), lines[lid].coeffs().data() + lines[lid].coeffs().size() );
+            for ( size_t i = 0; i != extrema[lid].size(); ++i )
+                key.insert( key.end(), extrema[lid][i].data(), extrema[lid][i].data() + 3 );
+            if ( key == cache.keys[lid] )
+                continue;
+
+            cache.keys [lid].swap( key );
+            cache.costs[lid].clear();
+            changed.push_back( lid );
+
+            if ( extrema[lid].empty() )
+                infinite.push_back( lid );
+            else
+            {
+                BoxT box;
+                for ( size_t i = 0; i != extrema[lid].size(); ++i )
+                    box.extend( extrema[lid][i].template cast<float>() );
+                box.min().array() -= max_dist;
+                box.max().array() += max_dist;
+                finite.insert( lid, box );
+            }
+        } //...for labels
+        finite.build();
+
+        // every thread lists the costs of a contiguous range of points
+        const int nThreads = RAPTER_MAX_OMP_THREADS;
+        std::vector< std::vector< std::vector<SparseDataCost> > > local( nThreads );
+        if ( changed.size() )
+        {
+            #pragma omp parallel num_threads(nThreads)
+            {
+                std::vector< std::vector<SparseDataCost> > &costs = local[ omp_get_thread_num() ];
+                costs.resize( num_labels );
+                std::vector<LidT> candidates;
+
+                #pragma omp for schedule(static)
+                for ( LidT pid = 0; pid < num_pixels; ++pid )
+                {
+                    const Eigen::Vector3f pos = cloud->at( pid ).getVector3fMap();
+                    finite.query( candidates, BoxT(pos), -1 );
+                    candidates.insert( candidates.end(), infinite.begin(), infinite.end() );
+
+                    for ( size_t i = 0; i != candidates.size(); ++i )
+                    {
+                        const float dist = pointDistance( lines[candidates[i]], extrema[candidates[i]], pos );
+                        if ( dist <= max_dist ) // NaN fails
+                        {
+                            SparseDataCost cost; cost.site = pid; cost.cost = dataCost( dist, params );
+                            costs[ candidates[i] ].push_back( cost );
+                        }
+                    }
+                } //...for points
+            } //...omp parallel
+        }
+
+        for ( size_t i = 0; i != changed.size(); ++i )
+        {
+            std::vector<SparseDataCost> &costs = cache.costs[ changed[i] ];
+            for ( int tid = 0; tid != nThreads; ++tid )
+                if ( local[tid].size() )
+                {
+                    costs.insert( costs.end(), local[tid][changed[i]].begin(), local[tid][changed[i]].end() );
+                    std::vector<SparseDataCost>().swap( local[tid][changed[i]] );
+                }
+            std::sort( costs.begin(), costs.end(), SparseDataCache::SiteLess() );
+        }
+
+        std::cout << "[" << __func__ << "]: " << "recomputed " << changed.size() << "/" << num_labels << " labels"
+                  << " (" << infinite.size() << " unpopulated)" << std::endl;
+
+        return EXIT_SUCCESS;
+    } //...sparseDataCosts()
+
     template <typename _PointContainerT, class _PrimitiveT> inline int
     Pearl::refit( std::vector<_PrimitiveT>        &lines
                   , std::vector<int> const& labels
@@ -7,6 +7,7 @@
 #define GCO_ENERGYTYPE float
 #include "gco/GCoptimization.h"
 #include "rapter/simpleTypes.h"
+#include "rapter/processing/reassigner.hpp" // Reassigner
 
 namespace rapter
 {
@@ -89,25 +90,65 @@ namespace rapter
 
             Scalar *result = new Scalar[num_pixels];   // stores result of optimization
 
-            // first set up the array for data costs
+            // first set up the data costs, only for the primitives within scale (and the closest one for points, that have none)
+            typedef gco::GCoptimization::SparseDataCost SparseDataCost;
+            typedef processing::Reassigner<Scalar>      ReassignerT;
             std::map< LidT, std::pair<LidT,LidT> > labelMap;
-            std::cout << "[" << __func__ << "]: " << "setting data labels..." << std::endl; fflush(stdout);
-            Scalar *data = new Scalar[num_pixels*num_labels];
-
-            #pragma omp for schedule(dynamic,8)
-            for ( PidT pid = 0; pid < num_pixels; pid++ )
+            std::vector<PrimitiveT const*>         labelPrims;
+            ReassignerT                            reassigner( ReassignerT::domainOf(points), params.scale );
             {
-                LidT label = 0;
                 LidT lid0 = 0;
                 for ( typename _PrimitiveContainerT::const_iterator it = primitives.begin(); it != primitives.end(); ++it, ++lid0 )
-                    for ( ULidT lid1 = 0; lid1 != it->size(); ++lid1, ++label )
+                    for ( ULidT lid1 = 0; lid1 != it->size(); ++lid1 )
                     {
-                        Scalar dist = it->at(lid1).getDistance( points[pid].template pos() );
-                        data[ pid*num_labels + label] = Scalar(100.) * dist * dist;
-                        labelMap[ label ] = std::pair<int,int>( lid0, lid1 );
+                        reassigner.insert( labelPrims.size(), it->at(lid1) );
+                        labelMap[ labelPrims.size() ] = std::pair<LidT,LidT>( lid0, lid1 );
+                        labelPrims.push_back( &(it->at(lid1)) );
                     }
+                reassigner.build();
             }
 
+            std::cout << "[" << __func__ << "]: " << "setting data labels..." << std::endl; fflush(stdout);
+            const int nThreads = RAPTER_MAX_OMP_THREADS;
+            std::vector< std::vector< std::vector<SparseDataCost> > > data( nThreads ); // per thread, per label
+            #pragma omp parallel num_threads(nThreads)
+            {
+                std::vector< std::vector<SparseDataCost> > &costs = data[ omp_get_thread_num() ];
+                costs.resize( num_labels );
+                std::vector<LidT> candidates;
+
+                #pragma omp for schedule(static)
+                for ( PidT pid = 0; pid < num_pixels; pid++ )
+                {
+                    reassigner.candidates( candidates, points[pid].template pos() );
+                    LidT closest = -1; Scalar closestDist = std::numeric_limits<Scalar>::max();
+                    for ( size_t i = 0; i != candidates.size(); ++i )
+                    {
+                        Scalar dist = labelPrims[ candidates[i] ]->getDistance( points[pid].template pos() );
+                        if ( std::abs(dist) < params.scale )
+                        {
+                            SparseDataCost cost; cost.site = pid; cost.cost = Scalar(100.) * dist * dist;
+                            costs[ candidates[i] ].push_back( cost );
+                            closest = candidates[i];
+                        }
+                    }
+
+                    if ( closest < 0 ) // no primitive within scale, keep the closest one
+                    {
+                        for ( LidT label = 0; label != num_labels; ++label )
+                        {
+                            const Scalar dist = std::abs( labelPrims[label]->getDistance(points[pid].template pos()) );
+                            if ( dist < closestDist ) { closest = label; closestDist = dist; }
+                        }
+                        if ( closest >= 0 )
+                        {
+                            SparseDataCost cost; cost.site = pid; cost.cost = Scalar(100.) * closestDist * closestDist;
+                            costs[ closest ].push_back( cost );
+                        }
+                    }
+                } //...for points
+            } //...omp parallel
+
             std::cout << "[" << __func__ << "]: " << "setting pairwise labels..." << std::endl; fflush(stdout);
             // next set up the array for smooth costs
             Scalar *smooth = new Scalar[ num_labels * num_labels ];
@@ -123,8 +164,31 @@ namespace rapter
             try
             {
                 gco::GCoptimizationGeneralGraph *gc = new gco::GCoptimizationGeneralGraph(num_pixels,num_labels);
-                gc->setDataCost(data);
+                // start from the cheapest listed label, like Pearl::expand, expansion never moves to a label, that is not listed for a point
+                std::vector<int>    start( num_pixels, -1 );
+                std::vector<Scalar> startCost( num_pixels, std::numeric_limits<Scalar>::max() );
+                for ( LidT label = 0; label != num_labels; ++label )
+                {
+                    std::vector<SparseDataCost> costs;
+                    for ( int tid = 0; tid != nThreads; ++tid )
+                        if ( data[tid].size() )
+                        {
+                            costs.insert( costs.end(), data[tid][label].begin(), data[tid][label].end() );
+                            std::vector<SparseDataCost>().swap( data[tid][label] );
+                        }
+                    if ( costs.size() )
+                        gc->setDataCost( label, &costs[0], costs.size() ); // ascending sites: static schedule, threads in order
+                    for ( size_t i = 0; i != costs.size(); ++i )
+                        if ( costs[i].cost < startCost[costs[i].site] )
+                        {
+                            start    [ costs[i].site ] = label;
+                            startCost[ costs[i].site ] = costs[i].cost;
+                        }
+                }
                 gc->setSmoothCost(smooth);
+                for ( PidT pid = 0; pid != num_pixels; ++pid )
+                    if ( start[pid] >= 0 )
+                        gc->setLabel( pid, start[pid] );
 
                 // now set up a grid neighborhood system
                 // first set up horizontal neighbors
@@ -173,7 +237,6 @@ namespace rapter
 
             delete [] result;
             delete [] smooth;
-            delete [] data;
         }
 
         return EXIT_SUCCESS;
@@ -5,6 +5,7 @@
 #include "rapter/io/inputParser.hpp"
 #include "rapter/io/trianglesFromObj.h"
 #include "rapter/primitives/impl/triangle.hpp"
+#include "rapter/processing/boxBvh.hpp"         // BoxBvh
 #include "pcl/PolygonMesh.h"
 
 #include "pcl/visualization/pcl_visualizer.h"
@@ -164,6 +165,21 @@ namespace rapter
         getTrianglesFromObj( triangles, meshPath, minPlaneEdge );
         std::cout << "have " << triangles.size() << " triangles" << std::endl;
 
+        // index triangles by their boxes, a little padded, so that rounding in getDistance() can't drop a triangle
+        typedef processing::BoxBvh<Scalar> TriangleBvhT;
+        TriangleBvhT triangleBvh;
+        for ( size_t triangleId = 0; triangleId != triangles.size(); ++triangleId )
+        {
+            typename TriangleBvhT::BoxT box;
+            for ( int j = 0; j != triangles[triangleId].getCornersCount(); ++j )
+                box.extend( triangles[triangleId].getCorner(j) );
+            const Scalar eps = Scalar(1.e-5) * (box.sizes().norm() + params.scale);
+            box.min().array() -= eps;
+            box.max().array() += eps;
+            triangleBvh.insert( triangleId, box );
+        }
+        triangleBvh.build();
+
         // debug ( add triangles )
 //        pcl::visualization::PCLVisualizer::Ptr vptr( new pcl::visualization::PCLVisualizer() );
 //        vptr->setBackgroundColor( .5, .6, .6 );
@@ -198,14 +214,14 @@ namespace rapter
         rapter::GidPidVectorMap populations; // populations[patch_id] = all points with GID==patch_id
         rapter::processing::getPopulations( populations, points );
 
-        // pointid => < triangleId, primitiveGid >
+        // pointid => < triangleId, primitiveGid >, triangleId is -1 for points without a triangle
         PidT reassignedCount = 0;
-        std::map<PidT,std::pair< LidT, LidT> > pointsTriangles;
+        std::vector< std::pair<LidT,LidT> > pointsTriangles( points.size(), std::pair<LidT,LidT>(-1,-1) );
         PidT unambigGtPointsCount = 0; // number of points, that have a triangle assigned
         // pointid
         //PidT pId( 0 );
-#       pragma omp parallel for num_threads(6)
-        for ( UPidT pId = 0; pId < points.size(); ++pId )
+#       pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) reduction(+:reassignedCount,unambigGtPointsCount) schedule(dynamic,1024)
+        for ( PidT pId = 0; pId < PidT(points.size()); ++pId )
         {
             // cache point reference
             //PointPrimitiveT const& point = *pIt;
@@ -224,41 +240,55 @@ namespace rapter
             // cache point position
             Vector  pos                     ( point.template pos() );
             Vector  triangleNormal;
-            // iterate triangles
-            for ( auto triIt = triangles.begin(); triIt != triangles.end(); ++triIt, ++triangleId )
+            if ( !ambig )
             {
-                Scalar dist = triIt->getDistance( pos );
-                // note, if closer and close enough
-                if ( (dist < minPointTriangleDistance) && (dist < params.scale) )
+                // closest triangle within scale, the first one on ties
+                closestTriangleId = triangleBvh.nearest( pos, [&triangles,&pos]( LidT const id ) { return triangles[id].getDistance( pos ); }, params.scale );
+            }
+            else
+            {
+                // iterate triangles, that can be within scale, in order
+                std::vector<LidT> nearbyIds;
+                {
+                    typename TriangleBvhT::BoxT box( pos );
+                    box.min().array() -= params.scale;
+                    box.max().array() += params.scale;
+                    triangleBvh.query( nearbyIds, box, -1 );
+                }
+                for ( size_t nearbyId = 0; nearbyId != nearbyIds.size(); ++nearbyId )
                 {
-                    minPointTriangleDistance = dist;
-                    closestTriangleId        = triangleId;
-                    Scalar triangleNormalAngle = 0.;
-                    if ( !trianglesNearby )
-                        triangleNormal = triIt->dir();
-                    else
+                    triangleId = nearbyIds[ nearbyId ];
+                    Triangle const* triIt = &triangles[ triangleId ];
+                    Scalar dist = triIt->getDistance( pos );
+                    // note, if closer and close enough
+                    if ( (dist < minPointTriangleDistance) && (dist < params.scale) )
                     {
-                        triangleNormalAngle = rapter::angleInRad( triangleNormal, triIt->dir() );
-                        triangleNormalAngle = std::min( triangleNormalAngle, Scalar(M_PI) - triangleNormalAngle );
+                        minPointTriangleDistance = dist;
+                        closestTriangleId        = triangleId;
+                        Scalar triangleNormalAngle = 0.;
+                        if ( !trianglesNearby )
+                            triangleNormal = triIt->dir();
+                        else
+                        {
+                            triangleNormalAngle = rapter::angleInRad( triangleNormal, triIt->dir() );
+                            triangleNormalAngle = std::min( triangleNormalAngle, Scalar(M_PI) - triangleNormalAngle );
+                        }
+
+                        ++trianglesNearby;
+
+                        if ( ambig && (trianglesNearby > ambig) && (triangleNormalAngle > 0.0001) )
+                        {
+                            closestTriangleId = -1;
+                            break;
+                        } //...if ambiguousity threshold exceeded
                     }
-
-                    ++trianglesNearby;
-
-                    if ( ambig && (trianglesNearby > ambig) && (triangleNormalAngle > 0.0001) )
-                    {
-                        closestTriangleId = -1;
-                        break;
-                    } //...if ambiguousity threshold exceeded
-                }
-            } //...for triangles
+                } //...for triangles
+            } //...if ambig
 
             // if triangle found
             if ( (closestTriangleId >= 0) )
             {
-#               pragma omp critical (UNAMBCNT)
-                {
-                    ++unambigGtPointsCount;
-                }
+                ++unambigGtPointsCount;
 
                 // we *need* a primitive for this point, since it ended up in the GT
                 GidT gid( PrimitiveT::LONG_VALUES::UNSET );
@@ -284,11 +314,8 @@ namespace rapter
                 // remember point for later
                 if ( gid != PrimitiveT::LONG_VALUES::UNSET )
                 {
-#                   pragma omp critical (PTR)
-                    {
-                        // note point to triangle assignment
-                        pointsTriangles[ pId ] = std::pair<LidT,GidT>( closestTriangleId, gid );
-                    }
+                    // note point to triangle assignment
+                    pointsTriangles[ pId ] = std::pair<LidT,GidT>( closestTriangleId, gid );
                 } //...gid not unset
 
             } //...triangle found
@@ -327,14 +354,16 @@ namespace rapter
         std::ofstream fAnglesSimple( outAnglesSimplePath );
         // write angles to file
         _PointContainerT orientedPoints, orientedGtPoints;
-        orientedPoints  .reserve( pointsTriangles.size() );
-        orientedGtPoints.reserve( pointsTriangles.size() );
-        for ( auto it = pointsTriangles.begin(); it != pointsTriangles.end(); ++it )
+        orientedPoints  .reserve( unambigGtPointsCount );
+        orientedGtPoints.reserve( unambigGtPointsCount );
+        for ( PidT pid = 0; pid != PidT(pointsTriangles.size()); ++pid )
         {
+            if ( pointsTriangles[pid].first < 0 )
+                continue;
+
             // read
-            PidT                   pid        = it->first;
-            LidT                   triangleId = it->second.first;
-            GidT                   primGid    = it->second.second;
+            LidT                   triangleId = pointsTriangles[pid].first;
+            GidT                   primGid    = pointsTriangles[pid].second;
             Triangle        const& triangle   = triangles .at( triangleId );
             PrimitiveT      const& prim       = primitives.at( primGid ).at( 0 );
             PointPrimitiveT const& point      = points    .at( pid );
@@ -0,0 +1,674 @@
+#ifndef RAPTER_IO_COLUMNAR_HPP
+#define RAPTER_IO_COLUMNAR_HPP
+
+#include <algorithm> // min, max
+#include <cstring>   // memcpy, memcmp
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "Eigen/Dense"
+#include "rapter/simpleTypes.h"
+#include "rapter/io/mappedFile.hpp"
+#include "rapter/util/containers.hpp" // valueOf()
+
+namespace rapter {
+namespace io {
+
+/*! \brief  Versioned binary columnar storage, selected by the ".bin" extension.
+ *
+ *          Layout: a 32 byte #Header, then one column after the other, each padded to 8 bytes. The columns depend on the #KIND of the file.
+ *          Files are memory-mapped for reading, and values are stored bit-exact, unlike the %.9f csv text.
+ */
+namespace columnar {
+
+    static const unsigned char VERSION = 1;
+    enum KIND
+    {
+        PRIMITIVES   = 1, //!< \brief coeffs (rows x coeffCount scalars, the same <x0,n> toFileEntry() writes), GID (int64), DIR_GID (int64), STATUS (int8), GEN_ANGLE (scalar).
+        ASSOCIATIONS = 2, //!< \brief point id (int64), GID (int64), DIR_GID (int64).
+        PROBLEM      = 3, //!< \brief See \ref writeProblem().
+        FORMULATION  = 4  //!< \brief See \ref writeFormulationCache().
+    };
+
+    //! \brief Length of the sizes column of #FORMULATION files, kept in Header::coeffCount. Caches with fewer sizes are rejected.
+    static const unsigned FORMULATION_SIZES = 7;
+
+    //! \brief Point ids of associations may exceed their row count this many times, the rows of unassigned points may be missing. Larger ids are rejected.
+    static const size_t ASSOCIATION_PID_SPREAD = 16;
+
+    //! \brief File header, fixed 32 bytes.
+    struct Header
+    {
+        char               magic[6];     //!< \brief "RAPTER"
+        unsigned char      version;      //!< \brief #VERSION
+        unsigned char      kind;         //!< \brief #KIND
+        unsigned long long rows;         //!< \brief Entry count, variable count of problems.
+        unsigned int       coeffCount;   //!< \brief Scalars per primitive, #FORMULATION_SIZES for formulation caches, 0 otherwise.
+        unsigned int       scalarBytes;  //!< \brief sizeof(Scalar) of coeffs and GEN_ANGLE.
+        unsigned long long reserved;
+    };
+
+    //! \brief True, if \p path should be read and written in the binary format.
+    inline bool isBinaryPath( std::string const& path )
+    {
+        static const std::string ext( ".bin" );
+        return (path.size() >= ext.size()) && (path.compare(path.size() - ext.size(), ext.size(), ext) == 0);
+    }
+
+    //! \brief Column size rounded up to 8 bytes.
+    inline size_t padded( size_t bytes ) { return (bytes + 7) & ~size_t(7); }
+
+    /*! \brief                  Adds the padded size of a column of \p count elements of \p elementBytes to \p bytes.
+     *  \return                 False, if the columns so far don't fit into \p fileSize. Counts read from a corrupt file can't overflow \p bytes.
+     */
+    inline bool addColumn( size_t & bytes, size_t const count, size_t const elementBytes, size_t const fileSize )
+    {
+        if ( elementBytes && (count > fileSize / elementBytes) )
+            return false;
+        bytes += padded( count * elementBytes );
+        return bytes <= fileSize;
+    } //...addColumn()
+
+    /*! \brief                  Maps \p path, and checks its header.
+     *  \param[in] rowBytes     Bytes per row of each column, that has header.rows rows. NULL, if the caller checks the size.
+     *  \param[in] columnCount  Length of \p rowBytes.
+     *  \return                 EXIT_SUCCESS, or EXIT_FAILURE, if the file can't be read, is of another kind, version or precision, or is truncated.
+     */
+    inline int openChecked( MappedFile & file, Header & header, std::string const& path, KIND const kind, unsigned const scalarBytes, size_t const* rowBytes = NULL, size_t const columnCount = 0 )
+    {
+        if ( EXIT_SUCCESS != file.open(path) )
+        {
+            std::cerr << "[" << __func__ << "]: " << "couldn't open file " << path << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        if ( file.size() < sizeof(Header) ) { std::cerr << "[" << __func__ << "]: " << path << " too short" << std::endl; return EXIT_FAILURE; }
+        std::memcpy( &header, file.data(), sizeof(Header) );
+        if (    std::memcmp(header.magic, "RAPTER", 6)
+             || (header.version     != VERSION)
+             || (header.kind        != kind   )
+             || (scalarBytes && (header.scalarBytes != scalarBytes)) )
+        {
+            std::cerr << "[" << __func__ << "]: " << path << " is not a version " << int(VERSION) << " file of kind " << kind << " with " << scalarBytes << " byte scalars" << std::endl;
+            return EXIT_FAILURE;
+        }
+        // every column is padded, so sum the padded sizes
+        size_t bytes = sizeof(Header);
+        for ( size_t c = 0; c != columnCount; ++c )
+            if ( !addColumn(bytes, header.rows, rowBytes[c], file.size()) )
+            {
+                std::cerr << "[" << __func__ << "]: " << path << " truncated" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+        return EXIT_SUCCESS;
+    } //...openChecked()
+
+    //! \brief Writes \p count elements as one padded column.
+    template <typename _T>
+    inline void writeColumn( std::ofstream & f, std::vector<_T> const& column )
+    {
+        static const char zeros[8] = { 0 };
+        const size_t bytes = column.size() * sizeof(_T);
+        if ( bytes ) f.write( reinterpret_cast<char const*>(column.data()), bytes );
+        f.write( zeros, padded(bytes) - bytes );
+    } //...writeColumn()
+
+    //! \brief Returns a pointer to the next column, and advances \p offset past it.
+    template <typename _T>
+    inline _T const* nextColumn( MappedFile const& file, size_t & offset, size_t const count )
+    {
+        _T const* column = reinterpret_cast<_T const*>( file.data() + offset );
+        offset += padded( count * sizeof(_T) );
+        return column;
+    } //...nextColumn()
+
+    //! \brief Binary version of \ref io::savePrimitives.
+    template <class PrimitiveT, class _inner_const_iterator, class PrimitiveContainerT> inline int
+    savePrimitives( PrimitiveContainerT const& primitives, std::string const& path )
+    {
+        typedef typename PrimitiveT::Scalar              Scalar;
+        typedef typename PrimitiveContainerT::const_iterator outer_const_iterator;
+        const int coeffCount = PrimitiveT::getFileEntryLength(); // <x0,n>
+
+        std::vector<Scalar>        coeffs, angles;
+        std::vector<long long>     gids, dids;
+        std::vector<signed char>   statuses;
+        for ( outer_const_iterator gid_it = primitives.begin(); gid_it != primitives.end(); ++gid_it )
+        {
+            _inner_const_iterator lid_end_it = containers::valueOf<PrimitiveT>(gid_it).end();
+            for ( _inner_const_iterator lid_it = containers::valueOf<PrimitiveT>(gid_it).begin(); lid_it != lid_end_it; ++lid_it )
+            {
+                const Eigen::Matrix<Scalar,3,1> pos = lid_it->pos(), nrm = lid_it->normal();
+                coeffs.insert( coeffs.end(), pos.data(), pos.data() + 3 );
+                coeffs.insert( coeffs.end(), nrm.data(), nrm.data() + coeffCount - 3 );
+                gids    .push_back( lid_it->getTag(PrimitiveT::TAGS::GID      ) );
+                dids    .push_back( lid_it->getTag(PrimitiveT::TAGS::DIR_GID  ) );
+                statuses.push_back( lid_it->getTag(PrimitiveT::TAGS::STATUS   ) );
+                angles  .push_back( lid_it->getTag(PrimitiveT::TAGS::GEN_ANGLE) );
+            }
+        }
+
+        std::ofstream f( path.c_str(), std::ios::binary );
+        if ( !f.is_open() ) { std::cerr << "could not open file..." << path << std::endl; return EXIT_FAILURE; }
+
+        Header header = { {'R','A','P','T','E','R'}, VERSION, PRIMITIVES, gids.size(), unsigned(coeffCount), sizeof(Scalar), 0 };
+        f.write( reinterpret_cast<char const*>(&header), sizeof(Header) );
+        writeColumn( f, coeffs   );
+        writeColumn( f, gids     );
+        writeColumn( f, dids     );
+        writeColumn( f, statuses );
+        writeColumn( f, angles   );
+
+        return f.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+    } //...savePrimitives()
+
+    //! \brief Binary version of \ref io::readPrimitives.
+    template <class PrimitiveT, class PatchT, class PrimitiveContainerT> inline int
+    readPrimitives( PrimitiveContainerT                                         & lines
+                  , std::string                                           const& path
+                  , std::map<GidT, typename PrimitiveContainerT::value_type>  * patches = NULL )
+    {
+        typedef typename PrimitiveT::Scalar Scalar;
+        const int coeffCount = PrimitiveT::getFileEntryLength();
+
+        MappedFile file;
+        Header     header;
+        const size_t rowBytes[] = { coeffCount * sizeof(Scalar), sizeof(long long), sizeof(long long), sizeof(signed char), sizeof(Scalar) };
+        if ( EXIT_SUCCESS != openChecked(file, header, path, PRIMITIVES, sizeof(Scalar), rowBytes, 5) )
+            return EXIT_FAILURE;
+        if ( header.coeffCount != static_cast<unsigned>(coeffCount) )
+        {
+            std::cerr << "[" << __func__ << "]: " << path << " has " << header.coeffCount << " coefficients per primitive, expected " << coeffCount << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        const size_t rows   = header.rows;
+        size_t       offset = sizeof(Header);
+        Scalar      const* coeffs   = nextColumn<Scalar     >( file, offset, rows * coeffCount );
+        long long   const* gids     = nextColumn<long long  >( file, offset, rows );
+        long long   const* dids     = nextColumn<long long  >( file, offset, rows );
+        signed char const* statuses = nextColumn<signed char>( file, offset, rows );
+        Scalar      const* angles   = nextColumn<Scalar     >( file, offset, rows );
+
+        std::map<GidT, PatchT> tmp_lines;
+        std::vector<Scalar>    floats( coeffCount );
+        for ( size_t row = 0; row != rows; ++row )
+        {
+            if ( gids[row] < 0 )
+                throw new std::runtime_error("[io::readPrims] code not up to date to handle gid==-1 cases, please add proper GID to primitives");
+
+            std::copy( coeffs + row * coeffCount, coeffs + (row + 1) * coeffCount, floats.begin() );
+            PatchT &patch = tmp_lines[ gids[row] ];
+            patch.push_back( PrimitiveT::fromFileEntry(floats) );
+            patch.back().setTag( PrimitiveT::TAGS::GID      , static_cast<GidT>(gids    [row]) );
+            patch.back().setTag( PrimitiveT::TAGS::DIR_GID  , static_cast<DidT>(dids    [row]) );
+            patch.back().setTag( PrimitiveT::TAGS::STATUS   , static_cast<char>(statuses[row]) );
+            patch.back().setTag( PrimitiveT::TAGS::GEN_ANGLE, angles[row] );
+        }
+
+        // copy all patches from map to vector (so that there are no empty patches in the vector)
+        for ( typename std::map<GidT, PatchT>::const_iterator it = tmp_lines.begin(); it != tmp_lines.end(); ++it )
+        {
+            lines.push_back( PatchT() );
+            lines.back().insert( lines.back().end(), it->second.begin(), it->second.end() );
+        }
+        if ( patches )
+            *patches = tmp_lines;
+
+        return EXIT_SUCCESS;
+    } //...readPrimitives()
+
+    //! \brief Binary version of \ref io::writeAssociations. \p pids, \p gids and \p dids are parallel columns.
+    inline int
+    writeAssociations( std::vector<long long> const& pids, std::vector<long long> const& gids, std::vector<long long> const& dids, std::string const& path )
+    {
+        std::ofstream f( path.c_str(), std::ios::binary );
+        if ( !f.is_open() ) { std::cerr << "[" << __func__ << "]: " << "could not open " << path << " for writing..." << std::endl; return EXIT_FAILURE; }
+
+        Header header = { {'R','A','P','T','E','R'}, VERSION, ASSOCIATIONS, pids.size(), 0, 0, 0 };
+        f.write( reinterpret_cast<char const*>(&header), sizeof(Header) );
+        writeColumn( f, pids );
+        writeColumn( f, gids );
+        writeColumn( f, dids );
+
+        return f.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+    } //...writeAssociations()
+
+    //! \brief Fills \p points_primitives and \p linear_indices from \p rows parallel columns, like \ref io::readAssociations. \p path is only reported.
+    //!        Point ids have to be below the size of \p points_primitives, or #ASSOCIATION_PID_SPREAD times \p rows, which bounds its resize.
+    inline int
+    associationsFromColumns( std::vector<std::pair<PidT,LidT> >   & points_primitives
+                           , std::map<PidT,LidT>                  * linear_indices
+                           , long long                       const* pids
+                           , long long                       const* gids
+                           , long long                       const* dids
+                           , size_t                          const  rows
+                           , std::string                     const& path )
+    {
+        // point ids index the output, GIDs and DIR_GIDs are TAG_UNSET (-1) for unassigned points
+        const unsigned long long pidLimit = std::min( static_cast<unsigned long long>( std::numeric_limits<PidT>::max() )
+                                                    , std::max( static_cast<unsigned long long>(points_primitives.size())
+                                                              , static_cast<unsigned long long>(rows) * ASSOCIATION_PID_SPREAD ) );
+        for ( size_t row = 0; row != rows; ++row )
+            if ( (pids[row] < 0) || (static_cast<unsigned long long>(pids[row]) >= pidLimit) || (gids[row] < -1) || (dids[row] < -1) )
+            {
+                std::cerr << "[" << __func__ << "]: " << path << " row " << row << " has invalid point id " << pids[row] << ", GID " << gids[row] << " or DIR_GID " << dids[row] << std::endl;
+                return EXIT_FAILURE;
+            }
+
+        std::set< std::pair<LidT,LidT> > lines;
+        for ( size_t row = 0; row != rows; ++row )
+        {
+            // 2d indices (lid,lid1)
+            if ( static_cast<long long>(points_primitives.size()) <= pids[row] )
+                points_primitives.resize( pids[row]+1, std::pair<LidT,LidT>(-1,-1) );
+            points_primitives[ pids[row] ] = std::pair<LidT,LidT>( gids[row], dids[row] );
+
+            // 1d indices (line_id)
+            if ( linear_indices )
+            {
+                lines.insert( std::pair<LidT,LidT>(gids[row], dids[row]) );
+                (*linear_indices)[ pids[row] ] = lines.size() - 1; // assumes sorted set
+            }
+        }
+
+        return EXIT_SUCCESS;
+    } //...associationsFromColumns()
+
+    //! \brief Binary version of \ref io::readAssociations.
+    inline int
+    readAssociations( std::vector<std::pair<PidT,LidT> >   & points_primitives
+                    , std::string                     const& path
+                    , std::map<PidT,LidT>                  * linear_indices )
+    {
+        MappedFile file;
+        Header     header;
+        const size_t rowBytes[] = { sizeof(long long), sizeof(long long), sizeof(long long) };
+        if ( EXIT_SUCCESS != openChecked(file, header, path, ASSOCIATIONS, 0, rowBytes, 3) )
+            return EXIT_FAILURE;
+
+        const size_t rows   = header.rows;
+        size_t       offset = sizeof(Header);
+        long long const* pids = nextColumn<long long>( file, offset, rows );
+        long long const* gids = nextColumn<long long>( file, offset, rows );
+        long long const* dids = nextColumn<long long>( file, offset, rows );
+
+        return associationsFromColumns( points_primitives, linear_indices, pids, gids, dids, rows, path );
+    } //...readAssociations()
+
+    //! \brief Copies the compressed rows of \p mx to \p outer, \p inner and \p values.
+    template <class _SparseMatrixT>
+    inline void toCsr( _SparseMatrixT mx, std::vector<long long> & outer, std::vector<long long> & inner, std::vector<typename _SparseMatrixT::Scalar> & values )
+    {
+        mx.makeCompressed();
+        outer .assign( mx.outerIndexPtr(), mx.outerIndexPtr() + mx.outerSize() + 1 );
+        inner .assign( mx.innerIndexPtr(), mx.innerIndexPtr() + mx.nonZeros() );
+        values.assign( mx.valuePtr()     , mx.valuePtr()      + mx.nonZeros() );
+    } //...toCsr()
+
+    //! \brief True, if all \p count \p indices are in [0,limit).
+    inline bool indicesValid( long long const* indices, size_t const count, size_t const limit )
+    {
+        for ( size_t k = 0; k != count; ++k )
+            if ( (indices[k] < 0) || (static_cast<unsigned long long>(indices[k]) >= limit) )
+                return false;
+        return true;
+    } //...indicesValid()
+
+    //! \brief True, if \p outer of \p rows compressed rows starts at 0, is non-decreasing, and ends at \p nnz, and \p inner is in [0,cols).
+    inline bool csrValid( long long const* outer, long long const* inner, size_t const rows, size_t const nnz, size_t const cols )
+    {
+        if ( (outer[0] != 0) || (static_cast<unsigned long long>(outer[rows]) != nnz) )
+            return false;
+        for ( size_t row = 0; row != rows; ++row )
+            if ( outer[row+1] < outer[row] )
+                return false;
+        return indicesValid( inner, nnz, cols );
+    } //...csrValid()
+
+    /*! \brief  Binary version of qcqpcpp::OptProblem::write(), one file instead of a directory of csv matrices.
+     *
+     *          Columns: sizes (int64: variables n, constraints m, nnz(Qo), nnz(A), Qi entries, starting point length), objective bias (scalar),
+     *          variable bound type, type and linearity (int8), lower and upper bounds, linear objective (scalar),
+     *          constraint bound type and linearity (int8), lower and upper bounds (scalar),
+     *          Qo and A in compressed sparse rows (outer int64, inner int64, values scalar),
+     *          Qi entries (constraint, row, col int64, value scalar), starting point (scalar).
+     *          Variable names are not stored, neither does the csv format.
+     *  \tparam _OptProblemT Concept: qcqpcpp::OptProblem.
+     */
+    template <class _OptProblemT> inline int
+    writeProblem( _OptProblemT const& problem, std::string const& path )
+    {
+        typedef typename _OptProblemT::Scalar       Scalar;
+        typedef typename _OptProblemT::SparseEntries SparseEntries;
+
+        const size_t n = problem.getVarCount(), m = problem.getConstraintCount();
+
+        std::vector<signed char> varBounds( n ), varTypes( n ), varLins( n ), constrBounds( m ), constrLins( m );
+        std::vector<Scalar>      varLower( n ), varUpper( n ), constrLower( m ), constrUpper( m );
+        for ( size_t j = 0; j != n; ++j )
+        {
+            varBounds[j] = problem.getVarBoundType ( j );
+            varTypes [j] = problem.getVarType      ( j );
+            varLins  [j] = problem.getVarLinearity ( j );
+            varLower [j] = problem.getVarLowerBound( j );
+            varUpper [j] = problem.getVarUpperBound( j );
+        }
+        for ( size_t i = 0; i != m; ++i )
+        {
+            constrBounds[i] = problem.getConstraintBoundType ( i );
+            constrLins  [i] = problem.getConstraintLinearity ( i );
+            constrLower [i] = problem.getConstraintLowerBound( i );
+            constrUpper [i] = problem.getConstraintUpperBound( i );
+        }
+
+        std::vector<long long> qoOuter, qoInner, aOuter, aInner;
+        std::vector<Scalar>    qoValues, aValues;
+        toCsr( problem.getQuadraticObjectivesMatrix(), qoOuter, qoInner, qoValues );
+        toCsr( problem.getLinConstraintsMatrix()     , aOuter , aInner , aValues  );
+
+        std::vector<long long> qiConstr, qiRows, qiCols;
+        std::vector<Scalar>    qiValues;
+        for ( size_t i = 0; i != problem.getQuadraticConstraints().size(); ++i )
+        {
+            SparseEntries const& entries = problem.getQuadraticConstraints( i );
+            for ( size_t k = 0; k != entries.size(); ++k )
+            {
+                qiConstr.push_back( i );
+                qiRows  .push_back( entries[k].row()   );
+                qiCols  .push_back( entries[k].col()   );
+                qiValues.push_back( entries[k].value() );
+            }
+        }
+
+        std::vector<Scalar> x0;
+        if ( problem.isUseStartingPoint() )
+            x0.assign( problem.getStartingPoint().data(), problem.getStartingPoint().data() + problem.getStartingPoint().size() );
+
+        std::vector<long long> sizes( 6 );
+        sizes[0] = n; sizes[1] = m; sizes[2] = qoValues.size(); sizes[3] = aValues.size(); sizes[4] = qiValues.size(); sizes[5] = x0.size();
+        std::vector<Scalar>    bias( 1, problem.getObjectiveBias() );
+
+        std::ofstream f( path.c_str(), std::ios::binary );
+        if ( !f.is_open() ) { std::cerr << "[" << __func__ << "]: " << "could not open " << path << " for writing..." << std::endl; return EXIT_FAILURE; }
+
+        Header header = { {'R','A','P','T','E','R'}, VERSION, PROBLEM, n, 0, sizeof(Scalar), 0 };
+        f.write( reinterpret_cast<char const*>(&header), sizeof(Header) );
+        writeColumn( f, sizes );
+        writeColumn( f, bias );
+        writeColumn( f, varBounds ); writeColumn( f, varTypes ); writeColumn( f, varLins );
+        writeColumn( f, varLower  ); writeColumn( f, varUpper ); writeColumn( f, problem.getLinObjectives() );
+        writeColumn( f, constrBounds ); writeColumn( f, constrLins );
+        writeColumn( f, constrLower  ); writeColumn( f, constrUpper );
+        writeColumn( f, qoOuter ); writeColumn( f, qoInner ); writeColumn( f, qoValues );
+        writeColumn( f, aOuter  ); writeColumn( f, aInner  ); writeColumn( f, aValues  );
+        writeColumn( f, qiConstr ); writeColumn( f, qiRows ); writeColumn( f, qiCols ); writeColumn( f, qiValues );
+        writeColumn( f, x0 );
+
+        if ( f.good() )
+            std::cout << "[" << __func__ << "]: " << "wrote " << n << " variables, " << m << " constraints to " << path << std::endl;
+        return f.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+    } //...writeProblem()
+
+    /*! \brief Binary version of qcqpcpp::OptProblem::read(), appends the problem written by \ref writeProblem() to an empty \p problem.
+     *  \tparam _OptProblemT Concept: qcqpcpp::OptProblem.
+     */
+    template <class _OptProblemT> inline int
+    readProblem( _OptProblemT & problem, std::string const& path )
+    {
+        typedef typename _OptProblemT::Scalar        Scalar;
+        typedef typename _OptProblemT::SparseMatrix  SparseMatrix;
+        typedef typename _OptProblemT::SparseEntry   SparseEntry;
+        typedef typename _OptProblemT::SparseEntries SparseEntries;
+        typedef typename _OptProblemT::BOUND         BOUND;
+        typedef typename _OptProblemT::VAR_TYPE      VAR_TYPE;
+        typedef typename _OptProblemT::LINEARITY     LINEARITY;
+
+        MappedFile file;
+        Header     header;
+        if ( EXIT_SUCCESS != openChecked(file, header, path, PROBLEM, sizeof(Scalar)) )
+            return EXIT_FAILURE;
+        if ( file.size() < sizeof(Header) + 6 * sizeof(long long) )
+        {
+            std::cerr << "[" << __func__ << "]: " << path << " truncated" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        size_t offset = sizeof(Header);
+        long long const* sizes = nextColumn<long long>( file, offset, 6 );
+        const size_t n = sizes[0], m = sizes[1], nnzQo = sizes[2], nnzA = sizes[3], nnzQi = sizes[4], x0Size = sizes[5];
+
+        // size of all columns, before touching any of them
+        const size_t counts[] = { 1, n, n, n, n, n, n, m, m, m, m, n + 1, nnzQo, nnzQo, m + 1, nnzA, nnzA, nnzQi, nnzQi, nnzQi, nnzQi, x0Size };
+        const size_t widths[] = { sizeof(Scalar), 1, 1, 1, sizeof(Scalar), sizeof(Scalar), sizeof(Scalar), 1, 1, sizeof(Scalar), sizeof(Scalar)
+                                , sizeof(long long), sizeof(long long), sizeof(Scalar), sizeof(long long), sizeof(long long), sizeof(Scalar)
+                                , sizeof(long long), sizeof(long long), sizeof(long long), sizeof(Scalar), sizeof(Scalar) };
+        size_t bytes = offset;
+        bool   fits  = (n == header.rows) && (n + 1 > n) && (m + 1 > m);
+        for ( size_t c = 0; fits && (c != sizeof(counts) / sizeof(counts[0])); ++c )
+            fits = addColumn( bytes, counts[c], widths[c], file.size() );
+        if ( !fits )
+        {
+            std::cerr << "[" << __func__ << "]: " << path << " truncated" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        Scalar      const* bias         = nextColumn<Scalar     >( file, offset, 1 );
+        signed char const* varBounds    = nextColumn<signed char>( file, offset, n );
+        signed char const* varTypes     = nextColumn<signed char>( file, offset, n );
+        signed char const* varLins      = nextColumn<signed char>( file, offset, n );
+        Scalar      const* varLower     = nextColumn<Scalar     >( file, offset, n );
+        Scalar      const* varUpper     = nextColumn<Scalar     >( file, offset, n );
+        Scalar      const* linObjs      = nextColumn<Scalar     >( file, offset, n );
+        signed char const* constrBounds = nextColumn<signed char>( file, offset, m );
+        signed char const* constrLins   = nextColumn<signed char>( file, offset, m );
+        Scalar      const* constrLower  = nextColumn<Scalar     >( file, offset, m );
+        Scalar      const* constrUpper  = nextColumn<Scalar     >( file, offset, m );
+        long long   const* qoOuter      = nextColumn<long long  >( file, offset, n + 1 );
+        long long   const* qoInner      = nextColumn<long long  >( file, offset, nnzQo );
+        Scalar      const* qoValues     = nextColumn<Scalar     >( file, offset, nnzQo );
+        long long   const* aOuter       = nextColumn<long long  >( file, offset, m + 1 );
+        long long   const* aInner       = nextColumn<long long  >( file, offset, nnzA );
+        Scalar      const* aValues      = nextColumn<Scalar     >( file, offset, nnzA );
+        long long   const* qiConstr     = nextColumn<long long  >( file, offset, nnzQi );
+        long long   const* qiRows       = nextColumn<long long  >( file, offset, nnzQi );
+        long long   const* qiCols       = nextColumn<long long  >( file, offset, nnzQi );
+        Scalar      const* qiValues     = nextColumn<Scalar     >( file, offset, nnzQi );
+        Scalar      const* x0           = nextColumn<Scalar     >( file, offset, x0Size );
+
+        // indices of a corrupt file would be read out of bounds below
+        if (    !csrValid( qoOuter, qoInner, n, nnzQo, n )
+             || !csrValid( aOuter , aInner , m, nnzA , n )
+             || !indicesValid( qiConstr, nnzQi, m )
+             || !indicesValid( qiRows  , nnzQi, n )
+             || !indicesValid( qiCols  , nnzQi, n )
+             || (x0Size && (x0Size != n)) )
+        {
+            std::cerr << "[" << __func__ << "]: " << path << " has invalid matrix indices, or starting point length" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        int err = EXIT_SUCCESS;
+        problem.setObjectiveBias( bias[0] );
+        for ( size_t j = 0; j != n; ++j )
+        {
+            problem.addVariable( BOUND(varBounds[j]), varLower[j], varUpper[j], VAR_TYPE(varTypes[j]), LINEARITY(varLins[j]) );
+            problem.setLinObjective( j, linObjs[j] );
+        }
+        for ( size_t i = 0; i != m; ++i )
+            err += problem.addConstraint( BOUND(constrBounds[i]), constrLower[i], constrUpper[i], NULL, LINEARITY(constrLins[i]) );
+
+        // Qo
+        {
+            SparseEntries entries;
+            entries.reserve( nnzQo );
+            for ( size_t row = 0; row != n; ++row )
+                for ( long long k = qoOuter[row]; k != qoOuter[row+1]; ++k )
+                    entries.push_back( SparseEntry(row, qoInner[k], qoValues[k]) );
+            err += problem.addQObjectives( entries );
+        }
+
+        // A
+        if ( nnzA )
+        {
+            SparseEntries entries;
+            entries.reserve( nnzA );
+            for ( size_t row = 0; row != m; ++row )
+                for ( long long k = aOuter[row]; k != aOuter[row+1]; ++k )
+                    entries.push_back( SparseEntry(row, aInner[k], aValues[k]) );
+            SparseMatrix a( m, n );
+            a.setFromTriplets( entries.begin(), entries.end() );
+            err += problem.addLinConstraints( a );
+        }
+
+        // Qi
+        for ( size_t k = 0; k != nnzQi; ++k )
+            err += problem.addQConstraint( qiConstr[k], qiRows[k], qiCols[k], qiValues[k] );
+
+        // X0
+        if ( x0Size )
+        {
+            typename _OptProblemT::VectorX startingPoint( x0Size );
+            std::copy( x0, x0 + x0Size, startingPoint.data() );
+            problem.setStartingPointDense( startingPoint );
+        }
+
+        std::cout << "[" << __func__ << "]: " << "read " << n << " variables, " << m << " constraints from " << path << std::endl;
+        return err ? EXIT_FAILURE : EXIT_SUCCESS;
+    } //...readProblem()
+
+    /*! \brief  Writes the \ref problemSetup::FormulationCache of an incremental formulate.
+     *
+     *          Columns: sizes (int64: setup hash, variable count, populations, data costs, proximities, variable keys, stale solution hash),
+     *          population GID (int64) and hash (uint64), data cost GID, DIR_GID (int64), hash (uint64) and value (double),
+     *          proximity first and second GID (int64), variable id, GID and DIR_GID (int64).
+     *  \tparam _CacheT Concept: \ref problemSetup::FormulationCache.
+     */
+    template <class _CacheT> inline int
+    writeFormulationCache( _CacheT const& cache, std::string const& path )
+    {
+        std::vector<long long>          popGids, costGids, costDids, proxFirst, proxSecond, varIds, varGids, varDids;
+        std::vector<unsigned long long> popHashes, costHashes;
+        std::vector<double>             costValues;
+        for ( typename _CacheT::HashMapT::const_iterator it = cache.populations.begin(); it != cache.populations.end(); ++it )
+        {
+            popGids  .push_back( it->first  );
+            popHashes.push_back( it->second );
+        }
+        for ( typename _CacheT::CostMapT::const_iterator it = cache.dataCosts.begin(); it != cache.dataCosts.end(); ++it )
+        {
+            costGids  .push_back( it->first.first   );
+            costDids  .push_back( it->first.second  );
+            costHashes.push_back( it->second.first  );
+            costValues.push_back( it->second.second );
+        }
+        for ( size_t i = 0; i != cache.proximities.size(); ++i )
+        {
+            proxFirst .push_back( cache.proximities[i].first  );
+            proxSecond.push_back( cache.proximities[i].second );
+        }
+        for ( typename _CacheT::VarKeyMapT::const_iterator it = cache.varKeys.begin(); it != cache.varKeys.end(); ++it )
+        {
+            varIds .push_back( it->first         );
+            varGids.push_back( it->second.first  );
+            varDids.push_back( it->second.second );
+        }
+
+        std::vector<long long> sizes( FORMULATION_SIZES );
+        sizes[0] = static_cast<long long>( cache.setup ); sizes[1] = cache.varCount;
+        sizes[2] = popGids.size(); sizes[3] = costGids.size(); sizes[4] = proxFirst.size(); sizes[5] = varIds.size();
+        sizes[6] = static_cast<long long>( cache.staleSolution );
+
+        std::ofstream f( path.c_str(), std::ios::binary );
+        if ( !f.is_open() ) { std::cerr << "[" << __func__ << "]: " << "could not open " << path << " for writing..." << std::endl; return EXIT_FAILURE; }
+
+        Header header = { {'R','A','P','T','E','R'}, VERSION, FORMULATION, costGids.size(), FORMULATION_SIZES, sizeof(double), 0 };
+        f.write( reinterpret_cast<char const*>(&header), sizeof(Header) );
+        writeColumn( f, sizes );
+        writeColumn( f, popGids  ); writeColumn( f, popHashes );
+        writeColumn( f, costGids ); writeColumn( f, costDids ); writeColumn( f, costHashes ); writeColumn( f, costValues );
+        writeColumn( f, proxFirst ); writeColumn( f, proxSecond );
+        writeColumn( f, varIds ); writeColumn( f, varGids ); writeColumn( f, varDids );
+
+        return f.good() ? EXIT_SUCCESS : EXIT_FAILURE;
+    } //...writeFormulationCache()
+
+    /*! \brief Reads the cache written by \ref writeFormulationCache() into an empty \p cache.
+     *  \tparam _CacheT Concept: \ref problemSetup::FormulationCache.
+     */
+    template <class _CacheT> inline int
+    readFormulationCache( _CacheT & cache, std::string const& path )
+    {
+        typedef typename _CacheT::KeyT    KeyT;
+        typedef typename _CacheT::GidPair GidPair;
+
+        MappedFile file;
+        Header     header;
+        if ( EXIT_SUCCESS != openChecked(file, header, path, FORMULATION, sizeof(double)) )
+            return EXIT_FAILURE;
+        if ( header.coeffCount != FORMULATION_SIZES )
+        {
+            std::cerr << "[" << __func__ << "]: " << path << " has " << header.coeffCount << " sizes, expected " << FORMULATION_SIZES << std::endl;
+            return EXIT_FAILURE;
+        }
+        size_t bytes = sizeof(Header);
+        if ( !addColumn(bytes, FORMULATION_SIZES, sizeof(long long), file.size()) )
+        {
+            std::cerr << "[" << __func__ << "]: " << path << " truncated" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        size_t offset = sizeof(Header);
+        long long const* sizes = nextColumn<long long>( file, offset, FORMULATION_SIZES );
+        const size_t nPop = sizes[2], nCost = sizes[3], nProx = sizes[4], nVar = sizes[5];
+
+        // size of all columns, before touching any of them, every element is 8 bytes
+        const size_t counts[] = { nPop, nPop, nCost, nCost, nCost, nCost, nProx, nProx, nVar, nVar, nVar };
+        bool fits = (nCost == header.rows);
+        for ( size_t c = 0; fits && (c != sizeof(counts) / sizeof(counts[0])); ++c )
+            fits = addColumn( bytes, counts[c], sizeof(long long), file.size() );
+        if ( !fits )
+        {
+            std::cerr << "[" << __func__ << "]: " << path << " truncated" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        long long          const* popGids    = nextColumn<long long         >( file, offset, nPop  );
+        unsigned long long const* popHashes  = nextColumn<unsigned long long>( file, offset, nPop  );
+        long long          const* costGids   = nextColumn<long long         >( file, offset, nCost );
+        long long          const* costDids   = nextColumn<long long         >( file, offset, nCost );
+        unsigned long long const* costHashes = nextColumn<unsigned long long>( file, offset, nCost );
+        double             const* costValues = nextColumn<double            >( file, offset, nCost );
+        long long          const* proxFirst  = nextColumn<long long         >( file, offset, nProx );
+        long long          const* proxSecond = nextColumn<long long         >( file, offset, nProx );
+        long long          const* varIds     = nextColumn<long long         >( file, offset, nVar  );
+        long long          const* varGids    = nextColumn<long long         >( file, offset, nVar  );
+        long long          const* varDids    = nextColumn<long long         >( file, offset, nVar  );
+
+        cache.setup    = static_cast<unsigned long long>( sizes[0] );
+        cache.varCount = sizes[1];
+        cache.staleSolution = static_cast<unsigned long long>( sizes[6] );
+        for ( size_t i = 0; i != nPop; ++i )
+            cache.populations[ popGids[i] ] = popHashes[i];
+        for ( size_t i = 0; i != nCost; ++i )
+            cache.dataCosts[ KeyT(costGids[i], costDids[i]) ] = std::make_pair( costHashes[i], costValues[i] );
+        cache.proximities.reserve( nProx );
+        for ( size_t i = 0; i != nProx; ++i )
+            cache.proximities.push_back( GidPair(proxFirst[i], proxSecond[i]) );
+        for ( size_t i = 0; i != nVar; ++i )
+            cache.varKeys[ varIds[i] ] = KeyT( varGids[i], varDids[i] );
+
+        std::cout << "[" << __func__ << "]: " << "read " << nCost << " data costs, " << nProx << " proximities from " << path << std::endl;
+        return EXIT_SUCCESS;
+    } //...readFormulationCache()
+
+} //...ns columnar
+} //...ns io
+} //...ns rapter
+
+#endif // RAPTER_IO_COLUMNAR_HPP
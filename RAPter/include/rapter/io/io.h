@@ -17,6 +17,11 @@
 #include "rapter/util/pclUtil.h"
 #include "rapter/util/impl/pclUtil.hpp"
 #include "rapter/util/containers.hpp"
+#include "rapter/primitives/extentCache.h"
+#include "rapter/io/columnar.hpp"
+#include "rapter/io/mappedCloud.hpp"
+#include "rapter/io/residentCloud.hpp"
+#include "rapter/io/residentFiles.hpp"
 
 
 namespace rapter
@@ -27,7 +32,7 @@ namespace rapter
         //typedef          pcl::PointCloud<PclPointT> PclCloudT;
         //typedef typename PclCloudT::Ptr             PclCloudPtrT;
 
-        //! \brief Dumps primitives with GID and DIR_GID to disk.
+        //! \brief Dumps primitives with GID and DIR_GID to disk. Writes the binary \ref columnar format, if \p out_file_name ends with ".bin".
         //! \tparam PrimitiveT Concept: PrimitiveContainerT::value_type::value_type aka rapter::LinePrimitive2.
         //! \tparam PrimitiveContainerT Concept: vector< vector< rapter::LinePrimitive2 > >.
         template <class PrimitiveT, class _inner_const_iterator, class PrimitiveContainerT> inline int
@@ -41,45 +46,70 @@ namespace rapter
             //const int Dim = PrimitiveT::Dim;
             typedef typename PrimitiveT::VectorType VectorType;
 
-            // out_lines
-            std::string parent_path = boost::filesystem::path(out_file_name).parent_path().string();
-            if ( !parent_path.empty() )
-                if ( !boost::filesystem::exists(parent_path) )
-                    boost::filesystem::create_directory( boost::filesystem::path(parent_path) );
-
-            std::ofstream out_file( out_file_name );
-            if ( !out_file.is_open() ) { std::cerr << "could not open file..." << out_file_name << std::endl; return EXIT_FAILURE; }
+            // keep the content in memory, see ResidentFiles
+            ResidentFiles &resident = ResidentFiles::instance();
+            if ( resident.enabled() )
+            {
+                std::shared_ptr< ResidentPrimitives<PrimitiveT> > entry( new ResidentPrimitives<PrimitiveT>() );
+                entry->template assign<_inner_const_iterator>( primitives );
+                resident.insert( out_file_name, entry );
+            }
 
-            LidT lid = 0;
-            outer_const_iterator gid_end_it = primitives.end();
-            for ( outer_const_iterator gid_it = primitives.begin(); gid_it != gid_end_it; ++gid_it, ++lid )
-            //for ( size_t lid = 0; lid != primitives.size(); ++lid )
+            if ( resident.toDisk() )
             {
-                LidT lid1 = 0;
-                _inner_const_iterator lid_end_it = containers::valueOf<PrimitiveT>(gid_it).end();
-                for ( _inner_const_iterator lid_it = containers::valueOf<PrimitiveT>(gid_it).begin(); lid_it != lid_end_it; ++lid_it, ++lid1 )
-                //for ( size_t lid1 = 0; lid1 != primitives[lid].size(); ++lid1 )
+                // out_lines
+                std::string parent_path = boost::filesystem::path(out_file_name).parent_path().string();
+                if ( !parent_path.empty() )
+                    if ( !boost::filesystem::exists(parent_path) )
+                        boost::filesystem::create_directory( boost::filesystem::path(parent_path) );
+
+                if ( columnar::isBinaryPath(out_file_name) )
                 {
-                    //for ( int d = 0; d != Dim; ++d )
-                        //out_file << std::setprecision(9) << ((VectorType)*lid_it)(d) << ",";
-                    //out_file << std::setprecision(9) << ((VectorType)primitives.at(lid).at(lid1))(d) << ",";
-
-                    // saves primitive part
-                    out_file << (*lid_it).toFileEntry();
-                    // save taggable part (todo: merge these)
-                    out_file << lid_it->getTag( PrimitiveT::TAGS::GID     ) << ",";
-                    out_file << lid_it->getTag( PrimitiveT::TAGS::DIR_GID ) << ",";
-                    out_file << (int)lid_it->getTag( PrimitiveT::TAGS::STATUS  ) << ",";
-                    out_file << lid_it->getTag( PrimitiveT::TAGS::GEN_ANGLE ) << "\n";
+                    if ( EXIT_SUCCESS != columnar::savePrimitives<PrimitiveT,_inner_const_iterator>(primitives, out_file_name) )
+                        return EXIT_FAILURE;
                 }
-            }
-            out_file.close();
+                else
+                {
+                    std::ofstream out_file( out_file_name );
+                    if ( !out_file.is_open() ) { std::cerr << "could not open file..." << out_file_name << std::endl; return EXIT_FAILURE; }
+
+                    LidT lid = 0;
+                    outer_const_iterator gid_end_it = primitives.end();
+                    for ( outer_const_iterator gid_it = primitives.begin(); gid_it != gid_end_it; ++gid_it, ++lid )
+                    //for ( size_t lid = 0; lid != primitives.size(); ++lid )
+                    {
+                        LidT lid1 = 0;
+                        _inner_const_iterator lid_end_it = containers::valueOf<PrimitiveT>(gid_it).end();
+                        for ( _inner_const_iterator lid_it = containers::valueOf<PrimitiveT>(gid_it).begin(); lid_it != lid_end_it; ++lid_it, ++lid1 )
+                        //for ( size_t lid1 = 0; lid1 != primitives[lid].size(); ++lid1 )
+                        {
+                            //for ( int d = 0; d != Dim; ++d )
+                                //out_file << std::setprecision(9) << ((VectorType)*lid_it)(d) << ",";
+                            //out_file << std::setprecision(9) << ((VectorType)primitives.at(lid).at(lid1))(d) << ",";
+
+                            // saves primitive part
+                            out_file << (*lid_it).toFileEntry();
+                            // save taggable part (todo: merge these)
+                            out_file << lid_it->getTag( PrimitiveT::TAGS::GID     ) << ",";
+                            out_file << lid_it->getTag( PrimitiveT::TAGS::DIR_GID ) << ",";
+                            out_file << (int)lid_it->getTag( PrimitiveT::TAGS::STATUS  ) << ",";
+                            out_file << lid_it->getTag( PrimitiveT::TAGS::GEN_ANGLE ) << "\n";
+                        }
+                    }
+                    out_file.close();
+                } //...if csv
+            } //...if toDisk
             if ( verbose ) std::cout << "[" << __func__ << "]: " << "saved " << out_file_name << std::endl;
 
+            // extents measured for these primitives, see ExtentCache
+            typedef ExtentCache<typename PrimitiveT::Scalar> ExtentCacheT;
+            if ( ExtentCacheT::enabled() && ExtentCacheT::instance().size() )
+                ExtentCacheT::instance().save( out_file_name + ExtentCacheT::suffix() );
+
             return EXIT_SUCCESS;
         }
 
-        //! \brief Reads primitives with their GIDs and dir_GIDs from file.
+        //! \brief Reads primitives with their GIDs and dir_GIDs from file. Reads the binary \ref columnar format, if \p path ends with ".bin".
         //! \tparam PatchT Concept: vector< \ref rapter::LinePrimitive2 >.
         template <
                    class       PrimitiveT          /*= typename PrimitiveContainerT::value_type::value_type*/
@@ -98,6 +128,22 @@ namespace rapter
             //typedef typename PrimitiveContainerT::value_type PatchT;
             typedef std::map<GidT, PatchT>                    PatchMap; // <GID, vector<primitives> >
 
+            // extents from the sub-command that wrote these primitives, loaded on first use
+            typedef ExtentCache<Scalar> ExtentCacheT;
+            if ( ExtentCacheT::enabled() )
+                ExtentCacheT::instance().setPath( path + ExtentCacheT::suffix() );
+
+            // written by an earlier stage of this process, see ResidentFiles
+            if ( ResidentFiles::instance().enabled() )
+                if ( std::shared_ptr< ResidentPrimitives<PrimitiveT> const > entry = ResidentFiles::instance().find< ResidentPrimitives<PrimitiveT> >(path) )
+                {
+                    entry->template read<PatchT>( lines, patches );
+                    return EXIT_SUCCESS;
+                }
+
+            if ( columnar::isBinaryPath(path) )
+                return columnar::readPrimitives<PrimitiveT,PatchT>( lines, path, patches );
+
             // open file
             std::ifstream file( path.c_str() );
             if ( !file.is_open() )
@@ -199,13 +245,21 @@ namespace rapter
 
         //! \brief                      Reads point-primitive associations from file
         //! \param points_primitives    [Out]    points_primitives[pid] = pair<lid,lid1>
-        //! \param path                 [In]     Path of file to read
+        //! \param path                 [In]     Path of file to read, binary \ref columnar format, if it ends with ".bin"
         //! \param linear_indices       [In/Out] If not null, will get filled like this: linear_indices[pid] = line_id
         //! \return                     EXIT_SUCCESS if could open file
         inline int readAssociations( std::vector<std::pair<PidT,LidT> >      & points_primitives
                                      , std::string                    const& path
                                      , std::map<PidT,LidT>                   * linear_indices )
         {
+            // written by an earlier stage of this process, see ResidentFiles
+            if ( ResidentFiles::instance().enabled() )
+                if ( std::shared_ptr<ResidentAssociations const> entry = ResidentFiles::instance().find<ResidentAssociations>(path) )
+                    return columnar::associationsFromColumns( points_primitives, linear_indices, entry->pids.data(), entry->gids.data(), entry->dids.data(), entry->pids.size(), path );
+
+            if ( columnar::isBinaryPath(path) )
+                return columnar::readAssociations( points_primitives, path, linear_indices );
+
             std::ifstream f( path.c_str() );
             if ( !f.is_open() )
             {
@@ -253,11 +307,45 @@ namespace rapter
             return EXIT_SUCCESS;
         } // ... readAssociations
 
+        //! \brief                       Writes parallel columns of point ids, GIDs and DIR_GIDs.
+        //!                              Keeps them in memory instead, or as well, if \ref ResidentFiles is enabled.
+        //! \param[in]  path             Output path, binary \ref columnar format, if it ends with ".bin"
+        //! \return                      EXIT_SUCCESS
+        inline int writeAssociationColumns( std::vector<long long> const& pids
+                                          , std::vector<long long> const& gids
+                                          , std::vector<long long> const& dids
+                                          , std::string            const& path )
+        {
+            // keep the content in memory, see ResidentFiles
+            ResidentFiles &resident = ResidentFiles::instance();
+            if ( resident.enabled() )
+            {
+                std::shared_ptr<ResidentAssociations> entry( new ResidentAssociations() );
+                entry->pids = pids;
+                entry->gids = gids;
+                entry->dids = dids;
+                resident.insert( path, entry );
+            }
+            if ( !resident.toDisk() )
+                return EXIT_SUCCESS;
+
+            if ( columnar::isBinaryPath(path) )
+                return columnar::writeAssociations( pids, gids, dids, path );
+
+            std::ofstream f_assoc( path.c_str() );
+            if ( !f_assoc.is_open() ) { std::cerr << "[" << __func__ << "]: " << "could not open " << path << " for writing..." << std::endl; return EXIT_FAILURE; }
+            f_assoc << "# point_id,primitive_gid,primitive_dir_gid" << std::endl;
+            for ( size_t i = 0; i != pids.size(); ++i )
+                f_assoc << pids[i] << "," << gids[i] << "," << dids[i] << "\n";
+
+            return EXIT_SUCCESS;
+        } //...writeAssociationColumns
+
         //! \brief                       Write points' associations to GID and DIR_GID.
         //! \tparam     _PointPrimitiveT Concept: \ref rapter::PointPrimitive.
         //! \tparam     _PointContainerT Concept: vector< \ref rapter::PointPrimitive >
         //! \param[in]  points           Output point vector
-        //! \param[in]  path             PLY source path
+        //! \param[in]  path             Output path, binary \ref columnar format, if it ends with ".bin"
         //! \return                      EXIT_SUCCESS
         template < class _PointPrimitiveT
                  , class _PointContainerT
@@ -265,31 +353,60 @@ namespace rapter
         inline int writeAssociations( _PointContainerT const& points
                                     , std::string const& f_assoc_path )
         {
-            // open
-            std::ofstream f_assoc( f_assoc_path );
-            if ( !f_assoc.is_open() ) { std::cerr << "[" << __func__ << "]: " << "could not open " << f_assoc_path << " for writing..." << std::endl; return EXIT_FAILURE; }
-
-            // preamble
-            f_assoc << "# point_id,primitive_gid,primitive_dir_gid" << std::endl;
-            // write points
+            std::vector<long long> pids( points.size() ), gids( points.size() ), dids( points.size(), -1 ); // assigned to patch, but no direction
             for ( size_t pid = 0; pid != points.size(); ++pid )
             {
-                f_assoc << points[pid].getTag( _PointPrimitiveT::TAGS::PID ) //pid changed by Aron on 13/1/2013
-                        << "," << points[pid].getTag( _PointPrimitiveT::TAGS::GID )
-                        << "," << -1  // assigned to patch, but no direction
-                        << std::endl;
+                pids[pid] = points[pid].getTag( _PointPrimitiveT::TAGS::PID ); //pid changed by Aron on 13/1/2013
+                gids[pid] = points[pid].getTag( _PointPrimitiveT::TAGS::GID );
             }
-            // finish
-            f_assoc.close();
+            if ( EXIT_SUCCESS != writeAssociationColumns(pids, gids, dids, f_assoc_path) )
+                return EXIT_FAILURE;
 
             std::cout << "[" << __func__ << "]: " << "wrote to " << f_assoc_path << std::endl;
 
             return EXIT_SUCCESS;
         } //...writeAssociations
 
+        //! \brief                       Write associations read by \ref readAssociations back to disk, in either format.
+        //! \param[in]  points_primitives points_primitives[pid] = pair<gid,dir_gid>, entries (-1,-1) are skipped.
+        //! \param[in]  path             Output path, binary \ref columnar format, if it ends with ".bin"
+        //! \return                      EXIT_SUCCESS
+        inline int writeAssociations( std::vector<std::pair<PidT,LidT> > const& points_primitives
+                                    , std::string                        const& path )
+        {
+            std::vector<long long> pids, gids, dids;
+            for ( size_t pid = 0; pid != points_primitives.size(); ++pid )
+            {
+                if ( (points_primitives[pid].first == -1) && (points_primitives[pid].second == -1) )
+                    continue;
+                pids.push_back( pid );
+                gids.push_back( points_primitives[pid].first  );
+                dids.push_back( points_primitives[pid].second );
+            }
+
+            return writeAssociationColumns( pids, gids, dids, path );
+        } //...writeAssociations
+
+        template <class _PrimitiveT> inline int
+        ResidentPrimitives<_PrimitiveT>::save( std::string const& path ) const
+        {
+            return savePrimitives<_PrimitiveT, typename std::vector<_PrimitiveT>::const_iterator>( patches, path );
+        }
+
+        inline int
+        ResidentAssociations::save( std::string const& path ) const
+        {
+            return writeAssociationColumns( pids, gids, dids, path );
+        }
+
         //! \brief                    Read stored points, and convert them to non-PCL format.
+        //!                           Binary PLY and PCD files are mapped, and decoded straight into \p points in parallel, see \ref MappedCloud.
+        //!                           Other layouts are loaded through PCL.
+        //!                           If \ref ResidentCloud is enabled, the file is only read the first time, and copied from memory afterwards.
         //! \param[out] points        Output point vector
         //! \param[in]  path          PLY source path
+        //! \param[out] cloud_arg     If not NULL, gets a pcl::PointNormal copy of the points.
+        //! \param[out] store         If not NULL, gets filled with the same points, see \ref PointStore::assign().
         //! \return                   EXIT_SUCCESS
         template < class _PointT /*= typename _PointContainerT::value_type */
                    , class _PointContainerT
@@ -298,8 +415,88 @@ namespace rapter
         readPoints( _PointContainerT &points
                   , std::string        path
                   //, pcl::PointCloud<pcl::PointNormal>::Ptr *cloud_arg = NULL )
-                  , PclCloudPtrT *cloud_arg = NULL )
+                  , PclCloudPtrT *cloud_arg = NULL
+                  , PointStore<_PointT> *store = NULL )
         {
+            typedef typename _PointT::Scalar     Scalar;
+            typedef typename _PointT::VectorType VectorType;
+            typedef ResidentCloud<_PointT>       ResidentT;
+
+            ResidentT &resident = ResidentT::instance();
+            if ( resident.enabled() )
+            {
+                typename ResidentT::Entry *entry = resident.find( path );
+                if ( !entry )
+                {
+                    entry = &resident.insert( path );
+                    resident.setEnabled( false );
+                    const int err = readPoints<_PointT>( entry->points, path, NULL, &entry->store );
+                    resident.setEnabled( true );
+                    if ( EXIT_SUCCESS != err )
+                    {
+                        resident.erase( path );
+                        return err;
+                    }
+                }
+
+                points.insert( points.end(), entry->points.begin(), entry->points.end() );
+                if ( cloud_arg )
+                {
+                    if ( !entry->cloud )
+                    {
+                        PclCloudPtrT cloud( new PclCloudT() );
+                        cloud->resize( entry->points.size() );
+#                       pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) schedule(static)
+                        for ( long pid = 0; pid < static_cast<long>(entry->points.size()); ++pid )
+                        {
+                            cloud->points[ pid ].getVector3fMap()       = entry->points[ pid ].pos().template cast<float>();
+                            cloud->points[ pid ].getNormalVector3fMap() = entry->points[ pid ].dir().template cast<float>();
+                        }
+                        entry->cloud = cloud;
+                    }
+                    *cloud_arg = PclCloudPtrT( new PclCloudT(*entry->cloud) ); // callers may change their cloud
+                }
+                if ( store )
+                    *store = entry->store; // shares the neighbour index
+
+                return EXIT_SUCCESS;
+            } //...if resident
+
+            MappedCloud<Scalar> mapped;
+            if ( EXIT_SUCCESS == mapped.open(path) )
+            {
+                const long offset = points.size();
+                const long count  = mapped.size();
+                points.resize( offset + count );
+#               pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) schedule(static)
+                for ( long pid = 0; pid < count; ++pid )
+                {
+                    _PointT &point = points[ offset + pid ];
+                    point = _PointT( (VectorType() << mapped.pos(pid), mapped.dir(pid)).finished() );
+                    point.setTag( _PointT::TAGS::PID, pid );
+                    point.setTag( _PointT::TAGS::GID, pid );
+                }
+
+                if ( cloud_arg )
+                {
+                    PclCloudPtrT cloud( new PclCloudT() );
+                    cloud->resize( count );
+#                   pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) schedule(static)
+                    for ( long pid = 0; pid < count; ++pid )
+                    {
+                        PclPointT &pnt = cloud->points[ pid ];
+                        pnt.getVector3fMap()       = mapped.pos( pid ).template cast<float>();
+                        pnt.getNormalVector3fMap() = mapped.dir( pid ).template cast<float>();
+                    }
+                    *cloud_arg = cloud;
+                }
+
+                if ( store )
+                    store->assign( mapped );
+
+                return EXIT_SUCCESS;
+            } //...if mapped
+
             pcl::PointCloud<pcl::PointNormal>::Ptr cloud;
 
             // sample image
@@ -309,23 +506,18 @@ namespace rapter
             else
                 pcl::io::loadPCDFile( path, *cloud );
 
-            // convert to raw vector
-            std::vector<typename _PointT::VectorType> raw_points;
-            pclutil::cloudToVector<typename _PointT::RawAllocator>( raw_points, cloud );
-
-            // convert to tagged v  ector
-            points.reserve( raw_points.size() );
-            for ( size_t pid = 0; pid != raw_points.size(); ++pid )
+            // convert to tagged vector
+            const size_t offset = points.size();
+            points.reserve( offset + cloud->size() );
+            for ( size_t pid = 0; pid != cloud->size(); ++pid )
             {
-                raw_points[pid](3) = cloud->at(pid).normal_x;
-                raw_points[pid](4) = cloud->at(pid).normal_y;
-                raw_points[pid](5) = cloud->at(pid).normal_z;
-
-                points.emplace_back( _PointT(raw_points[pid]) );
+                PclPointT const& pnt = cloud->at( pid );
+                points.emplace_back( _PointT((VectorType() << pnt.getVector3fMap().template cast<Scalar>(), pnt.getNormalVector3fMap().template cast<Scalar>()).finished()) );
                 points.back().setTag( _PointT::TAGS::PID, pid );
                 points.back().setTag( _PointT::TAGS::GID, pid );
             }
             if ( cloud_arg ) *cloud_arg = cloud;
+            if ( store     ) store->assign( points );
 
             return EXIT_SUCCESS;
         } // ...Solver::readPoints()
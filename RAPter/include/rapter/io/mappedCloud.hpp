@@ -0,0 +1,293 @@
+#ifndef RAPTER_IO_MAPPEDCLOUD_HPP
+#define RAPTER_IO_MAPPEDCLOUD_HPP
+
+#include <algorithm> // min
+#include <cstdlib>   // atoi
+#include <cstring>   // memcpy
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Eigen/Dense"
+#include "rapter/simpleTypes.h"
+#include "rapter/io/mappedFile.hpp"
+
+namespace rapter {
+namespace io {
+
+/*! \brief  Zero-copy view of the oriented points in a binary PLY or PCD file.
+ *
+ *          Parses the header, maps the file, and decodes x,y,z and nx,ny,nz (or normal_x,normal_y,normal_z) of point \p pid on access,
+ *          so the points can be filled straight into their final container, in parallel, without an intermediate cloud.
+ *          Supports "binary_little_endian" PLY with the vertices as first element, and "DATA binary" PCD.
+ *          Any other layout (ascii, big endian, binary_compressed, list properties in the vertices) fails to #open(), the caller falls back to PCL.
+ *          Missing normals read as zero, like the PCL loaders leave them.
+ *
+ *          Models the read-only _PointContainerT concept of \ref rapter::PointStore::assign(): size(), operator[] answering pos(), dir() and getTag().
+ *
+ *  \tparam _Scalar Precision of the decoded positions and orientations.
+ */
+template <typename _Scalar>
+class MappedCloud
+{
+    public:
+        typedef _Scalar                     Scalar;
+        typedef Eigen::Matrix<_Scalar,3,1>  Vector3;
+
+        //! \brief Read-only proxy to one point. Tags PID and GID both read as the point id, like \ref io::readPoints sets them.
+        class PointRef
+        {
+            public:
+                PointRef( MappedCloud const* cloud, size_t pid ) : _cloud( cloud ), _pid( pid ) {}
+
+                inline Vector3  pos()               const { return _cloud->pos( _pid ); }
+                inline Vector3  dir()               const { return _cloud->dir( _pid ); }
+                inline GidT     getTag( GidT )      const { return _pid; }
+
+            protected:
+                MappedCloud const*  _cloud;
+                size_t              _pid;
+        }; //...PointRef
+
+        typedef PointRef value_type;
+
+        MappedCloud() : _count( 0 ), _stride( 0 ), _body( NULL ), _hasNormals( false ) {}
+
+        /*! \brief  Maps \p path, and parses its header.
+         *  \return EXIT_SUCCESS, or EXIT_FAILURE, if the file can't be mapped, or is not in a supported binary layout.
+         */
+        inline int open( std::string const& path )
+        {
+            _count = 0; _stride = 0; _body = NULL;
+            std::fill( _fields, _fields + 6, Field() );
+            if ( EXIT_SUCCESS != _file.open(path) )
+                return EXIT_FAILURE;
+
+            int err = EXIT_FAILURE;
+            if ( (_file.size() > 3) && (std::string(_file.data(), 3) == "ply") )
+                err = this->parsePlyHeader();
+            else
+                err = this->parsePcdHeader();
+
+            if ( EXIT_SUCCESS == err )
+            {
+                for ( int d = 0; d != 3; ++d )
+                    if ( _fields[d].type == NONE )
+                        err = EXIT_FAILURE;
+                _hasNormals = (_fields[3].type != NONE) && (_fields[4].type != NONE) && (_fields[5].type != NONE);
+                // divide, the header's point count may be large enough to overflow _count * _stride
+                const size_t offset = _body - _file.data();
+                if ( !_stride || (offset > _file.size()) || (_count > (_file.size() - offset) / _stride) )
+                {
+                    std::cerr << "[" << __func__ << "]: " << path << " is truncated" << std::endl;
+                    err = EXIT_FAILURE;
+                }
+            }
+
+            if ( EXIT_SUCCESS != err )
+            {
+                _file.close();
+                _count = 0;
+            }
+            return err;
+        } //...open()
+
+        inline size_t   size      ()             const { return _count; }
+        inline bool     hasNormals()             const { return _hasNormals; }
+        inline PointRef operator[]( size_t pid ) const { return PointRef( this, pid ); }
+
+        inline Vector3 pos( size_t pid ) const
+        {
+            char const* row = _body + pid * _stride;
+            return Vector3( decode(row, _fields[0]), decode(row, _fields[1]), decode(row, _fields[2]) );
+        }
+
+        inline Vector3 dir( size_t pid ) const
+        {
+            if ( !_hasNormals ) return Vector3::Zero();
+            char const* row = _body + pid * _stride;
+            return Vector3( decode(row, _fields[3]), decode(row, _fields[4]), decode(row, _fields[5]) );
+        }
+
+    protected:
+        enum TYPE { NONE, INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64 };
+
+        //! \brief Where and how a coordinate is stored in a row.
+        struct Field
+        {
+            Field() : offset( 0 ), type( NONE ) {}
+            size_t  offset;
+            TYPE    type;
+        };
+
+        static inline int sizeOf( TYPE const type )
+        {
+            switch ( type )
+            {
+                case INT8:    case UINT8:   return 1;
+                case INT16:   case UINT16:  return 2;
+                case INT32:   case UINT32:  case FLOAT32: return 4;
+                case FLOAT64:               return 8;
+                default:                    return 0;
+            }
+        }
+
+        //! \brief Unaligned little endian read of one coordinate.
+        static inline Scalar decode( char const* row, Field const& field )
+        {
+            char const* p = row + field.offset;
+            switch ( field.type )
+            {
+                case FLOAT32: { float          v; std::memcpy( &v, p, 4 ); return v; }
+                case FLOAT64: { double         v; std::memcpy( &v, p, 8 ); return v; }
+                case INT8:    { signed char    v; std::memcpy( &v, p, 1 ); return v; }
+                case UINT8:   { unsigned char  v; std::memcpy( &v, p, 1 ); return v; }
+                case INT16:   { short          v; std::memcpy( &v, p, 2 ); return v; }
+                case UINT16:  { unsigned short v; std::memcpy( &v, p, 2 ); return v; }
+                case INT32:   { int            v; std::memcpy( &v, p, 4 ); return v; }
+                case UINT32:  { unsigned       v; std::memcpy( &v, p, 4 ); return v; }
+                default:      return Scalar( 0 );
+            }
+        } //...decode()
+
+        //! \brief Slot of a property in #_fields (x,y,z,nx,ny,nz), or -1, if not needed.
+        static inline int slotOf( std::string const& name )
+        {
+            static const char* names[] = { "x", "y", "z", "nx", "ny", "nz", "normal_x", "normal_y", "normal_z" };
+            for ( int i = 0; i != 9; ++i )
+                if ( name == names[i] )
+                    return i < 6 ? i : i - 3;
+            return -1;
+        }
+
+        //! \brief Reads the header lines up to and including \p lastLine. \return Offset of the body, or 0, if \p lastLine was not found.
+        inline size_t readHeader( std::vector<std::string> & lines, std::string const& lastLine ) const
+        {
+            size_t begin = 0;
+            const size_t maxHeader = std::min( _file.size(), size_t(1) << 16 );
+            for ( size_t pos = 0; pos != maxHeader; ++pos )
+            {
+                if ( _file.data()[pos] != '\n' ) continue;
+
+                std::string line( _file.data() + begin, pos - begin );
+                if ( !line.empty() && (line[line.size()-1] == '\r') ) line.resize( line.size() - 1 );
+                lines.push_back( line );
+                begin = pos + 1;
+                if ( line.compare(0, lastLine.size(), lastLine) == 0 )
+                    return begin;
+            }
+            return 0;
+        } //...readHeader()
+
+        inline int parsePlyHeader()
+        {
+            std::vector<std::string> lines;
+            const size_t bodyOffset = this->readHeader( lines, "end_header" );
+            if ( !bodyOffset ) return EXIT_FAILURE;
+
+            bool binary = false, inVertex = false, seenElement = false;
+            for ( size_t l = 0; l != lines.size(); ++l )
+            {
+                std::istringstream iss( lines[l] );
+                std::string key;
+                iss >> key;
+                if ( key == "format" )
+                {
+                    std::string format;
+                    iss >> format;
+                    binary = (format == "binary_little_endian");
+                }
+                else if ( key == "element" )
+                {
+                    std::string name;
+                    iss >> name;
+                    if ( !seenElement && (name == "vertex") ) { inVertex = true; iss >> _count; }
+                    else                                        inVertex = false;
+                    seenElement = true;
+                }
+                else if ( (key == "property") && inVertex )
+                {
+                    std::string type, name;
+                    iss >> type >> name;
+                    if ( type == "list" ) return EXIT_FAILURE;
+
+                    Field field;
+                    field.offset = _stride;
+                    if      ( type == "char"   || type == "int8"    ) field.type = INT8;
+                    else if ( type == "uchar"  || type == "uint8"   ) field.type = UINT8;
+                    else if ( type == "short"  || type == "int16"   ) field.type = INT16;
+                    else if ( type == "ushort" || type == "uint16"  ) field.type = UINT16;
+                    else if ( type == "int"    || type == "int32"   ) field.type = INT32;
+                    else if ( type == "uint"   || type == "uint32"  ) field.type = UINT32;
+                    else if ( type == "float"  || type == "float32" ) field.type = FLOAT32;
+                    else if ( type == "double" || type == "float64" ) field.type = FLOAT64;
+                    else return EXIT_FAILURE;
+
+                    const int slot = slotOf( name );
+                    if ( slot >= 0 ) _fields[slot] = field;
+                    _stride += sizeOf( field.type );
+                }
+            }
+
+            if ( !binary || !_count ) return EXIT_FAILURE;
+            _body = _file.data() + bodyOffset;
+            return EXIT_SUCCESS;
+        } //...parsePlyHeader()
+
+        inline int parsePcdHeader()
+        {
+            std::vector<std::string> lines;
+            const size_t bodyOffset = this->readHeader( lines, "DATA" );
+            if ( !bodyOffset || (lines.back() != "DATA binary") ) return EXIT_FAILURE;
+
+            std::vector<std::string> names;
+            std::vector<int>         sizes, counts;
+            std::vector<char>        types;
+            for ( size_t l = 0; l != lines.size(); ++l )
+            {
+                std::istringstream iss( lines[l] );
+                std::string key, token;
+                iss >> key;
+                if      ( key == "FIELDS" ) while ( iss >> token ) names.push_back( token );
+                else if ( key == "SIZE"   ) while ( iss >> token ) sizes.push_back( atoi(token.c_str()) );
+                else if ( key == "TYPE"   ) while ( iss >> token ) types.push_back( token[0] );
+                else if ( key == "COUNT"  ) while ( iss >> token ) counts.push_back( atoi(token.c_str()) );
+                else if ( key == "POINTS" ) iss >> _count;
+            }
+            if ( counts.empty() ) counts.resize( names.size(), 1 );
+            if ( (sizes.size() != names.size()) || (types.size() != names.size()) || (counts.size() != names.size()) )
+                return EXIT_FAILURE;
+
+            for ( size_t f = 0; f != names.size(); ++f )
+            {
+                Field field;
+                field.offset = _stride;
+                switch ( types[f] )
+                {
+                    case 'F': field.type = sizes[f] == 8 ? FLOAT64 : FLOAT32; break;
+                    case 'I': field.type = sizes[f] == 1 ? INT8  : (sizes[f] == 2 ? INT16  : INT32 ); break;
+                    case 'U': field.type = sizes[f] == 1 ? UINT8 : (sizes[f] == 2 ? UINT16 : UINT32); break;
+                    default:  return EXIT_FAILURE;
+                }
+                const int slot = slotOf( names[f] );
+                if ( slot >= 0 ) _fields[slot] = field;
+                _stride += sizes[f] * counts[f];
+            }
+
+            if ( !_count ) return EXIT_FAILURE;
+            _body = _file.data() + bodyOffset;
+            return EXIT_SUCCESS;
+        } //...parsePcdHeader()
+
+        MappedFile  _file;
+        size_t      _count;         //!< \brief Number of points.
+        size_t      _stride;        //!< \brief Bytes per point.
+        char const* _body;          //!< \brief First point.
+        Field       _fields[6];     //!< \brief x, y, z, nx, ny, nz.
+        bool        _hasNormals;
+}; //...MappedCloud
+
+} //...ns io
+} //...ns rapter
+
+#endif // RAPTER_IO_MAPPEDCLOUD_HPP
@@ -0,0 +1,79 @@
+#ifndef RAPTER_IO_MAPPEDFILE_HPP
+#define RAPTER_IO_MAPPEDFILE_HPP
+
+#include <cstdlib>  // EXIT_SUCCESS
+#include <fstream>
+#include <iterator> // istreambuf_iterator
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#   include <fcntl.h>    // open
+#   include <sys/mman.h> // mmap
+#   include <sys/stat.h> // fstat
+#   include <unistd.h>   // close
+#endif
+
+namespace rapter {
+namespace io {
+
+//! \brief Read-only memory map of a whole file. Falls back to reading into memory, where mmap is not available.
+class MappedFile
+{
+    public:
+        MappedFile() : _data( NULL ), _size( 0 ) {}
+        ~MappedFile() { this->close(); }
+
+        // owns the mapping, a copy would unmap it twice
+        MappedFile( MappedFile const& )            = delete;
+        MappedFile& operator=( MappedFile const& ) = delete;
+
+        //! \return EXIT_SUCCESS, or EXIT_FAILURE, if the file could not be opened or mapped.
+        inline int open( std::string const& path )
+        {
+            this->close();
+#ifndef _WIN32
+            int fd = ::open( path.c_str(), O_RDONLY );
+            if ( fd < 0 ) return EXIT_FAILURE;
+            struct stat st;
+            if ( (fstat(fd, &st) != 0) || (st.st_size <= 0) ) { ::close( fd ); return EXIT_FAILURE; }
+            void* addr = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            ::close( fd );
+            if ( addr == MAP_FAILED ) return EXIT_FAILURE;
+            _data = static_cast<char const*>( addr );
+            _size = st.st_size;
+#else
+            std::ifstream f( path.c_str(), std::ios::binary );
+            if ( !f.is_open() ) return EXIT_FAILURE;
+            _buffer.assign( std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>() );
+            _data = _buffer.data();
+            _size = _buffer.size();
+#endif
+            return EXIT_SUCCESS;
+        } //...open()
+
+        inline void close()
+        {
+#ifndef _WIN32
+            if ( _data ) munmap( const_cast<char*>(_data), _size );
+#else
+            _buffer.clear();
+#endif
+            _data = NULL;
+            _size = 0;
+        } //...close()
+
+        inline char const* data() const { return _data; }
+        inline size_t      size() const { return _size; }
+
+    protected:
+        char const* _data;
+        size_t      _size;
+#ifdef _WIN32
+        std::vector<char> _buffer;
+#endif
+}; //...MappedFile
+
+} //...ns io
+} //...ns rapter
+
+#endif // RAPTER_IO_MAPPEDFILE_HPP
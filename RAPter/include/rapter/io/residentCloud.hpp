@@ -0,0 +1,64 @@
+#ifndef RAPTER_IO_RESIDENTCLOUD_HPP
+#define RAPTER_IO_RESIDENTCLOUD_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include "rapter/util/pclUtil.h"            // PclCloudPtrT
+#include "rapter/primitives/pointStore.h"
+
+namespace rapter {
+namespace io {
+
+/*! \brief  Process-wide copies of the point clouds read by \ref io::readPoints, used when several stages run in one process (see --pipeline).
+ *
+ *          Disabled by default, so every sub-command reads its cloud from disk as before. Once enabled, the first readPoints of a path
+ *          parses the file, and every later one copies the parsed points from memory. The PointNormal cloud is built once on first request,
+ *          and the \ref PointStore handed out shares its neighbour index with all stages, see \ref PointStore::getSpatialIndex().
+ *
+ *  \tparam _PointT Concept: \ref rapter::PointPrimitive.
+ */
+template <class _PointT>
+class ResidentCloud
+{
+    public:
+        //! \brief Everything kept for one path.
+        struct Entry
+        {
+            std::vector<_PointT>    points; //!< \brief Points as read, tagged PID = GID = index.
+            PclCloudPtrT            cloud;  //!< \brief Built on first request.
+            PointStore<_PointT>     store;  //!< \brief Positions and orientations as read, with the shared neighbour index.
+        };
+
+        static inline ResidentCloud& instance()
+        {
+            static ResidentCloud resident;
+            return resident;
+        }
+
+        inline bool enabled   () const          { return _enabled; }
+        inline void setEnabled( bool enabled )  { _enabled = enabled; }
+
+        //! \return The entry of \p path, or NULL, if not read yet.
+        inline Entry*   find  ( std::string const& path )
+        {
+            typename EntriesT::iterator it = _entries.find( path );
+            return it == _entries.end() ? NULL : &it->second;
+        }
+        inline Entry&   insert( std::string const& path ) { return _entries[ path ]; }
+        inline void     erase ( std::string const& path ) { _entries.erase( path ); }
+        inline void     clear ()                          { _entries.clear(); }
+
+    protected:
+        typedef std::map<std::string, Entry> EntriesT;
+
+        ResidentCloud() : _enabled( false ) {}
+
+        EntriesT    _entries;
+        bool        _enabled;
+}; //...ResidentCloud
+
+} //...ns io
+} //...ns rapter
+
+#endif // RAPTER_IO_RESIDENTCLOUD_HPP
@@ -0,0 +1,191 @@
+#ifndef RAPTER_IO_RESIDENTFILES_HPP
+#define RAPTER_IO_RESIDENTFILES_HPP
+
+#include <map>
+#include <memory> // shared_ptr
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include "rapter/simpleTypes.h"             // GidT, DidT
+#include "Eigen/Dense"
+#include "rapter/util/containers.hpp"       // valueOf
+
+namespace rapter {
+namespace io {
+
+/*! \brief  Process-wide, in-memory primitive and association files, used when several stages run in one process (see --pipeline).
+ *
+ *          Disabled by default, so every sub-command reads and writes its files as before. Once enabled, \ref io::savePrimitives and
+ *          \ref io::writeAssociations keep their content keyed by path, and \ref io::readPrimitives and \ref io::readAssociations
+ *          return it from there without touching the disk. The files are written too only, if persistent.
+ *          The content is stored the way it would have been read back from a \ref columnar file, so stages see the same primitives.
+ *          Paths are compared lexically normalized, "./patches.csv" and "patches.csv" are the same file.
+ */
+class ResidentFiles
+{
+    public:
+        //! \brief Content of one file.
+        struct Entry
+        {
+            virtual ~Entry() {}
+            //! \brief Writes the content to \p path, in the format its extension selects.
+            virtual int save( std::string const& path ) const = 0;
+        };
+        typedef std::shared_ptr<Entry const> EntryPtrT;
+
+        static inline ResidentFiles& instance()
+        {
+            static ResidentFiles resident;
+            return resident;
+        }
+
+        inline bool enabled      () const             { return _enabled; }
+        inline void setEnabled   ( bool enabled )     { _enabled = enabled; }
+        inline bool persistent   () const             { return _persistent; }
+        //! \brief If true, every file kept in memory is written to disk as well.
+        inline void setPersistent( bool persistent )  { _persistent = persistent; }
+        //! \return True, if a file about to be kept in memory has to be written to disk as well.
+        inline bool toDisk       () const             { return !_enabled || _persistent; }
+
+        //! \return The content of \p path, if it is a \p _EntryT, or NULL.
+        template <class _EntryT>
+        inline std::shared_ptr<_EntryT const> find( std::string const& path ) const
+        {
+            EntriesT::const_iterator it = _entries.find( key(path) );
+            return it == _entries.end() ? std::shared_ptr<_EntryT const>() : std::dynamic_pointer_cast<_EntryT const>( it->second );
+        }
+        inline bool     contains( std::string const& path ) const       { return _entries.find( key(path) ) != _entries.end(); }
+        inline void     insert  ( std::string const& path, EntryPtrT const& entry ) { _entries[ key(path) ] = entry; }
+        inline void     erase   ( std::string const& path )             { _entries.erase( key(path) ); }
+        inline void     clear   ()                                      { _entries.clear(); }
+
+        //! \brief Makes \p to share the content of \p from, the content is never modified in place. \return False, if \p from is not in memory.
+        inline bool copy( std::string const& from, std::string const& to )
+        {
+            EntriesT::const_iterator it = _entries.find( key(from) );
+            if ( it == _entries.end() ) return false;
+            _entries[ key(to) ] = it->second;
+            return true;
+        }
+
+        //! \brief Moves the content of \p from to \p to. \return False, if \p from is not in memory.
+        inline bool rename( std::string const& from, std::string const& to )
+        {
+            if ( !copy(from, to) ) return false;
+            if ( key(from) != key(to) ) _entries.erase( key(from) );
+            return true;
+        }
+
+        //! \brief Writes the content of \p path to the file \p to. \return EXIT_FAILURE, if \p path is not in memory, or could not be written.
+        inline int save( std::string const& path, std::string const& to )
+        {
+            EntriesT::const_iterator it = _entries.find( key(path) );
+            if ( it == _entries.end() ) return EXIT_FAILURE;
+
+            // write the file itself, instead of keeping it again
+            const bool enabled = _enabled;
+            _enabled = false;
+            const int err = it->second->save( to );
+            _enabled = enabled;
+            return err;
+        }
+
+    protected:
+        typedef std::map<std::string, EntryPtrT> EntriesT;
+
+        //! \return \p path lexically normalized, without a leading "./".
+        static inline std::string key( std::string const& path )
+        {
+            std::string normal = boost::filesystem::path( path ).lexically_normal().string();
+            while ( (normal.size() > 2) && (normal.compare(0, 2, "./") == 0) )
+                normal.erase( 0, 2 );
+            return normal;
+        }
+
+        ResidentFiles() : _enabled( false ), _persistent( false ) {}
+
+        EntriesT    _entries;
+        bool        _enabled;
+        bool        _persistent;
+}; //...ResidentFiles
+
+/*! \brief  Primitives kept by \ref io::savePrimitives, grouped by GID like \ref io::readPrimitives groups them.
+ *  \tparam _PrimitiveT Concept: \ref rapter::LinePrimitive2.
+ */
+template <class _PrimitiveT>
+struct ResidentPrimitives : public ResidentFiles::Entry
+{
+    typedef typename _PrimitiveT::Scalar                 Scalar;
+    typedef std::map< GidT, std::vector<_PrimitiveT> >   PatchMapT;
+
+    //! \brief Copies the coefficients and the GID, DIR_GID, STATUS and GEN_ANGLE tags of \p primitives, the rest of a primitive is not stored.
+    template <class _inner_const_iterator, class _PrimitiveContainerT>
+    inline void assign( _PrimitiveContainerT const& primitives )
+    {
+        typedef typename _PrimitiveContainerT::const_iterator outer_const_iterator;
+        const int coeffCount = _PrimitiveT::getFileEntryLength(); // <x0,n>
+
+        std::vector<Scalar> floats( coeffCount );
+        for ( outer_const_iterator gid_it = primitives.begin(); gid_it != primitives.end(); ++gid_it )
+        {
+            _inner_const_iterator lid_end_it = containers::valueOf<_PrimitiveT>(gid_it).end();
+            for ( _inner_const_iterator lid_it = containers::valueOf<_PrimitiveT>(gid_it).begin(); lid_it != lid_end_it; ++lid_it )
+            {
+                const Eigen::Matrix<Scalar,3,1> pos = lid_it->pos(), nrm = lid_it->normal();
+                std::copy( pos.data(), pos.data() + 3             , floats.begin()     );
+                std::copy( nrm.data(), nrm.data() + coeffCount - 3, floats.begin() + 3 );
+
+                // same conversions as a columnar::savePrimitives, columnar::readPrimitives round trip
+                const long long   gid    = lid_it->getTag( _PrimitiveT::TAGS::GID       );
+                const long long   did    = lid_it->getTag( _PrimitiveT::TAGS::DIR_GID   );
+                const signed char status = lid_it->getTag( _PrimitiveT::TAGS::STATUS    );
+                const Scalar      angle  = lid_it->getTag( _PrimitiveT::TAGS::GEN_ANGLE );
+                std::vector<_PrimitiveT> &patch = patches[ static_cast<GidT>(gid) ];
+                patch.push_back( _PrimitiveT::fromFileEntry(floats) );
+                patch.back().setTag( _PrimitiveT::TAGS::GID      , static_cast<GidT>(gid)    );
+                patch.back().setTag( _PrimitiveT::TAGS::DIR_GID  , static_cast<DidT>(did)    );
+                patch.back().setTag( _PrimitiveT::TAGS::STATUS   , static_cast<char>(status) );
+                patch.back().setTag( _PrimitiveT::TAGS::GEN_ANGLE, angle                     );
+            }
+        }
+    } //...assign()
+
+    //! \brief Appends the patches to \p lines, and copies them to \p outPatches, like \ref io::readPrimitives.
+    template <class _PatchT, class _PrimitiveContainerT>
+    inline void read( _PrimitiveContainerT & lines, std::map<GidT, typename _PrimitiveContainerT::value_type> *outPatches ) const
+    {
+        if ( patches.size() && (patches.begin()->first < 0) )
+            throw new std::runtime_error("[io::readPrims] code not up to date to handle gid==-1 cases, please add proper GID to primitives");
+
+        std::map<GidT, _PatchT> tmp_lines;
+        for ( typename PatchMapT::const_iterator it = patches.begin(); it != patches.end(); ++it )
+        {
+            lines.push_back( _PatchT() );
+            lines.back().insert( lines.back().end(), it->second.begin(), it->second.end() );
+            if ( outPatches )
+                tmp_lines[ it->first ].insert( tmp_lines[it->first].end(), it->second.begin(), it->second.end() );
+        }
+        if ( outPatches )
+            *outPatches = tmp_lines;
+    } //...read()
+
+    //! \brief Writes the patches through \ref io::savePrimitives.
+    int save( std::string const& path ) const;
+
+    PatchMapT patches;
+}; //...ResidentPrimitives
+
+//! \brief Associations kept by \ref io::writeAssociations, as parallel columns of point ids, GIDs and DIR_GIDs.
+struct ResidentAssociations : public ResidentFiles::Entry
+{
+    //! \brief Writes the columns through \ref io::writeAssociationColumns.
+    int save( std::string const& path ) const;
+
+    std::vector<long long> pids, gids, dids;
+}; //...ResidentAssociations
+
+} //...ns io
+} //...ns rapter
+
+#endif // RAPTER_IO_RESIDENTFILES_HPP
@@ -24,7 +24,9 @@ namespace rapter
              /*! \brief                  Step 1. Generates primitives from a cloud. Reads "cloud.ply" and saves "candidates.csv".
               *  \param argc             Contains --cloud cloud.ply, and --scale scale.
               *  \param argv             Contains --cloud cloud.ply, and --scale scale.
-              *  \return                 EXIT_SUCCESS.
+              *  \param[out] remaining   Count of the small patches, that are left to promote on this threshold.
+              *  \return                 EXIT_SUCCESS or EXIT_FAILURE, if \p remaining is given.
+              *                          Otherwise the larger of the error and the remaining count, scripts/rapter.py reads it from the exit code.
               */
             template < class    _PrimitiveContainerT
                      , class    _PointContainerT
@@ -33,7 +35,7 @@ namespace rapter
                      , class    _PrimitiveT
                      >
             static inline int
-            generateCli( int argc, char** argv );
+            generateCli( int argc, char** argv, int *remaining = NULL );
 
             /*! \brief Main functionality to generate lines from points.
              *
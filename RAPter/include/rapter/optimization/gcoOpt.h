@@ -0,0 +1,93 @@
+#ifndef RAPTER_GCOOPT_H
+#define RAPTER_GCOOPT_H
+
+#include <vector>
+#include <unordered_map>
+#include "gco/GCoptimization.h"     // GCoptimizationGeneralGraph
+#include "qcqpcpp/optProblem.h"     // OptProblem
+#include "rapter/simpleTypes.h"     // LidT
+
+namespace rapter {
+
+/*! \brief  Alpha-expansion backend (gco-v3) for the selection problems formulated by \ref ProblemSetup, selected by --solver gco.
+ *
+ *          Every patch (site) chooses exactly one of its candidates, the label of a candidate is its direction (DIR_GID).
+ *          The data cost of a label is the linear objective of its variable, minus the complexity weight,
+ *          which is charged once per used label instead (label cost). The smooth cost of two neighbouring patches
+ *          is the quadratic objective between the two chosen candidates.
+ *
+ *          Expansion needs metric smooth costs. If a non-submodular move is detected, the optimization continues
+ *          from the current labeling with alpha-beta swaps, which ignore the label cost.
+ *          The solution selects one candidate per patch, so it is approximate, and only feasible for "patch" constraint modes.
+ *
+ *  \tparam _Scalar Precision of the problem, double for the problems of \ref problemSetup::OptProblemT.
+ */
+template <typename _Scalar>
+class GcoOpt : public qcqpcpp::OptProblem<_Scalar>
+{
+    public:
+        typedef qcqpcpp::OptProblem<_Scalar>                ParentType;
+        typedef typename ParentType::SparseMatrix           SparseMatrix;
+        typedef typename ParentType::OBJ_SENSE              OBJ_SENSE;
+
+        GcoOpt() : _labelCost( 0 ), _maxIterations( 10 ), _verbose( false ) {}
+        virtual ~GcoOpt() {}
+
+        /*! \brief              Assigns every variable to a patch (site) and a direction (label). Call before #update().
+         *  \param[in] sites    Site of each variable, i.e. the GID of the candidate.
+         *  \param[in] labels   Label of each variable, i.e. the DIR_GID of the candidate.
+         *  \param[in] labelCost Complexity weight, subtracted from the linear objectives, and charged once per used label.
+         */
+        inline void setLabeling( std::vector<LidT> const& sites, std::vector<LidT> const& labels, _Scalar const labelCost )
+        {
+            _varSites  = sites;
+            _varLabels = labels;
+            _labelCost = labelCost;
+        }
+
+        inline void setMaxIterations( int const iterations ) { _maxIterations = iterations; } //!< \brief Expansion cycles, -1 until convergence.
+
+        /*! \brief          Builds the sparse data costs and the neighbourhood of the sites.
+         *  \return         EXIT_SUCCESS, or EXIT_FAILURE, if the labeling is missing, or a variable is not binary.
+         */
+        virtual int update( bool verbose = false );
+
+        /*! \brief                  Runs alpha-expansion. Call #update() before.
+         *  \param[out] x_out       One selected variable per site.
+         *  \return                 EXIT_SUCCESS, or EXIT_FAILURE, if the labeling violates a constraint of the problem.
+         */
+        virtual int optimize( std::vector<_Scalar> *x_out = NULL, OBJ_SENSE objective_sense = ParentType::MINIMIZE );
+
+    protected:
+        //! \brief Variable of label \p label at site \p site, -1 if the site has no such candidate.
+        inline LidT variable( LidT const site, LidT const label ) const;
+
+        //! \brief Smooth cost callback of gco, \p data is the GcoOpt instance.
+        static gco::GCoptimization::EnergyTermType smoothCost( int s1, int s2, int l1, int l2, void *data );
+
+        //! \brief Number of constraints \p x violates.
+        LidT countViolations( std::vector<_Scalar> const& x ) const;
+
+        // input
+        std::vector<LidT>       _varSites;
+        std::vector<LidT>       _varLabels;
+        _Scalar                 _labelCost;
+        int                     _maxIterations;
+        bool                    _verbose;
+
+        // set by update()
+        std::vector< std::vector< std::pair<LidT,LidT> > >   _siteLabelVars; //!< \brief Sorted (compact label, variable) pairs per compact site.
+        std::vector<LidT>                                   _siteIds;       //!< \brief Compact site of each variable.
+        std::vector<LidT>                                   _labelIds;      //!< \brief Compact label of each variable.
+        LidT                                                _labelCount;
+        std::vector<_Scalar>                                _data;          //!< \brief Data cost per variable, shifted to 0 per site.
+        std::unordered_map<unsigned long long, _Scalar>     _pairwise;      //!< \brief Quadratic objective per variable pair, keyed by var0 * n + var1, both orders.
+        std::vector< std::pair<LidT,LidT> >                 _neighbours;    //!< \brief Site pairs (s < t) with a pairwise term.
+        _Scalar                                             _scale;         //!< \brief Divides costs to stay below GCO_MAX_ENERGYTERM.
+}; //...class GcoOpt
+
+} //...ns rapter
+
+#include "rapter/optimization/impl/gcoOpt.hpp"
+
+#endif // RAPTER_GCOOPT_H
@@ -6,6 +6,7 @@
 #include "rapter/io/io.h"                         // readPrimities,savePrimitives,etc.
 #include "rapter/optimization/energyFunctors.h"   // MyPointPrimitiveDistanceFunctor
 #include "rapter/processing/util.hpp"             // calcPopulations()
+#include "rapter/processing/directionIndex.hpp"   // DirectionIndex
 #include "rapter/processing/impl/angleUtil.hpp"       // selectAngles
 #include "rapter/util/diskUtil.hpp"               // saveBackup
 #include "rapter/util/impl/pclUtil.hpp"           // PCLPointAllocator
@@ -152,37 +153,80 @@ namespace rapter
         return true;
     }
 
-    /*! \brief Adds a candidate at location prim0, with direction from prim1.
+    /*! \brief Tests, if prim0 can receive the direction of prim1, and generates the candidate. Depends only on its input, so it can run in parallel.
+     *  \param[out] cand0              The candidate at prim0, with direction from prim1. Valid, if returns true.
+     *  \param[out] closest_angle_id0  Id of the angle in \p angles, prim0 and prim1 enclose.
+     *  \return                        True, if the static filters and the angle test passed, and the candidate could be generated.
+     */
+    template < class _PrimitivePrimitiveAngleFunctorT, class _PrimitiveT, typename _Scalar, class _AnglesT, class _PromotedT>
+    inline bool prepareCandidate( _PrimitiveT   const& prim0
+                                , _PrimitiveT   const& prim1
+                                , LidT          const  lid0
+                                , LidT          const  lid1
+                                , int           const  safe_mode
+                                , int           const  allow_promoted
+                                , _Scalar       const  angle_limit
+                                , _AnglesT      const& angles
+                                , _PromotedT    const& promoted
+                                , _PrimitiveT        & cand0
+                                , int                & closest_angle_id0
+                                )
+    {
+        const GidT gid0     = prim0.getTag( _PrimitiveT::TAGS::GID );
+        const GidT gid1     = prim1.getTag( _PrimitiveT::TAGS::GID );
+
+        bool add0 = notSMALL(prim0) && notSMALL(prim1);
+        if ( !allow_promoted )
+            add0 &= notPROMOTED(gid1,lid1); // sender cannot be promoted
+        // changed by Aron 08:15, 26/09/2014 to prevent many candidates, trust originals, don't add anything to them, just add to promoted ones
+        if ( safe_mode )
+            add0 &= isPROMOTED(gid0,lid0); // add cand0 only, if prim0 was promoted
+
+        if ( !add0 )
+            return false;
+
+        closest_angle_id0 = 0;
+        _Scalar angdiff0 = _PrimitivePrimitiveAngleFunctorT::template eval<_Scalar>( prim0, prim1, angles, &closest_angle_id0 );
+        // prim0 needs to be close to prim1 in angle
+        if ( !(angdiff0 < angle_limit) )
+            return false;
+
+        // can candidate be created?
+        return prim0.generateFrom( cand0, prim1, closest_angle_id0, angles, _Scalar(1.) );
+    } //...prepareCandidate()
+
+    /*! \brief Adds a candidate at location prim0, with direction from prim1, that passed \ref prepareCandidate().
+     *         Reads and updates the shared bookkeeping, so calls have to be made in the same order as with \ref addCandidate().
      *  \param[in/out] allowedAngles
      *  \param[in/out] copied           [gid] = [ <dir0,angle_id0>, <dir0,angle_id1>, <dir2,angle_id0>, ... ]
      *  \param[in/out] generated        Records, how many extra candidates the input primitive generated in the output.
      *  \param[in/out] nLines           Keeps track of overall output size.
      *  \param[in/out] aliases          Keeps track of diretion ids and their assigned generator angles. If not set, not enabled. NULL is used at the second phase, when aliases are added.
+     *  \param[in] cand0                Output of \ref prepareCandidate(), copied, since it might get overwritten.
+     *  \param[in] closest_angle_id0    Output of \ref prepareCandidate().
      */
     template < class _PrimitivePrimitiveAngleFunctorT, class _AliasesT
              , class _PrimitiveT, typename _Scalar, class _AnglesT, class _PromotedT
              , class _AllowedAnglesT, class _CopiedT, class _GeneratedT, class _PrimitiveContainerT, class _PointContainerT>
-    inline int addCandidate( _PrimitiveT        const& prim0
-                           , _PrimitiveT        const& prim1
-                           , LidT               const  lid0
-                           , LidT               const  lid1
-                           , int                const  safe_mode
-                           , int                const  allow_promoted
-                           , _Scalar            const  angle_limit
-                           , _AnglesT           const& angles
-                           , _AnglesT           const& angle_gens_in_rad
-                           , _PromotedT         const& promoted
-                           , _AllowedAnglesT         & allowedAngles
-                           , _CopiedT                & copied
-                           , _GeneratedT             & generated
-                           , LidT                    & nLines
-                           , _PrimitiveContainerT    & out_prims
-                           , _PointContainerT   const& points
-                           , _Scalar            const  scale
-                           , _AliasesT               * aliases
-                           , bool               const  tripletSafe  = false
-                           , bool               const  verbose      = false
-                           )
+    inline int commitCandidate( _PrimitiveT        const& prim0
+                              , _PrimitiveT        const& prim1
+                              , LidT               const  lid0
+                              , _PrimitiveT               cand0
+                              , int                       closest_angle_id0
+                              , _AnglesT           const& angles
+                              , _AnglesT           const& angle_gens_in_rad
+                              , _PromotedT         const& promoted
+                              , _AllowedAnglesT         & allowedAngles
+                              , _CopiedT                & copied
+                              , _GeneratedT             & generated
+                              , LidT                    & nLines
+                              , _PrimitiveContainerT    & out_prims
+                              , _PointContainerT   const& points
+                              , _Scalar            const  scale
+                              , _AliasesT               * aliases
+                              , bool               const  tripletSafe  = false
+                              , bool               const  verbose      = false
+                              )
     {
         typedef typename _PointContainerT::value_type PointPrimitiveT;
 
@@ -191,51 +235,18 @@ namespace rapter
         const DidT dir_gid0 = prim0.getTag( _PrimitiveT::TAGS::DIR_GID );
         const DidT dir_gid1 = prim1.getTag( _PrimitiveT::TAGS::DIR_GID );
 
-        if ( gid0 == 283 || gid1 == 283 )
-            std::cout << " at " << gid0 << "," << dir_gid0 << " from " << gid1  << ", " << dir_gid1 << std::endl;
+        bool add0 = true;
 
-        bool add0 = false;
-
-        add0 = notSMALL(prim0) && notSMALL(prim1);
-        if ( !allow_promoted )
-            add0 &= notPROMOTED(gid1,lid1); // sender cannot be promoted
-        // changed by Aron 08:15, 26/09/2014 to prevent many candidates, trust originals, don't add anything to them, just add to promoted ones
-        if ( safe_mode )
-            add0 &= isPROMOTED(gid0,lid0); // add cand0 only, if prim0 was promoted
-
-        if ( !add0 )
-            return false;
-
-        int closest_angle_id0 = 0;
         // do I have restrictions, when I copy dir1 to pos0 with this angle?
-        bool isRestricted0 = false;
-        {
-            isRestricted0 = allowedAngles.find(dir_gid1) != allowedAngles.end();
-        }
-
-        _Scalar angdiff0 = _PrimitivePrimitiveAngleFunctorT::template eval<_Scalar>( prim0, prim1,
-                                                                                     /*isRestricted0 ? allowedAngles[dir_gid1] : */ angles,
-                                                                                     &closest_angle_id0 );
-        // prim0 needs to be close to prim1 in angle
-        //if ( notPROMOTED(gid0,lid0) ) // don't bias small patches, copy best match to promoted patches
-            add0 &= angdiff0 < angle_limit;
+        const bool isRestricted0 = allowedAngles.find(dir_gid1) != allowedAngles.end();
 
         // was this direction-angle pair already covered?
         {
 //#warning "bumm 19/4/2015"
             if ( copied[gid0].find(DidAid(dir_gid1,closest_angle_id0)) != copied[gid0].end() )
-                add0 = false;
+                return false;
         }
 
-        // are we still adding it?
-        if ( !add0 )
-            return false;
-
-        // can candidate be created?
-        _PrimitiveT cand0;
-        if ( !prim0.generateFrom(cand0, prim1, closest_angle_id0, angles, _Scalar(1.)) )
-            return false;
-
         // TEST triplets
         if ( tripletSafe ) // cancel candidate, if not ideally angled with any of the candidates with same dId already
         {
@@ -395,7 +406,57 @@ namespace rapter
         }
 
         return added0;
-    }
+    } //...commitCandidate()
+
+    /*! \brief Adds a candidate at location prim0, with direction from prim1. \ref prepareCandidate() followed by \ref commitCandidate().
+     *  \param[in/out] allowedAngles
+     *  \param[in/out] copied           [gid] = [ <dir0,angle_id0>, <dir0,angle_id1>, <dir2,angle_id0>, ... ]
+     *  \param[in/out] generated        Records, how many extra candidates the input primitive generated in the output.
+     *  \param[in/out] nLines           Keeps track of overall output size.
+     *  \param[in/out] aliases          Keeps track of diretion ids and their assigned generator angles. If not set, not enabled. NULL is used at the second phase, when aliases are added.
+     */
+    template < class _PrimitivePrimitiveAngleFunctorT, class _AliasesT
+             , class _PrimitiveT, typename _Scalar, class _AnglesT, class _PromotedT
+             , class _AllowedAnglesT, class _CopiedT, class _GeneratedT, class _PrimitiveContainerT, class _PointContainerT>
+    inline int addCandidate( _PrimitiveT        const& prim0
+                           , _PrimitiveT        const& prim1
+                           , LidT               const  lid0
+                           , LidT               const  lid1
+                           , int                const  safe_mode
+                           , int                const  allow_promoted
+                           , _Scalar            const  angle_limit
+                           , _AnglesT           const& angles
+                           , _AnglesT           const& angle_gens_in_rad
+                           , _PromotedT         const& promoted
+                           , _AllowedAnglesT         & allowedAngles
+                           , _CopiedT                & copied
+                           , _GeneratedT             & generated
+                           , LidT                    & nLines
+                           , _PrimitiveContainerT    & out_prims
+                           , _PointContainerT   const& points
+                           , _Scalar            const  scale
+                           , _AliasesT               * aliases
+                           , bool               const  tripletSafe  = false
+                           , bool               const  verbose      = false
+                           )
+    {
+        _PrimitiveT cand0;
+        int         closest_angle_id0 = 0;
+        if ( !prepareCandidate<_PrimitivePrimitiveAngleFunctorT>(prim0, prim1, lid0, lid1, safe_mode, allow_promoted, angle_limit, angles, promoted, cand0, closest_angle_id0) )
+            return false;
+
+        return commitCandidate<_PrimitivePrimitiveAngleFunctorT>( prim0, prim1, lid0, cand0, closest_angle_id0, angles, angle_gens_in_rad, promoted,
+                                                                  allowedAngles, copied, generated, nLines, out_prims, points, scale, aliases, tripletSafe, verbose );
+    } //...addCandidate()
+
+    /*! \brief Candidate of a receiver, with direction from a sender, that passed \ref prepareCandidate(). Indices are into the flattened input. */
+    template <class _PrimitiveT>
+    struct PreparedCandidateT
+    {
+        LidT        _receiver, _sender;
+        int         _closestAngleId;
+        _PrimitiveT _cand;
+    };
 
     template <class _PrimitiveT>
     struct AliasT
@@ -533,10 +594,29 @@ namespace rapter
         {
             Eigen::Matrix<_Scalar,Eigen::Dynamic,1> spatialSignif(1,1); // cache variable
 
+            // the spatial significance of promotable primitives is independent, so it is computed in parallel, in input order
+            std::vector< std::pair<_PrimitiveT const*,PidVector*> > promotable; // <primitive, population>
+            for ( outer_iterator outer_it0 = inPrims.begin(); outer_it0 != inPrims.end(); ++outer_it0 )
+            {
+                auto popIt = populations.find( (*outer_it0).first );
+                if ( (popIt == populations.end()) || (popIt->second.size() <= static_cast<size_t>(params.patch_population_limit)) )
+                    continue;
+                for ( inner_iterator inner_it0 = (*outer_it0).second.begin(); inner_it0 != (*outer_it0).second.end(); ++inner_it0 )
+                {
+                    const int prim_status = inner_it0->getTag( _PrimitiveT::TAGS::STATUS );
+                    if ( (prim_status == _PrimitiveT::STATUS_VALUES::SMALL) || (prim_status == _PrimitiveT::STATUS_VALUES::UNSET) )
+                        promotable.push_back( std::make_pair(&(*inner_it0), &(popIt->second)) );
+                }
+            }
+            std::vector<_Scalar> significances( promotable.size() );
+#           pragma omp parallel for firstprivate(spatialSignif) schedule(dynamic) num_threads(RAPTER_MAX_OMP_THREADS)
+            for ( LidT i = 0; i < static_cast<LidT>(promotable.size()); ++i )
+                significances[i] = promotable[i].first->getSpatialSignificance( spatialSignif, points, scale, promotable[i].second )(0);
+            size_t promotableId = 0;
+
             // either all (patches), or none (second iteration) have to be unset
             int unset_count = 0, input_count = 0;
             // for all input primitives
-            // #pragma omp parallel for private(spatialSignif)
             for ( outer_iterator outer_it0 = inPrims.begin(); outer_it0 != inPrims.end(); ++outer_it0 )
             {
                 int gid = (*outer_it0).first;
@@ -561,7 +641,7 @@ namespace rapter
                         // Promote: check, if patch is large by now
                         if (    ((populations.find(gid) != populations.end()) &&
                                  (populations[gid].size() > static_cast<size_t>(params.patch_population_limit)) )
-                             && (prim.getSpatialSignificance( spatialSignif, points, scale, &(populations[gid]))(0) >= smallThresh  )   )
+                             && ((spatialSignif(0) = significances[promotableId++]) >= smallThresh)   )
                         {
                             // store primitives, that have just been promoted to large from small
                             if ( (prim_status == _PrimitiveT::STATUS_VALUES::SMALL) )
@@ -710,61 +790,79 @@ namespace rapter
 
         DidT maxDid = 0; // collects currently existing maximum cluster id (!small, active, all!)
 
-        GidT gid0, gid1, dir_gid0, dir_gid1, lid0, lid1;
-        gid0 = gid1 = dir_gid0 = dir_gid1 = _PrimitiveT::TAG_UNSET; // group tags cached
+        // flatten the input in iteration order, and index the directions of the primitives, that can take part in a candidate
+        std::vector< std::pair<_PrimitiveT const*,LidT> > flatPrims; // <primitive, lid>
+        processing::DirectionIndex<_Scalar> dirIndex;
         for ( outer_const_iterator outer_it0  = inPrims.begin(); outer_it0 != inPrims.end(); ++outer_it0 )
         {
-            gid0 = -2; // -1 is unset, -2 is unread
-            lid0 =  0;
-            for ( inner_const_iterator inner_it0  = (*outer_it0).second.begin(); inner_it0 != (*outer_it0).second.end(); ++inner_it0, ++lid0 )
+            LidT lid = 0;
+            for ( inner_const_iterator inner_it0  = (*outer_it0).second.begin(); inner_it0 != (*outer_it0).second.end(); ++inner_it0, ++lid )
             {
-                // cache outer primitive
-                _PrimitiveT const& prim0 = *inner_it0;
-                dir_gid0                 = prim0.getTag( _PrimitiveT::TAGS::DIR_GID );
-
-                if ( dir_gid0 > maxDid ) maxDid = dir_gid0; // small, active, uninited!
-
-                // cache group id of patch at first member
-                     if ( gid0 == -2               )  gid0 = prim0.getTag( _PrimitiveT::TAGS::GID ); // store gid of first member in patch
-                else if ( gid0 != outer_it0->first )  std::cerr << "[" << __func__ << "]: " << "Not good, prims under one gid don't have same GID..." << std::endl;
+                _PrimitiveT const& prim = *inner_it0;
+                if ( prim.getTag(_PrimitiveT::TAGS::DIR_GID) > maxDid ) maxDid = prim.getTag( _PrimitiveT::TAGS::DIR_GID ); // small, active, uninited!
+                if ( prim.getTag(_PrimitiveT::TAGS::GID) != outer_it0->first )
+                    std::cerr << "[" << __func__ << "]: " << "Not good, prims under one gid don't have same GID..." << std::endl;
+
+                // small primitives neither give, nor receive candidates in addCandidate
+                if ( notSMALL(prim) )
+                    dirIndex.insert( flatPrims.size(), prim.template dir() );
+                flatPrims.push_back( std::make_pair(&prim, lid) );
+            }
+        }
+        dirIndex.build( angles, angle_limit );
+        if ( verbose ) { std::cout << "[" << __func__ << "]: " << dirIndex.size() << " primitives in " << dirIndex.cellCount() << " direction cells" << std::endl; fflush(stdout); }
+
+        // every unordered pair once, in the order of the nested loops over inPrims, skipping pairs, that fail the angle test of addCandidate anyway.
+        // Workers prepare the candidates of a block of primitives into per-primitive lists, which are then committed in input order,
+        // so the shared bookkeeping (copied, allowedAngles, aliases, DIR_GIDs) evolves exactly as in a sequential run.
+        const LidT flatCount = flatPrims.size();
+        const LidT blockSize = 64 * RAPTER_MAX_OMP_THREADS;
+        std::vector< std::vector<PreparedCandidateT<_PrimitiveT> > > prepared;
+        for ( LidT blockStart = 0; blockStart < flatCount; blockStart += blockSize )
+        {
+            const LidT blockEnd = std::min( flatCount, blockStart + blockSize );
+            prepared.assign( blockEnd - blockStart, std::vector<PreparedCandidateT<_PrimitiveT> >() );
 
-                for ( outer_const_iterator outer_it1  = outer_it0; outer_it1 != inPrims.end(); ++outer_it1 )
+#           pragma omp parallel num_threads(RAPTER_MAX_OMP_THREADS)
+            {
+                std::vector<LidT>               partners;
+                PreparedCandidateT<_PrimitiveT> entry;
+#               pragma omp for schedule(dynamic)
+                for ( LidT id0 = blockStart; id0 < blockEnd; ++id0 )
                 {
-                    gid1 = -2; // -1 is unset, -2 is unread
-                    lid1 = 0;
-                    for ( inner_const_iterator inner_it1  = (outer_it0 == outer_it1) ? ++inner_const_iterator( inner_it0 )
-                                                                                     : (*outer_it1).second.begin();
-                                               inner_it1 != (*outer_it1).second.end();
-                                             ++inner_it1, ++lid1 )
+                    _PrimitiveT const& prim0 = *flatPrims[id0].first;
+                    const LidT         lid0  =  flatPrims[id0].second;
+                    if ( isSMALL(prim0) ) continue;
+
+                    std::vector<PreparedCandidateT<_PrimitiveT> > &out = prepared[ id0 - blockStart ];
+                    dirIndex.query( partners, prim0.template dir(), id0 );
+                    for ( size_t k = 0; k != partners.size(); ++k )
                     {
-                        // cache inner primitive
-                        _PrimitiveT const& prim1 = containers::valueOf<_PrimitiveT>( inner_it1 );
-
-                        // cache group id of patch at first member
-                             if ( gid1 == -2               )    gid1 = prim1.getTag( _PrimitiveT::TAGS::GID );
-                        else if ( gid1 != outer_it1->first )    std::cerr << "[" << __func__ << "]: " << "Not good, prims under one gid don't have same GID in inner loop..." << std::endl;
-
-                        addCandidate<_PrimitivePrimitiveAngleFunctorT>(
-                                    prim0, prim1, lid0, lid1, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
-                                    allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
-                        addCandidate<_PrimitivePrimitiveAngleFunctorT>(
-                                    prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
-                                    allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
-
-//#warning "wasteful 19/4/2015"
-
-//                        AnglesT tmpAngles = AnglesT({0.});
-//                        addCandidate<_PrimitivePrimitiveAngleFunctorT>(
-//                                    prim0, prim1, lid0, lid1, safe_mode, allowPromoted, angle_limit, tmpAngles, angle_gens_in_rad, promoted,
-//                                    allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
-//                        addCandidate<_PrimitivePrimitiveAngleFunctorT>(
-//                                    prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, tmpAngles, angle_gens_in_rad, promoted,
-//                                    allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
-
-                    } //...for l3
-                } //...for l2
-            } //...for l1
-        } //...for l0
+                        const LidT         id1   =  partners[k];
+                        _PrimitiveT const& prim1 = *flatPrims[id1].first;
+                        const LidT         lid1  =  flatPrims[id1].second;
+
+                        entry._receiver = id0; entry._sender = id1;
+                        if ( prepareCandidate<_PrimitivePrimitiveAngleFunctorT>(prim0, prim1, lid0, lid1, safe_mode, allowPromoted, angle_limit, angles, promoted, entry._cand, entry._closestAngleId) )
+                            out.push_back( entry );
+                        entry._receiver = id1; entry._sender = id0;
+                        if ( prepareCandidate<_PrimitivePrimitiveAngleFunctorT>(prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, angles, promoted, entry._cand, entry._closestAngleId) )
+                            out.push_back( entry );
+                    } //...for partners
+                } //...for primitives in block
+            } //...omp parallel
+
+            // reduce in input order
+            for ( size_t i = 0; i != prepared.size(); ++i )
+                for ( size_t j = 0; j != prepared[i].size(); ++j )
+                {
+                    PreparedCandidateT<_PrimitiveT> const& entry = prepared[i][j];
+                    commitCandidate<_PrimitivePrimitiveAngleFunctorT>(
+                                *flatPrims[entry._receiver].first, *flatPrims[entry._sender].first, flatPrims[entry._receiver].second,
+                                entry._cand, entry._closestAngleId, angles, angle_gens_in_rad, promoted,
+                                allowedAngles, copied, generated, nlines, outPrims, points, scale, &aliases, tripletSafe, verbose );
+                }
+        } //...for blocks
         if ( verbose ) { std::cout << "[" << __func__ << "]: " << "generate end" << std::endl; fflush(stdout); }
 
         // ___________ (4) ALIASES _______________
@@ -807,22 +905,29 @@ namespace rapter
                                                   , /*    verbose: */ false
                                                   , /*      inRad: */ true );
 
-                // add all allowed copies
-                for ( outer_const_iterator outer_it  = inPrims.begin(); outer_it != inPrims.end(); ++outer_it )
+                // add all allowed copies, receivers in input order, that can pass the angle test
+                std::vector<LidT> receivers;
+                dirIndex.query( receivers, prim0.template dir(), -1 );
+                std::vector<PreparedCandidateT<_PrimitiveT> > entries( receivers.size() );
+                std::vector<char>                             passed ( receivers.size(), 0 );
+#               pragma omp parallel for schedule(dynamic,16) num_threads(RAPTER_MAX_OMP_THREADS)
+                for ( LidT k = 0; k < static_cast<LidT>(receivers.size()); ++k )
                 {
-                    lid1 =  0;
-                    for ( inner_const_iterator inner_it = (*outer_it).second.begin(); inner_it != (*outer_it).second.end(); ++inner_it, ++lid1 )
-                    {
-                        // cache outer primitive
-                        _PrimitiveT const& prim1 = *inner_it;
+                    _PrimitiveT const& prim1 = *flatPrims[ receivers[k] ].first;
+                    const LidT         lid1  =  flatPrims[ receivers[k] ].second;
+                    passed[k] = prepareCandidate<_PrimitivePrimitiveAngleFunctorT>( prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, angles, promoted,
+                                                                                    entries[k]._cand, entries[k]._closestAngleId );
+                }
 
-                        // copy prim0 (the alias) to all compatible receivers given allowedAngles.
-                        addCandidate<_PrimitivePrimitiveAngleFunctorT,AliasesT<_PrimitiveT,_Scalar> >(
-                            prim1, prim0, lid1, lid0, safe_mode, allowPromoted, angle_limit, angles, angle_gens_in_rad, promoted,
-                            allowedAngles, copied, generated, nlines, outPrims, points, scale, nullptr, tripletSafe, verbose );
+                for ( size_t k = 0; k != receivers.size(); ++k )
+                {
+                    if ( !passed[k] ) continue;
 
-                    } //...inner for
-                } //...outer for
+                    // copy prim0 (the alias) to all compatible receivers given allowedAngles.
+                    commitCandidate<_PrimitivePrimitiveAngleFunctorT,AliasesT<_PrimitiveT,_Scalar> >(
+                        *flatPrims[ receivers[k] ].first, prim0, flatPrims[ receivers[k] ].second, entries[k]._cand, entries[k]._closestAngleId,
+                        angles, angle_gens_in_rad, promoted, allowedAngles, copied, generated, nlines, outPrims, points, scale, nullptr, tripletSafe, verbose );
+                } //...for receivers
             } //...for all angles
         } //...for all aliases
         if ( verbose ) { std::cout << "[" << __func__ << "]: " << "alias end" << std::endl; fflush(stdout); }
@@ -969,7 +1074,8 @@ namespace rapter
     /*! \brief                  Step 1. Generates primitives from a cloud. Reads "cloud.ply" and saves "candidates.csv".
      *  \param argc             Contains --cloud cloud.ply, and --scale scale.
      *  \param argv             Contains --cloud cloud.ply, and --scale scale.
-     *  \return                 EXIT_SUCCESS.
+     *  \param[out] remaining   Count of the small patches, that are left to promote on this threshold.
+     *  \return                 EXIT_SUCCESS or EXIT_FAILURE, if \p remaining is given, otherwise the larger of the error and the remaining count.
      */
     template < class    _PrimitiveContainerT
              , class    _PointContainerT
@@ -979,11 +1085,13 @@ namespace rapter
              >
     int
     CandidateGenerator::generateCli( int    argc
-                                   , char** argv )
+                                   , char** argv
+                                   , int   *remaining )
     {
         typedef typename _PrimitiveContainerT::value_type InnerPrimitiveContainerT;
         //typedef typename PointContainerT::value_type PointPrimitiveT;
         int err = EXIT_SUCCESS;
+        if ( remaining ) *remaining = 0;
 
         CandidateGeneratorParams<_Scalar> generatorParams;
         std::string                 cloud_path              = "./cloud.ply";
@@ -1251,6 +1359,11 @@ namespace rapter
 
 //        if ( attempts > 1 )
 //            return 1;
+        if ( remaining )
+        {
+            *remaining = std::max( ret, 0 );
+            return err;
+        }
         return std::max(ret,err);
     } // ...CandidateGenerator::generateCli()
 
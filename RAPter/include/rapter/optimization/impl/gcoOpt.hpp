@@ -0,0 +1,281 @@
+#ifndef RAPTER_GCOOPT_HPP
+#define RAPTER_GCOOPT_HPP
+
+#include <algorithm> // sort, max
+#include <cmath>     // abs
+#include <iostream>
+#include <map>
+#include <set>
+#include "rapter/optimization/gcoOpt.h"
+
+namespace rapter {
+
+namespace gcoOpt
+{
+    //! \brief Largest cost handed to gco, well below GCO_MAX_ENERGYTERM, so that summed terms don't overflow.
+    static const double MAX_TERM = 1e6;
+} //...ns gcoOpt
+
+template <typename _Scalar> int
+GcoOpt<_Scalar>::update( bool verbose )
+{
+    typedef typename ParentType::BOUND    BOUND;
+
+    _verbose = verbose;
+    const LidT varCount = this->getVarCount();
+
+    if ( (static_cast<LidT>(_varSites.size()) != varCount) || (static_cast<LidT>(_varLabels.size()) != varCount) )
+    {
+        std::cerr << "[" << __func__ << "]: " << "every variable needs a site and a label, got " << _varSites.size() << " for " << varCount
+                  << " variables. Only --no-clusters problems with --candidates are supported" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    for ( LidT j = 0; j != varCount; ++j )
+    {
+        const BOUND bound = this->getVarBoundType( j );
+        if (    (bound == BOUND::FREE) || (bound == BOUND::GREATER_EQ) || (bound == BOUND::LESS_EQ)
+             || (this->getVarLowerBound(j) < _Scalar(0)) || (this->getVarUpperBound(j) > _Scalar(1)) )
+        {
+            std::cerr << "[" << __func__ << "]: " << "variable " << j << " is not binary, alpha-expansion only solves 0/1 problems" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    // compact sites and labels
+    std::map<LidT,LidT> sites, labels;
+    for ( LidT j = 0; j != varCount; ++j )
+    {
+        sites .insert( std::make_pair(_varSites [j], LidT(sites .size())) );
+        labels.insert( std::make_pair(_varLabels[j], LidT(labels.size())) );
+    }
+    _labelCount = labels.size();
+
+    _siteIds .resize( varCount );
+    _labelIds.resize( varCount );
+    _siteLabelVars.assign( sites.size(), std::vector< std::pair<LidT,LidT> >() );
+    for ( LidT j = 0; j != varCount; ++j )
+    {
+        _siteIds [j] = sites .at( _varSites [j] );
+        _labelIds[j] = labels.at( _varLabels[j] );
+        _siteLabelVars[ _siteIds[j] ].push_back( std::make_pair(_labelIds[j], j) );
+    }
+    for ( size_t s = 0; s != _siteLabelVars.size(); ++s )
+        std::sort( _siteLabelVars[s].begin(), _siteLabelVars[s].end() );
+
+    // data: linear and diagonal terms without the complexity, shifted to 0 per site, since every site takes exactly one label
+    _data = this->getLinObjectives();
+    _data.resize( varCount, _Scalar(0) );
+    for ( LidT j = 0; j != varCount; ++j )
+        _data[j] -= _labelCost;
+
+    _pairwise.clear();
+    std::set< std::pair<LidT,LidT> > neighbours;
+    LidT inSite = 0;
+    const SparseMatrix qo = this->getQuadraticObjectivesMatrix();
+    for ( LidT row = 0; row < qo.outerSize(); ++row )
+        for ( typename SparseMatrix::InnerIterator it(qo, row); it; ++it )
+        {
+            const LidT a = it.row(), b = it.col();
+            if ( a == b )
+                _data[a] += it.value();
+            else if ( _siteIds[a] == _siteIds[b] )
+                ++inSite; // never both selected
+            else
+            {
+                _pairwise[ static_cast<unsigned long long>(a) * varCount + b ] += it.value();
+                _pairwise[ static_cast<unsigned long long>(b) * varCount + a ] += it.value();
+                neighbours.insert( std::make_pair(std::min(_siteIds[a], _siteIds[b]), std::max(_siteIds[a], _siteIds[b])) );
+            }
+        }
+    _neighbours.assign( neighbours.begin(), neighbours.end() );
+
+    for ( size_t s = 0; s != _siteLabelVars.size(); ++s )
+    {
+        _Scalar minData = _data[ _siteLabelVars[s].front().second ];
+        for ( size_t k = 1; k < _siteLabelVars[s].size(); ++k )
+            minData = std::min( minData, _data[_siteLabelVars[s][k].second] );
+        for ( size_t k = 0; k != _siteLabelVars[s].size(); ++k )
+            _data[ _siteLabelVars[s][k].second ] -= minData;
+    }
+
+    // scale
+    _Scalar maxTerm = std::abs( _labelCost );
+    for ( LidT j = 0; j != varCount; ++j )
+        maxTerm = std::max( maxTerm, std::abs(_data[j]) );
+    for ( typename std::unordered_map<unsigned long long,_Scalar>::const_iterator it = _pairwise.begin(); it != _pairwise.end(); ++it )
+        maxTerm = std::max( maxTerm, std::abs(it->second) );
+    _scale = std::max( _Scalar(1), maxTerm / _Scalar(gcoOpt::MAX_TERM) );
+
+    if ( verbose )
+        std::cout << "[" << __func__ << "]: " << sites.size() << " sites, " << _labelCount << " labels, " << _neighbours.size() << " neighbouring site pairs, "
+                  << inSite << " pairwise terms within sites ignored, costs divided by " << _scale << std::endl;
+
+    this->_updated = true;
+    return EXIT_SUCCESS;
+} //...update()
+
+template <typename _Scalar> inline LidT
+GcoOpt<_Scalar>::variable( LidT const site, LidT const label ) const
+{
+    std::vector< std::pair<LidT,LidT> > const& labelVars = _siteLabelVars[ site ];
+    typename std::vector< std::pair<LidT,LidT> >::const_iterator it = std::lower_bound( labelVars.begin(), labelVars.end(), std::make_pair(label, LidT(-1)) );
+    return ( (it != labelVars.end()) && (it->first == label) ) ? it->second : -1;
+} //...variable()
+
+template <typename _Scalar> gco::GCoptimization::EnergyTermType
+GcoOpt<_Scalar>::smoothCost( int s1, int s2, int l1, int l2, void *data )
+{
+    GcoOpt<_Scalar> const* self = static_cast<GcoOpt<_Scalar> const*>( data );
+    const LidT a = self->variable( s1, l1 ), b = self->variable( s2, l2 );
+    if ( (a < 0) || (b < 0) ) // label not allowed at the site, its data cost is infinite already
+        return 0;
+
+    typename std::unordered_map<unsigned long long,_Scalar>::const_iterator it = self->_pairwise.find( static_cast<unsigned long long>(a) * self->_siteIds.size() + b );
+    return it == self->_pairwise.end() ? 0 : it->second / self->_scale;
+} //...smoothCost()
+
+template <typename _Scalar> LidT
+GcoOpt<_Scalar>::countViolations( std::vector<_Scalar> const& x ) const
+{
+    typedef typename ParentType::BOUND BOUND;
+
+    const LidT constrCount = this->getConstraintCount();
+    std::vector<_Scalar> activity( constrCount, _Scalar(0) );
+
+    const SparseMatrix A = this->getLinConstraintsMatrix();
+    for ( LidT row = 0; row < A.outerSize(); ++row )
+        for ( typename SparseMatrix::InnerIterator it(A, row); it; ++it )
+            activity[ it.row() ] += it.value() * x[ it.col() ];
+
+    for ( LidT c = 0; c != static_cast<LidT>(this->getQuadraticConstraints().size()); ++c )
+    {
+        typename ParentType::SparseEntries const& entries = this->getQuadraticConstraints( c );
+        for ( size_t k = 0; k != entries.size(); ++k )
+            activity[c] += entries[k].value() * x[ entries[k].row() ] * x[ entries[k].col() ];
+    }
+
+    const _Scalar eps = 1e-6;
+    LidT violated = 0;
+    for ( LidT c = 0; c != constrCount; ++c )
+    {
+        const BOUND bound = this->getConstraintBoundType( c );
+        if (    ( ((bound == BOUND::GREATER_EQ) || (bound == BOUND::RANGE) || (bound == BOUND::EQUAL)) && (activity[c] < this->getConstraintLowerBound(c) - eps) )
+             || ( ((bound == BOUND::LESS_EQ   ) || (bound == BOUND::RANGE) || (bound == BOUND::EQUAL)) && (activity[c] > this->getConstraintUpperBound(c) + eps) ) )
+            ++violated;
+    }
+    return violated;
+} //...countViolations()
+
+template <typename _Scalar> int
+GcoOpt<_Scalar>::optimize( std::vector<_Scalar> *x_out, OBJ_SENSE objective_sense )
+{
+    typedef gco::GCoptimization::EnergyTermType EnergyTermType;
+
+    if ( !this->_updated )
+    {
+        std::cerr << "[" << __func__ << "]: " << "call update() first" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if ( objective_sense != ParentType::MINIMIZE )
+    {
+        std::cerr << "[" << __func__ << "]: " << "alpha-expansion only minimizes" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const LidT varCount   = this->getVarCount();
+    const LidT siteCount  = _siteLabelVars.size();
+    const LidT labelCount = std::max( LidT(2), _labelCount ); // gco needs two labels, an unused one is never chosen
+
+    // sparse data costs, sites ascending per label
+    std::vector< std::vector<gco::GCoptimization::SparseDataCost> > dataCosts( labelCount );
+    for ( LidT s = 0; s != siteCount; ++s )
+        for ( size_t k = 0; k != _siteLabelVars[s].size(); ++k )
+        {
+            gco::GCoptimization::SparseDataCost cost = { static_cast<int>(s), static_cast<EnergyTermType>(_data[_siteLabelVars[s][k].second] / _scale) };
+            dataCosts[ _siteLabelVars[s][k].first ].push_back( cost );
+        }
+
+    // initial labeling: the starting point, or the cheapest candidate
+    std::vector<int> labeling( siteCount );
+    {
+        const bool useStart = this->isUseStartingPoint() && (this->getStartingPoint().size() == varCount);
+        for ( LidT s = 0; s != siteCount; ++s )
+        {
+            LidT best = 0;
+            for ( size_t k = 1; k < _siteLabelVars[s].size(); ++k )
+            {
+                const LidT var = _siteLabelVars[s][k].second, bestVar = _siteLabelVars[s][best].second;
+                if ( useStart ? (this->getStartingPoint()(var) > this->getStartingPoint()(bestVar)) : (_data[var] < _data[bestVar]) )
+                    best = k;
+            }
+            labeling[s] = _siteLabelVars[s][best].first;
+        }
+    }
+
+    // expansion with label costs first, swaps from where it stopped, if a smooth cost is not a metric
+    bool done = false;
+    for ( int pass = 0; (pass != 2) && !done; ++pass )
+    {
+        const bool expansion = (pass == 0);
+        gco::GCoptimizationGeneralGraph *gc = NULL;
+        try
+        {
+            gc = new gco::GCoptimizationGeneralGraph( siteCount, labelCount );
+            for ( LidT l = 0; l != labelCount; ++l )
+                if ( dataCosts[l].size() )
+                    gc->setDataCost( l, &dataCosts[l][0], dataCosts[l].size() );
+            gc->setSmoothCost( &GcoOpt<_Scalar>::smoothCost, this );
+            if ( expansion && (_labelCost > _Scalar(0)) )
+                gc->setLabelCost( static_cast<EnergyTermType>(_labelCost / _scale) );
+            for ( size_t i = 0; i != _neighbours.size(); ++i )
+                gc->setNeighbors( _neighbours[i].first, _neighbours[i].second );
+            for ( LidT s = 0; s != siteCount; ++s )
+                gc->setLabel( s, labeling[s] );
+
+            if ( _verbose ) std::cout << "[" << __func__ << "]: " << (expansion ? "expansion" : "swap") << " energy before: " << gc->compute_energy() * _scale;
+            if ( expansion ) gc->expansion( _maxIterations );
+            else             gc->swap     ( _maxIterations );
+            if ( _verbose ) std::cout << ", after: " << gc->compute_energy() * _scale << std::endl;
+
+            for ( LidT s = 0; s != siteCount; ++s )
+                labeling[s] = gc->whatLabel( s );
+            done = true;
+        }
+        catch ( gco::GCException e )
+        {
+            // the labeling of the last finished move is kept in gc
+            if ( gc )
+                for ( LidT s = 0; s != siteCount; ++s )
+                    labeling[s] = gc->whatLabel( s );
+            std::cerr << "[" << __func__ << "]: " << e.message << (expansion ? ", continuing with alpha-beta swaps" : ", keeping the current labeling") << std::endl;
+        }
+        if ( gc ) { delete gc; gc = NULL; }
+    }
+
+    // output
+    std::vector<_Scalar> x( varCount, _Scalar(0) );
+    for ( LidT s = 0; s != siteCount; ++s )
+    {
+        const LidT var = this->variable( s, labeling[s] );
+        if ( var >= 0 )
+            x[ var ] = _Scalar(1);
+    }
+
+    this->setSolution( Eigen::Map<typename ParentType::VectorX const>(x.data(), varCount) );
+    if ( x_out )
+        *x_out = x;
+
+    const LidT violated = countViolations( x );
+    if ( violated )
+    {
+        std::cerr << "[" << __func__ << "]: " << "the labeling violates " << violated << " constraints, alpha-expansion only handles \"at least one direction per patch\" problems" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+} //...optimize()
+
+} //...ns rapter
+
+#endif // RAPTER_GCOOPT_HPP
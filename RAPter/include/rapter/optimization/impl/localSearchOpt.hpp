@@ -0,0 +1,442 @@
+#ifndef RAPTER_LOCALSEARCHOPT_HPP
+#define RAPTER_LOCALSEARCHOPT_HPP
+
+#include <algorithm> // sort, unique, max
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include "omp.h"
+#include "rapter/optimization/localSearchOpt.h"
+
+namespace rapter {
+
+namespace localSearch
+{
+    //! \brief Violation and objective differences below this are ties.
+    static const double EPS = 1e-9;
+
+    //! \brief Constraints with more variables are not scanned for 2-swap partners, only 1-flips change them.
+    static const size_t MAX_SWAP_MEMBERS = 256;
+} //...ns localSearch
+
+template <typename _Scalar> int
+LocalSearchOpt<_Scalar>::update( bool verbose )
+{
+    typedef typename ParentType::BOUND    BOUND;
+    typedef typename ParentType::VAR_TYPE VAR_TYPE;
+    typedef Eigen::Triplet<_Scalar>       Triplet;
+
+    _verbose = verbose;
+    const LidT varCount    = this->getVarCount();
+    const LidT constrCount = this->getConstraintCount();
+
+    // variables
+    _fixed.assign( varCount, false );
+    LidT continuousCount = 0;
+    for ( LidT j = 0; j != varCount; ++j )
+    {
+        const BOUND bound = this->getVarBoundType( j );
+        if (    (bound == BOUND::FREE) || (bound == BOUND::GREATER_EQ) || (bound == BOUND::LESS_EQ)
+             || (this->getVarLowerBound(j) < _Scalar(0)) || (this->getVarUpperBound(j) > _Scalar(1)) )
+        {
+            std::cerr << "[" << __func__ << "]: " << "variable " << j << " is not binary, the local search only solves 0/1 problems" << std::endl;
+            return EXIT_FAILURE;
+        }
+        _fixed[j] = (bound == BOUND::EQUAL) || (this->getVarLowerBound(j) == this->getVarUpperBound(j));
+        continuousCount += (this->getVarType(j) == VAR_TYPE::CONTINUOUS);
+    }
+    if ( continuousCount )
+        std::cerr << "[" << __func__ << "]: " << "treating " << continuousCount << " continuous [0,1] variables as binary" << std::endl;
+
+    // objective: linear and diagonal terms per variable, symmetric off-diagonal neighbours
+    {
+        _lin = this->getLinObjectives();
+        _lin.resize( varCount, _Scalar(0) );
+
+        const SparseMatrix qo = this->getQuadraticObjectivesMatrix();
+        std::vector<Triplet> entries;
+        entries.reserve( 2 * qo.nonZeros() );
+        for ( LidT row = 0; row < qo.outerSize(); ++row )
+            for ( typename SparseMatrix::InnerIterator it(qo, row); it; ++it )
+            {
+                if ( it.row() == it.col() )
+                    _lin[ it.row() ] += it.value();
+                else
+                {
+                    entries.push_back( Triplet(it.row(), it.col(), it.value()) );
+                    entries.push_back( Triplet(it.col(), it.row(), it.value()) );
+                }
+            }
+        _qSym.resize( varCount, varCount );
+        _qSym.setFromTriplets( entries.begin(), entries.end() );
+    }
+
+    // constraints
+    {
+        _aT = this->getLinConstraintsMatrix().transpose();
+        _aT.makeCompressed();
+
+        _members.assign( constrCount, std::vector<LidT>() );
+        for ( LidT var = 0; var < _aT.outerSize(); ++var )
+            for ( typename SparseMatrix::InnerIterator it(_aT, var); it; ++it )
+                _members[ it.col() ].push_back( var );
+
+        _qTerms.assign( varCount, std::vector<QTerm>() );
+        for ( LidT c = 0; c != static_cast<LidT>(this->getQuadraticConstraints().size()); ++c )
+        {
+            typename ParentType::SparseEntries const& entries = this->getQuadraticConstraints( c );
+            for ( size_t k = 0; k != entries.size(); ++k )
+            {
+                const LidT i = entries[k].row(), j = entries[k].col();
+                QTerm term = { c, j, entries[k].value() };
+                _qTerms[i].push_back( term );
+                _members[c].push_back( i );
+                if ( i != j )
+                {
+                    term.other = i;
+                    _qTerms[j].push_back( term );
+                    _members[c].push_back( j );
+                }
+            }
+        }
+        for ( LidT c = 0; c != constrCount; ++c )
+        {
+            std::sort( _members[c].begin(), _members[c].end() );
+            _members[c].erase( std::unique(_members[c].begin(), _members[c].end()), _members[c].end() );
+        }
+
+        _lower.resize( constrCount );
+        _upper.resize( constrCount );
+        for ( LidT c = 0; c != constrCount; ++c )
+        {
+            const BOUND bound = this->getConstraintBoundType( c );
+            const bool  hasLower = (bound == BOUND::GREATER_EQ) || (bound == BOUND::RANGE) || (bound == BOUND::EQUAL);
+            const bool  hasUpper = (bound == BOUND::LESS_EQ   ) || (bound == BOUND::RANGE) || (bound == BOUND::EQUAL);
+            _lower[c] = hasLower ? this->getConstraintLowerBound(c) : -std::numeric_limits<_Scalar>::infinity();
+            _upper[c] = hasUpper ? this->getConstraintUpperBound(c) :  std::numeric_limits<_Scalar>::infinity();
+        }
+    }
+
+    if ( verbose )
+        std::cout << "[" << __func__ << "]: " << varCount << " variables, " << _qSym.nonZeros() / 2 << " pairwise terms, " << constrCount << " constraints" << std::endl;
+
+    this->_updated = true;
+    return EXIT_SUCCESS;
+} //...update()
+
+template <typename _Scalar> void
+LocalSearchOpt<_Scalar>::accumulate( LidT const var, LidT const flipped, Scratch &scratch ) const
+{
+    const _Scalar sign = valueAfter( var, flipped ) ? _Scalar(-1) : _Scalar(1);
+
+    for ( typename SparseMatrix::InnerIterator it(_aT, var); it; ++it )
+    {
+        if ( !scratch.seen[it.col()] ) { scratch.seen[it.col()] = true; scratch.touched.push_back( it.col() ); }
+        scratch.delta[ it.col() ] += sign * it.value();
+    }
+
+    std::vector<QTerm> const& terms = _qTerms[ var ];
+    for ( size_t k = 0; k != terms.size(); ++k )
+    {
+        // x_var * x_var == x_var
+        if ( (terms[k].other != var) && !valueAfter(terms[k].other, flipped) )
+            continue;
+
+        if ( !scratch.seen[terms[k].constr] ) { scratch.seen[terms[k].constr] = true; scratch.touched.push_back( terms[k].constr ); }
+        scratch.delta[ terms[k].constr ] += sign * terms[k].coeff;
+    }
+} //...accumulate()
+
+template <typename _Scalar> _Scalar
+LocalSearchOpt<_Scalar>::objectiveDelta( LidT const var, LidT const flipped ) const
+{
+    _Scalar grad = _grad[ var ];
+    if ( (flipped >= 0) && (flipped != var) )
+        grad += (_x[flipped] ? _Scalar(-1) : _Scalar(1)) * _qSym.coeff( var, flipped );
+
+    return _sign * (valueAfter(var, flipped) ? _Scalar(-1) : _Scalar(1)) * (_lin[var] + grad);
+} //...objectiveDelta()
+
+template <typename _Scalar> _Scalar
+LocalSearchOpt<_Scalar>::collectViolation( Scratch &scratch ) const
+{
+    _Scalar dViol = _Scalar( 0 );
+    for ( size_t k = 0; k != scratch.touched.size(); ++k )
+    {
+        const LidT c = scratch.touched[k];
+        dViol += violation( c, _activity[c] + scratch.delta[c] ) - violation( c, _activity[c] );
+        scratch.delta[c] = _Scalar( 0 );
+        scratch.seen [c] = false;
+    }
+    scratch.touched.clear();
+
+    return dViol;
+} //...collectViolation()
+
+template <typename _Scalar> typename LocalSearchOpt<_Scalar>::Move
+LocalSearchOpt<_Scalar>::evaluate( LidT const first, LidT const second, Scratch &scratch ) const
+{
+    Move move;
+    (_x[first] ? move.off : move.on) = first;
+    accumulate( first, -1, scratch );
+    move.dObj = objectiveDelta( first, -1 );
+
+    if ( second >= 0 )
+    {
+        (_x[second] ? move.off : move.on) = second;
+        accumulate( second, first, scratch );
+        move.dObj += objectiveDelta( second, first );
+    }
+
+    move.dViol = collectViolation( scratch );
+    return move;
+} //...evaluate()
+
+template <typename _Scalar> void
+LocalSearchOpt<_Scalar>::flip( LidT const var, Scratch &scratch )
+{
+    accumulate( var, -1, scratch );
+    for ( size_t k = 0; k != scratch.touched.size(); ++k )
+    {
+        const LidT c = scratch.touched[k];
+        _activity[c]     += scratch.delta[c];
+        scratch.delta[c]  = _Scalar( 0 );
+        scratch.seen [c]  = false;
+    }
+    scratch.touched.clear();
+
+    const _Scalar sign = _x[var] ? _Scalar(-1) : _Scalar(1);
+    for ( typename SparseMatrix::InnerIterator it(_qSym, var); it; ++it )
+        _grad[ it.col() ] += sign * it.value();
+    _x[var] = !_x[var];
+} //...flip()
+
+template <typename _Scalar> bool
+LocalSearchOpt<_Scalar>::isBetter( Move const& a, Move const& b )
+{
+    if ( a.dViol < b.dViol - localSearch::EPS ) return true;
+    if ( a.dViol > b.dViol + localSearch::EPS ) return false;
+    if ( a.dObj  != b.dObj                    ) return a.dObj < b.dObj;
+    // ties are broken by variable id, so that the result does not depend on the thread count
+    return (a.on < b.on) || ((a.on == b.on) && (a.off < b.off));
+} //...isBetter()
+
+template <typename _Scalar> int
+LocalSearchOpt<_Scalar>::optimize( std::vector<_Scalar> *x_out, OBJ_SENSE objective_sense )
+{
+    using localSearch::EPS;
+    typedef std::chrono::steady_clock Clock;
+
+    if ( !this->_updated )
+    {
+        std::cerr << "[" << __func__ << "]: " << "call update() first" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const Clock::time_point start       = Clock::now();
+    const LidT              varCount    = this->getVarCount();
+    const LidT              constrCount = this->getConstraintCount();
+    const int               threadCount = RAPTER_MAX_OMP_THREADS;
+    _sign = (objective_sense == ParentType::MAXIMIZE) ? _Scalar(-1) : _Scalar(1);
+
+    // start from the starting point, or from nothing selected
+    _x.assign( varCount, false );
+    for ( LidT j = 0; j != varCount; ++j )
+    {
+        if ( _fixed[j] )
+            _x[j] = this->getVarLowerBound( j ) > _Scalar( .5 );
+        else if ( this->isUseStartingPoint() && (this->getStartingPoint().size() == varCount) )
+            _x[j] = this->getStartingPoint()( j ) > _Scalar( .5 );
+    }
+
+    // gradient, activities, violation and objective of the start
+    _grad.assign( varCount, _Scalar(0) );
+    _activity.assign( constrCount, _Scalar(0) );
+    _Scalar objective = _Scalar( 0 );
+    for ( LidT j = 0; j != varCount; ++j )
+    {
+        if ( !_x[j] ) continue;
+
+        objective += _lin[j];
+        for ( typename SparseMatrix::InnerIterator it(_qSym, j); it; ++it )
+            _grad[ it.col() ] += it.value();
+        for ( typename SparseMatrix::InnerIterator it(_aT, j); it; ++it )
+            _activity[ it.col() ] += it.value();
+        for ( size_t k = 0; k != _qTerms[j].size(); ++k )
+            if ( (_qTerms[j][k].other <= j) && _x[_qTerms[j][k].other] ) // each entry once
+                _activity[ _qTerms[j][k].constr ] += _qTerms[j][k].coeff;
+    }
+    for ( LidT j = 0; j != varCount; ++j )
+        if ( _x[j] )
+            objective += _Scalar( .5 ) * _grad[j]; // each pair was counted at both ends
+    objective *= _sign;
+
+    _Scalar viol = _Scalar( 0 );
+    for ( LidT c = 0; c != constrCount; ++c )
+        viol += violation( c, _activity[c] );
+
+    std::vector<Scratch> scratches( threadCount );
+    for ( int tid = 0; tid != threadCount; ++tid )
+    {
+        scratches[tid].delta.assign( constrCount, _Scalar(0) );
+        scratches[tid].seen .assign( constrCount, false );
+    }
+
+    auto isImproving = []( Move const& move ) -> bool { return (move.dViol < -EPS) || ((move.dViol <= EPS) && (move.dObj < -EPS)); };
+
+    // greedy descent: evaluate all 1-flips in parallel, apply the improving ones best first, each re-evaluated after the ones before it
+    LidT greedyMoves = 0;
+    for ( bool changed = true; changed; )
+    {
+        std::vector< std::vector<Move> > candidates( threadCount );
+#       pragma omp parallel for num_threads(threadCount) schedule(dynamic,256)
+        for ( LidT j = 0; j < varCount; ++j )
+        {
+            if ( _fixed[j] ) continue;
+
+            const Move move = evaluate( j, -1, scratches[omp_get_thread_num()] );
+            if ( isImproving(move) )
+                candidates[ omp_get_thread_num() ].push_back( move );
+        }
+        for ( int tid = 1; tid < threadCount; ++tid )
+            candidates[0].insert( candidates[0].end(), candidates[tid].begin(), candidates[tid].end() );
+        std::sort( candidates[0].begin(), candidates[0].end(), &LocalSearchOpt<_Scalar>::isBetter );
+
+        changed = false;
+        for ( size_t k = 0; k != candidates[0].size(); ++k )
+        {
+            const LidT var  = std::max( candidates[0][k].on, candidates[0][k].off );
+            const Move move = evaluate( var, -1, scratches[0] );
+            if ( !isImproving(move) ) continue;
+
+            flip( var, scratches[0] );
+            viol      += move.dViol;
+            objective += move.dObj;
+            changed    = true;
+            ++greedyMoves;
+        }
+
+        const double elapsed = std::chrono::duration<double>( Clock::now() - start ).count();
+        if ( (this->getTimeLimit() > _Scalar(0)) && (elapsed > this->getTimeLimit()) ) break;
+    } //...greedy
+    if ( viol < EPS ) viol = _Scalar( 0 );
+    if ( _verbose )
+        std::cout << "[" << __func__ << "]: " << "greedy descent made " << greedyMoves << " moves, objective " << _sign * objective << ", violation " << viol << std::endl;
+
+    // tabu search: take the best 1-flip or 2-swap, that does not flip a recently flipped variable, even if it is worse
+    std::vector<char>   best        = _x;
+    _Scalar             bestViol    = viol;
+    _Scalar             bestObj     = objective;
+    std::vector<LidT>   tabuUntil( varCount, 0 );
+    std::vector<LidT>   selected;
+    LidT                iteration   = 0, lastImprovement = 0;
+    for ( ; iteration < _maxIterations; ++iteration )
+    {
+        const double elapsed = std::chrono::duration<double>( Clock::now() - start ).count();
+        if ( (this->getTimeLimit() > _Scalar(0)) && (elapsed > this->getTimeLimit()) ) break;
+        if ( iteration - lastImprovement > _stagnationLimit )                           break;
+
+        selected.clear();
+        for ( LidT j = 0; j != varCount; ++j )
+            if ( _x[j] && !_fixed[j] )
+                selected.push_back( j );
+
+        auto isAdmissible = [&]( Move const& move ) -> bool
+        {
+            const bool isTabu =    ((move.on  >= 0) && (tabuUntil[move.on ] > iteration))
+                                || ((move.off >= 0) && (tabuUntil[move.off] > iteration));
+            // aspiration: always allow a new best feasible solution
+            return !isTabu || ((viol + move.dViol <= EPS) && (objective + move.dObj < bestObj - EPS));
+        };
+
+        std::vector<Move> threadBest ( threadCount );
+        std::vector<char> threadFound( threadCount, false );
+#       pragma omp parallel num_threads(threadCount)
+        {
+            const int tid     = omp_get_thread_num();
+            Scratch  &scratch = scratches[ tid ];
+            Move     &myBest  = threadBest[ tid ];
+            char     &found   = threadFound[ tid ];
+
+            // 1-flips
+#           pragma omp for schedule(dynamic,256) nowait
+            for ( LidT j = 0; j < varCount; ++j )
+            {
+                if ( _fixed[j] ) continue;
+
+                const Move move = evaluate( j, -1, scratch );
+                if ( isAdmissible(move) && (!found || isBetter(move, myBest)) ) { myBest = move; found = true; }
+            }
+
+            // 2-swaps: a selected variable off, an unselected one sharing a constraint on
+#           pragma omp for schedule(dynamic,16)
+            for ( LidT s = 0; s < static_cast<LidT>(selected.size()); ++s )
+            {
+                const LidT off = selected[s];
+                auto tryPartners = [&]( LidT const c )
+                {
+                    if ( _members[c].size() > localSearch::MAX_SWAP_MEMBERS ) return;
+                    for ( size_t k = 0; k != _members[c].size(); ++k )
+                    {
+                        const LidT on = _members[c][k];
+                        if ( _x[on] || _fixed[on] ) continue;
+
+                        const Move move = evaluate( off, on, scratch );
+                        if ( isAdmissible(move) && (!found || isBetter(move, myBest)) ) { myBest = move; found = true; }
+                    }
+                };
+                for ( typename SparseMatrix::InnerIterator it(_aT, off); it; ++it )
+                    tryPartners( it.col() );
+                for ( size_t k = 0; k != _qTerms[off].size(); ++k )
+                    tryPartners( _qTerms[off][k].constr );
+            } //...for selected
+        } //...omp parallel
+
+        Move move;
+        bool found = false;
+        for ( int tid = 0; tid != threadCount; ++tid )
+            if ( threadFound[tid] && (!found || isBetter(threadBest[tid], move)) ) { move = threadBest[tid]; found = true; }
+        if ( !found ) break; // everything is tabu
+
+        // apply
+        if ( move.off >= 0 ) { flip( move.off, scratches[0] ); tabuUntil[ move.off ] = iteration + _tabuTenure; }
+        if ( move.on  >= 0 ) { flip( move.on , scratches[0] ); tabuUntil[ move.on  ] = iteration + _tabuTenure; }
+        viol      += move.dViol;
+        objective += move.dObj;
+        if ( viol < EPS ) viol = _Scalar( 0 );
+
+        // keep the best: feasibility first, objective second
+        if (    ((viol <= EPS) && ((bestViol > EPS) || (objective < bestObj - EPS)))
+             || ((bestViol > EPS) && (viol < bestViol - EPS)) )
+        {
+            best            = _x;
+            bestViol        = viol;
+            bestObj         = objective;
+            lastImprovement = iteration;
+        }
+    } //...for iterations
+
+    _x = best;
+    typename ParentType::VectorX solution( varCount );
+    for ( LidT j = 0; j != varCount; ++j )
+        solution( j ) = _x[j] ? _Scalar(1) : _Scalar(0);
+    this->setSolution( solution );
+    if ( x_out )
+        x_out->assign( solution.data(), solution.data() + varCount );
+
+    std::cout << "[" << __func__ << "]: " << "local search finished after " << greedyMoves << " greedy moves and " << iteration << " tabu iterations, "
+              << std::chrono::duration<double>( Clock::now() - start ).count() << " s"
+              << ", objective " << _sign * bestObj << ", violation " << bestViol
+              << ", " << std::count(_x.begin(), _x.end(), true) << "/" << varCount << " selected" << std::endl;
+
+    if ( bestViol > EPS )
+    {
+        std::cerr << "[" << __func__ << "]: " << "no feasible solution found" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+} //...optimize()
+
+} //...ns rapter
+
+#endif // RAPTER_LOCALSEARCHOPT_HPP
@@ -2,6 +2,7 @@
 #define RAPTER_MERGING_HPP
 
 #include <iostream>
+#include <unordered_set>
 
 #include "rapter/util/parse.h"
 
@@ -16,6 +17,7 @@
 #include "rapter/processing/impl/angleUtil.hpp" // appendAngles...
 #include "rapter/optimization/patchDistanceFunctors.h" // RepresentativeSqrPatchPatchDistanceFunctorT
 #include "rapter/util/util.hpp"
+#include "rapter/processing/boxBvh.hpp"         // BoxBvh
 #include "omp.h"
 
 #define CHECK(err,text) { if ( err != EXIT_SUCCESS )  std::cerr << "[" << __func__ << "]: " << text << " returned an error! Code: " << err << std::endl; }
@@ -281,12 +283,25 @@ namespace merging
     }
 
 
+    //! \brief Hashes an id pair for \ref ComparedSet.
+    template <typename _ULongT>
+    struct IdPairHash
+    {
+        inline size_t operator()( std::pair<_ULongT,_ULongT> const& pair ) const
+        {
+            const size_t h0 = std::hash<_ULongT>()( pair.first ), h1 = std::hash<_ULongT>()( pair.second );
+            return h0 ^ (h1 + 0x9e3779b9 + (h0 << 6) + (h0 >> 2));
+        }
+    };
+
+    /*! \brief Unordered pairs of USER_ID4 tags, that were compared, and not merged. Hashed, and indexed by id, so that #eraseAny() only visits the pairs of an id.
+     */
     template <typename _ULongT = ULidT>
-    class ComparedSet : public std::set< std::pair<_ULongT, _ULongT> >
+    class ComparedSet : public std::unordered_set< std::pair<_ULongT, _ULongT>, IdPairHash<_ULongT> >
     {
         public:
-            typedef std::pair<_ULongT, _ULongT> ElementT;
-            typedef std::set < ElementT       > ParentT;
+            typedef std::pair<_ULongT, _ULongT>                     ElementT;
+            typedef std::unordered_set < ElementT, IdPairHash<_ULongT> > ParentT;
 
             /*! \brief Overload constructor to initialize max id field.
              */
@@ -301,26 +316,37 @@ namespace merging
                 if ( __x.first  > _maxId ) _maxId = __x.first;
                 if ( __x.second > _maxId ) _maxId = __x.second;
 
-                return ParentT::insert( __x );
+                std::pair<typename ParentT::iterator, bool> ret = ParentT::insert( __x );
+                if ( ret.second )
+                {
+                    _partners[ __x.first  ].push_back( __x.second );
+                    _partners[ __x.second ].push_back( __x.first  );
+                }
+                return ret;
             }
 
             /*! \brief Erases any member pair, that has x.first or x.second in it.
              */
             void eraseAny( typename ParentT::value_type& x )
             {
-                for ( auto it = this->begin(); it != this->end(); )
-                    if (    (it->first == x.first) || (it->second == x.first)
-                         || (it->first== x.second) || (it->second == x.second)
-                       )
-                        this->erase( it++ );
-                    else
-                        ++it;
+                const _ULongT ids[2] = { x.first, x.second };
+                for ( int i = 0; i != 2; ++i )
+                {
+                    auto partnersIt = _partners.find( ids[i] );
+                    if ( partnersIt == _partners.end() ) continue;
+
+                    // entries in the partner's list are left stale, erasing a missing pair is a no-op
+                    for ( auto it = partnersIt->second.begin(); it != partnersIt->second.end(); ++it )
+                        ParentT::erase( (ids[i] < *it) ? ElementT(ids[i], *it) : ElementT(*it, ids[i]) );
+                    _partners.erase( partnersIt );
+                }
             }
 
             void
             clear() _GLIBCXX_NOEXCEPT
             {
                 ParentT::clear();
+                _partners.clear();
                 _maxId = 0;
             }
 
@@ -333,6 +359,7 @@ namespace merging
         protected:
             _ULongT _maxId;
             ULidT _hits;
+            std::unordered_map< _ULongT, std::vector<_ULongT> > _partners; //!< \brief Ids paired with an id.
     }; //...ComparedSet
 
 
@@ -437,124 +464,367 @@ namespace merging
         typedef MergePartition<_PrimitiveMapT, _PointContainerT> ElementT;
     };
 
-    template <class _PrimitiveMapT, class _PointContainerT, class _PartitionT, class _MergeParamsT>
-    void inline partition( _PartitionT           & outPartition
-                         , _PrimitiveMapT   const& prims
-                         , _PointContainerT const& points
-                         , _MergeParamsT    const& params
-                         , size_t           const  sizeLimit
-                         , int              const  splitCount = 8
-                         , int              const  level = 0
-                         )
+    //! \brief Bounding box of the points of each patch, or of its primitives' positions, if the patch has no points.
+    template <class _PrimitiveMapT, class _PointContainerT, typename _Scalar>
+    inline void patchBoxes( std::map< GidT, Eigen::AlignedBox<_Scalar,3> > &boxes, _PrimitiveMapT const& prims, _PointContainerT const& points )
+    {
+        typedef typename _PointContainerT::value_type PointPrimitiveT;
+
+        boxes.clear();
+        for ( size_t pid = 0; pid != points.size(); ++pid )
+        {
+            const GidT gid = points[pid].getTag( PointPrimitiveT::TAGS::GID );
+            if ( prims.find(gid) == prims.end() ) continue;
+            boxes[ gid ].extend( points[pid].template pos().template cast<_Scalar>() );
+        }
+
+        for ( typename _PrimitiveMapT::const_iterator it = prims.begin(); it != prims.end(); ++it )
+            if ( boxes[ it->first ].isEmpty() )
+                for ( auto it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
+                    boxes[ it->first ].extend( it2->template pos().template cast<_Scalar>() );
+    } //...patchBoxes()
+
+    //! \brief Largest DIR_GID in \p prims.
+    template <class _PrimitiveMapT>
+    inline DidT maxDirGid( _PrimitiveMapT const& prims )
     {
-        typedef typename _PointContainerT::value_type            PointPrimitiveT;
         typedef typename _PrimitiveMapT::mapped_type::value_type PrimitiveT;
 
+        DidT maxDid = 0;
+        for ( typename _PrimitiveMapT::const_iterator it = prims.begin(); it != prims.end(); ++it )
+            for ( auto it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
+                maxDid = std::max( maxDid, static_cast<DidT>(it2->getTag(PrimitiveT::TAGS::DIR_GID)) );
+        return maxDid;
+    } //...maxDirGid()
+
+    /*! \brief Moves the direction ids above \p localMax, that a merge created, to start after \p base.
+     *         Merges number new directions from the largest id they see, so independently merged parts would otherwise reuse ids.
+     */
+    template <class _PrimitiveMapT>
+    inline void shiftNewDirGids( _PrimitiveMapT &prims, DidT const localMax, DidT const base )
+    {
+        typedef typename _PrimitiveMapT::mapped_type::value_type PrimitiveT;
+
+        if ( base <= localMax ) return;
+        for ( typename _PrimitiveMapT::iterator it = prims.begin(); it != prims.end(); ++it )
+            for ( auto it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
+                if ( it2->getTag(PrimitiveT::TAGS::DIR_GID) > localMax )
+                    it2->setTag( PrimitiveT::TAGS::DIR_GID, it2->getTag(PrimitiveT::TAGS::DIR_GID) - localMax + base );
+    } //...shiftNewDirGids()
+
+    //! \brief Parts of a node of \ref partition().
+    struct PartitionSide { enum { LEFT = 0, RIGHT = 1, BOUNDARY = 2 }; };
+
+    /*! \brief  Cuts the patches of a node of \ref partition() at the median of their box centers along the widest axis.
+     *
+     *          Patches, whose box comes closer to the cut than the merge threshold (the halo), could merge with the other side,
+     *          so they are held back to the node as its boundary.
+     *
+     *  \param[out] splits      Patches and points of the two sides and the boundary, see \ref PartitionSide.
+     *  \param[out] outPartition Receives the unassigned points.
+     *  \return                 False, if the node is a leaf: it has less than \p sizeLimit patches, or one side would be empty.
+     */
+    template <class _PrimitiveMapT, class _PointContainerT, class _PartitionT, class _MergeParamsT, typename _Scalar>
+    bool inline cutNode( _PartitionT              (&splits)[3]
+                       , _PartitionT               & outPartition
+                       , int                       & axis
+                       , _Scalar                   & cut
+                       , _PrimitiveMapT       const& prims
+                       , _PointContainerT     const& points
+                       , _MergeParamsT        const& params
+                       , size_t               const  sizeLimit
+                       , int                  const  level
+                       , bool                 const  verbose
+                       )
+    {
+        typedef typename _PointContainerT::value_type            PointPrimitiveT;
+        typedef          Eigen::AlignedBox<_Scalar,3>            BoxT;
+
         // (1) recursion exit condition
         if ( prims.size() < sizeLimit )
+            return false;
+
+        // (2.1) cut patches at the median along the widest axis
+        const _Scalar         halo = params.spatial_threshold_mult * params.scale; // farthest extrema, that can still be merged
+        std::map<GidT,BoxT>   boxes;
+        std::map<GidT,int>    gidsParts;                                              // <Gid, Side> (helps sort the points)
+        patchBoxes( boxes, prims, points );
+
+        BoxT                 centers;
+        std::vector<_Scalar> coords;
+        for ( auto it = boxes.begin(); it != boxes.end(); ++it )
+            centers.extend( it->second.center() );
+        centers.sizes().maxCoeff( &axis );
+        for ( auto it = boxes.begin(); it != boxes.end(); ++it )
+            coords.push_back( it->second.center()(axis) );
+        std::nth_element( coords.begin(), coords.begin() + coords.size() / 2, coords.end() );
+        cut = coords[ coords.size() / 2 ];
+
+        LidT counts[3] = { 0, 0, 0 };
+        for ( auto it = boxes.begin(); it != boxes.end(); ++it )
         {
-            // CALL merge!
-            outPartition.getPoints() = points;
-            merging::iterativeMerge<PointPrimitiveT,PrimitiveT, _PointContainerT>
-                    ( /* out: */ outPartition.getPrimitives(), outPartition.getPoints()
-                    , /*  in: */ prims, params );
-            return;
+            BoxT const& box = it->second;
+            int side = PartitionSide::BOUNDARY;
+            if      ( box.max()(axis) + halo < cut ) side = PartitionSide::LEFT;
+            else if ( box.min()(axis) - halo > cut ) side = PartitionSide::RIGHT;
+            gidsParts[ it->first ] = side;
+            ++counts[ side ];
         }
 
-        // (2.1) split primitives
-        std::vector<_PartitionT> splits; splits.resize( splitCount );
-        size_t       partSize     = float(prims.size()) / float(splitCount); // targeted primcount in each partition
-        size_t       splitPrimCnt = 0,                                       // current primcount in current split
-                     splitId      = 0;                                       // id of current split
-        std::map<GidT, LidT> gidsParts;                                      // <Gid, splitId> (helps sort the points)
-        // for each input primitive
-        for ( typename _PrimitiveMapT::const_iterator it = prims.begin(); it != prims.end(); ++it )
-        {
-            // first: GID
-            // second: vector<Primitive>
+        // nothing to split, e.g. all patches span the cut
+        if ( !counts[PartitionSide::LEFT] || !counts[PartitionSide::RIGHT] )
+            return false;
 
-            // add it to the current split
+        // (2.2) split primitives and points
+        for ( typename _PrimitiveMapT::const_iterator it = prims.begin(); it != prims.end(); ++it )
             for ( auto it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
-            {
-                containers::add( splits[ splitId ].getPrimitives(), /* gid: */ it->first, /* prim: */ *it2 );
-                ++splitPrimCnt;
-            }
-            if ( gidsParts.find( it->first ) != gidsParts.end() )
-                std::cerr << "[" << __func__ << "]: " << "gid " << it->first << " already added" << std::endl;
-            // record membership for points
-            gidsParts[ it->first ] = splitId;
-            if ( (splitPrimCnt >= partSize) && (splitId+1 < splits.size()) )
-            {
-                ++splitId;
-                splitPrimCnt = 0;
-            }
-        } //...for all input primitives
+                containers::add( splits[ gidsParts[it->first] ].getPrimitives(), /* gid: */ it->first, /* prim: */ *it2 );
 
-        // (2.2) split points
         for ( size_t i = 0; i < points.size(); ++i )
         {
-            // get GID
-            const GidT pointGid = points[i].getTag( PointPrimitiveT::TAGS::GID );
-            // get split for GID
-            auto it = gidsParts.find( pointGid );
+            auto it = gidsParts.find( points[i].getTag(PointPrimitiveT::TAGS::GID) );
             if ( it != gidsParts.end() )    splits[ it->second ].getPoints().push_back( points[i] );
-            else                            splits[ 0          ].getPoints().push_back( points[i] ); // if point unassigned
+            else                            outPartition.getPoints().push_back( points[i] ); // if point unassigned
         } //...split points
 
-        // debug
-        {
-            std::cout << "splits: ";
-            for ( size_t i = 0; i != splits.size(); ++i )
-                std::cout << "<" << splits[i].getPrimitives().size() << "," << splits[i].getPoints().size() << ">, ";
-            std::cout << std::endl;
-        }
+        if ( verbose )
+            std::cout << "[" << __func__ << "]: " << "level " << level << " cut at " << cut << " along " << axis << ": <"
+                      << splits[PartitionSide::LEFT    ].getPrimitives().size() << "," << splits[PartitionSide::LEFT    ].getPoints().size() << ">, <"
+                      << splits[PartitionSide::RIGHT   ].getPrimitives().size() << "," << splits[PartitionSide::RIGHT   ].getPoints().size() << ">, boundary <"
+                      << splits[PartitionSide::BOUNDARY].getPrimitives().size() << "," << splits[PartitionSide::BOUNDARY].getPoints().size() << ">" << std::endl;
 
-        // (3) recurse
-        std::vector<_PartitionT> processedParts; processedParts.resize( splits.size() );
-        #pragma omp parallel for if(splitCount > 2)
-        for ( size_t i = 0; i < splits.size(); ++i )
+        return true;
+    } //...cutNode()
+
+    //! \brief Merges a leaf of \ref partition() as a whole, new directions are numbered after \p maxDid.
+    template <class _PrimitiveMapT, class _PointContainerT, class _PartitionT, class _MergeParamsT>
+    void inline mergeLeaf( _PartitionT           & outPartition
+                         , _PrimitiveMapT   const& prims
+                         , _PointContainerT const& points
+                         , _MergeParamsT    const& params
+                         , DidT             const  maxDid
+                         )
+    {
+        typedef typename _PointContainerT::value_type            PointPrimitiveT;
+        typedef typename _PrimitiveMapT::mapped_type::value_type PrimitiveT;
+
+        outPartition.getPoints() = points;
+        merging::iterativeMerge<PointPrimitiveT,PrimitiveT, _PointContainerT>
+                ( /* out: */ outPartition.getPrimitives(), outPartition.getPoints()
+                , /*  in: */ prims, params );
+        shiftNewDirGids( outPartition.getPrimitives(), maxDirGid(prims), maxDid );
+    } //...mergeLeaf()
+
+    /*! \brief  Gathers a node of \ref partition() after both sides are merged. The boundary patches are merged with the patches of the sides,
+     *          whose box comes closer to the box of a boundary patch than the halo, all other patches are passed up as they are.
+     *
+     *  \param[in] splits           Output of \ref cutNode(), the boundary is consumed.
+     *  \param[in] processedParts   Merged LEFT and RIGHT sides.
+     */
+    template <class _PartitionT, class _MergeParamsT>
+    void inline gatherNode( _PartitionT           & outPartition
+                          , _PartitionT             (&splits)[3]
+                          , _PartitionT             (&processedParts)[2]
+                          , _MergeParamsT    const& params
+                          , DidT             const  maxDid
+                          , int              const  level
+                          , bool             const  verbose
+                          )
+    {
+        typedef typename _PartitionT::first_type                 PrimitiveMapT;
+        typedef typename _PartitionT::second_type                PointContainerT;
+        typedef typename PointContainerT::value_type             PointPrimitiveT;
+        typedef typename PrimitiveMapT::mapped_type::value_type  PrimitiveT;
+        typedef typename PrimitiveT::Scalar                      Scalar;
+        typedef          Eigen::AlignedBox<Scalar,3>             BoxT;
+
+        const Scalar halo = params.spatial_threshold_mult * params.scale;
+
+        // keep new directions of the two sides apart
+        shiftNewDirGids( processedParts[PartitionSide::RIGHT].getPrimitives(), maxDid, std::max(maxDid, maxDirGid(processedParts[PartitionSide::LEFT].getPrimitives())) );
+
+        // (4.1) gather: patches of the sides, that come closer to a boundary patch than the halo, can merge with it, so they are merged again with them.
+        //       A boundary patch can run far along the cut, so the side patches are tested against the boundary boxes, not the cut.
+        _PartitionT &remerge = splits[PartitionSide::BOUNDARY];
+        std::map<GidT,BoxT>        boxes;
+        processing::BoxBvh<Scalar> boundaryBvh;
+        patchBoxes( boxes, remerge.getPrimitives(), remerge.getPoints() );
+        for ( typename std::map<GidT,BoxT>::const_iterator it = boxes.begin(); it != boxes.end(); ++it )
         {
-            partition( /* out: */ processedParts[i]
-                     , /*  in: */ splits[i].getPrimitives(), splits[i].getPoints()
-                     , params, sizeLimit, 2, level + 1 );
+            BoxT box = it->second;
+            if ( !box.isEmpty() ) // inflate
+            {
+                box.min().array() -= halo;
+                box.max().array() += halo;
+            }
+            boundaryBvh.insert( it->first, box );
         }
+        boundaryBvh.build();
 
-        // (4.1) gather to <gatheredPrimitives,outPartition.getPoints>
-        _PrimitiveMapT gatheredPrimitives;
-        for ( size_t i = 0; i < processedParts.size(); ++i )
+        std::vector<LidT> nearBoundary;
+        for ( int side = PartitionSide::LEFT; side <= PartitionSide::RIGHT; ++side )
         {
-            gatheredPrimitives.insert( processedParts[i].getPrimitives().begin()
-                                               , processedParts[i].getPrimitives().end()   );
-            outPartition.getPoints().insert( outPartition.getPoints().end()
-                                             , processedParts[i].getPoints().begin()
-                                             , processedParts[i].getPoints().end()  );
+            PrimitiveMapT const& sidePrims = processedParts[side].getPrimitives();
+            patchBoxes( boxes, sidePrims, processedParts[side].getPoints() );
+
+            std::set<GidT> reaching;
+            for ( typename PrimitiveMapT::const_iterator it = sidePrims.begin(); it != sidePrims.end(); ++it )
+            {
+                boundaryBvh.query( nearBoundary, boxes[it->first], /* after: */ -1 );
+                const bool reaches = !nearBoundary.empty();
+                if ( reaches ) reaching.insert( it->first );
+
+                PrimitiveMapT &dest = reaches ? remerge.getPrimitives() : outPartition.getPrimitives();
+                for ( auto it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
+                    containers::add( dest, it->first, *it2 );
+            }
+
+            PointContainerT const& sidePoints = processedParts[side].getPoints();
+            for ( size_t i = 0; i < sidePoints.size(); ++i )
+            {
+                if ( reaching.find(sidePoints[i].getTag(PointPrimitiveT::TAGS::GID)) != reaching.end() )
+                    remerge.getPoints().push_back( sidePoints[i] );
+                else
+                    outPartition.getPoints().push_back( sidePoints[i] );
+            }
         } //...gather
 
-//#if 0
-        // (4.2) merge <gatheredPrimitives(),outPartition.getPoints()> to <outPartition.getPrimitives(),outPartition.getPoints()>
         if ( !level )
         {
+            PrimitiveMapT gatheredPrimitives = outPartition.getPrimitives();
+            for ( typename PrimitiveMapT::const_iterator it = remerge.getPrimitives().begin(); it != remerge.getPrimitives().end(); ++it )
+                for ( auto it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
+                    containers::add( gatheredPrimitives, it->first, *it2 );
+
+            PointContainerT gatheredPoints = outPartition.getPoints();
+            gatheredPoints.insert( gatheredPoints.end(), remerge.getPoints().begin(), remerge.getPoints().end() );
+
             char o_path[2048]; sprintf( o_path, "unMergedLvl%02d", level );
-            io::savePrimitives<PrimitiveT, typename _PrimitiveMapT::mapped_type::const_iterator>( gatheredPrimitives
-                                                                                               , std::string(o_path) + ".csv" );
+            io::savePrimitives<PrimitiveT, typename PrimitiveMapT::mapped_type::const_iterator>( gatheredPrimitives
+                                                                                              , std::string(o_path) + ".csv" );
             std::cout << "wrote " << o_path << std::endl;
 
             char oPointsPath[2048];
             sprintf( oPointsPath, "points_%s.csv", o_path );
-            io::writeAssociations<PointPrimitiveT>( outPartition.getPoints(), oPointsPath );
+            io::writeAssociations<PointPrimitiveT>( gatheredPoints, oPointsPath );
             std::cout << "wrote " << oPointsPath << std::endl;
         }
 
+        // (4.2) merge the boundary, new directions follow the ones of the sides
+        {
+            if ( verbose )
+                std::cout << "[" << __func__ << "]: " << "gathering level " << level << ", re-merging " << remerge.getPrimitives().size() << " boundary patches" << std::endl;
+            const DidT sidesMaxDid = std::max( maxDid, std::max(maxDirGid(outPartition.getPrimitives()), maxDirGid(remerge.getPrimitives())) );
+            const DidT remergeMaxDid = maxDirGid( remerge.getPrimitives() );
+
+            PrimitiveMapT merged;
+            merging::iterativeMerge<PointPrimitiveT,PrimitiveT, PointContainerT>
+                    ( /* out: */ merged, remerge.getPoints()
+                    , /*  in: */ remerge.getPrimitives(), params );
+            shiftNewDirGids( merged, remergeMaxDid, sidesMaxDid );
+
+            for ( typename PrimitiveMapT::const_iterator it = merged.begin(); it != merged.end(); ++it )
+                for ( auto it2 = it->second.begin(); it2 != it->second.end(); ++it2 )
+                    containers::add( outPartition.getPrimitives(), it->first, *it2 );
+            outPartition.getPoints().insert( outPartition.getPoints().end(), remerge.getPoints().begin(), remerge.getPoints().end() );
+            if ( verbose )
+                std::cout << "[" << __func__ << "]: " << "gathering level " << level << " finished" << std::endl;
+        }
+    } //...gatherNode()
+
+    /*! \brief  One node of the kd-tree of \ref partition() below the root. Runs as a task of the pool opened there.
+     *
+     *          Cuts the node (\ref cutNode()), merges the two sides as tasks, then merges the boundary (\ref gatherNode()).
+     *          Merges inside a task run on the thread of the task, the pool's threads are kept busy by the other tasks.
+     *
+     *  \param[in] maxDid   Largest DIR_GID of the whole input, new directions of the node are numbered after it.
+     */
+    template <class _PrimitiveMapT, class _PointContainerT, class _PartitionT, class _MergeParamsT>
+    void inline partitionNode( _PartitionT           & outPartition
+                             , _PrimitiveMapT   const& prims
+                             , _PointContainerT const& points
+                             , _MergeParamsT    const& params
+                             , size_t           const  sizeLimit
+                             , DidT             const  maxDid
+                             , int              const  level
+                             , bool             const  verbose
+                             )
+    {
+        typedef typename _PrimitiveMapT::mapped_type::value_type PrimitiveT;
+        typedef typename PrimitiveT::Scalar                      Scalar;
+
+        _PartitionT splits[3];                                                  // LEFT, RIGHT, BOUNDARY
+        int         axis = 0;
+        Scalar      cut  = Scalar(0.);
+        if ( !cutNode(splits, outPartition, axis, cut, prims, points, params, sizeLimit, level, verbose) )
+        {
+            mergeLeaf( outPartition, prims, points, params, maxDid );
+            return;
+        }
+
+        // (3) recurse, idle threads of the pool pick up the sides
+        _PartitionT processedParts[2];
+        for ( int side = PartitionSide::LEFT; side <= PartitionSide::RIGHT; ++side )
+        {
+#           pragma omp task default(shared) firstprivate(side)
+            partitionNode( /* out: */ processedParts[side]
+                         , /*  in: */ splits[side].getPrimitives(), splits[side].getPoints()
+                         , params, sizeLimit, maxDid, level + 1, verbose );
+        }
+#       pragma omp taskwait
+
+        gatherNode( outPartition, splits, processedParts, params, maxDid, level, verbose );
+        if ( verbose )
+            std::cout << "[" << __func__ << "]: " << "primcount: " << prims.size() << " -> " << outPartition.getPrimitives().size() << std::endl;
+    } //...partitionNode
+
+    /*! \brief  Merges a large scene in spatial chunks. The patches are cut into a kd-tree along their point bounding boxes, until less than
+     *          \p sizeLimit remain in a leaf. Leaves are merged independently by a pool of tasks, only patches near a cut are merged again
+     *          at the level of the cut. See \ref partitionNode().
+     *
+     *          The root is cut and gathered outside the pool, so its merges, the largest ones, run with the full team of threads
+     *          instead of inside a task.
+     *          The tree is binary, its depth follows from \p sizeLimit. This replaces the former splitCount argument, that set the number of
+     *          chunks of the first, non-spatial split.
+     */
+    template <class _PrimitiveMapT, class _PointContainerT, class _PartitionT, class _MergeParamsT>
+    void inline partition( _PartitionT           & outPartition
+                         , _PrimitiveMapT   const& prims
+                         , _PointContainerT const& points
+                         , _MergeParamsT    const& params
+                         , size_t           const  sizeLimit
+                         , bool             const  verbose = false
+                         )
+    {
+        typedef typename _PrimitiveMapT::mapped_type::value_type PrimitiveT;
+        typedef typename PrimitiveT::Scalar                      Scalar;
+
+        const DidT  maxDid = maxDirGid( prims );
+        _PartitionT splits[3];                                                  // LEFT, RIGHT, BOUNDARY
+        int         axis   = 0;
+        Scalar      cut    = Scalar(0.);
+        if ( !cutNode(splits, outPartition, axis, cut, prims, points, params, sizeLimit, /* level: */ 0, verbose) )
         {
-//#else
-            std::cout << "[" << __func__ << "]: " << "gathering level " << level << std::endl;
-            merging::iterativeMerge<PointPrimitiveT,PrimitiveT, _PointContainerT>
-                    ( /* out: */ outPartition.getPrimitives(), outPartition.getPoints()
-                    , /*  in: */ gatheredPrimitives, params );
-            std::cout << "[" << __func__ << "]: " << "gathering level " << level << " finished" << std::endl;
+            mergeLeaf( outPartition, prims, points, params, maxDid );
+            return;
         }
 
-        std::cout << "[" << __func__ << "]: " << "primcount: " << prims.size() << " -> " << outPartition.getPrimitives().size() << std::endl;
+        _PartitionT processedParts[2];
+#       pragma omp parallel num_threads(RAPTER_MAX_OMP_THREADS)
+        {
+#           pragma omp single
+            for ( int side = PartitionSide::LEFT; side <= PartitionSide::RIGHT; ++side )
+            {
+#               pragma omp task default(shared) firstprivate(side)
+                partitionNode( /* out: */ processedParts[side]
+                             , /*  in: */ splits[side].getPrimitives(), splits[side].getPoints()
+                             , params, sizeLimit, maxDid, /* level: */ 1, verbose );
+            }
+        } // tasks finish at the barrier of the region
+
+        gatherNode( outPartition, splits, processedParts, params, maxDid, /* level: */ 0, verbose );
+        if ( verbose )
+            std::cout << "[" << __func__ << "]: " << "primcount: " << prims.size() << " -> " << outPartition.getPrimitives().size() << std::endl;
     } //...partition
 } //...merging
 
@@ -573,7 +843,8 @@ Merging::mergeCli( int argc, char** argv )
                 prims_path = "primitives.bonmin.csv",
                 assoc_path = "points_primitives.csv";
     AnglesT  angle_gens( {AnglesT::Scalar(90.)} );
-    size_t sizeLimit = 0; // if >0, a non-spatial recursive partitioning will happen
+    size_t sizeLimit = 0; // if >0, the scene is cut into a kd-tree of patches, with less than sizeLimit patches in each leaf
+    bool   verbose   = false;
 
     // parse params
     {
@@ -599,6 +870,7 @@ Merging::mergeCli( int argc, char** argv )
         rapter::console::parse_argument( argc, argv, "--patch-pop-limit", params.patch_population_limit );
 
         rapter::console::parse_argument( argc, argv, "--partition", sizeLimit );
+        verbose = pcl::console::find_switch(argc,argv,"--verbose") || pcl::console::find_switch(argc,argv,"-v");
 
         if ( !valid_input || pcl::console::find_switch(argc,argv,"--help") || pcl::console::find_switch(argc,argv,"-h") )
         {
@@ -614,7 +886,8 @@ Merging::mergeCli( int argc, char** argv )
                       << "\t[--patch-pop-limit " << params.patch_population_limit << "]\n"
                       << "\t[--thresh-mult " << params.spatial_threshold_mult << "]\n"
                       << "\t[--no-paral]\n"
-                      << "\t[--partition " << sizeLimit << "\t split scene into chunks ]\n"
+                      << "\t[--partition " << sizeLimit << "\t split scene spatially into chunks of less than this many patches ]\n"
+                      << "\t[-v,--verbose\t log the cuts of --partition ]\n"
                       << std::endl;
 
             return EXIT_FAILURE;
@@ -685,7 +958,7 @@ Merging::mergeCli( int argc, char** argv )
     else
     {
         merging::MergePartition<PrimitiveMapT, _PointContainerT> outPartition;
-        partition( outPartition, prims_map, points, params, sizeLimit );
+        partition( outPartition, prims_map, points, params, sizeLimit, verbose );
         out_prims = outPartition.getPrimitives();
         points = outPartition.getPoints();
     }
@@ -1033,131 +1306,124 @@ int Merging::mergeSameDirGids( _PrimitiveContainerT               & out_primitiv
 
     //bool merged = false;
 
-    // Reference traversal
+    // Visit the ref/candidate couples in the same order, but only the ones with overlapping extents.
+    // The merge functors need an extremum of one primitive within scale of the other's extent (in each direction),
+    // so extents further than 2 * scale apart are never merged, and need not be compared.
+    std::vector<GidLid>                             order;          // traversal id -> <gid,lid>
+    std::vector<ExtremaT const*>                    orderExtrema;   // traversal id -> extrema
+    processing::BoxBvh<_Scalar>                     bvh;
     for ( GidIt gid_it = extrema.cbegin(); gid_it != extrema.cend(); ++gid_it )
-    {
-        const GidT gid0 = gid_it->first;
-
         for ( PrimIt prim_it = gid_it->second.cbegin(); prim_it != gid_it->second.cend(); ++prim_it )
         {
-            // linear id of the reference
-            const LidT lid0 = std::distance<typename LidExtremaT::const_iterator>( gid_it ->second.cbegin(), prim_it );
-
-            // Reference primitive key, used to check if it has not been merged previously
-            GidLid refGidLid (gid0, lid0);
-
-            // check if this primitives has not been merged previously
-            if (ignoreList.find(gid0) != ignoreList.end()) continue;
-
-            // reference primitive
-            const _PrimitiveT& prim0 = primitives.at(gid0).at(lid0);
-
-            // is the reference valid, i.e. no merge occured
-            bool is0Valid = true;
-
-
-            // Candidates traversal
-            // This loop and the nested one check if the ref primitive is still valid for comparison,
-            // i.e. no merge occured.
-            // This construction prevent to use two successive break commands (this loop and the nested one)
-            for ( GidIt gid_it1 = gid_it; is0Valid && gid_it1 != extrema.cend(); ++gid_it1 )
+            typename processing::BoxBvh<_Scalar>::BoxT box;
+            for ( size_t i = 0; i != prim_it->second.size(); ++i )
+                box.extend( prim_it->second[i] );
+            if ( !box.isEmpty() ) // inflate
             {
+                box.min().array() -= scale;
+                box.max().array() += scale;
+            }
 
-                GidT gid1 = gid_it1->first;
-
-                // Given the ref. primitive, we check for merging candidates. They can be in:
-                //   - the same map entry, after the ref. primitive in the linear Primitive array
-                //   - the next map entries, any index
-                for ( PrimIt prim_it1 = (gid_it1 == gid_it) ? ++PrimIt(prim_it) :       // for the same map entry, after the ref. primitive
-                                                              gid_it1->second.cbegin(); // for the next map entries, any index
-                      is0Valid && prim_it1 != gid_it1->second.cend();
-                      ++prim_it1 )
-                {
+            bvh.insert( order.size(), box );
+            orderExtrema.push_back( &prim_it->second );
+            order.push_back( GidLid(gid_it->first, std::distance<typename LidExtremaT::const_iterator>(gid_it->second.cbegin(), prim_it)) );
+        }
+    bvh.build();
 
-                    const LidT lid1 = std::distance<typename LidExtremaT::const_iterator>( gid_it1->second.cbegin(), prim_it1 );
+    // Reference traversal
+    std::vector<LidT> candidates;
+    for ( LidT id0 = 0; id0 != static_cast<LidT>(order.size()); ++id0 )
+    {
+        const GidT gid0 = order[id0].first;
+        // linear id of the reference
+        const LidT lid0 = order[id0].second;
 
-                    // resume of the candidate primitive, used to record the matching operation for later and
-                    // detect previous merge operations
-                    GidLid candGidLid (gid1, lid1);
+        // check if this primitives has not been merged previously
+        if (ignoreList.find(gid0) != ignoreList.end()) continue;
 
-                    // Here we don't need to define
-                    // bool is1Valid,
-                    // calling continue is sufficient to jump to the next primitive after and merge,
-                    // plus here check that a previous merge has not been recorded
-                    if (ignoreList.find(gid1) != ignoreList.end()) continue;
+        // reference primitive
+        const _PrimitiveT& prim0 = primitives.at(gid0).at(lid0);
 
-                    const _PrimitiveT& prim1 = primitives.at(gid1).at(lid1);
+        // Candidates traversal: the same map entry after the ref. primitive, and the next map entries, nearby ones only.
+        // After a merge, the reference is invalid, so we jump to the next one.
+        bvh.query( candidates, bvh.box(id0), id0 );
+        for ( size_t k = 0; k != candidates.size(); ++k )
+        {
+            const GidT gid1 = order[ candidates[k] ].first;
+            const LidT lid1 = order[ candidates[k] ].second;
 
-                    PidT uid40 = prim0.getTag( _PrimitiveT::USER_TAGS::USER_ID4 ),
-                         uid41 = prim1.getTag( _PrimitiveT::USER_TAGS::USER_ID4 );
+            // Here we don't need to define
+            // bool is1Valid,
+            // calling continue is sufficient to jump to the next primitive after and merge,
+            // plus here check that a previous merge has not been recorded
+            if (ignoreList.find(gid1) != ignoreList.end()) continue;
 
-                    UidPairT uid4Pair;
-                    if ( uid40 > uid41 ) uid4Pair = UidPairT(uid41,uid40);
-                    else                 uid4Pair = UidPairT(uid40,uid41);
+            const _PrimitiveT& prim1 = primitives.at(gid1).at(lid1);
 
-                    if ( comparedUids.find( uid4Pair ) != comparedUids.end() )
-                    {
-                        comparedUids.incHits();
-                        continue;
-                    }
+            PidT uid40 = prim0.getTag( _PrimitiveT::USER_TAGS::USER_ID4 ),
+                 uid41 = prim1.getTag( _PrimitiveT::USER_TAGS::USER_ID4 );
 
+            UidPairT uid4Pair;
+            if ( uid40 > uid41 ) uid4Pair = UidPairT(uid41,uid40);
+            else                 uid4Pair = UidPairT(uid40,uid41);
 
-                    if (primitiveDecideMergeFunct.eval( prim_it->second,  // extrema 0
-                                                        prim0,            // prim 0
-                                                        prim_it1->second, // extrema 1
-                                                        prim1,            // prim 1
-                                                        scale))
-                    {
-                        //std::cout << " YES" << std::endl;
+            if ( comparedUids.find( uid4Pair ) != comparedUids.end() )
+            {
+                comparedUids.incHits();
+                continue;
+            }
 
-                        // record this to detect unmerged primitives later and invalidate both primitives
-                        ignoreList.insert(gid0);
-                        ignoreList.insert(gid1);
 
-                        if (    ( prim0.getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL )
-                             || ( prim1.getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL ) )
-                        {
-                            std::cout << "[" << __func__ << "]: " << "crap, small patches are merged..." << std::endl; fflush(stdout);
-                            throw new std::runtime_error("asdf");
-                        }
+            if (primitiveDecideMergeFunct.eval( *orderExtrema[id0],           // extrema 0
+                                                prim0,                        // prim 0
+                                                *orderExtrema[candidates[k]], // extrema 1
+                                                prim1,                        // prim 1
+                                                scale))
+            {
+                //std::cout << " YES" << std::endl;
 
-                        merging::merge( out_primitives,     // [out] Container storing merged primitives
-                                        prim0,              // [in]  First primitive (can be invalidated during the call)
-                                        populations[gid0],  // [in]  First primitive population (point ids)
-                                        prim1,              // [in]  Second primitive
-                                        populations[gid1],  // [in]  Second primitive population (point ids)
-                                        points,             // [in]  Point cloud
-                                        scale,              // [in]  Working scale (for refit)
-                                        maxDirGId,          // [in,out] maximum direction id
-                                        comparedUids.getMaxId() // [in,out] maximum new unique id
-                                       );
+                // record this to detect unmerged primitives later and invalidate both primitives
+                ignoreList.insert(gid0);
+                ignoreList.insert(gid1);
 
-                        //merged = true;
+                if (    ( prim0.getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL )
+                     || ( prim1.getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::SMALL ) )
+                {
+                    std::cout << "[" << __func__ << "]: " << "crap, small patches are merged..." << std::endl; fflush(stdout);
+                    throw new std::runtime_error("asdf");
+                }
 
-                        is0Valid = false;
+                merging::merge( out_primitives,     // [out] Container storing merged primitives
+                                prim0,              // [in]  First primitive (can be invalidated during the call)
+                                populations[gid0],  // [in]  First primitive population (point ids)
+                                prim1,              // [in]  Second primitive
+                                populations[gid1],  // [in]  Second primitive population (point ids)
+                                points,             // [in]  Point cloud
+                                scale,              // [in]  Working scale (for refit)
+                                maxDirGId,          // [in,out] maximum direction id
+                                comparedUids.getMaxId() // [in,out] maximum new unique id
+                               );
 
-                        //comparedUids.erase( uid4Pair );
-                        comparedUids.eraseAny( uid4Pair );
+                //merged = true;
 
-                        continue;  // jump to the next couple ref/candidate primitive
-                    }
-                    else
-                    {
+                //comparedUids.erase( uid4Pair );
+                comparedUids.eraseAny( uid4Pair );
 
-                        auto uidPairIt = comparedUids.find( uid4Pair );
-                        if ( uidPairIt != comparedUids.end() )
-                        {
-                            std::cout << "this shouldn't happen, why are we rechecking this pair: " << uid40 << "," << uid41 << std::endl;
-                        }
+                break;  // the reference is invalid, jump to the next one
+            }
+            else
+            {
 
-                        comparedUids.insert( uid4Pair );
-                    }
-                    //else
-                    //    std::cout << " NO" << std::endl;
+                auto uidPairIt = comparedUids.find( uid4Pair );
+                if ( uidPairIt != comparedUids.end() )
+                {
+                    std::cout << "this shouldn't happen, why are we rechecking this pair: " << uid40 << "," << uid41 << std::endl;
                 }
+
+                comparedUids.insert( uid4Pair );
             }
-        }
-    }
+        } //...for candidates
+    } //...for references
 
     //typedef typename _PrimitiveContainerT::mapped_type::iterator inner_iterator;
 
@@ -5,6 +5,8 @@
 #include <vector>
 #include <map>
 #include <set> // edgelist
+#include <unordered_set>
+#include <algorithm>
 #include "Eigen/Dense"
 
 #if RAPTER_USE_PCL
@@ -12,6 +14,7 @@
 #endif
 
 #include "qcqpcpp/optProblem.h"                   // OptProblem
+#include "qcqpcpp/io/io.h"                        // readSparseMatrix()
 
 #include "rapter/optimization/energyFunctors.h" // AbstractPrimitivePrimitiveEnergyFunctor,
 #include "rapter/parameters.h"                  // ProblemSetupParams
@@ -35,14 +38,27 @@ inline _Scalar calcPwCost( _PrimitiveT const& p0, _PrimitiveT const& p1, _Angles
     return std::sqrt( MyPrimitivePrimitiveAngleFunctor::eval( p0, p1, angles ) );
 }
 
+namespace problemSetup
+{
+    //! \brief Hash of the content of the solution at \p x_path, 0, if it can't be read.
+    inline FormulationCache::HashT hashSolution( std::string const& x_path )
+    {
+        io::MappedFile file;
+        if ( EXIT_SUCCESS != file.open(x_path) )
+            return 0;
+        return FormulationCache::hash( file.data(), file.size() );
+    } //...hashSolution()
+} //...ns problemSetup
+
 template < class _PrimitiveContainerT
          , class _PointContainerT
          , class _PrimitiveT
          , class _PointPrimitiveT
          , class _FiniteFiniteDistFunctor
          > int
-ProblemSetup::formulateCli( int    argc
-                          , char** argv )
+ProblemSetup::formulateCli( int                          argc
+                          , char**                       argv
+                          , problemSetup::OptProblemT   *problemOut /* = NULL */ )
 {
     bool verbose = false;
     typedef          MyPointPrimitiveDistanceFunctor               _PointPrimitiveDistanceFunctor;
@@ -64,6 +80,7 @@ ProblemSetup::formulateCli( int    argc
     std::string               energy_path        = "energy.csv";
     int                       clustersMode       = 1;
     bool                      calc_energy        = false; // instead of writing the problem, calculate the energy of selecting all input lines.
+    std::string               incremental_path   = "";    // cache of the previous formulation, relative to the candidates, empty: formulate from scratch
     // parse params
     {
         bool valid_input = true;
@@ -81,6 +98,7 @@ ProblemSetup::formulateCli( int    argc
         pcl::console::parse_argument( argc, argv, "--cost-fn", cost_string );
         pcl::console::parse_argument( argc, argv, "--srand", srand_val );
         pcl::console::parse_argument( argc, argv, "--rod"  , problem_rel_path );
+        pcl::console::parse_argument( argc, argv, "--incremental", incremental_path );
         pcl::console::parse_x_arguments( argc, argv, "--angle-gens", angle_gens );
         pcl::console::parse_argument( argc, argv, "--dir-bias", params.dir_id_bias );
         if ( (pcl::console::parse_argument( argc, argv, "--assoc", assoc_path) < 0) && pcl::console::parse_argument( argc, argv, "-a", assoc_path ) < 0 )
@@ -155,7 +173,8 @@ ProblemSetup::formulateCli( int    argc
                       << " [--data-mode *" << (int)params.data_cost_mode << "* (assoc | band | instance) ]\n"
                       << " [--constr-mode *" << (int)params.constr_mode << "* (patch | point | hybrid ) ]\n"
                       << " [--srand " << srand_val << "]\n"
-                      << " [--rod " << problem_rel_path << "]\t\tRelative output path of the output matrix files\n"
+                      << " [--rod " << problem_rel_path << "]\t\tRelative output path of the output matrix files, a single binary file, if it ends with \".bin\"\n"
+                      << " [--incremental " << incremental_path << "]\t Relative path of a cache, that keeps data costs and proximities of unchanged patches between iterations, and the solution of the previous problem as starting point\n"
                       << " [--patch-pop-limit " << params.patch_population_limit << "]\n"
                       << " [--freq-weight " << params.freq_weight << "]\n"
                       << " [--energy-out " << energy_path << "]\n"
@@ -180,11 +199,12 @@ ProblemSetup::formulateCli( int    argc
 
     // read points
     _PointContainerT     points;
+    PointStore<_PointPrimitiveT> pointStore; // positions and neighbour index, GIDs are copied from points later
 
     PclCloudPtrT pclCloud( new PclCloudT() );
     {
         if ( verbose ) std::cout << "[" << __func__ << "]: " << "reading cloud from " << cloud_path << "...";
-        io::readPoints<_PointPrimitiveT>( points, cloud_path, &pclCloud );
+        io::readPoints<_PointPrimitiveT>( points, cloud_path, &pclCloud, &pointStore );
         if ( verbose ) std::cout << "reading cloud ok\n";
     } //...read points
 
@@ -241,8 +261,60 @@ ProblemSetup::formulateCli( int    argc
 //        else                                        std::cerr << "[" << __func__ << "]: " << "Could not parse cost functor input..." << std::endl;
     } //...parse cost function
 
+    std::string parent_path = boost::filesystem::path(candidates_path).parent_path().string();
+    if ( !parent_path.empty() )     parent_path += "/";
+    else                            parent_path =  ".";
+    const std::string problem_path = parent_path + "/" + problem_rel_path;
+
+    // incremental: reuse the previous formulation, and start from the previous solution
+    problemSetup::FormulationCache  cache;
+    problemSetup::FormulationCache *p_cache    = NULL;
+    std::string                     cache_path, x_path;
+    if ( !incremental_path.empty() && !calc_energy )
+    {
+        p_cache    = &cache;
+        cache_path = parent_path + "/" + incremental_path;
+
+        // the solver writes x.csv next to the problem
+        std::string x_dir = problem_path;
+        if ( io::columnar::isBinaryPath(problem_path) )
+            x_dir = boost::filesystem::path(problem_path).parent_path().string();
+        x_path = (x_dir.empty() ? std::string(".") : x_dir) + "/x.csv";
+
+        if ( boost::filesystem::exists(cache_path) )
+        {
+            if ( EXIT_SUCCESS != io::columnar::readFormulationCache(cache, cache_path) )
+                cache = problemSetup::FormulationCache(); // start over
+            else
+            {
+                // it's the solution of the cached formulation only, if it changed since the cache was written (timestamps have a resolution of a second)
+                const problemSetup::FormulationCache::HashT xHash = problemSetup::hashSolution( x_path );
+                if ( xHash && (xHash != cache.staleSolution) )
+                {
+                    typedef Eigen::SparseMatrix<double,Eigen::RowMajor> SolutionT;
+                    SolutionT x = qcqpcpp::io::readSparseMatrix<double>( x_path, 0 );
+                    if ( x.rows() == cache.varCount )
+                    {
+                        for ( int k = 0; k < x.outerSize(); ++k )
+                            for ( SolutionT::InnerIterator it(x, k); it; ++it )
+                            {
+                                if ( it.value() < .5 ) continue;
+                                problemSetup::FormulationCache::VarKeyMapT::const_iterator keyIt = cache.varKeys.find( it.row() );
+                                if ( keyIt != cache.varKeys.end() )
+                                    cache.selected.insert( keyIt->second );
+                            }
+                        std::cout << "[" << __func__ << "]: " << "starting from the " << cache.selected.size() << " candidates selected in " << x_path << std::endl;
+                    }
+                    else
+                        std::cerr << "[" << __func__ << "]: " << x_path << " has " << x.rows() << " variables instead of " << cache.varCount << ", not starting from it" << std::endl;
+                }
+            }
+        }
+    } //...incremental
+
     // WORK
-    problemSetup::OptProblemT problem;
+    problemSetup::OptProblemT  localProblem;
+    problemSetup::OptProblemT &problem = problemOut ? *problemOut : localProblem;
     AnglesT angle_gens_in_rad;
     for ( AnglesT::const_iterator angle_it = angle_gens.begin(); angle_it != angle_gens.end(); ++angle_it )
         angle_gens_in_rad.push_back( *angle_it * M_PI / 180. );
@@ -262,6 +334,8 @@ ProblemSetup::formulateCli( int    argc
                                                         , params.freq_weight
                                                         , clustersMode
                                                         , params.collapseAngleSqrt
+                                                        , &pointStore
+                                                        , p_cache
                                                         );
 #else
     int err = formulate<_PointPrimitiveDistanceFunctor>( problem
@@ -280,17 +354,20 @@ ProblemSetup::formulateCli( int    argc
                                                            , clustersMode );
 #endif
 
-    // dump. default output: ./problem/*.csv; change by --rod
+    // dump. default output: ./problem/*.csv; change by --rod. Handed over in memory, only an explicit binary dump is written.
     if ( EXIT_SUCCESS == err )
     {
-        std::string parent_path = boost::filesystem::path(candidates_path).parent_path().string();
-        if ( !parent_path.empty() )     parent_path += "/";
-        else                            parent_path =  ".";
-
         if ( !calc_energy )
         {
-            std::string problem_path = parent_path + "/" + problem_rel_path;
-            problem.write( problem_path );
+            if ( io::columnar::isBinaryPath(problem_path) )
+                err = io::columnar::writeProblem( problem, problem_path );
+            else if ( !problemOut )
+                problem.write( problem_path );
+
+            if ( p_cache )
+                cache.staleSolution = problemSetup::hashSolution( x_path ); // not solved yet
+            if ( p_cache && (EXIT_SUCCESS != io::columnar::writeFormulationCache(cache, cache_path)) )
+                std::cerr << "[" << __func__ << "]: " << "could not write " << cache_path << ", the next formulate starts from scratch" << std::endl;
         }
         else
         {
@@ -321,55 +398,74 @@ ProblemSetup::formulateCli( int    argc
 
 /*! \brief                  Calculate vicinity of patches based on smallest point-point distance.
  * \tparam      NeighMapT   map<GidT,set<GidT>>
+ * \param[in]   points      Concept: \ref PointStore, its shared neighbour index is reused, or built with \p radius cells.
  * \param[in]   radius      Lookup radius, usually 2x scale (\ref ProblemSetupParams::spatial_weight_distance)
+ * \param[in]   seeds       Optional, only the neighbourhoods of these points are searched, which finds every pair with a patch of a seed point.
  */
 template <class NeighMapT, typename _PointContainerT, typename _Scalar>
-inline void calculateNeighbourhoods( NeighMapT &proximity, _PointContainerT const& points, const _Scalar radius )
+inline void calculateNeighbourhoods( NeighMapT &proximity, _PointContainerT const& points, const _Scalar radius, std::vector<PidT> const* seeds = NULL )
 {
     typedef typename _PointContainerT::PrimitiveT PointPrimitiveT;
-    //typedef typename PointPrimitiveT::Scalar Scalar;
-    using pclutil::PclSearchPointT;
-    typedef Eigen::Vector3f Colour;
+    typedef typename PointPrimitiveT::Scalar      Scalar;
+    typedef std::pair<GidT,GidT>                  GidPair;
 
-    pclutil::PclSearchTreePtrT tree = pclutil::buildANN( points );
+    // the index is queried concurrently, the neighbourhoods are consumed right away instead of being stored
+    processing::SpatialHash<Scalar> const& index = points.getSpatialIndex( radius );
 
-    std::vector<int>    k_indices;
-    std::vector<float>  k_sqr_distances;
+    // collect gid pairs per thread, and insert them once
+    const int threadCount = RAPTER_MAX_OMP_THREADS;
+    std::vector< std::vector<GidPair> > pairs( threadCount );
     int warningCount = 0;
-    #pragma omp parallel for private(k_indices,k_sqr_distances) num_threads(RAPTER_MAX_OMP_THREADS)
-    for ( size_t i = 0; i < points.size(); ++i )
+    #pragma omp parallel num_threads(threadCount) reduction(+:warningCount)
+    {
+        std::vector<GidPair>                                   &myPairs = pairs[ omp_get_thread_num() ];
+        std::vector<typename processing::SpatialHash<Scalar>::DistPid> neighs;
+    #pragma omp for schedule(dynamic,1024)
+    for ( long k = 0; k < static_cast<long>(seeds ? seeds->size() : points.size()); ++k )
     {
+        const long i    = seeds ? (*seeds)[k] : k;
         const GidT gidI = points[i].getTag(PointPrimitiveT::TAGS::GID);
 
         if ( gidI == PointPrimitiveT::TAG_UNSET ) continue;
 
-        pclutil::PclSearchPointT pnt;
-        pnt.getVector3fMap() = points[i].template pos();
-        tree->radiusSearch( pnt, radius, k_indices, k_sqr_distances, /*maxnn:*/ 0 );
-
-#       pragma omp critical (NEIGHWARN)
-        if ( k_indices.size() > 1000 )
-        {
+        index.radiusSearch( points[i].template pos(), radius, neighs );
+        if ( neighs.size() > 1000 )
             ++warningCount;
-        }
 
-        for ( size_t j = 1; j < k_indices.size(); ++j )
+        // the point itself is skipped as same gid, not as the first neighbour, coincident points might come first
+        for ( size_t j = 0; j < neighs.size(); ++j )
         {
-            const PidT neighPid = k_indices[j];
-            const GidT gidJ = points[neighPid].getTag(PointPrimitiveT::TAGS::GID);
+            const GidT gidJ = points[ neighs[j].second ].getTag(PointPrimitiveT::TAGS::GID);
             if (    ( gidJ == PointPrimitiveT::TAG_UNSET )
                  || ( gidJ == gidI )
                ) continue;
 
-#           pragma omp critical (PROXIMITY)
-            {
-                proximity[ gidI ].insert( gidJ );
-                proximity[ gidJ ].insert( gidI );
-            }
+            myPairs.push_back( GidPair(std::min(gidI,gidJ), std::max(gidI,gidJ)) );
         } //...foreach neighbour
 
+        // keep the per-thread lists short
+        if ( myPairs.size() > (1u << 20) )
+        {
+            std::sort( myPairs.begin(), myPairs.end() );
+            myPairs.erase( std::unique(myPairs.begin(), myPairs.end()), myPairs.end() );
+        }
     } //...foreach point
-    std::cerr << "[" << __func__ << "]: " << "more, than 1000 neighbrours " << warningCount << "/" << points.size() << " times" << std::endl;
+    } //...omp parallel
+
+    std::vector<GidPair> allPairs;
+    for ( size_t tid = 0; tid != pairs.size(); ++tid )
+    {
+        std::sort( pairs[tid].begin(), pairs[tid].end() );
+        pairs[tid].erase( std::unique(pairs[tid].begin(), pairs[tid].end()), pairs[tid].end() );
+        allPairs.insert( allPairs.end(), pairs[tid].begin(), pairs[tid].end() );
+    }
+    for ( size_t p = 0; p != allPairs.size(); ++p )
+    {
+        proximity[ allPairs[p].first  ].insert( allPairs[p].second );
+        proximity[ allPairs[p].second ].insert( allPairs[p].first  );
+    }
+
+    std::cerr << "[" << __func__ << "]: " << "more, than 1000 neighbrours " << warningCount << "/" << (seeds ? seeds->size() : points.size()) << " times" << std::endl;
 } //...calculateNeighbourhoods
 
 template < class _PointPrimitiveDistanceFunctor
@@ -395,14 +491,18 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
                        , _Scalar                                                       const  freq_weight /* = 0. */
                        , int                                                           const  clusterMode
                        , _Scalar                                                       const  collapseThreshold /* = 0.07 */ // sqrt( 0.1 * PI / 180 ) == 0.06605545496
+                       , PointStore<_PointPrimitiveT>                                  const* inPointStore /* = NULL */
+                       , problemSetup::FormulationCache                                     * cache /* = NULL */
         )
 {
     using problemSetup::OptProblemT;
+    using problemSetup::FormulationCache;
 
     typedef Graph< _Scalar, typename MyGraphConfig<_Scalar>::UndirectedGraph > GraphT;
     typedef graph::EdgeT<_Scalar> EdgeT;
     typedef typename OptProblemT::SparseMatrix        SparseMatrix;
     typedef typename OptProblemT::SparseEntry         SparseEntry;
+    typedef typename OptProblemT::SparseEntries       SparseEntries;
 
     bool needPairwise = ((primPrimDistFunctor->getSpatialWeightCoeff() != _Scalar(0.)) || clusterMode);
     if ( needPairwise ) std::cout << "needPairwise, because spatW: " << primPrimDistFunctor->getSpatialWeightCoeff() << ", and clusterMode: " << clusterMode << std::endl;
@@ -426,8 +526,53 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
         throw new std::runtime_error("angle_gens need to be in rad, are you sure");
     }
 
+    // structure-of-arrays copy of the points for the population and proximity scans, sharing the neighbour index of the caller's store
+    PointStore<_PointPrimitiveT> pointStore;
+    if ( inPointStore && (inPointStore->size() == points.size()) )
+    {
+        pointStore = *inPointStore;
+        pointStore.copyGidsFrom( points );
+    }
+    else
+        pointStore.assign( points );
+
     GidPidVectorMap populations;
-    processing::getPopulations( populations, points );
+    processing::getPopulations( populations, pointStore );
+
+    // incremental: find the patches, whose points changed since the cached formulation
+    std::set<GidT> dirty;
+    bool           reusable = false; // cached entries are valid for this cloud and these parameters
+    if ( cache )
+    {
+        const _Scalar params[] = { scale, primPrimDistFunctor->getSpatialWeightDistMult() * scale, _Scalar(needPairwise), _Scalar(data_cost_mode) };
+        FormulationCache::HashT setup = FormulationCache::hash( params, sizeof(params) );
+        setup = FormulationCache::hash( weights.data(), weights.size() * sizeof(_Scalar), setup );
+        setup = FormulationCache::hash( pointStore.x(), pointStore.size() * sizeof(*pointStore.x()), setup );
+        setup = FormulationCache::hash( pointStore.y(), pointStore.size() * sizeof(*pointStore.y()), setup );
+        setup = FormulationCache::hash( pointStore.z(), pointStore.size() * sizeof(*pointStore.z()), setup );
+        reusable = (cache->setup == setup);
+
+        FormulationCache::HashMapT popHashes;
+        for ( GidPidVectorMap::const_iterator it = populations.begin(); it != populations.end(); ++it )
+            popHashes[ it->first ] = FormulationCache::hash( it->second.data(), it->second.size() * sizeof(PidT) );
+        if ( reusable )
+        {
+            for ( FormulationCache::HashMapT::const_iterator it = popHashes.begin(); it != popHashes.end(); ++it )
+            {
+                FormulationCache::HashMapT::const_iterator prevIt = cache->populations.find( it->first );
+                if ( (prevIt == cache->populations.end()) || (prevIt->second != it->second) )
+                    dirty.insert( it->first );
+            }
+            for ( FormulationCache::HashMapT::const_iterator it = cache->populations.begin(); it != cache->populations.end(); ++it )
+                if ( popHashes.find(it->first) == popHashes.end() )
+                    dirty.insert( it->first );
+        }
+        std::cout << "[" << __func__ << "]: " << (reusable ? "reusing cached formulation, " : "cached formulation does not match, ")
+                  << (reusable ? dirty.size() : popHashes.size()) << "/" << popHashes.size() << " patches changed" << std::endl;
+
+        cache->setup = setup;
+        cache->populations.swap( popHashes );
+    } //...cache
 
     // find smallest pwcost
     if ( verbose ) { std::cout << "[" << __func__ << "]: " << "collapse loop start..." << std::endl; fflush(stdout); }
@@ -537,8 +682,12 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
                                                       , OptProblemT::LINEARITY::LINEAR, name ); // changed to nonlinear by Aron on 29.12.2014
                 lids_varids[ IntPair(lid,lid1) ] = var_id;
 
+                // previous solution: the cached one, if given, the active candidates otherwise
+                const bool wasSelected = (cache && !cache->selected.empty()) ? (cache->selected.find(FormulationCache::KeyT(gId,dId)) != cache->selected.end())
+                                                                             : (prims[lid][lid1].getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::ACTIVE);
+
                 // save for initial starting point: 1. [active && ( no replace OR has not dId to be replaced )] OR [ replace set && has the dId to replace by ]
-                if (    (    (prims[lid][lid1].getTag(_PrimitiveT::TAGS::STATUS) == _PrimitiveT::STATUS_VALUES::ACTIVE)
+                if (    (    wasSelected
                           &&
                              ( (replaceBy.first == _PrimitiveT::LONG_VALUES::UNSET) || (replaceBy.first != dId)       )
                         )
@@ -583,6 +732,17 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
                     break;
                 }
         } //...for dIds
+
+        // candidate of each variable, to map the solution to the next formulation
+        if ( cache )
+        {
+            cache->varKeys.clear();
+            for ( typename std::map<IntPair,LidT>::const_iterator it = lids_varids.begin(); it != lids_varids.end(); ++it )
+            {
+                _PrimitiveT const& prim = prims[ it->first.first ][ it->first.second ];
+                cache->varKeys[ it->second ] = FormulationCache::KeyT( prim.getTag(_PrimitiveT::TAGS::GID), prim.getTag(_PrimitiveT::TAGS::DIR_GID) );
+            }
+        }
     } // ... variables
     if ( verbose ) {  std::cout << "[" << __func__ << "]: " << "var loop end..." << std::endl; fflush(stdout); }
 
@@ -625,7 +785,7 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
         {
             case ProblemSetupParams<_Scalar>::DATA_COST_MODE::ASSOC_BASED:
                 err = problemSetup::associationBasedDataCost<_PointPrimitiveDistanceFunctor, _PrimitiveT, _PointPrimitiveT>
-                        ( problem, prims, points, lids_varids, weights, scale, freq_weight, verbose );
+                        ( problem, prims, points, lids_varids, weights, scale, freq_weight, verbose, cache, reusable ? &dirty : NULL );
                 break;
 
             case ProblemSetupParams<_Scalar>::DATA_COST_MODE::INSTANCE_BASED:
@@ -669,10 +829,42 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
         if ( needPairwise )
         {
             std::cout << "[" << __func__ << "]: " << "proximity start..." << std::endl; fflush(stdout);
-            calculateNeighbourhoods( proximities, points, primPrimDistFunctor->getSpatialWeightDistMult() * scale );
+            const _Scalar radius = primPrimDistFunctor->getSpatialWeightDistMult() * scale;
+            if ( cache && reusable )
+            {
+                // search only from the points of changed patches, the pairs of unchanged patches stay
+                std::vector<PidT> seeds;
+                for ( std::set<GidT>::const_iterator it = dirty.begin(); it != dirty.end(); ++it )
+                {
+                    GidPidVectorMap::const_iterator popIt = populations.find( *it );
+                    if ( popIt != populations.end() )
+                        seeds.insert( seeds.end(), popIt->second.begin(), popIt->second.end() );
+                }
+                calculateNeighbourhoods( proximities, pointStore, radius, &seeds );
+
+                for ( size_t i = 0; i != cache->proximities.size(); ++i )
+                {
+                    const GidT gid0 = cache->proximities[i].first, gid1 = cache->proximities[i].second;
+                    if ( (dirty.find(gid0) != dirty.end()) || (dirty.find(gid1) != dirty.end()) )
+                        continue;
+                    proximities[ gid0 ].insert( gid1 );
+                    proximities[ gid1 ].insert( gid0 );
+                }
+                std::cout << "[" << __func__ << "]: " << "searched " << seeds.size() << "/" << pointStore.size() << " points" << std::endl;
+            }
+            else
+                calculateNeighbourhoods( proximities, pointStore, radius );
             std::cout << "[" << __func__ << "]: " << "proximity end..." << std::endl; fflush(stdout);
         }
 
+        if ( cache )
+        {
+            cache->proximities.clear();
+            for ( ProximityMapT::const_iterator it = proximities.begin(); it != proximities.end(); ++it )
+                for ( typename ProximityMapT::mapped_type::const_iterator it1 = it->second.upper_bound(it->first); it1 != it->second.end(); ++it1 )
+                    cache->proximities.push_back( FormulationCache::GidPair(it->first, *it1) );
+        }
+
         //GraphT::testGraph();
         std::set< EdgeT > edgesList;
 
@@ -681,70 +873,84 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
         {
             if ( verbose ) {  std::cout << "[" << __func__ << "]: " << "spatial start..." << std::endl; fflush(stdout); }
 
-#           pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS)
+            // patches of each gid, so that only the neighbours in the proximity graph are visited
+            std::map< GidT, std::vector<LidT> > gidLids;
             for ( size_t lid = 0; lid < prims.size(); ++lid )
+                if ( prims[lid].size() )
+                    gidLids[ prims[lid][0].getTag(_PrimitiveT::TAGS::GID) ].push_back( lid );
+
+            // entries are collected per block of patches without locking, and appended to the problem in patch order
+            const LidT blockSize  = 64;
+            const LidT blockCount = (prims.size() + blockSize - 1) / blockSize;
+            std::vector< SparseEntries > blockEntries( blockCount );
+#           pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) schedule(dynamic,1)
+            for ( LidT block = 0; block < blockCount; ++block )
             {
-                for ( size_t lid1 = 0; lid1 != prims[lid].size(); ++lid1 )
+                SparseEntries &entries = blockEntries[ block ];
+                const LidT stop = std::min( LidT(prims.size()), (block + 1) * blockSize );
+                for ( LidT lid = block * blockSize; lid < stop; ++lid )
                 {
-                    _PrimitiveT const& prim = prims[lid][lid1];
-                    if ( prim.getTag( _PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::SMALL )
-                        continue;
+                    if ( !prims[lid].size() ) continue;
 
-                    const GidT gid = prim.getTag( _PrimitiveT::TAGS::GID );
-                    const DidT did = prim.getTag( _PrimitiveT::TAGS::DIR_GID );
+                    const GidT gid = prims[lid][0].getTag( _PrimitiveT::TAGS::GID );
+                    ProximityMapT::const_iterator gidNeighsIt = proximities.find( gid );
+                    if ( gidNeighsIt == proximities.end() ) continue;
 
-                    // extremas key
-                    LidLid lidLid1( lid, lid1 );
-
-                    for ( size_t lidOth = 0; lidOth != prims.size(); ++lidOth )
+                    for ( size_t lid1 = 0; lid1 != prims[lid].size(); ++lid1 )
                     {
-                        for ( size_t lid1Oth = 0; lid1Oth != prims[lidOth].size(); ++lid1Oth )
-                        {
-                            _PrimitiveT const& prim1 = prims[lidOth][lid1Oth];
+                        _PrimitiveT const& prim = prims[lid][lid1];
+                        if ( prim.getTag( _PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::SMALL )
+                            continue;
 
-                            if ( prim1.getTag( _PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::SMALL )
-                                continue;
+                        const DidT did    = prim.getTag( _PrimitiveT::TAGS::DIR_GID );
+                        const LidT varId0 = lids_varids.at( IntPair(lid,lid1) );
 
-                            // skip same line, that's always zero
-                            if ( (lid == lidOth) && (lid1 == lid1Oth) ) continue;
+                        // we don't want to pollute problem with unnecessary edges, so only proximate patches, never the same one
+                        for ( typename ProximityMapT::mapped_type::const_iterator gIdOtherIt = gidNeighsIt->second.begin(); gIdOtherIt != gidNeighsIt->second.end(); ++gIdOtherIt )
+                        {
+                            if ( *gIdOtherIt == gid ) continue;
 
-                            const GidT gIdOther = prim1.getTag( _PrimitiveT::TAGS::GID );
-                            const DidT dIdOther = prim1.getTag( _PrimitiveT::TAGS::DIR_GID );
+                            typename std::map< GidT, std::vector<LidT> >::const_iterator lidsOthIt = gidLids.find( *gIdOtherIt );
+                            if ( lidsOthIt == gidLids.end() ) continue;
 
-                            ProximityMapT::const_iterator gidNeighsIt = proximities.find( gid );
-                            if (    /*( did != dIdOther )
-                                 && */( gid != gIdOther ) // we don't want to pollute problem with unnecessary edges
-                                 && (    (gidNeighsIt                        != proximities.end()        )
-                                      && (gidNeighsIt->second.find(gIdOther) != gidNeighsIt->second.end())
-                                    )
-                               )
+                            for ( size_t i = 0; i != lidsOthIt->second.size(); ++i )
                             {
-//                                std::cout << "adding spatw " << halfSpatialWeightCoeff << " to "
-//                                          << lid << ", " << lid1 << " - "
-//                                          << lidOth  << ", " << lid1Oth
-//                                          << std::endl;
-                                const LidT varId0 = lids_varids.at( lidLid1 );
-                                const LidT varId1 = lids_varids.at( IntPair(lidOth,lid1Oth) );
-#                               pragma omp critical (PS_PROBLEM)
+                                const LidT lidOth = lidsOthIt->second[i];
+                                for ( size_t lid1Oth = 0; lid1Oth != prims[lidOth].size(); ++lid1Oth )
                                 {
-                                    if ( did != dIdOther )
-                                        problem.addQObjective( varId0, varId1, halfSpatialWeightCoeff ); // /2, since it's going to be added both ways Aron 6/1/2015
-#if 0
-                                    else { // encourage parallel added by Aron 19/4/2015
-#warning "Temporary Tweak"
-                                        Scalar ang = rapter::angleInRad( prim.template dir(), prim1.template dir() );
-                                        while ( ang > M_PI ) ang -= M_PI;
-                                        ang = std::min( ang, Scalar(M_PI - ang) );
-                                        if ( ang > 0.01 )
-                                            problem.addQObjective( varId0, varId1, halfSpatialWeightCoeff/2. ); // /2, since it's going to be added both ways Aron 6/1/2015
-                                    }
-#endif
-                                }
-                            }
-                        } // ... olid1
-                    } // ... olid
-                } // ... lid1
-            } // ... lid
+                                    _PrimitiveT const& prim1 = prims[lidOth][lid1Oth];
+
+                                    if ( prim1.getTag( _PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::SMALL )
+                                        continue;
+
+                                    if ( did != prim1.getTag(_PrimitiveT::TAGS::DIR_GID) )
+                                        entries.push_back( SparseEntry(varId0, lids_varids.at( IntPair(lidOth,lid1Oth) ), halfSpatialWeightCoeff) ); // /2, since it's going to be added both ways Aron 6/1/2015
+                                } // ... olid1
+                            } // ... olid
+                        } // ... gIdOther
+                    } // ... lid1
+                } // ... lid
+            } // ... block
+
+            // one concatenation into the problem
+            SparseEntries pairwiseEntries;
+            {
+                size_t entryCount = 0;
+                for ( LidT block = 0; block < blockCount; ++block )
+                    entryCount += blockEntries[block].size();
+                pairwiseEntries.reserve( entryCount );
+                for ( LidT block = 0; block < blockCount; ++block )
+                {
+                    pairwiseEntries.insert( pairwiseEntries.end(), blockEntries[block].begin(), blockEntries[block].end() );
+                    SparseEntries().swap( blockEntries[block] );
+                }
+            }
+            if ( EXIT_SUCCESS != problem.addQObjectives(pairwiseEntries) )
+            {
+                std::cerr << "[" << __func__ << "]: " << "could not add pairwise costs" << std::endl;
+                return EXIT_FAILURE;
+            }
+            if ( verbose ) std::cout << "[" << __func__ << "]: " << "added " << pairwiseEntries.size() << " pairwise entries" << std::endl;
 
             if ( clusterMode )
             {
@@ -910,6 +1116,8 @@ ProblemSetup::formulate2( problemSetup::OptProblemT
             problem.setStartingPoint( x0 );
         }
     } //...Initial solution
+    if ( cache )
+        cache->varCount = problem.getVarCount();
     if ( verbose ) {  std::cout << "[" << __func__ << "]: " << "init solution done" << std::endl; fflush(stdout); }
 
     // log
@@ -930,6 +1138,19 @@ namespace problemSetup {
 
     //____________________________________________Constraints__________________________________________________
 
+    //! \brief Hashes a sorted column index list, used to find duplicate constraint lines without storing them densely.
+    template <typename _IndexT>
+    struct SortedColsHash
+    {
+        inline size_t operator()( std::vector<_IndexT> const& cols ) const
+        {
+            size_t seed = cols.size();
+            for ( size_t i = 0; i != cols.size(); ++i )
+                seed ^= static_cast<size_t>(cols[i]) + 0x9e3779b9 + (seed << 6) + (seed >> 2); // boost::hash_combine
+            return seed;
+        }
+    }; //...SortedColsHash
+
     //! \brief              Adds constraints to \p problem so, that each patch (prims[i] that have the same _PrimitiveT::TAGS::GID) has at least one member j (prims[i][j]) selected.
     //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
     template < class _PointPrimitiveDistanceFunctor
@@ -953,18 +1174,21 @@ namespace problemSetup {
     {
         typedef typename _AssocT::key_type IntPair;
 
+        typedef typename _OptProblemT::SparseMatrix  SparseMatrix;
+        typedef typename _OptProblemT::SparseEntry   SparseEntry;
+        typedef std::vector<LidT>                    ColsT;
+
         int err = EXIT_SUCCESS;
 
         // one direction / patch needs to be choosen
-        std::vector< double              > coeffs ( problem.getVarCount(), 0 ); // constraint coefficient line in A
-        std::set   < std::vector<double> > uniqueA;                             // to ensure unique constraints
+        ColsT                                                cols;     // sorted non-zero columns of the constraint line in A
+        std::unordered_set< ColsT, SortedColsHash<LidT> >   uniqueA;  // to ensure unique constraints
+        std::vector< SparseEntry >                           entries;  // (row, col, 1.) triplets of the new lines
+        const LidT                                           firstRow = problem.getConstraintCount();
         // for all patches
         for ( size_t lid = 0; lid != prims.size(); ++lid )
         {
-            bool non_zero_line = false;
-
-            // init row to 0
-            std::fill( coeffs.begin(), coeffs.end(), 0 );
+            cols.clear();
 
             // add 1 for each direction patch -> at least one direction has to be chosen for this patch
             for ( size_t lid1 = 0; lid1 != prims[lid].size(); ++lid1 )
@@ -973,20 +1197,23 @@ namespace problemSetup {
                     continue;
 
                 if ( verbose && (lid1 == 0) ) std::cout << "[" << __func__ << "]: " << "Constraining " << prims[lid][lid1].getTag( _PrimitiveT::TAGS::GID ) << " to choose one of ";
-                coeffs[ /* varid: */ lids_varids.at(IntPair(lid,lid1)) ] = 1.0;
-                non_zero_line = true;
+                cols.push_back( /* varid: */ lids_varids.at(IntPair(lid,lid1)) );
                 if ( verbose ) std::cout << prims[lid][lid1].getTag( _PrimitiveT::TAGS::DIR_GID ) << ", ";
             }
             if ( verbose )std::cout << " directions";
 
-            if ( non_zero_line )
+            if ( !cols.empty() )
             {
-                // unique insertion
-                unsigned prev_size = uniqueA.size(); // store prev set size to check for unique insert
-                uniqueA.insert( coeffs );            // insert into set
-                if ( uniqueA.size() > prev_size )    // if line was unique, add to problem
+                std::sort( cols.begin(), cols.end() );
+                cols.erase( std::unique(cols.begin(), cols.end()), cols.end() );
+
+                // unique insertion, if line was unique, add to problem
+                if ( uniqueA.insert(cols).second )
                 {
-                    problem.addLinConstraint( _OptProblemT::BOUND::GREATER_EQ, 1, problem.getINF(), coeffs ); // 1 <= A( lid, : ) * X <= INF
+                    const LidT row = problem.getConstraintCount();
+                    problem.addConstraint( _OptProblemT::BOUND::GREATER_EQ, 1, problem.getINF() ); // 1 <= A( row, : ) * X <= INF
+                    for ( size_t i = 0; i != cols.size(); ++i )
+                        entries.push_back( SparseEntry(row, cols[i], 1.0) );
                     if  ( verbose )     std::cout << " ADDED\n";
                 }
                 else
@@ -994,6 +1221,14 @@ namespace problemSetup {
             }
         } // ... for each patch
 
+        // add the new lines of A at once
+        if ( problem.getConstraintCount() > static_cast<size_t>(firstRow) )
+        {
+            SparseMatrix A( problem.getConstraintCount(), problem.getVarCount() );
+            A.setFromTriplets( entries.begin(), entries.end() );
+            err = problem.addLinConstraints( A );
+        }
+
         return err;
     } // ...everyPatchNeedsDirectionConstraint
 
@@ -1019,7 +1254,9 @@ namespace problemSetup {
                             , _WeightsT            const& weights
                             , _Scalar              const  scale
                             , _Scalar              const freq_weight
-                            , bool                 const verbose )
+                            , bool                 const verbose
+                            , FormulationCache          * cache /* = NULL */
+                            , std::set<GidT>       const* dirty /* = NULL */ )
     {
         typedef typename _AssocT::key_type IntPair;
 
@@ -1049,114 +1286,132 @@ namespace problemSetup {
             }
 #endif
 
-#       pragma omp parallel for num_threads(4)
+        // flatten candidates, so that the threads share the work evenly, even if patch sizes and direction counts differ
+        std::vector<IntPair> candidates;
         for ( size_t lid = 0; lid < prims.size(); ++lid )
+            for ( size_t lid1 = 0; lid1 < prims[lid].size(); ++lid1 )
+                if ( prims[lid][lid1].getTag( _PrimitiveT::TAGS::STATUS ) != _PrimitiveT::STATUS_VALUES::SMALL )
+                    candidates.push_back( IntPair(lid,lid1) );
+
+        std::vector<_Scalar>                 coeffs( candidates.size() );
+        std::vector<FormulationCache::HashT> hashes( cache ? candidates.size() : 0 ); // of the coefficients and the patch, to recognize unchanged candidates
+        LidT                                 reusedCount = 0;
+#       pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) schedule(dynamic,16) reduction(+:reusedCount)
+        for ( long cid = 0; cid < static_cast<long>(candidates.size()); ++cid )
         {
-            // check, if any directions for patch
-            if ( !prims[lid].size() )
-            {
-                //std::cerr << "[" << __func__ << "]: " << "no directions for patch[" << lid << "]! This shouldn't happen. Skipping patch..." << std::endl;
-                continue;
-            }
+            const LidT         lid  = candidates[cid].first;
+            const LidT         lid1 = candidates[cid].second;
+            _PrimitiveT const& prim = prims[lid][lid1];
 
             // cache patch group id to match with point group ids
             const GidT gid = prims[lid][0].getTag( _PrimitiveT::TAGS::GID );
 
-            // for each direction
-            for ( size_t lid1 = 0; lid1 < prims[lid].size(); ++lid1 )
+            // reuse the cost of an unchanged candidate of an unchanged patch
+            if ( cache )
             {
-                if ( prims[lid][lid1].getTag( _PrimitiveT::TAGS::STATUS ) == _PrimitiveT::STATUS_VALUES::SMALL )
-                    continue;
+                hashes[cid] = FormulationCache::hash( prim.coeffs().data(), prim.coeffs().size() * sizeof(*prim.coeffs().data())
+                                                    , FormulationCache::hash(&gid, sizeof(gid)) );
+                if ( dirty && (dirty->find(gid) == dirty->end()) )
+                {
+                    FormulationCache::CostMapT::const_iterator it = cache->dataCosts.find( FormulationCache::KeyT(prim.getTag(_PrimitiveT::TAGS::GID), prim.getTag(_PrimitiveT::TAGS::DIR_GID)) );
+                    if ( (it != cache->dataCosts.end()) && (it->second.first == hashes[cid]) )
+                    {
+                        coeffs[cid] = it->second.second;
+                        ++reusedCount;
+                        continue;
+                    }
+                }
+            }
 
+            // the population index holds exactly the points assigned to the patch, no need to scan the cloud
+            GidPidVectorMap::const_iterator popIt = populations.find( gid );
+            const size_t cnt = (popIt != populations.end()) ? popIt->second.size() : 0;
+
+            // data-cost coefficient (output)
+            _Scalar unary_i = _Scalar(0);
+            if ( cnt )
+            {
+                PidVector const& population = popIt->second;
+
+                // extent once per candidate, reused for all its points
                 typename _PrimitiveT::ExtremaT extrema;
-                int err = prims[lid][lid1].template getExtent<_PointPrimitiveT>
+                int err = prim.template getExtent<_PointPrimitiveT>
                         ( extrema
                         , points
                         , scale
-                        , populations[gid].size() ? &(populations[gid]) : NULL );
-
-                // point count for normalization
-                unsigned cnt = 0;
-                // data-cost coefficient (output)
-                _Scalar unary_i = _Scalar(0);
-                // for each point, check if assigned to main patch (TODO: move assignment test to earlier, it's indep of lid1)
-                for ( size_t pid = 0; pid != points.size(); ++pid )
+                        , &population );
+
+                if ( err == EXIT_SUCCESS )
                 {
-                    //if ( points[pid].getTag( PointPrimitiveT::TAGS::GID ) == static_cast<int>(lid) )
-                    if ( points[pid].getTag( _PointPrimitiveT::TAGS::GID ) == gid )
+                    for ( size_t i = 0; i != cnt; ++i )
                     {
-                        // if within scale, add unary cost
-
                         // changed by Aron on 6/1/2015
-                         _Scalar dist = std::numeric_limits<_Scalar>::max();
-                        if ( err == EXIT_SUCCESS )
-                        {
-                            //dist = MyPointFiniteLineDistanceFunctor::eval( extrema, prims[lid][lid1], points[pid].template pos() );
-                            dist = prims[lid][lid1].getFiniteDistance( extrema, points[pid].template pos() );
-                        }
-                        else
-                        {
-                            //dist = _PointPrimitiveDistanceFunctor::template eval<_Scalar>( points[pid], prims[lid][lid1] );
-
-                            dist = 2.; // we don't want an empty primitive
-                        }
+                        const _Scalar dist = prim.getFiniteDistance( extrema, points[population[i]].template pos() );
                         unary_i += dist * dist; //changed on 18/09/14
-                        ++cnt;              // normalizer
                     }
-                } // for points
-
-                // average data cost
-                _Scalar coeff = cnt ? /* unary: */ weights(0) * unary_i / _Scalar(cnt)
-                                    : /* unary: */ weights(0) * _Scalar(2);            // add large weight, if no points assigned
-//                std::cout << "coeff(" << gid
-//                          << ","
-//                          << prims[lid][lid1].getTag(_PrimitiveT::TAGS::DIR_GID) << ") = "
-//                          << coeff
-//                          << ", unary: " << unary_i << ", cnt: " << cnt << ", weights(0): " << weights(0)
-//                          << std::endl;
+                }
+                else
+                    unary_i = cnt * _Scalar(4.); // dist = 2., we don't want an empty primitive
+            }
 
-#if 0
-                // prefer dominant directions
-                if ( freq_weight > _Scalar(0.) )
-                {
-                    const DidT dir_gid = prims[lid][lid1].getTag( _PrimitiveT::TAGS::GID );
+            // average data cost
+            _Scalar coeff = cnt ? /* unary: */ weights(0) * unary_i / _Scalar(cnt)
+                                : /* unary: */ weights(0) * _Scalar(2);            // add large weight, if no points assigned
 
-                    if ( verbose && dir_instances[dir_gid] )
-                        std::cout << "[" << __func__ << "]: " << "changed " << coeff << " to ";
+#if 0
+            // prefer dominant directions
+            if ( freq_weight > _Scalar(0.) )
+            {
+                const DidT dir_gid = prims[lid][lid1].getTag( _PrimitiveT::TAGS::GID );
 
-                    // changed by Aron 10:32 24/09/2014
-                    // old version: 1/#did, better version would be normalized, so: 1 / (#did/all)
-                    // new version: Dataweight = dataweight * (.1 + .9 * ((#did/n)^2 - 1.)^6)
-                    if ( dir_instances[dir_gid] > 0 )
-                    {
-                        _Scalar v = _Scalar(dir_instances[dir_gid]) / _Scalar(active_count); // #did/n
-                        v *= v;                                                              // (#did/n)^2
-                        v -= _Scalar(1.);                                                    // (#did/n)^2 - 1.
-                        v *= v;                                                              // ((#did/n)^2 - 1.)^2
-                        v *= v * v;                                                          // ((#did/n)^2 - 1.)^6
-                        coeff *= (w_mod_base + w_mod_base_inv * v) * freq_weight;            // .1 + .9 * ((#did/n)^2 - 1.)^6
-                        //coeff *= freq_weight * _Scalar(1.) / ( _Scalar(1.) + std::log(dir_instances[dir_gid]) );
-                        //coeff *= freq_weight / _Scalar(dir_instances[dir_gid]);
-                    }
-                    else
-                        coeff *= freq_weight;
+                if ( verbose && dir_instances[dir_gid] )
+                    std::cout << "[" << __func__ << "]: " << "changed " << coeff << " to ";
 
-                    if ( verbose && dir_instances[dir_gid] )
-                        std::cout << coeff << " since dirpop: " << dir_instances[dir_gid] << std::endl;
+                // changed by Aron 10:32 24/09/2014
+                // old version: 1/#did, better version would be normalized, so: 1 / (#did/all)
+                // new version: Dataweight = dataweight * (.1 + .9 * ((#did/n)^2 - 1.)^6)
+                if ( dir_instances[dir_gid] > 0 )
+                {
+                    _Scalar v = _Scalar(dir_instances[dir_gid]) / _Scalar(active_count); // #did/n
+                    v *= v;                                                              // (#did/n)^2
+                    v -= _Scalar(1.);                                                    // (#did/n)^2 - 1.
+                    v *= v;                                                              // ((#did/n)^2 - 1.)^2
+                    v *= v * v;                                                          // ((#did/n)^2 - 1.)^6
+                    coeff *= (w_mod_base + w_mod_base_inv * v) * freq_weight;            // .1 + .9 * ((#did/n)^2 - 1.)^6
+                    //coeff *= freq_weight * _Scalar(1.) / ( _Scalar(1.) + std::log(dir_instances[dir_gid]) );
+                    //coeff *= freq_weight / _Scalar(dir_instances[dir_gid]);
                 }
+                else
+                    coeff *= freq_weight;
+
+                if ( verbose && dir_instances[dir_gid] )
+                    std::cout << coeff << " since dirpop: " << dir_instances[dir_gid] << std::endl;
+            }
 #endif
 
-                // complexity cost:
-                coeff += weights(2); // changed by Aron on 21/9/2014
+            // complexity cost:
+            coeff += weights(2); // changed by Aron on 21/9/2014
 
-                // add to problem
-#               pragma omp critical (PS_PROBLEM)
-                {
-                    problem.addLinObjective( /* var_id: */ lids_varids.at( IntPair(lid,lid1) )
-                                           , /*  value: */ coeff );
-                }
-            } //...for each direction
-        } //...for each patch
+            coeffs[cid] = coeff;
+        } //...for each candidate
+
+        // add to problem in candidate order
+        for ( size_t cid = 0; cid != candidates.size(); ++cid )
+            problem.addLinObjective( /* var_id: */ lids_varids.at( candidates[cid] )
+                                   , /*  value: */ coeffs[cid] );
+
+        // remember for the next formulation
+        if ( cache )
+        {
+            FormulationCache::CostMapT dataCosts;
+            for ( size_t cid = 0; cid != candidates.size(); ++cid )
+            {
+                _PrimitiveT const& prim = prims[ candidates[cid].first ][ candidates[cid].second ];
+                dataCosts[ FormulationCache::KeyT(prim.getTag(_PrimitiveT::TAGS::GID), prim.getTag(_PrimitiveT::TAGS::DIR_GID)) ] = std::make_pair( hashes[cid], double(coeffs[cid]) );
+            }
+            cache->dataCosts.swap( dataCosts );
+            std::cout << "[" << __func__ << "]: " << "reused " << reusedCount << "/" << candidates.size() << " data costs" << std::endl;
+        }
 
         return EXIT_SUCCESS;
     } //...associationBasedDataCost
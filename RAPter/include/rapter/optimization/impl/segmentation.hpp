@@ -50,14 +50,21 @@ int
 Segmentation::orientPoints( _PointContainerT          &points
                           , _Scalar             const  scale
                           , int                 const  nn_K
-                          , int                 const  verbose )
+                          , int                 const  verbose
+                          , PointStore<_PointPrimitiveT> *pointStore )
 {
     typedef pcl::PointCloud<pcl::PointXYZ>        CloudXYZ;
 
-    // to pcl cloud
-    CloudXYZ::Ptr cloud( new CloudXYZ() );
-    _PointPrimitiveT::template toCloud<CloudXYZ::Ptr, _PointContainerT, pclutil::PCLPointAllocator<_PointPrimitiveT::Dim> >
-            ( cloud, points );
+    // to pcl cloud, or reuse the one of the point store
+    CloudXYZ::Ptr cloud;
+    if ( pointStore )
+        cloud = pointStore->getSearchCloud();
+    else
+    {
+        cloud.reset( new CloudXYZ() );
+        _PointPrimitiveT::template toCloud<CloudXYZ::Ptr, _PointContainerT, pclutil::PCLPointAllocator<_PointPrimitiveT::Dim> >
+                ( cloud, points );
+    }
 
     // (1) local fit lines from pcl cloud
     std::vector<_PrimitiveT> fit_lines;
@@ -71,13 +78,16 @@ Segmentation::orientPoints( _PointContainerT          &points
                , /*         nn_radius: */ scale
                , /*       soft_radius: */ true
                , /* [out]     mapping: */ &point_ids
-               , verbose ); // contains point id for fit_line
+               , verbose // contains point id for fit_line
+               , /* shared neighbour index: */ pointStore ? &pointStore->getSpatialIndex(scale) : NULL );
 
         // copy line direction into point
         for ( UPidT pid_id = 0; pid_id != point_ids.size(); ++pid_id )
         {
             const UPidT pid = point_ids[pid_id];
             points[pid].coeffs().template segment<3>(3) = fit_lines.at(pid).dir();
+            if ( pointStore )
+                pointStore->setDir( pid, fit_lines.at(pid).dir() );
         }
     } // ... (1) local fit
 
@@ -98,6 +108,7 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
                        , bool                   const  soft_radius
                        , std::vector<PidT>            * point_ids
                        , int                    const  verbose
+                       , processing::SpatialHash<float> const* index
                        )
 {
     using std::vector;
@@ -109,12 +120,15 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
 
     // get neighbourhoods
     if ( verbose ) std::cout << "[" << __func__ << "]: " << "starting neighbourhood queries";
-    std::vector< std::vector<int   > > neighs;
-    std::vector< std::vector<Scalar> > sqr_dists;
-    processing::getNeighbourhoodIndices( /*   [out] neighbours: */ neighs
-                                       , /* [in]  pointCloud: */ cloud
-                                       , /* [in]     indices: */ indices
-                                       , /* [out]  sqr_dists: */ &sqr_dists
+    processing::SpatialHash<float>       localIndex;
+    processing::NeighbourhoodsCSR<float> neighbourhoods;
+    if ( !index )
+    {
+        localIndex.buildFromCloud( cloud, radius );
+        index = &localIndex;
+    }
+    processing::getNeighbourhoodIndices( /* [out] neighbours: */ neighbourhoods
+                                       , /* [in]       index: */ *index
                                        , /* [in]        nn_K: */ K              // 15
                                        , /* [in]      radius: */ radius         // 0.02f
                                        , /* [in] soft_radius: */ soft_radius    // true
@@ -122,24 +136,31 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
     if ( verbose ) std::cout << "ok...\n";
 
     // only use, if more then 2 data-points
-    if ( std::count_if( neighs.begin(), neighs.end(), [] (vector<int> const& n1) { return n1.size() > 2; } ) < 2 )
     {
-        std::cerr << "[" << __func__ << "]: " << "not enough to work with (<2)...change scale " << radius << std::endl;
-        return EXIT_SUCCESS;
+        size_t usable = 0;
+        for ( size_t pid = 0; pid != neighbourhoods.size(); ++pid )
+            usable += ( neighbourhoods.count(pid) > 2 );
+        if ( usable < 2 )
+        {
+            std::cerr << "[" << __func__ << "]: " << "not enough to work with (<2)...change scale " << radius << std::endl;
+            return EXIT_SUCCESS;
+        }
     }
 
     // every point proposes primitive[s] using its neighbourhood
     unsigned int step_count(0);
     LidT skipped = 0;
-    for ( size_t pid = 0; pid != neighs.size(); ++pid )
+    std::vector<int> neighs; // neighbourhood of the current point
+    for ( size_t pid = 0; pid != neighbourhoods.size(); ++pid )
     {
         // can't fit a line to 0 or 1 points
-        if ( neighs[pid].size() < 2 )
+        if ( neighbourhoods.count(pid) < 2 )
         {
             ++skipped;
-            std::cout << "[" << __func__ << "]: " << "skipped " << neighs[pid].size() << " neighs" << std::endl;
+            std::cout << "[" << __func__ << "]: " << "skipped " << neighbourhoods.count(pid) << " neighs" << std::endl;
             continue;
         }
+        neighbourhoods.copyTo( pid, neighs );
 
         int err = EXIT_SUCCESS;
         if ( PrimitiveT::EmbedSpaceDim == 2 ) // we are in 2D, and TLine is LinePrimitive2
@@ -147,7 +168,7 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
             Eigen::Matrix<Scalar,6,1> line;
             err = smartgeometry::geometry::fitLinearPrimitive<PointsT,Scalar,6>( /*           output: */ line , /*         points: */ *cloud
                                                                                           , /*          scale: */ radius
-                                                                                          , /*        indices: */ &(neighs[pid])
+                                                                                          , /*        indices: */ &neighs
                                                                                           , /*    refit times: */ 2
                                                                                           , /* use input line: */ false
                                                                                           );
@@ -160,15 +181,15 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
         else // we are in 3D, and TLine is PlanePrimitive
         {
 //            std::cout << "fitting to " << (*cloud)[pid].getVector3fMap().transpose() << " and neighbours:\n";
-//            for ( int j = 0; j != neighs[pid].size(); ++j )
-//                std::cout << "\t" << (*cloud)[ neighs[pid][j] ].getVector3fMap().transpose() << "\n";
+//            for ( int j = 0; j != neighs.size(); ++j )
+//                std::cout << "\t" << (*cloud)[ neighs[j] ].getVector3fMap().transpose() << "\n";
 
             // fitLInearPirmitive uses "rows==4" to fit a plane TODO: use processing::fitlinearprimitive instead.
             Eigen::Matrix<Scalar,4,1> plane;
             err = smartgeometry::geometry::fitLinearPrimitive<PointsT,Scalar,4>( /*         output: */ plane
                                                                                , /*         points: */ *cloud
                                                                                , /*          scale: */ radius
-                                                                               , /*        indices: */ &(neighs[pid])
+                                                                               , /*        indices: */ &neighs
                                                                                , /*    refit times: */ 2
                                                                                , /* use input line: */ false
                                                                                );
@@ -180,17 +201,17 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
                                                     , /* normal: */ plane.template head<3>() )  );
 #if 0
                 std::cout << "fit " << primitives.back().toString() << " to\n";
-                for ( int i = 0; i != neighs[pid].size(); ++i )
+                for ( int i = 0; i != neighs.size(); ++i )
                 {
-                    const int pj = neighs[pid][i];
+                    const int pj = neighs[i];
                     std::cout << (*cloud)[pj].getVector3fMap().transpose()
-                              << ", with dist " << sqr_dists[pid][i] << " == " << sqr_dists[pid][i] << " < " << radius << std::endl;
+                              << ", with dist " << neighbourhoods.sqrDistsBegin(pid)[i] << " < " << radius << std::endl;
                 }
 #endif
             }
             else
             {
-                std::cout << "[" << __func__ << "]: " << "no primitive for " << neighs[pid].size() << "neighbours " << std::endl;
+                std::cout << "[" << __func__ << "]: " << "no primitive for " << neighs.size() << "neighbours " << std::endl;
             }
         }
 
@@ -202,14 +223,14 @@ Segmentation:: fitLocal( _PrimitiveContainerT        & primitives
 
         if ( verbose && !(++step_count % 100000) )
         {
-            std::cout << "fit to " << primitives.size() << " / " << neighs.size() << "(" << (Scalar)(primitives.size()) / neighs.size() << "%)" << std::endl;
+            std::cout << "fit to " << primitives.size() << " / " << neighbourhoods.size() << "(" << (Scalar)(primitives.size()) / neighbourhoods.size() << "%)" << std::endl;
             fflush(stdout);
         }
     } //...for points
 
     std::cout << "[" << __func__ << "]: "
-              << skipped << "/" << neighs.size() << ": " << skipped / static_cast<float>(neighs.size()) * 100.f << "% of points did not produce primitives, so the primitive count is:"
-              << primitives.size() << " = " << primitives.size() / static_cast<float>(neighs.size()) *100.f << "%" << std::endl;
+              << skipped << "/" << neighbourhoods.size() << ": " << skipped / static_cast<float>(neighbourhoods.size()) * 100.f << "% of points did not produce primitives, so the primitive count is:"
+              << primitives.size() << " = " << primitives.size() / static_cast<float>(neighbourhoods.size()) *100.f << "%" << std::endl;
 
     return EXIT_SUCCESS;
 } // ...Segment::propose()
@@ -241,6 +262,7 @@ Segmentation::patchify( _PrimitiveContainerT                   & patches
                       , int                               const  nn_K
                       , int                               const  verbose
                       , size_t                            const patchPopLimit
+                      , PointStore<typename _PointContainerT::value_type> const* pointStore
                       )
 {
     typedef segmentation::Patch<_Scalar,_PrimitiveT> PatchT;
@@ -261,7 +283,8 @@ Segmentation::patchify( _PrimitiveContainerT                   & patches
                   , /* [in] patchPatchDistanceFunctor: */ patchPatchDistanceFunctor
                   , /* [in]              gid_tag_name: */ PointPrimitiveT::TAGS::GID
                   , /* [in]                      nn_K: */ nn_K
-                  , /* [in]                   verbose: */ verbose );
+                  , /* [in]                   verbose: */ verbose
+                  , /* [in]                pointStore: */ pointStore );
     } // ... (1) group
 
     // (2) Create PrimitiveContainer
@@ -359,6 +382,82 @@ Segmentation::patchify( _PrimitiveContainerT                   & patches
     return EXIT_SUCCESS;
 } // ...Segmentation::patchify()
 
+template < class    _PatchT
+         , class    _PointStoreT
+         , class    _SpatialIndexT
+         , typename _Scalar
+         > inline bool
+Segmentation::_growPatch( _PatchT                                   & patch
+                        , PidT                                 const  seed
+                        , std::vector<char>                    const& assigned
+                        , std::vector< std::atomic<unsigned> >      & owner
+                        , unsigned                             const  stamp
+                        , unsigned                             const  minStamp
+                        , _PointStoreT                         const& store
+                        , _SpatialIndexT                       const& index
+                        , _Scalar                              const  maxDist
+                        , _Scalar                              const  maxAngle )
+{
+    std::vector<typename _SpatialIndexT::DistPid> neighs;
+    std::vector<PidT>                             privateSeeds; // used as a stack
+
+    // takes pid, unless an earlier patch has it: keeps the smallest stamp in [minStamp,stamp], stale stamps are overwritten
+    struct Claim
+    {
+        static inline bool take( std::atomic<unsigned> &pidOwner, unsigned const stamp, unsigned const minStamp )
+        {
+            unsigned current = pidOwner.load();
+            do
+            {
+                if ( (current >= minStamp) && (current < stamp) )
+                    return false;
+            } while ( !pidOwner.compare_exchange_weak(current, stamp) );
+            return true;
+        }
+    };
+
+    if ( !Claim::take(owner[seed], stamp, minStamp) )
+        return false;
+    patch.push_back( segmentation::PidLid(seed,-1) );
+    patch.update( store );
+
+    privateSeeds.push_back( seed );
+    while ( privateSeeds.size() )
+    {
+        const PidT pid = privateSeeds.back();
+        privateSeeds.pop_back();
+
+        // look for unassigned neighbours, the index is read-only here
+        index.radiusSearch( store.pos(pid), maxDist, neighs );
+
+        for ( size_t pid_id = 1; pid_id < neighs.size(); ++pid_id )
+        {
+            const PidT pid2 = neighs[ pid_id ].second;
+
+            if ( assigned[pid2] || (owner[pid2].load() == stamp) )
+                continue;
+
+            _Scalar ang_diff = rapter::angleInRad( patch.template dir(), store.dir(pid2) );
+            // map 90..180 to 0..90:
+            if ( ang_diff > M_PI_2 )    ang_diff = M_PI - ang_diff;
+
+            // location from point, but direction is the representative's
+            if ( ang_diff > maxAngle )
+                continue;
+
+            if ( !Claim::take(owner[pid2], stamp, minStamp) )
+                return false;
+            patch.push_back( segmentation::PidLid(pid2,-1) );
+            patch.updateWithPoint( store[pid2] );
+
+            // enqueue for visit
+            privateSeeds.push_back( pid2 );
+        } //...for neighs
+    } //...while privateSeeds
+
+    return true;
+} //...Segmentation::_growPatch()
+
 /*  \brief                               Greedy region growing
  *  \tparam _PrimitiveContainerT         Concept: std::vector<\ref rapter::LinePrimitive2>
  *  \tparam _PointContainerT             Concept: std::vector<\ref rapter::PointPrimitive>
@@ -389,6 +488,7 @@ Segmentation::regionGrow( _PointContainerT                       & points
                         , GidT                              const  gid_tag_name
                         , int                               const  nn_K
                         , bool                              const  verbose
+                        , PointStore<_PointPrimitiveT>      const* pointStore
                         )
 {
     std::cout << "[" << __func__ << "]: " << "running with " << patchPatchDistanceFunctor.toString() << std::endl;
@@ -400,7 +500,8 @@ Segmentation::regionGrow( _PointContainerT                       & points
 
     // create patches with a single point in them
     std::cout << "[" << __func__ << "]: " << "starting deque" << std::endl; fflush(stdout);
-    std::deque<PidT> seeds;
+    std::vector<PidT> seeds;
+    seeds.reserve( points.size() );
     for ( UPidT pid = 0; pid != points.size(); ++pid )
     {
         //const int pid = point_ids_arg ? (*point_ids_arg)[ pid_id ] : pid_id;
@@ -411,206 +512,94 @@ Segmentation::regionGrow( _PointContainerT                       & points
     std::cout << "[" << __func__ << "]: " << "finished deque" << std::endl; fflush(stdout);
     std::random_shuffle( seeds.begin(), seeds.end() );
 
-    // prebulid ann cloud
-    std::cout << "[" << __func__ << "]: " << "starting create ann cloud" << std::endl; fflush(stdout);
-    pcl::PointCloud<pcl::PointXYZ>::Ptr ann_cloud( new pcl::PointCloud<pcl::PointXYZ>() );
+    // positions and orientations are read from a structure-of-arrays copy, that also holds the neighbour index
+    PointStore<_PointPrimitiveT> localStore;
+    if ( !pointStore )
     {
-        ann_cloud->resize( points.size() );
-#       pragma omp parallel for
-        for ( size_t pid = 0; pid < points.size(); ++pid )
-            ann_cloud->at(pid).getVector3fMap() = points[pid].template pos();
+        localStore.assign( points );
+        pointStore = &localStore;
     }
-    std::cout << "[" << __func__ << "]: " << "finished create ann cloud" << std::endl; fflush(stdout);
-
-    std::cout << "[" << __func__ << "]: " << "starting create ann TREE" << std::endl; fflush(stdout);
-    typename pcl::search::KdTree<pcl::PointXYZ>::Ptr tree( new pcl::search::KdTree<pcl::PointXYZ> );
-    tree->setInputCloud( ann_cloud );
-    std::cout << "[" << __func__ << "]: " << "finished create ann TREE" << std::endl; fflush(stdout);
-
-    //Patches patches; patches.reserve( std::max(1.5*sqrt(points.size()),10.) );
-    std::vector< Patches > patchesVector( RAPTER_MAX_OMP_THREADS );
-    for ( size_t i = 0; i != patchesVector.size(); ++i )
-        patchesVector[i].reserve( std::max(1.5*sqrt(points.size()),1000.) );
-
-    // get unassigned point
-    const char VISITED = 2;
-    const char ASSIGNED = 1;
-    std::vector<char> status( points.size(), 0 );
-//    std::vector<bool> assigned( points.size(), false );
-//    std::vector<bool> visited( points.size(), false );
+    PointStore<_PointPrimitiveT> const& store = *pointStore;
 
     const _Scalar       max_dist            = patchPatchDistanceFunctor.getSpatialThreshold();// * _Scalar(3.5); // longest axis of ellipse)
 
-    unsigned step_count = 0; // for logging
-    //int tid; //omp thread_id
+    // neighbour index, shared with orientPoints, if it was built there
+    std::cout << "[" << __func__ << "]: " << "starting create ann index" << std::endl; fflush(stdout);
+    typedef processing::SpatialHash<_Scalar> SpatialIndexT;
+    typedef typename SpatialIndexT::DistPid  DistPid;
+    SpatialIndexT const& index = store.getSpatialIndex( max_dist );
+    std::cout << "[" << __func__ << "]: " << "finished create ann index" << std::endl; fflush(stdout);
+
+    const int threadCount = RAPTER_MAX_OMP_THREADS;
+
+    // Seeds are taken in batches. The patches of a batch are grown in parallel, and committed in seed order.
+    // A patch gives up, when it wants a point an earlier patch of its batch took, and is grown again at commit, as is a patch that overlaps
+    // an earlier one after all. So the patches are the ones a single thread growing them in seed order would find, at any thread count.
+    Patches             patches;
+    patches.reserve( std::max(1.5*sqrt(points.size()),1000.) );
+    std::vector<char>   assigned( points.size(), 0 );
+    std::vector< std::atomic<unsigned> > owner( points.size() ); // stamp 2*rank+1: grown in parallel, 2*rank+2: grown again at commit
+#   pragma omp parallel for num_threads(threadCount)
+    for ( long pid = 0; pid < static_cast<long>(points.size()); ++pid )
+        owner[pid].store( 0 );
+    const size_t        batchSize       = 16 * threadCount;
+    Patches             batch( batchSize );
+    std::vector<char>   complete( batchSize );
+    unsigned            regrown         = 0; // for logging
+
     TIC
     // look for neighbours, merge most similar
     std::cout << "[" << __func__ << "]: " << "starting reggrow loop" << std::endl; fflush(stdout);
-    std::map< PidT, int > patchesVectorId;
-#   pragma omp parallel num_threads(RAPTER_MAX_OMP_THREADS) shared(seeds)
-    while ( seeds.size() )
+#   pragma omp parallel num_threads(threadCount)
+    for ( size_t first = 0; first < seeds.size(); first += batchSize )
     {
-        const int tid = omp_get_thread_num();
-        std::vector< int >  neighs( nn_K );
-        std::vector<float>  sqr_dists( nn_K );
-
-        //PidT                found_points_count  = 0;
-        pcl::PointXYZ       searchPoint;
+        const size_t last = std::min( first + batchSize, seeds.size() );
 
-        PidT seed = -1;
-        std::deque<PidT> privateSeeds;
+#       pragma omp for schedule(dynamic,1)
+        for ( long rank = first; rank < static_cast<long>(last); ++rank )
         {
-            bool quit = false;
-#           pragma omp critical (RG_SEEDS)
-            {
-                if ( !seeds.size() )    quit = true;
-                else
-                {
-                    seed = seeds.front();
-                    seeds.pop_front();
-                }
-            }
-            if ( quit ) continue;
-
-            privateSeeds.push_front( seed );
-#pragma omp critical (RG_PVID)
-            {
-                patchesVectorId[ seed ] = tid;
-            }
-
-            // add to new cluster
-            {
-                bool addPatch = false;
-#               pragma omp critical (RG_STATUS)
-                {
-                    if ( !(status[seed] & ASSIGNED) )
-                    {
-                        status[ seed ] |= ASSIGNED;
-                        addPatch       = true;
-                    }
-                } //...assigned
-
-                if ( addPatch )
-                {
-#                   pragma omp critical (RG_PVID)
-                    {
-                        PatchT tmp_patch; tmp_patch.push_back( segmentation::PidLid(seed,-1) );
-                        patchesVector[patchesVectorId[seed]].push_back( tmp_patch );
-                        patchesVector[patchesVectorId[seed]].back().update( points );
-                    }
-                } //...if addPatch
-            } //...new cluster
-        } // init privateSeeds
-
-        while ( privateSeeds.size() )
+            PatchT &patch = batch[ rank - first ];
+            patch = PatchT();
+            complete[ rank - first ] = !assigned[seeds[rank]]
+                                       && _growPatch( patch, seeds[rank], assigned, owner, 2 * rank + 1, 2 * first + 1, store, index, max_dist, patchPatchDistanceFunctor.getAngularThreshold() );
+        } //...for batch
+
+#       pragma omp single
+        for ( size_t rank = first; rank != last; ++rank )
         {
-            if ( tid != omp_get_thread_num() )
-            {
-                std::cout << "[" << __func__ << "]: " << "tid " << tid << " != " << omp_get_thread_num() << std::endl;
-            }
-            //tid = omp_get_thread_num();
-
-            //        #pragma omp critical (RG_COUT)
-            //std::cout << "thread_id: " << tid << std::endl; fflush(stdout);
-
-            if ( verbose && !(++step_count % 50000) )
+            if ( verbose && !((rank + 1) % 50000) )
             {
-                std::cout << seeds.size() << " "; fflush(stdout);
+                std::cout << rank << " "; fflush(stdout);
             }
 
-            // remove point from unassigned
-            PidT pid = -1;
-            pid = privateSeeds.front();
-            privateSeeds.pop_front();
+            PatchT &patch = batch[ rank - first ];
+            const PidT seed = seeds[ rank ];
+            if ( assigned[seed] )
+                continue;
 
+            bool valid = complete[ rank - first ];
+            for ( size_t pid_id = 0; (pid_id != patch.size()) && valid; ++pid_id )
+                valid = !assigned[ patch[pid_id].first ];
+            if ( !valid )
             {
-                bool quit = false;
-#               pragma omp critical (RG_STATUS)
-                {
-                    if ( status[pid] & VISITED ) quit          = true;
-                    else                         status[pid] |= VISITED;
-                }
-                if ( quit ) continue;
-            }
-
-            // look for unassigned neighbours
-#pragma omp critical (RG_KDTREE)
-            {
-                searchPoint.getVector3fMap() = points[ pid ].template pos();
-                /*found_points_count = */ tree->radiusSearch( searchPoint, max_dist, neighs, sqr_dists, 0);
+                patch = PatchT();
+                _growPatch( patch, seed, assigned, owner, 2 * rank + 2, 2 * rank + 2, store, index, max_dist, patchPatchDistanceFunctor.getAngularThreshold() );
+                ++regrown;
             }
 
-            for ( size_t pid_id = 1; pid_id < neighs.size(); ++pid_id )
-            {
-                const PidT pid2 = neighs[ pid_id ];
-
-                // if !assigned[pid2]
-                {
-                    bool quit = false;
-#                   pragma omp critical (RG_STATUS)
-                    {
-                        if ( status[pid2] & ASSIGNED )   quit = true;
-                    }
-                    if ( quit ) continue;
-                }
-
-                _Scalar ang_diff( 0. );
-#               pragma omp critical (RG_PVID)
-                {
-                    ang_diff = rapter::angleInRad( patchesVector[patchesVectorId[seed]].back().template dir(), points[pid2].template dir() );
-                }
-                // map 90..180 to 0..90:
-                if ( ang_diff > M_PI_2 )    ang_diff = M_PI - ang_diff;
-
-                // location from point, but direction is the representative's
-                if (     (ang_diff > patchPatchDistanceFunctor.getAngularThreshold())
-                     //|| ((points[pid].template pos() - points[pid2].template pos()).norm() > max_dist)
-                         ) // original condition
-                    continue;
-
-#               pragma omp critical (RG_STATUS)
-                {
-                    status[pid2] |= ASSIGNED;
-#                   pragma omp critical (RG_PVID)
-                    {
-                        patchesVector[patchesVectorId[seed]].back().push_back( segmentation::PidLid(pid2,-1) );
-                        patchesVector[patchesVectorId[seed]].back().updateWithPoint( points[pid2] );
-                    }
-                } //...RG_PATCHES
-
-                //#pragma omp critical (RG_PRIV_SEEDS)
-                {
-                    // enqueue for visit
-                    //seeds.push_front( pid2 );
-                    privateSeeds.push_front( pid2 );
-                }
-            }
-        } //...while privateSeeds
-#                   pragma omp critical (RG_PVID)
-        {
-            if ( patchesVectorId.find(seed) == patchesVectorId.end() ) std::cerr << "[" << tid << "] can't find seed point ..." << std::endl;
-            patchesVectorId.erase( seed );
-        }
-    } //...while seeds
-
-    for ( size_t i = 1; i < patchesVector.size(); ++i )
-    {
-        patchesVector[0].reserve( patchesVector.size() + patchesVector[i].size() );
-        for ( size_t j = 0; j < patchesVector[i].size(); ++j )
-            if ( patchesVector[i][j].getSize() )
-                patchesVector[0].push_back( patchesVector[i][j] );
-            else
-                std::cout << "[" << __func__ << "]: " << "empty group created...." << std::endl;
-        //patchesVector[0].insert( patchesVector[0].end(), patchesVector[i].begin(), patchesVector[i].end() );
-    }
+            for ( size_t pid_id = 0; pid_id != patch.size(); ++pid_id )
+                assigned[ patch[pid_id].first ] = 1;
+            patches.push_back( patch );
+        } //...commit
+    } //...omp parallel
 
     std::cout << std::endl;
     TOC( "Reggrow", 1)
-    std::cout << "[" << __func__ << "]: " << "finished reggrow loop" << std::endl; fflush(stdout);
+    std::cout << "[" << __func__ << "]: " << "finished reggrow loop, " << regrown << " / " << patches.size() << " patches regrown at commit" << std::endl; fflush(stdout);
 
     // copy patches to groups
     std::cout << "[" << __func__ << "]: " << "copying patches" << std::endl; fflush(stdout);
-    groups_arg.insert( groups_arg.end(), patchesVector[0].begin(), patchesVector[0].end() );
+    groups_arg.insert( groups_arg.end(), patches.begin(), patches.end() );
     std::cout << "[" << __func__ << "]: " << "finished copying patches" << std::endl; fflush(stdout);
 
     // assign points to patches
@@ -621,29 +610,49 @@ Segmentation::regionGrow( _PointContainerT                       & points
     // gather orphans
     // add left out points to closest patch
 #if 1
-    std::vector<int> neighs(nn_K);
-    std::vector<float>  sqr_dists( nn_K );
-#   pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) private(neighs,sqr_dists)
-    for ( UPidT pid = 0; pid < points.size(); ++pid )
+    // The neighbours' gids are read before any orphan is changed, and sweeps are repeated, until no orphan takes over a gid.
+    // Chains of orphans are filled from the patches outwards, and the result does not depend on the thread count.
+    std::vector<GidT> orphanGids( points.size(), _PointPrimitiveT::LONG_VALUES::UNSET );
+    unsigned useful = 0, notUseful = 0, sweeps = 0;
+    for ( bool changed = true; changed; ++sweeps )
     {
-        if ( points[pid].getTag( gid_tag_name ) != _PointPrimitiveT::LONG_VALUES::UNSET ) continue;
-
-        #pragma omp critical (RG_KDTREE)
+        unsigned sweepUseful = 0, sweepNotUseful = 0;
+#       pragma omp parallel num_threads(threadCount) reduction(+:sweepUseful,sweepNotUseful)
         {
-            pcl::PointXYZ       searchPoint;
-            searchPoint.getVector3fMap() = points[ pid ].template pos();
-            tree->radiusSearch( searchPoint, 0., neighs, sqr_dists, nn_K );
+            std::vector<DistPid> neighs;
+#           pragma omp for schedule(dynamic,1024)
+            for ( long pid = 0; pid < static_cast<long>(points.size()); ++pid )
+            {
+                if ( points[pid].getTag( gid_tag_name ) != _PointPrimitiveT::LONG_VALUES::UNSET ) continue;
+
+                index.radiusSearch( store.pos(pid), _Scalar(0), neighs, nn_K );
+
+                for ( size_t pid_id = 0; pid_id != neighs.size(); ++pid_id )
+                    if ( points[neighs[pid_id].second].getTag( _PointPrimitiveT::TAGS::GID ) != _PointPrimitiveT::LONG_VALUES::UNSET )
+                    {
+                        ++sweepUseful;
+                        orphanGids[pid] = points[neighs[pid_id].second].getTag( _PointPrimitiveT::TAGS::GID );
+                        break;
+                    }
+                if ( !neighs.size() )
+                    ++sweepNotUseful;
+            }
         }
-        for ( size_t pid_id = 0; pid_id != neighs.size(); ++pid_id )
-            if ( points[neighs[pid_id]].getTag( _PointPrimitiveT::TAGS::GID ) != _PointPrimitiveT::LONG_VALUES::UNSET )
+
+        changed = false;
+        for ( UPidT pid = 0; pid != orphanGids.size(); ++pid )
+            if ( orphanGids[pid] != _PointPrimitiveT::LONG_VALUES::UNSET )
             {
-                std::cout << "useful " << std::endl; fflush(stdout);
-                points[pid].setTag( gid_tag_name, points[neighs[pid_id]].getTag(_PointPrimitiveT::TAGS::GID) );
-                break;
+                points[pid].setTag( gid_tag_name, orphanGids[pid] );
+                orphanGids[pid] = _PointPrimitiveT::LONG_VALUES::UNSET;
+                changed = true;
             }
-        if ( !neighs.size() )
-            std::cout << "not useful" << std::endl;
+        useful += sweepUseful;
+        if ( !sweeps )
+            notUseful = sweepNotUseful;
     }
+    if ( useful || notUseful )
+        std::cout << "[" << __func__ << "]: " << "orphans assigned: " << useful << ", without neighbours: " << notUseful << " in " << sweeps << " sweeps" << std::endl;
 #endif
 
     return EXIT_SUCCESS;
@@ -756,9 +765,10 @@ Segmentation::segmentCli( int    argc
     // Read points
     bool isOriented = false;
     _PointContainerT points;
+    PointStore<_PointPrimitiveT> pointStore; // structure-of-arrays copy shared by orientPoints and regionGrow
     if ( EXIT_SUCCESS == err )
     {
-        err = io::readPoints<_PointPrimitiveT>( points, cloud_path );
+        err = io::readPoints<_PointPrimitiveT>( points, cloud_path, NULL, &pointStore );
         if ( err != EXIT_SUCCESS )  std::cerr << "[" << __func__ << "]: " << "readPoints returned error " << err << std::endl;
         unsigned long normalCnt = 0;
         for ( size_t i = 0; i != points.size(); ++i )
@@ -769,7 +779,6 @@ Segmentation::segmentCli( int    argc
             std::cout << "more than 50% of the normals seem set, so assuming oriented cloud\n";
             isOriented = true;
         }
-
     } //...read points
 
     //_____________________WORK_______________________
@@ -778,7 +787,7 @@ Segmentation::segmentCli( int    argc
     // orientPoints
     if ( (EXIT_SUCCESS == err) && !isOriented )
     {
-        err = Segmentation::orientPoints<_PointPrimitiveT,_PrimitiveT>( points, generatorParams.scale, generatorParams.nn_K, verbose );
+        err = Segmentation::orientPoints<_PointPrimitiveT,_PrimitiveT>( points, generatorParams.scale, generatorParams.nn_K, verbose, &pointStore );
         if ( err != EXIT_SUCCESS ) std::cerr << "[" << __func__ << "]: " << "orientPoints exited with error! Code: " << err << std::endl;
     } //...orientPoints
 
@@ -803,6 +812,7 @@ Segmentation::segmentCli( int    argc
                                             , generatorParams.nn_K
                                             , verbose
                                             , ((generatorParams.patch_population_limit > 0) ? generatorParams.patch_population_limit : 0)
+                                            , &pointStore
                                             );
             }
                 break;
@@ -11,6 +11,10 @@
 #   include "qcqpcpp/bonminOptProblem.h"
 #endif
 
+#ifdef RAPTER_WITH_GCO
+#   include "rapter/optimization/gcoOpt.h"
+#endif
+
 #include "rapter/util/diskUtil.hpp"                 // saveBAckup
 #include "rapter/util/util.hpp"                     // timestamp2Str
 
@@ -18,28 +22,32 @@
 //#include "rapter/optimization/candidateGenerator.h" // generate()
 //#include "rapter/optimization/energyFunctors.h"     // PointLineDistanceFunctor,
 #include "rapter/optimization/problemSetup.h"         // everyPatchNeedsDirection()
+#include "rapter/optimization/localSearchOpt.h"       // LocalSearchOpt
 #include "rapter/processing/diagnostic.hpp"           // Diagnostic
 #include "rapter/processing/impl/angleUtil.hpp"
 
 namespace rapter
 {
 
-//! \brief      Step 3. Reads a formulated problem from path and runs qcqpcpp::OptProblem::optimize() on it.
-//! \param argc Number of command line arguments.
-//! \param argv Vector of command line arguments.
-//! \return     Exit code. 0 == EXIT_SUCCESS.
+//! \brief           Step 3. Reads a formulated problem from path and runs qcqpcpp::OptProblem::optimize() on it.
+//! \param argc      Number of command line arguments.
+//! \param argv      Vector of command line arguments.
+//! \param problemIn Problem formulated in memory by \ref ProblemSetup::formulateCli(), or NULL to read --problem (a csv directory, or a ".bin" file).
+//!                  It is swapped into the solver, and back after each attempt, instead of being copied.
+//! \return          Exit code. 0 == EXIT_SUCCESS.
 template <class _PrimitiveContainerT
          , class _InnerPrimitiveContainerT
          , class _PrimitiveT
          >
 int
-Solver::solve( int    argc
-             , char** argv )
+Solver::solve( int                              argc
+             , char**                           argv
+             , problemSetup::OptProblemT      * problemIn /* = NULL */ )
 {
     int                                   err           = EXIT_SUCCESS;
 
     bool                                  verbose       = false;
-    enum SOLVER { MOSEK, BONMIN, GUROBI } solver        = MOSEK;
+    enum SOLVER { MOSEK, BONMIN, GUROBI, LOCAL, GCO } solver = MOSEK;
     std::string                           project_path  = "problem", solver_str = "bonmin";
     Scalar                                max_time      = 360;
     int                                   bmode         = 0; // Bonmin solver mode, B_Bb by default
@@ -47,6 +55,8 @@ Solver::solve( int    argc
     std::string                           x0_path       = "";
     int                                   attemptCount  = 0;
     std::string                           energy_path        = "energy.csv";
+    LidT                                  stagnationLimit = 1000; // local search stops after this many iterations without improvement
+    Scalar                                labelCost     = 0.; // alpha-expansion: complexity weight of formulate, charged per used direction
 
     // parse
     {
@@ -63,6 +73,8 @@ Solver::solve( int    argc
                  if ( !solver_str.compare("mosek")  ) solver = MOSEK;
             else if ( !solver_str.compare("bonmin") ) solver = BONMIN;
             else if ( !solver_str.compare("gurobi") ) solver = GUROBI;
+            else if ( !solver_str.compare("local")  ) solver = LOCAL;
+            else if ( !solver_str.compare("gco")    ) solver = GCO;
             else
             {
                 std::cerr << "[" << __func__ << "]: " << "Cannot parse solver " << solver_str << std::endl;
@@ -72,6 +84,10 @@ Solver::solve( int    argc
                  if ( solver == BONMIN )
                      throw new std::runtime_error("You have to specify a different solver, the project was not compiled with Bonmin enabled!");
 #           endif // WITH_BONMIN
+#           ifndef RAPTER_WITH_GCO
+                 if ( solver == GCO )
+                     throw new std::runtime_error("You have to specify a different solver, the project was not compiled with GCO enabled!");
+#           endif // WITH_GCO
         }
         // problem parsing
         pcl::console::parse_argument( argc, argv, "--problem", project_path );
@@ -80,21 +96,30 @@ Solver::solve( int    argc
         // parse bonmin solver mode
         pcl::console::parse_argument( argc, argv, "--bmode", bmode );
         pcl::console::parse_argument( argc, argv, "--rod"  , rel_out_path );
+        pcl::console::parse_argument( argc, argv, "--ls-stagnation", stagnationLimit );
+        pcl::console::parse_argument( argc, argv, "--cmp", labelCost );
 
         // X0
         if (pcl::console::parse_argument( argc, argv, "--x0", x0_path ) >= 0)
         {
-            if ( !boost::filesystem::exists(x0_path) )
+            if ( (x0_path != "local") && !boost::filesystem::exists(x0_path) )
             {
                 std::cerr << "[" << __func__ << "]: " << "X0 path does not exist! " << x0_path << std::endl;
                 valid_input = false;
             }
+            else if ( (x0_path == "local") && (solver == LOCAL) )
+            {
+                std::cerr << "[" << __func__ << "]: " << "--x0 local needs --solver bonmin, the local search can not start from itself" << std::endl;
+                valid_input = false;
+            }
+            else if ( (solver != BONMIN) && (solver != LOCAL) )
+                std::cerr << "[" << __func__ << "]: " << "--x0 is only used by --solver bonmin and --solver local, ignoring it" << std::endl;
         }
 
         // usage print
         std::cerr << "[" << __func__ << "]: " << "Usage:\t gurobi_opt\n"
-                  << "\t--solver *" << solver_str << "* (mosek | bonmin | gurobi)\n"
-                  << "\t--problem " << project_path << "\n"
+                  << "\t--solver *" << solver_str << "* (mosek | bonmin | gurobi | local | gco)\t local: greedy + tabu search, feasible, not proven optimal; gco: alpha-expansion, one direction per patch, needs --candidates\n"
+                  << "\t--problem " << project_path << "\t Directory of csv matrices, or a \".bin\" file\n"
                   << "\t[--time] " << max_time << "\n"
                   << "\t[--bmode *" << bmode << "*\n"
                          << "\t\t0 = B_BB, Bonmin\'s Branch-and-bound \n"
@@ -105,7 +130,9 @@ Solver::solve( int    argc
                          << "\t\t5 = B_IFP Bonmin's implemantation of iterated feasibility pump for MINLP]\n"
                   << "\t[--verbose] " << "\n"
                   << "\t[--rod " << rel_out_path << "]\t\t Relative output directory\n"
-                  << "\t[--x0 " << x0_path << "]\t Path to starting point sparse matrix\n"
+                  << "\t[--x0 " << x0_path << "]\t Path to starting point sparse matrix (i.e. x.csv of --solver local), or \"local\" to run the local search first. Used by --solver bonmin and local\n"
+                  << "\t[--ls-stagnation " << stagnationLimit << "]\t Local search stops after this many iterations without improvement\n"
+                  << "\t[--cmp " << labelCost << "]\t Complexity weight used by --formulate, gco charges it once per used direction\n"
                   << "\t[--help, -h] "
                   << std::endl;
 
@@ -127,13 +154,49 @@ Solver::solve( int    argc
         typedef qcqpcpp::OptProblem<OptScalar>  OptProblemT;
         typedef OptProblemT::SparseMatrix       SparseMatrix;
         OptProblemT *p_problem = NULL;
+        bool         swappedIn = false; // problemIn is in p_problem, and has to be handed back
         if ( EXIT_SUCCESS == err )
         {
             switch ( solver )
             {
+#           ifdef RAPTER_WITH_BONMIN
                 case BONMIN:
                     p_problem = new qcqpcpp::BonminOpt<OptScalar>();
                     break;
+#           endif // WITH_BONMIN
+
+                case LOCAL:
+                    p_problem = new LocalSearchOpt<OptScalar>();
+                    static_cast<LocalSearchOpt<OptScalar>*>(p_problem)->setStagnationLimit( stagnationLimit );
+                    break;
+
+#           ifdef RAPTER_WITH_GCO
+                case GCO:
+                {
+                    // every variable is a non-small candidate (see output below), its patch is the site, its direction the label
+                    std::vector<LidT> sites, labels;
+                    std::string candidates_path;
+                    if ( pcl::console::parse_argument( argc, argv, "--candidates", candidates_path ) >= 0 )
+                    {
+                        _PrimitiveContainerT prims;
+                        io::readPrimitives<_PrimitiveT, _InnerPrimitiveContainerT>( prims, candidates_path );
+                        for ( size_t l = 0; l != prims.size(); ++l )
+                            for ( size_t l1 = 0; l1 != prims[l].size(); ++l1 )
+                                if ( prims[l][l1].getTag( _PrimitiveT::TAGS::STATUS ) != _PrimitiveT::STATUS_VALUES::SMALL )
+                                {
+                                    sites .push_back( prims[l][l1].getTag(_PrimitiveT::TAGS::GID    ) );
+                                    labels.push_back( prims[l][l1].getTag(_PrimitiveT::TAGS::DIR_GID) );
+                                }
+                    }
+                    else
+                        std::cerr << "[" << __func__ << "]: " << "--solver gco needs --candidates" << std::endl;
+
+                    GcoOpt<OptScalar>* p_gcoProblem = new GcoOpt<OptScalar>();
+                    p_gcoProblem->setLabeling( sites, labels, labelCost );
+                    p_problem = p_gcoProblem;
+                    break;
+                }
+#           endif // WITH_GCO
 
                 default:
                     std::cerr << "[" << __func__ << "]: " << "Unrecognized solver type, exiting" << std::endl;
@@ -145,7 +208,15 @@ Solver::solve( int    argc
         // problem.read()
         if ( EXIT_SUCCESS == err )
         {
-            err += p_problem->read( project_path );
+            if ( problemIn )
+            {
+                p_problem->swap( *problemIn ); // moves the problem in, keeps the solver specific state
+                swappedIn = true;
+            }
+            else if ( io::columnar::isBinaryPath(project_path) )
+                err += io::columnar::readProblem( *p_problem, project_path );
+            else
+                err += p_problem->read( project_path );
             if ( EXIT_SUCCESS != err )
                 std::cerr << "[" << __func__ << "]: " << "Could not read problem, exiting" << std::endl;
         } //...problem.read()PrimitiveT
@@ -166,7 +237,25 @@ Solver::solve( int    argc
 //                    p_bonminProblem->setMaxSolutions( 1 ); // this is evil
 //                }
                 OptProblemT::SparseMatrix x0;
-                if ( !x0_path.empty() )
+                if ( x0_path == "local" )
+                {
+                    // warm start from the local search, on a copy of the problem
+                    LocalSearchOpt<OptScalar> localSearch;
+                    static_cast<OptProblemT&>( localSearch ) = *p_problem;
+                    localSearch.setStagnationLimit( stagnationLimit );
+                    std::vector<OptScalar> x_local;
+                    if ( (EXIT_SUCCESS == localSearch.update(verbose)) && (EXIT_SUCCESS == localSearch.optimize(&x_local)) )
+                    {
+                        x0.resize( x_local.size(), 1 );
+                        for ( size_t i = 0; i != x_local.size(); ++i )
+                            if ( x_local[i] > 0. )
+                                x0.insert( i, 0 ) = x_local[i];
+                        p_bonminProblem->setStartingPoint( x0 );
+                    }
+                    else
+                        std::cerr << "[" << __func__ << "]: " << "local search found no feasible starting point, starting without" << std::endl;
+                }
+                else if ( !x0_path.empty() )
                 {
                     x0 = qcqpcpp::io::readSparseMatrix<OptScalar>( x0_path, 0 );
                     static_cast<qcqpcpp::BonminOpt<OptScalar>*>(p_problem)->setStartingPoint( x0 );
@@ -174,6 +263,11 @@ Solver::solve( int    argc
 
 #           endif // WITH_BONMIN
             }
+            else if ( (solver == LOCAL) && !x0_path.empty() )
+            {
+                // the local search starts from x0 instead of nothing selected, see LocalSearchOpt::optimize()
+                p_problem->setStartingPoint( qcqpcpp::io::readSparseMatrix<OptScalar>(x0_path, 0) );
+            }
         }
 
         // problem.update()
@@ -239,7 +333,14 @@ Solver::solve( int    argc
             {
                 Diagnostic<OptScalar> diag( p_problem->getLinObjectivesMatrix(), p_problem->getQuadraticObjectivesMatrix() );
                 {
-                    std::string x_path = project_path + "/x.csv";
+                    std::string x_dir = project_path;
+                    if ( io::columnar::isBinaryPath(project_path) )
+                    {
+                        x_dir = boost::filesystem::path(project_path).parent_path().string();
+                        if ( x_dir.empty() ) x_dir = ".";
+                    }
+                    boost::filesystem::create_directories( x_dir ); // not written by formulate, if handed over in memory
+                    std::string x_path = x_dir + "/x.csv";
                     OptProblemT::SparseMatrix sp_x( x_out.size(), 1 ); // output colvector
                     for ( size_t i = 0; i != x_out.size(); ++i )
                     {
@@ -385,6 +486,8 @@ Solver::solve( int    argc
 
         } //...problem.optimize()
 
+        // hand the problem back, for the next attempt
+        if ( swappedIn ) p_problem->swap( *problemIn );
         if ( p_problem ) { delete p_problem; p_problem = NULL; }
     } //...err == doRetry || exit_SUCCESS
 
@@ -0,0 +1,137 @@
+#ifndef RAPTER_LOCALSEARCHOPT_H
+#define RAPTER_LOCALSEARCHOPT_H
+
+#include <vector>
+#include "Eigen/Sparse"
+#include "qcqpcpp/optProblem.h"     // OptProblem
+#include "rapter/simpleTypes.h"     // LidT, RAPTER_MAX_OMP_THREADS
+
+namespace rapter {
+
+/*! \brief  Native heuristic backend for the binary selection problems formulated by \ref ProblemSetup, selected by --solver local.
+ *
+ *          Minimizes qo' * x + x' * Qo * x over binary x, subject to lower(i) <= A(i,:) * x + x' * Qi * x <= upper(i).
+ *          Starts from the starting point (or all zeros), descends greedily, then runs tabu search over 1-flip and 2-swap moves.
+ *          A 2-swap turns off a selected variable, and turns on an unselected one sharing a constraint with it,
+ *          so a patch can change its direction without uncovering the "every patch needs a direction" constraint in between.
+ *          Moves compare by total constraint violation first, and by objective second, so infeasible starts are repaired first.
+ *          Every iteration evaluates all moves in parallel, and takes the best one, that is not tabu.
+ *
+ *          Stops at the time limit (setTimeLimit()), after #setMaxIterations() iterations,
+ *          or after #setStagnationLimit() iterations without a better feasible solution.
+ *          The result is feasible, but not proven optimal. It is a good --x0 starting point for Bonmin, see \ref Solver::solve().
+ *
+ *  \tparam _Scalar Precision of the problem, double for the problems of \ref problemSetup::OptProblemT.
+ */
+template <typename _Scalar>
+class LocalSearchOpt : public qcqpcpp::OptProblem<_Scalar>
+{
+    public:
+        typedef qcqpcpp::OptProblem<_Scalar>                ParentType;
+        typedef typename ParentType::SparseMatrix           SparseMatrix;
+        typedef typename ParentType::OBJ_SENSE              OBJ_SENSE;
+
+        LocalSearchOpt()
+            : _maxIterations  ( 100000 )
+            , _stagnationLimit( 1000 )
+            , _tabuTenure     ( 10 )
+            , _verbose        ( false )
+            , _sign           ( 1 )
+        {}
+        virtual ~LocalSearchOpt() {}
+
+        /*! \brief          Builds the symmetric objective, and the variable-constraint incidence used by #optimize().
+         *  \return         EXIT_SUCCESS, or EXIT_FAILURE, if a variable is not binary, i.e. its bounds are not within [0,1].
+         */
+        virtual int update( bool verbose = false );
+
+        /*! \brief                  Runs the search. Call #update() before.
+         *  \param[out] x_out       The best feasible solution, or the least violating one, if no feasible was found.
+         *  \param objective_sense  Minimization or maximization.
+         *  \return                 EXIT_SUCCESS, or EXIT_FAILURE, if no feasible solution was found.
+         */
+        virtual int optimize( std::vector<_Scalar> *x_out = NULL, OBJ_SENSE objective_sense = ParentType::MINIMIZE );
+
+        inline void setMaxIterations  ( LidT const iterations ) { _maxIterations   = iterations; }
+        inline void setStagnationLimit( LidT const iterations ) { _stagnationLimit = iterations; } //!< \brief Iterations without improvement to stop after.
+        inline void setTabuTenure     ( LidT const iterations ) { _tabuTenure      = iterations; } //!< \brief Iterations a flipped variable stays unchanged.
+
+    protected:
+        //! \brief Turns variable #on on, and #off off, -1 if unused. Changes total violation by #dViol, and objective by #dObj.
+        struct Move
+        {
+            Move() : on( -1 ), off( -1 ), dViol( 0 ), dObj( 0 ) {}
+            LidT    on, off;
+            _Scalar dViol, dObj;
+        }; //...Move
+
+        //! \brief Entry Qi(var,other) of constraint #constr, stored at both variables.
+        struct QTerm
+        {
+            LidT    constr, other;
+            _Scalar coeff;
+        }; //...QTerm
+
+        //! \brief Per-thread dense accumulator of constraint activity changes.
+        struct Scratch
+        {
+            std::vector<_Scalar> delta;     //!< \brief Activity change per constraint.
+            std::vector<char>    seen;      //!< \brief True, if in #touched.
+            std::vector<LidT>    touched;   //!< \brief Constraints with a change.
+        }; //...Scratch
+
+        //! \brief Violation of constraint \p c at activity \p act.
+        inline _Scalar violation( LidT const c, _Scalar const act ) const
+        {
+            return std::max( _Scalar(0), _lower[c] - act ) + std::max( _Scalar(0), act - _upper[c] );
+        }
+
+        //! \brief Value of \p var, after \p flipped was flipped.
+        inline bool valueAfter( LidT const var, LidT const flipped ) const { return _x[var] != (var == flipped); }
+
+        //! \brief Adds the activity changes of flipping \p var to \p scratch, after \p flipped was flipped (-1 for none).
+        inline void accumulate( LidT const var, LidT const flipped, Scratch &scratch ) const;
+
+        //! \brief Objective change of flipping \p var, after \p flipped was flipped (-1 for none).
+        inline _Scalar objectiveDelta( LidT const var, LidT const flipped ) const;
+
+        //! \brief Sums the violation change in \p scratch, and resets it.
+        inline _Scalar collectViolation( Scratch &scratch ) const;
+
+        //! \brief Evaluates flipping \p first, then \p second (-1 for none).
+        inline Move evaluate( LidT const first, LidT const second, Scratch &scratch ) const;
+
+        //! \brief Flips \p var, and updates the objective gradient and the constraint activities.
+        inline void flip( LidT const var, Scratch &scratch );
+
+        //! \brief True, if \p a is better than \p b: less violating, or equally violating with a lower objective.
+        static inline bool isBetter( Move const& a, Move const& b );
+
+        // parameters
+        LidT                    _maxIterations;
+        LidT                    _stagnationLimit;
+        LidT                    _tabuTenure;
+        bool                    _verbose;
+
+        // set by update()
+        SparseMatrix                        _qSym;      //!< \brief Off-diagonal Qo, symmetric, rows are the neighbours of a variable.
+        std::vector<_Scalar>                _lin;       //!< \brief qo plus the diagonal of Qo, the cost of turning a variable on alone.
+        SparseMatrix                        _aT;        //!< \brief A transposed, rows are the constraints of a variable.
+        std::vector< std::vector<QTerm> >   _qTerms;    //!< \brief Qi entries per variable.
+        std::vector< std::vector<LidT> >    _members;   //!< \brief Variables per constraint.
+        std::vector<_Scalar>                _lower;     //!< \brief Constraint lower bounds, -inf, if unbounded.
+        std::vector<_Scalar>                _upper;     //!< \brief Constraint upper bounds, +inf, if unbounded.
+        std::vector<char>                   _fixed;     //!< \brief Variables with equal bounds, never flipped.
+
+        // search state
+        std::vector<char>                   _x;         //!< \brief Current solution.
+        std::vector<_Scalar>                _grad;      //!< \brief _qSym * _x.
+        std::vector<_Scalar>                _activity;  //!< \brief A * _x + _x' * Qi * _x.
+        _Scalar                             _sign;      //!< \brief -1, if maximizing.
+}; //...class LocalSearchOpt
+
+} //...ns rapter
+
+#include "rapter/optimization/impl/localSearchOpt.hpp"
+
+#endif // RAPTER_LOCALSEARCHOPT_H
@@ -8,6 +8,7 @@
 #include "qcqpcpp/optProblem.h"     // OptProblem
 #include "rapter/parameters.h"      // ProblemSetupParams
 #include "rapter/util/pclUtil.h"    // PclCloudPtrT
+#include "rapter/primitives/pointStore.h" // PointStore
 
 namespace rapter
 {
@@ -19,6 +20,45 @@ namespace rapter
         //! \brief General problem type, most implementations require double, so it is fixed to double.
         typedef qcqpcpp::OptProblem<double> OptProblemT;
 
+        /*! \brief  What \ref ProblemSetup::formulate2() computed for the previous candidates, to reuse what did not change in the next iteration (--incremental).
+         *
+         *          Data costs are keyed by <GID,DIR_GID>, and reused, if the candidate's coefficients and the points of its patch did not change.
+         *          Proximities between unchanged patches are kept, only the points of changed patches are searched again.
+         *          Nothing is reused, if #setup (cloud, scale, weights, proximity radius) differs.
+         *          The variable keys map the previous solution (x.csv) to the new variables, see #selected.
+         *          x.csv is the solution of the cached formulation, if its content changed since the cache was written, see #staleSolution.
+         *          Stored by \ref io::columnar::writeFormulationCache().
+         */
+        struct FormulationCache
+        {
+            typedef unsigned long long                      HashT;
+            typedef std::pair<GidT,DidT>                    KeyT;       //!< \brief <GID,DIR_GID> of a candidate.
+            typedef std::pair<GidT,GidT>                    GidPair;
+            typedef std::map< GidT, HashT >                 HashMapT;
+            typedef std::map< KeyT, std::pair<HashT,double> > CostMapT;
+            typedef std::map< LidT, KeyT >                  VarKeyMapT;
+
+            FormulationCache() : setup( 0 ), varCount( 0 ), staleSolution( 0 ) {}
+
+            HashT                                           setup;          //!< \brief Hash of the cloud and parameters, that the entries depend on. 0: empty.
+            HashMapT                                        populations;    //!< \brief Hash of the point ids of each patch.
+            CostMapT                                        dataCosts;      //!< \brief < coefficient hash, data cost > of each candidate.
+            std::vector< GidPair >                          proximities;    //!< \brief Patch pairs closer than the proximity radius, first < second.
+            LidT                                            varCount;       //!< \brief Variable count of the problem, that #varKeys index.
+            VarKeyMapT                                      varKeys;        //!< \brief Candidate of each primitive variable.
+            HashT                                           staleSolution;  //!< \brief Hash of the x.csv, that was there, when the cache was written, 0: none. Not the solution of #varKeys.
+            std::set< KeyT >                                selected;       //!< \brief Not stored. Previous solution, used as starting point instead of the ACTIVE status, if not empty.
+
+            //! \brief FNV-1a hash of \p count bytes, continuing from \p seed.
+            static inline HashT hash( void const* bytes, size_t const count, HashT seed = 14695981039346656037ULL )
+            {
+                unsigned char const* b = static_cast<unsigned char const*>( bytes );
+                for ( size_t i = 0; i != count; ++i )
+                    seed = (seed ^ b[i]) * 1099511628211ULL;
+                return seed;
+            }
+        }; //...FormulationCache
+
         //! \brief              Adds constraints to \p problem so, that each patch (prims[i] that have the same _PrimitiveT::TAGS::GID) has at least one member j (prims[i][j]) selected.
         //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
         template < class _PointPrimitiveDistanceFunctor
@@ -42,6 +82,8 @@ namespace rapter
 
         //! \brief              Adds unary costs to problem based on point to primitive associations.
         //! \tparam _AssocT     Associates a primitive identified by <lid,lid1> with a variable id in the problem. Default: std::map< std::pair<int,int>, int >
+        //! \param[in,out] cache Optional. Costs of candidates outside the \p dirty patches are reused from it, if \p dirty is given, then it's overwritten with the costs of \p prims.
+        //! \param[in] dirty     Patches, whose points changed since \p cache was filled. NULL: nothing is reused.
         template < class _PointPrimitiveDistanceFunctor
                  , class _PrimitiveT        /* = typename _PrimitiveContainerT::value_type::value_type */
                  , class _PointPrimitiveT   /* = typename _PointContainerT::value_type */
@@ -60,7 +102,9 @@ namespace rapter
                                 , _WeightsT            const& weights
                                 , _Scalar              const  scale
                                 , _Scalar              const  freq_weight
-                                , bool                 const  verbose );
+                                , bool                 const  verbose
+                                , FormulationCache          * cache = NULL
+                                , std::set<GidT>       const* dirty = NULL );
     } //... namespace problemSetup
 
     //! \brief Class to formulate problem into an quadratic optimization problem.
@@ -73,6 +117,7 @@ namespace rapter
               *  \tparam _FiniteFiniteDistFunctor Concept: \ref rapter::SpatialSqrtPrimitivePrimitiveEnergyFunctor.
               *  \param argc                     Number of CLI arguments.
               *  \param argv                     Vector of CLI arguments.
+              *  \param problemOut               If not NULL, the problem is formulated into it for \ref Solver::solve(), and only written to disk, if --rod is a ".bin" path.
               *  \return                         Outputs EXIT_SUCCESS or the error the OptProblem implementation returns.
               *  \sa \ref problemSetup::largePatchesNeedDirectionConstraint
                                                          */
@@ -83,7 +128,7 @@ namespace rapter
                      , class _PointPrimitiveT     /*= typename _PointContainerT::value_type*/
                      , class _FiniteFiniteDistFunctor
                      >
-            static inline int formulateCli( int argc, char** argv );
+            static inline int formulateCli( int argc, char** argv, problemSetup::OptProblemT *problemOut = NULL );
 #if 0
             /*! \brief                          Step 2. Reads the output from generate and sets up the optimization problem in form of sparse matrices.
              *  \tparam _PrimitiveContainerT    Concept: vector< vector< \ref rapter::LinePrimitive2 > >.
@@ -146,6 +191,8 @@ namespace rapter
              *  \param[in] dir_id_bias          \copydoc ProblemSetupParams::dir_id_bias.
              *  \param[in] verbose              Debug messages display.
              *  \param[in] freq_weight          Multiplies the data cost by freq_weight / DIR_COUNT.
+             *  \param[in] pointStore           Optional copy of \p points, its positions and neighbour index are reused.
+             *  \param[in,out] cache            Optional. The previous formulation to reuse data costs and proximities from, overwritten with this one.
              *  \return                         Outputs EXIT_SUCCESS or the error the OptProblem implementation returns.
              *  \note                           \p points are assumed to be tagged at _PointPrimitiveT::TAGS::GID with the _PrimitiveT::TAGS::GID of the \p prims.
              *  \sa \ref problemSetup::largePatchesNeedDirectionConstraint
@@ -174,6 +221,8 @@ namespace rapter
                      , _Scalar                                                            const  freq_weight            = 0.
                      , int                                                                const  clusterMode            = 1
                      , _Scalar                                                            const  collapseThreshold      = 0.07 // sqrt( 0.1 * PI / 180 ) == 0.06605545496
+                     , PointStore<_PointPrimitiveT>                                       const* pointStore             = NULL
+                     , problemSetup::FormulationCache                                          * cache                  = NULL
                      );
 
     }; //...class ProblemSetup
@@ -3,9 +3,11 @@
 
 #include <utility> // pair
 #include <vector>
+#include <atomic>
 #include "Eigen/Dense"
 
 #include "rapter/simpleTypes.h"
+#include "rapter/primitives/pointStore.h"
 #include <iostream>
 
 namespace rapter {
@@ -101,6 +103,7 @@ class Segmentation
         //! \param[in/out] points
         //! \param[in]     scale    Fit radius
         //! \param[in]     nn_K     Nearest neighbour count to fit primitive to.
+        //! \param[in,out] pointStore Optional structure-of-arrays copy of \p points. Its search cloud is reused, and its orientations are updated too.
         template < class     _PointPrimitiveT
                  , class     _PrimitiveT
                  , typename  _Scalar
@@ -110,7 +113,8 @@ class Segmentation
         orientPoints( _PointContainerT       &points
                     , _Scalar          const  scale
                     , int              const  nn_K
-                    , int              const  verbose );
+                    , int              const  verbose
+                    , PointStore<_PointPrimitiveT> *pointStore = NULL );
 
         /*!
          * \brief patchify Groups unoriented points into oriented patches represented by a single primitive
@@ -124,6 +128,7 @@ class Segmentation
          * \param[in]  angles                    Desired angles to use for groupings.
          * \param[in]  patchPatchDistanceFunctor #regionGrow() uses the thresholds encoded to group points. The evalSpatial() function is used to assign orphan points.
          * \param[in]  nn_K                      Number of nearest neighbour points looked for in #regionGrow().
+         * \param[in]  pointStore                Optional structure-of-arrays copy of \p points relayed to #regionGrow().
          */
         template <
                  class       _PrimitiveT
@@ -140,6 +145,7 @@ class Segmentation
                 , int                               const  nn_K
                 , int                               const  verbose
                 , size_t                            const  patchPopLimit
+                , PointStore<typename _PointContainerT::value_type> const* pointStore = NULL
                 );
 
         /*! \brief                               Greedy region growing
@@ -158,6 +164,7 @@ class Segmentation
          *                                       that only contains a neighbouring point, and decides. See in \ref RepresentativeSqrPatchPatchDistanceFunctorT.
          *  \param[in] gid_tag_name              The key value of GID in _PointT. Suggested to be: _PointT::GID.
          *  \param[in] nn_K                      Number of nearest neighbour points looked for.
+         *  \param[in] pointStore                Optional structure-of-arrays copy of \p points to read positions and orientations from. Built locally, if NULL.
          */
         template < class       _PrimitiveT
                  , class       _PointContainerT
@@ -174,12 +181,14 @@ class Segmentation
                   , GidT                        const  gid_tag_name              //= _PointT::GID
                   , int                         const  nn_K
                   , bool                        const  verbose
+                  , PointStore<_PointT>         const* pointStore = NULL
                   );
 
         /*! \brief  Fits a local direction to each point and it's neighourhood.
          *          Create local fits to local neighbourhoods, these will be the point orientations.
          *  \tparam PrimitiveContainerT Concept: vector< vector< LinePrimitive2/PlanePrimitive > >.
          *  \tparam _PointContainerPtrT Concept: pcl::PointCloud<pcl::PointXYZRGB>::Ptr.
+         *  \param[in] index           Optional neighbour index over \p cloud to reuse. A temporary one is built at \p radius, if NULL.
          */
         template <  class _PrimitiveContainerT
                   , class _PointContainerPtrT>
@@ -192,8 +201,30 @@ class Segmentation
                 , bool                 const  soft_radius
                 , std::vector<PidT>          * mapping
                 , int                    const  verbose
+                , processing::SpatialHash<float> const* index = NULL
                 );
     protected:
+        /*! \brief                  Greedily grows \p patch from \p seed over the neighbours within \p maxDist, that are not \p assigned, and whose direction is close to the patch's.
+         *  \param[in,out] owner    Stamp of the patch, that took each point last. Points taken by this patch are set to \p stamp.
+         *  \param[in] minStamp     Stamps in [minStamp,stamp) belong to earlier patches of the same batch, that have precedence.
+         *  \return                 False, if the patch wanted a point of an earlier patch, and was given up.
+         */
+        template < class    _PatchT
+                 , class    _PointStoreT
+                 , class    _SpatialIndexT
+                 , typename _Scalar
+                 >  static bool
+        _growPatch( _PatchT                                   & patch
+                  , PidT                                 const  seed
+                  , std::vector<char>                    const& assigned
+                  , std::vector< std::atomic<unsigned> >      & owner
+                  , unsigned                             const  stamp
+                  , unsigned                             const  minStamp
+                  , _PointStoreT                         const& store
+                  , _SpatialIndexT                       const& index
+                  , _Scalar                              const  maxDist
+                  , _Scalar                              const  maxAngle );
+
         template < class    _PointPrimitiveT
                  , typename _Scalar
                  , class    _PointPatchDistanceFunctorT
@@ -4,6 +4,7 @@
 //#include "qcqpcpp/io/io.h"    // read/writeSparseMatrix
 #include "Eigen/Sparse"         // Eigen::SparseMatrix (solve)
 #include "rapter/typedefs.h"    // rapter::Scalar (solve)
+#include "rapter/optimization/problemSetup.h" // problemSetup::OptProblemT
 
 namespace rapter {
 
@@ -22,11 +23,15 @@ class Solver
         //typedef Eigen::Matrix<Scalar,3,1>                   Vector;
         typedef Eigen::SparseMatrix<Scalar,Eigen::RowMajor> SparseMatrix;
 
+        /*! \brief Step 3. Solves the problem formulated by \ref ProblemSetup::formulateCli().
+         *  \param problemIn If not NULL, solves this problem instead of reading --problem, which then only locates the output x.csv.
+         *                   It is swapped into the solver, not copied, and swapped back, once solved.
+         */
         template < class _PrimitiveContainerT
                  , class _InnerPrimitiveContainerT
                  , class _PrimitiveT
                  >
-        static inline int solve      ( int argc, char** argv );
+        static inline int solve      ( int argc, char** argv, problemSetup::OptProblemT      * problemIn = NULL );
 
         /*! \brief Globfit planned. \todo: move to datafit.h. */
         template < class _PrimitiveContainerT
@@ -0,0 +1,232 @@
+#ifndef __RAPTER_EXTENTCACHE_H__
+#define __RAPTER_EXTENTCACHE_H__
+
+#include <cstdlib>       // getenv
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "Eigen/Dense"
+#include "rapter/simpleTypes.h"
+
+namespace rapter
+{
+    /*! \brief  Content-addressed, persistent cache of primitive extents.
+     *
+     *          Every sub-command re-reads the primitives from csv, so the in-memory Primitive::_extents is empty each time.
+     *          This cache keys an extent by the primitive's coefficients, its population (point ids and positions), the inlier threshold
+     *          and the axis-aligned flag, so an unchanged primitive with an unchanged population is only measured once across the pipeline.
+     *          A changed population, or a moved primitive gives a new key, and is measured again.
+     *
+     *          io::readPrimitives points the cache to "<primitives>.extents", which is loaded on the first lookup.
+     *          io::savePrimitives writes the entries used in this run to "<output>.extents".
+     *          Set RAPTER_EXTENT_CACHE=0 to disable it.
+     *
+     *  \tparam _Scalar Precision of the stored extrema.
+     */
+    template <typename _Scalar>
+    class ExtentCache
+    {
+        public:
+            typedef unsigned long long                          KeyT;
+            typedef Eigen::Matrix<_Scalar,3,1>                  Position;
+            typedef std::vector<Position>                       ExtremaT;
+
+            //! \brief Suffix of the cache file next to a primitives file.
+            static inline std::string suffix() { return ".extents"; }
+
+            //! \brief Process-wide instance used by getExtent().
+            static inline ExtentCache& instance()
+            {
+                static ExtentCache cache;
+                return cache;
+            }
+
+            //! \brief False, if disabled by RAPTER_EXTENT_CACHE=0.
+            static inline bool enabled()
+            {
+                static const bool isEnabled = !( std::getenv("RAPTER_EXTENT_CACHE") && (std::string(std::getenv("RAPTER_EXTENT_CACHE")) == "0") );
+                return isEnabled;
+            }
+
+            /*! \brief              Hashes everything the extent of a primitive depends on (FNV-1a).
+             *  \param[in] coeffs   Primitive coefficients.
+             *  \param[in] cloud    Point container. Concept: std::vector<\ref rapter::PointPrimitive>.
+             *  \param[in] indices  Population of the primitive in \p cloud, or NULL for the whole cloud.
+             */
+            template <class _CoeffsT, class _PointContainerT, class _IndicesContainerT>
+            static inline KeyT makeKey( _CoeffsT            const& coeffs
+                                      , _PointContainerT    const& cloud
+                                      , _IndicesContainerT  const* indices
+                                      , double              const  threshold
+                                      , bool                const  force_axis_aligned )
+            {
+                KeyT key = 14695981039346656037ULL;
+                hash( key, coeffs.data(), coeffs.size() * sizeof(typename _CoeffsT::Scalar) );
+                hash( key, &threshold, sizeof(threshold) );
+                const char flag = force_axis_aligned;
+                hash( key, &flag, sizeof(flag) );
+
+                const PidT count = indices ? indices->size() : cloud.size();
+                hash( key, &count, sizeof(count) );
+                for ( PidT i = 0; i != count; ++i )
+                {
+                    const PidT     pid = indices ? (*indices)[i] : i;
+                    const Position pos = cloud[pid].template pos().template cast<_Scalar>();
+                    hash( key, &pid, sizeof(pid) );
+                    hash( key, pos.data(), 3 * sizeof(_Scalar) );
+                }
+
+                return key;
+            } //...makeKey()
+
+            //! \brief Sets the file to load lazily on the next lookup. Entries already in memory are kept.
+            inline void setPath( std::string const& path )
+            {
+#               pragma omp critical (EXTENT_CACHE)
+                {
+                    if ( path != _path )
+                    {
+                        _path   = path;
+                        _loaded = false;
+                    }
+                }
+            } //...setPath()
+
+            //! \brief Looks up \p key, loads the cache file first, if not done yet. \return True, if found.
+            inline bool find( KeyT const key, ExtremaT & extrema )
+            {
+                bool found = false;
+#               pragma omp critical (EXTENT_CACHE)
+                {
+                    if ( !_loaded )
+                    {
+                        this->load( _path );
+                        _loaded = true;
+                    }
+
+                    typename MapT::iterator it = _entries.find( key );
+                    if ( it != _entries.end() )
+                    {
+                        extrema           = it->second.first;
+                        it->second.second = true;
+                        found             = true;
+                    }
+                }
+                return found;
+            } //...find()
+
+            //! \brief Stores an extent measured in this run.
+            inline void insert( KeyT const key, ExtremaT const& extrema )
+            {
+#               pragma omp critical (EXTENT_CACHE)
+                {
+                    _entries[ key ] = EntryT( extrema, true );
+                }
+            } //...insert()
+
+            /*! \brief              Writes the entries looked up or inserted in this run to \p path.
+             *  \return             EXIT_SUCCESS, or EXIT_FAILURE, if the file could not be written.
+             */
+            inline int save( std::string const& path ) const
+            {
+                int err = EXIT_SUCCESS;
+                if ( !_persistent ) return err;
+
+#               pragma omp critical (EXTENT_CACHE)
+                {
+                    std::ofstream f( path.c_str(), std::ios::binary );
+                    if ( !f.is_open() )
+                    {
+                        std::cerr << "[" << __func__ << "]: " << "could not open " << path << " for writing" << std::endl;
+                        err = EXIT_FAILURE;
+                    }
+                    else
+                    {
+                        unsigned long long count = 0;
+                        for ( typename MapT::const_iterator it = _entries.begin(); it != _entries.end(); ++it )
+                            count += it->second.second;
+
+                        f.write( magic(), 8 );
+                        f.write( reinterpret_cast<char const*>(&count), sizeof(count) );
+                        for ( typename MapT::const_iterator it = _entries.begin(); it != _entries.end(); ++it )
+                        {
+                            if ( !it->second.second ) continue;
+
+                            const unsigned size = it->second.first.size();
+                            f.write( reinterpret_cast<char const*>(&it->first), sizeof(KeyT) );
+                            f.write( reinterpret_cast<char const*>(&size)     , sizeof(size) );
+                            for ( unsigned i = 0; i != size; ++i )
+                                f.write( reinterpret_cast<char const*>(it->second.first[i].data()), 3 * sizeof(_Scalar) );
+                        }
+                    }
+                }
+                return err;
+            } //...save()
+
+            inline size_t size() const { return _entries.size(); }
+
+            //! \brief If false, entries only live in memory: nothing is loaded or saved. Set by --pipeline, where all stages share this instance.
+            inline void setPersistent( bool const persistent ) { _persistent = persistent; }
+
+        protected:
+            typedef std::pair<ExtremaT,bool>            EntryT; //!< \brief Extrema, and if used in this run.
+            typedef std::unordered_map<KeyT,EntryT>     MapT;
+
+            ExtentCache() : _loaded( true ), _persistent( true ) {}
+
+            static inline char const* magic() { return sizeof(_Scalar) == 4 ? "RAPEXTf1" : "RAPEXTd1"; }
+
+            static inline void hash( KeyT & key, void const* data, size_t bytes )
+            {
+                unsigned char const* p = static_cast<unsigned char const*>( data );
+                for ( size_t i = 0; i != bytes; ++i )
+                {
+                    key ^= p[i];
+                    key *= 1099511628211ULL;
+                }
+            } //...hash()
+
+            //! \brief Reads \p path, a missing file is an empty cache. Not thread-safe, called from find().
+            inline void load( std::string const& path )
+            {
+                if ( path.empty() || !_persistent ) return;
+
+                std::ifstream f( path.c_str(), std::ios::binary );
+                if ( !f.is_open() ) return;
+
+                char header[8];
+                unsigned long long count = 0;
+                if ( !f.read(header, 8) || std::string(header, 8) != magic() || !f.read(reinterpret_cast<char*>(&count), sizeof(count)) )
+                {
+                    std::cerr << "[" << __func__ << "]: " << "ignoring invalid extent cache " << path << std::endl;
+                    return;
+                }
+
+                for ( unsigned long long e = 0; e != count; ++e )
+                {
+                    KeyT     key;
+                    unsigned size;
+                    if ( !f.read(reinterpret_cast<char*>(&key), sizeof(key)) || !f.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > 8 )
+                        break;
+
+                    ExtremaT extrema( size );
+                    for ( unsigned i = 0; i != size; ++i )
+                        f.read( reinterpret_cast<char*>(extrema[i].data()), 3 * sizeof(_Scalar) );
+                    if ( !f ) break;
+
+                    if ( _entries.find(key) == _entries.end() )
+                        _entries[ key ] = EntryT( extrema, false );
+                }
+            } //...load()
+
+            MapT        _entries;
+            std::string _path;      //!< \brief File to load lazily.
+            bool        _loaded;    //!< \brief True, if _path was read already.
+            bool        _persistent;//!< \brief False, if not backed by files.
+    }; //...class ExtentCache
+
+} //...ns rapter
+
+#endif // __RAPTER_EXTENTCACHE_H__
@@ -47,8 +47,8 @@ namespace rapter
 
         // select inliers
         std::vector<PidT> inliers;
-        inliers.reserve( cloud.size() );
         const PidT stop_at = indices_arg ? indices_arg->size() : cloud.size();
+        inliers.reserve( stop_at );
         for ( PidT i = 0; i != stop_at; ++i )
         {
             const PidT pid = indices_arg ? (*indices_arg)[i] : i;
@@ -87,6 +87,7 @@ namespace rapter
     /*! \brief                          Calculates the length of the plane based on the points in \p cloud, masked by \p indices and the distance from point to plane \p threshold.
      *
      *                                  The method calculates the inliers and selects the most far away point from #pos() in both directions.
+     *                                  The rectangle is the exact minimum area one (convex hull and rotating calipers), unless \p force_axis_aligned.
      *  \tparam     _PointT             Point wrapper stored in _PointContainerT.
      *  \tparam     _PointContainerT    Type to store the points to select inliers from. Concept: std::vector<\ref rapter::PointPrimitive>. Depr: pcl::PointCloud< _PointT >::Ptr.
      *  \tparam     _IndicesContainerT  Concept: std::vector<int>.
@@ -112,12 +113,19 @@ namespace rapter
             return 0;
         }
 
-#ifdef RAPTER_USE_PCL
+        // measured by an earlier sub-command, or an earlier iteration
+        typedef ExtentCache<Scalar> ExtentCacheT;
+        const typename ExtentCacheT::KeyT cacheKey = ExtentCacheT::enabled() ? ExtentCacheT::makeKey( _coeffs, cloud, indices_arg, threshold, force_axis_aligned ) : 0;
+        if ( ExtentCacheT::enabled() && ExtentCacheT::instance().find(cacheKey, minMax) )
+        {
+            this->_extents.update( minMax );
+            return EXIT_SUCCESS;
+        }
 
         std::vector<LidT> inliers;
         {
-            inliers.reserve( cloud.size() );
             const PidT stop_at = indices_arg ? indices_arg->size() : cloud.size();
+            inliers.reserve( stop_at );
             for ( PidT i = 0; i != stop_at; ++i )
             {
                 const PidT pid = indices_arg ? (*indices_arg)[i] : i;
@@ -131,21 +139,29 @@ namespace rapter
         // check size
         if ( !inliers.size() ) return EXIT_FAILURE;
 
-        // project cloud
-        _PointContainerT on_plane_cloud;
-        //on_plane_cloud.reserve( inliers.size() );
-        on_plane_cloud.resize( inliers.size() );
-#       pragma omp parallel for num_threads(4)
+        // project inliers
+        std::vector<Position> on_plane( inliers.size() );
         for ( UPidT pid_id = 0; pid_id < inliers.size(); ++pid_id )
-        {
-            on_plane_cloud[pid_id] = _PointPrimitiveT( this->projectPoint(cloud[ inliers[pid_id] ].template pos()),
-                                                                          cloud[ inliers[pid_id] ].template dir()
-                                                     );
-        }
+            on_plane[pid_id] = this->projectPoint( cloud[ inliers[pid_id] ].template pos() );
 
         Eigen::Matrix<Scalar,4,4> frame; // 3 major vectors as columns, and the fourth is the centroid
         {
-            processing::PCA<_IndicesContainerT>( frame, on_plane_cloud, /* indices: */ NULL ); // no indices needed, already full cloud
+            // PCA of the projected inliers, same as processing::PCA, biggest eigen value first
+            Position centroid( Position::Zero() );
+            for ( size_t pid_id = 0; pid_id != on_plane.size(); ++pid_id )
+                centroid += on_plane[pid_id];
+            centroid /= Scalar( on_plane.size() );
+
+            Eigen::Matrix<Scalar,3,3> covariance( Eigen::Matrix<Scalar,3,3>::Zero() );
+            for ( size_t pid_id = 0; pid_id != on_plane.size(); ++pid_id )
+                covariance += (on_plane[pid_id] - centroid) * (on_plane[pid_id] - centroid).transpose();
+
+            Eigen::SelfAdjointEigenSolver< Eigen::Matrix<Scalar,3,3> > eigen_solver( covariance, Eigen::ComputeEigenvectors ); // increasing eigen values
+            frame = Eigen::Matrix<Scalar,4,4>::Identity();
+            frame.template block<3,1>(0,0) = eigen_solver.eigenvectors().col(2);
+            frame.template block<3,1>(0,1) = eigen_solver.eigenvectors().col(1);
+            frame.template block<3,1>(0,2) = eigen_solver.eigenvectors().col(0);
+            frame.template block<3,1>(0,3) = centroid;
 
             if ( force_axis_aligned )
             {
@@ -162,78 +178,43 @@ namespace rapter
             }
             else
             {
-#if 1
-                Scalar step      = Scalar(1. * M_PI) / Scalar(180.);
-                Scalar limits[2] = { -Scalar(M_PI_4), Scalar(M_PI_4) };
-                for ( int it = 0; it != 2; ++it, step /= Scalar(5.) )
-                {
-                    std::pair <Scalar,Scalar> min_volume; // <ang, volume>
-                    min_volume.first  = Scalar(-1.);
-                    min_volume.second = Scalar(FLT_MAX);
-                    int i = 0;
-                    for ( Scalar ang = limits[0]; ang < limits[1]; ang += step, ++i )
-                    {
-                        //                std::cout << "rot by " << ang << ", step: " << step << std::endl;
-                        // rotated frame
-                        Eigen::Matrix4f tmp_frame = frame;
-
-                        // rotate frame around up_vector by ang
-                        Eigen::AngleAxisf rot( ang, tmp_frame.block<3,1>(0,2) );
-                        tmp_frame.block<3,1>(0,0) = rot * tmp_frame.block<3,1>(0,0);
-                        tmp_frame.block<3,1>(0,1) = rot * tmp_frame.block<3,1>(0,1);
-
-                        // calculate volume
-                        _PointContainerT local_cloud;
-                        processing::cloud2Local<_PointPrimitiveT,_IndicesContainerT>( local_cloud, tmp_frame, on_plane_cloud, /* indices: */ NULL ); // no indices needed, it's already a full cloud
-
-                        _PointPrimitiveT min_pt, max_pt;
-                        processing::getMinMax3D<_IndicesContainerT>( min_pt, max_pt, local_cloud, /* indices: */ NULL );
-
-                        Eigen::Vector3f diag    = max_pt.template pos() - min_pt.template pos();
-
-                        //get location of minimum
-                        Eigen::MatrixXf::Index minRow, minCol;
-                        diag.minCoeff( &minRow, &minCol );
-                        //                std::cout << "minRow: " << minRow << std::endl;
-                        float volume = 0.;
-                        if ( minRow == 1 )
-                            volume = diag(0) * diag(2);
-                        else if ( minRow )
-                            volume = diag(0) * diag(1);
-                        else
-                            volume = diag(1) * diag(2);
-                        // select min
-                        if ( volume < min_volume.second )
-                        {
-                            min_volume.first  = ang;
-                            min_volume.second = volume;
-                        }
-                    } // for caliper angles
-
-                    // selected apply rotation
-                    Eigen::AngleAxisf rot( min_volume.first, frame.block<3,1>(0,2) );
-                    frame.block<3,1>(0,0) = rot * frame.block<3,1>(0,0);
-                    frame.block<3,1>(0,1) = rot * frame.block<3,1>(0,1);
-
-                    // modify lookup around chosen angle for next iteration
-                    limits[0] = -step/2.f;
-                    limits[1] = limits[0] + step;
-                } //...for caliper levels
-#endif
+                // minimum area rectangle: convex hull of the in-plane coordinates, then rotating calipers
+                typedef Eigen::Matrix<Scalar,2,1> Position2;
+                const Position axis0    = frame.template block<3,1>(0,0);
+                const Position axis1    = frame.template block<3,1>(0,1);
+
+                std::vector<Position2> local( on_plane.size() ), hull;
+                for ( size_t pid_id = 0; pid_id != on_plane.size(); ++pid_id )
+                    local[pid_id] = Position2( (on_plane[pid_id] - centroid).dot(axis0), (on_plane[pid_id] - centroid).dot(axis1) );
+
+                processing::convexHull2D( hull, local );
+                const Scalar ang = processing::minAreaRectAngle( hull ); // closest to the PCA major axis, in [-pi/4, pi/4)
+
+                // rotate frame in its plane by ang
+                frame.template block<3,1>(0,0) =  std::cos(ang) * axis0 + std::sin(ang) * axis1;
+                frame.template block<3,1>(0,1) = -std::sin(ang) * axis0 + std::cos(ang) * axis1;
             } //calipers
         } //...estimate frame
 
-        _PointContainerT local_cloud;
-        processing::cloud2Local<_PointPrimitiveT,_IndicesContainerT>( local_cloud, frame, on_plane_cloud, /* indices: */ NULL ); // no indices needed, it's already a full cloud
-
-        _PointPrimitiveT min_pt, max_pt;
-        processing::getMinMax3D<_IndicesContainerT>( min_pt, max_pt, local_cloud, /* indices: */ NULL );
+        // local bounding box
+        Position min_pt( Position::Constant( std::numeric_limits<Scalar>::max()) ),
+                 max_pt( Position::Constant(-std::numeric_limits<Scalar>::max()) );
+        {
+            const Eigen::Matrix<Scalar,3,3> toLocal = frame.template block<3,3>(0,0).transpose();
+            const Position                  origin  = frame.template block<3,1>(0,3);
+            for ( size_t pid_id = 0; pid_id != on_plane.size(); ++pid_id )
+            {
+                const Position pos = toLocal * (on_plane[pid_id] - origin);
+                min_pt = min_pt.cwiseMin( pos );
+                max_pt = max_pt.cwiseMax( pos );
+            }
+        }
 
         minMax.resize( 4 );
-        minMax[0]    = minMax[1] = min_pt.template pos();
-        minMax[1](1)             = max_pt.template pos()(1);
-        minMax[2]    = minMax[3] = max_pt.template pos();
-        minMax[3](1)             = min_pt.template pos()(1);
+        minMax[0]    = minMax[1] = min_pt;
+        minMax[1](1)             = max_pt(1);
+        minMax[2]    = minMax[3] = max_pt;
+        minMax[3](1)             = min_pt(1);
 
         for ( int d = 0; d != 4; ++d )
         {
@@ -242,12 +223,10 @@ namespace rapter
         }
 
         this->_extents.update( minMax );
+        if ( ExtentCacheT::enabled() )
+            ExtentCacheT::instance().insert( cacheKey, minMax );
 
         return EXIT_SUCCESS;
-#           else
-        std::cerr << "[" << __func__ << "]: " << "Needs PCL to work!!!!"
-        return exit_FAILURE;
-#           endif //...RAPTER_USE_PCL
     } //...getExtent()
 
     /*! \brief Calculates size, a bit smarter, than taking the area of #getExtent().
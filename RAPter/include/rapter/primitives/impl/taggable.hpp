@@ -1,13 +1,55 @@
+
 #ifndef RAPTER_TAGGABLE_HPP__
 #define RAPTER_TAGGABLE_HPP__
 
 #include <string>
 #include <map>
+#include <algorithm> // fill_n, copy
 #include "rapter/primitives/taggable.h"
 #include "rapter/simpleTypes.h"
 
 namespace rapter
 {
+    template <typename _Scalar>
+    Taggable<_Scalar>::Taggable()
+        : _scalarSlot( TAG_UNSET )
+        , _overflow  ( NULL )
+    {
+        std::fill_n( _longSlots, static_cast<int>(LONG_SLOT_COUNT), static_cast<rapter::GidT>(TAG_UNSET) );
+        std::fill_n( _charSlots, static_cast<int>(CHAR_SLOT_COUNT), static_cast<char>(TAG_UNSET) );
+    }
+
+    template <typename _Scalar>
+    Taggable<_Scalar>::Taggable( Taggable<_Scalar> const& other )
+        : _overflow( NULL )
+    {
+        this->copyTagsFrom( other );
+    }
+
+    template <typename _Scalar>
+    Taggable<_Scalar>::~Taggable()
+    {
+        delete _overflow;
+    }
+
+    template <typename _Scalar>
+    Taggable<_Scalar>&
+    Taggable<_Scalar>::operator=( Taggable<_Scalar> const& other )
+    {
+        if ( this != &other )
+            this->copyTagsFrom( other );
+        return *this;
+    }
+
+    template <typename _Scalar>
+    inline typename Taggable<_Scalar>::OverflowTags&
+    Taggable<_Scalar>::overflow()
+    {
+        if ( !_overflow )
+            _overflow = new OverflowTags();
+        return *_overflow;
+    }
+
     /*! \brief              Stores long tag for int key. Mostly used by the enum typedefs.
       * \param[in] key      Key to store \p value at.
       * \param[in] value    Value to store.
@@ -17,7 +59,11 @@ namespace rapter
     inline Taggable<_Scalar>&
     Taggable<_Scalar>::setTag( int key, long value )
     {
-        _longValuedTags[key] = value;
+        const int slot = longSlot( key );
+        if ( slot >= 0 )
+            _longSlots[ slot ] = value;
+        else
+            overflow()._longValuedTags[key] = value;
         return *this;
     }
 
@@ -30,8 +76,7 @@ namespace rapter
     inline Taggable<_Scalar>&
     Taggable<_Scalar>::setTag( int key, int value )
     {
-        _longValuedTags[key] = value;
-        return *this;
+        return setTag( key, static_cast<long>(value) );
     }
 
     /*! \brief              Stores size_t valued tag for int key.
@@ -43,8 +88,7 @@ namespace rapter
     inline Taggable<_Scalar>&
     Taggable<_Scalar>::setTag( int key, std::size_t value )
     {
-        _longValuedTags[key] = value;
-        return *this;
+        return setTag( key, static_cast<long>(value) );
     }
 
     /*! \brief              Stores tag for int key.
@@ -56,7 +100,10 @@ namespace rapter
     inline Taggable<_Scalar>&
     Taggable<_Scalar>::setTag( char key, char value )
     {
-        _charValuedTags[key] = value;
+        if ( key >= 0 && key < CHAR_SLOT_COUNT )
+            _charSlots[ static_cast<int>(key) ] = value;
+        else
+            overflow()._charValuedTags[key] = value;
         return *this;
     }
 
@@ -69,7 +116,10 @@ namespace rapter
     inline Taggable<_Scalar>&
     Taggable<_Scalar>::setTag( _Scalar key, _Scalar value )
     {
-        _scalarValuedTags[key] = value;
+        if ( key == _Scalar(SCALAR_SLOT_KEY) )
+            _scalarSlot = value;
+        else
+            overflow()._scalarValuedTags[key] = value;
         return *this;
     }
 
@@ -83,9 +133,16 @@ namespace rapter
     inline rapter::GidT
     Taggable<_Scalar>::getTag( rapter::GidT key ) const
     {
-        typename std::map<rapter::GidT, rapter::GidT>::const_iterator it = _longValuedTags.find( key );
-        if ( it != _longValuedTags.end() )
-            return it->second; // _tags.at( key ); changed by Aron on 3/1/2015
+        const int slot = longSlot( key );
+        if ( slot >= 0 )
+            return _longSlots[ slot ];
+
+        if ( _overflow )
+        {
+            typename std::map<rapter::GidT, rapter::GidT>::const_iterator it = _overflow->_longValuedTags.find( key );
+            if ( it != _overflow->_longValuedTags.end() )
+                return it->second; // _tags.at( key ); changed by Aron on 3/1/2015
+        }
 
         return TAG_UNSET;
     }
@@ -101,9 +158,15 @@ namespace rapter
     inline char
     Taggable<_Scalar>::getTag( char key ) const
     {
-        typename std::map<char,char>::const_iterator it = _charValuedTags.find( key );
-        if ( it != _charValuedTags.end() )
-            return it->second;
+        if ( key >= 0 && key < CHAR_SLOT_COUNT )
+            return _charSlots[ static_cast<int>(key) ];
+
+        if ( _overflow )
+        {
+            typename std::map<char,char>::const_iterator it = _overflow->_charValuedTags.find( key );
+            if ( it != _overflow->_charValuedTags.end() )
+                return it->second;
+        }
 
         return TAG_UNSET;
     }
@@ -116,9 +179,15 @@ namespace rapter
     inline _Scalar
     Taggable<_Scalar>::getTag( _Scalar key ) const
     {
-        typename std::map<_Scalar,_Scalar>::const_iterator it = _scalarValuedTags.find( key );
-        if ( it != _scalarValuedTags.end() )
-            return it->second; // _tags.at( key ); changed by Aron on 3/1/2015
+        if ( key == _Scalar(SCALAR_SLOT_KEY) )
+            return _scalarSlot;
+
+        if ( _overflow )
+        {
+            typename std::map<_Scalar,_Scalar>::const_iterator it = _overflow->_scalarValuedTags.find( key );
+            if ( it != _overflow->_scalarValuedTags.end() )
+                return it->second; // _tags.at( key ); changed by Aron on 3/1/2015
+        }
 
         return TAG_UNSET;
     }
@@ -127,9 +196,20 @@ namespace rapter
     inline int
     Taggable<_Scalar>::copyTagsFrom( Taggable<_Scalar> const& other )
     {
-        _longValuedTags    = other._longValuedTags;
-        _scalarValuedTags  = other._scalarValuedTags;
-        _charValuedTags    = other._charValuedTags;
+        std::copy( other._longSlots, other._longSlots + LONG_SLOT_COUNT, _longSlots );
+        std::copy( other._charSlots, other._charSlots + CHAR_SLOT_COUNT, _charSlots );
+        _scalarSlot = other._scalarSlot;
+
+        if ( other._overflow )
+        {
+            if ( _overflow ) *_overflow = *other._overflow;
+            else             _overflow  = new OverflowTags( *other._overflow );
+        }
+        else
+        {
+            delete _overflow;
+            _overflow = NULL;
+        }
         //_intValuedTags     = other._intValuedTags;
         //_str_tags          = other._str_tags;
 
@@ -138,4 +218,3 @@ namespace rapter
 } // ... ns rapter
 
 #endif // __GO_TAGGABLE_HPP__
-
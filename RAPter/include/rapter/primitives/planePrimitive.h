@@ -4,6 +4,7 @@
 #include <Eigen/Dense>
 #include "rapter/optimization/energyFunctors.h"
 #include "rapter/primitives/primitive.h"
+#include "rapter/primitives/extentCache.h"
 #include "rapter/processing/util.hpp" // pca, getPopulationOf()
 
 #ifdef RAPTER_USE_PCL
@@ -0,0 +1,212 @@
+#ifndef __RAPTER_POINTSTORE_H__
+#define __RAPTER_POINTSTORE_H__
+
+#include <memory> // shared_ptr
+#include <vector>
+#include "Eigen/Dense"
+#include "pcl/point_types.h"
+#include "pcl/point_cloud.h"
+#include "rapter/simpleTypes.h"
+#include "rapter/processing/spatialHash.hpp"
+
+namespace rapter
+{
+    /*! \brief  Structure-of-arrays storage of oriented points.
+     *
+     *          Keeps positions, orientations and the GID of each point in separate contiguous arrays,
+     *          so that neighbourhood queries, population scans and extent calculations touch only the fields they need.
+     *          The store models the read-only part of the _PointContainerT concept (size(), operator[], value_type, PrimitiveT),
+     *          so it can be handed to the templated processing functions that only read pos(), dir() and the GID tag.
+     *          It also implements the dataset adaptor interface of nanoflann (kdtree_get_point_count(), kdtree_get_pt(), kdtree_get_bbox()).
+     *
+     *  \tparam _PointPrimitiveT Element type of the container the store is built from. Concept: \ref rapter::PointPrimitive.
+     */
+    template <class _PointPrimitiveT>
+    class PointStore
+    {
+        public:
+            typedef _PointPrimitiveT                        PointPrimitiveT;
+            typedef typename _PointPrimitiveT::Scalar       Scalar;
+            typedef Eigen::Matrix<Scalar,3,1>               Vector3;
+            typedef pcl::PointXYZ                           SearchPointT;
+            typedef pcl::PointCloud<SearchPointT>           SearchCloudT;
+            typedef typename SearchCloudT::Ptr              SearchCloudPtrT;
+
+            //! \brief Read-only proxy to one point of the store. Answers pos(), dir() and getTag(TAGS::GID) like a \ref rapter::PointPrimitive.
+            class PointRef
+            {
+                public:
+                    typedef typename _PointPrimitiveT::TAGS         TAGS;
+                    typedef typename _PointPrimitiveT::LONG_VALUES  LONG_VALUES;
+                    typedef typename PointStore::Scalar             Scalar;
+                    static const int TAG_UNSET = _PointPrimitiveT::TAG_UNSET;
+
+                    PointRef( PointStore const* store, UPidT pid ) : _store( store ), _pid( pid ) {}
+
+                    inline Vector3  pos()                  const { return _store->pos( _pid ); }
+                    inline Vector3  dir()                  const { return _store->dir( _pid ); }
+                    //! \brief Only the GID is stored, every other key reads as unset.
+                    inline GidT     getTag( GidT key )     const { return key == TAGS::GID ? _store->gid( _pid ) : GidT( TAG_UNSET ); }
+                    inline bool     gidUnset()             const { return _store->gid( _pid ) == LONG_VALUES::UNSET; }
+
+                protected:
+                    PointStore const*   _store;
+                    UPidT               _pid;
+            }; //...PointRef
+
+            typedef PointRef value_type;  //!< \brief Container concept typedef.
+            typedef PointRef PrimitiveT;  //!< \brief Same as \ref rapter::PointPrimitiveVector::PrimitiveT.
+
+            PointStore() {}
+
+            //! \brief Builds the arrays from an array-of-structures container. Concept: std::vector<\ref rapter::PointPrimitive>.
+            template <class _PointContainerT>
+            explicit PointStore( _PointContainerT const& points ) { this->assign( points ); }
+
+            //! \brief Replaces the contents with \p points. Drops the cached search cloud.
+            template <class _PointContainerT>
+            inline void assign( _PointContainerT const& points )
+            {
+                this->resize( points.size() );
+#               pragma omp parallel for
+                for ( long pid = 0; pid < static_cast<long>(points.size()); ++pid )
+                {
+                    const Vector3 pos( points[pid].template pos() ), dir( points[pid].template dir() );
+                    _x [pid] = pos(0); _y [pid] = pos(1); _z [pid] = pos(2);
+                    _nx[pid] = dir(0); _ny[pid] = dir(1); _nz[pid] = dir(2);
+                    _gid[pid] = points[pid].getTag( _PointPrimitiveT::TAGS::GID );
+                }
+            } //...assign()
+
+            //! \brief Writes the GIDs back to an array-of-structures container of the same size.
+            template <class _PointContainerT>
+            inline void copyGidsTo( _PointContainerT & points ) const
+            {
+                for ( size_t pid = 0; pid != points.size(); ++pid )
+                    points[pid].setTag( _PointPrimitiveT::TAGS::GID, _gid[pid] );
+            }
+
+            //! \brief Reads the GIDs from an array-of-structures container of the same size.
+            template <class _PointContainerT>
+            inline void copyGidsFrom( _PointContainerT const& points )
+            {
+                for ( size_t pid = 0; pid != points.size(); ++pid )
+                    _gid[pid] = points[pid].getTag( _PointPrimitiveT::TAGS::GID );
+            }
+
+            //! \brief Writes the orientations back to an array-of-structures container of the same size.
+            template <class _PointContainerT>
+            inline void copyDirsTo( _PointContainerT & points ) const
+            {
+                for ( size_t pid = 0; pid != points.size(); ++pid )
+                    points[pid].coeffs().template segment<3>(3) = this->dir( pid );
+            }
+
+            inline size_t   size ()                 const { return _x.size(); }
+            inline bool     empty()                 const { return _x.empty(); }
+            inline void     resize( size_t n )
+            {
+                _x .resize( n ); _y .resize( n ); _z .resize( n );
+                _nx.resize( n ); _ny.resize( n ); _nz.resize( n );
+                _gid.resize( n, GidT(_PointPrimitiveT::LONG_VALUES::UNSET) );
+                this->outdatePositions();
+            }
+            inline void     reserve( size_t n )
+            {
+                _x .reserve( n ); _y .reserve( n ); _z .reserve( n );
+                _nx.reserve( n ); _ny.reserve( n ); _nz.reserve( n );
+                _gid.reserve( n );
+            }
+
+            inline void     push_back( Vector3 const& pos, Vector3 const& dir, GidT const gid = _PointPrimitiveT::LONG_VALUES::UNSET )
+            {
+                _x .push_back( pos(0) ); _y .push_back( pos(1) ); _z .push_back( pos(2) );
+                _nx.push_back( dir(0) ); _ny.push_back( dir(1) ); _nz.push_back( dir(2) );
+                _gid.push_back( gid );
+                this->outdatePositions();
+            }
+
+            inline PointRef operator[]( size_t pid )   const { return PointRef( this, pid ); }
+
+            inline Vector3  pos   ( size_t pid )        const { return Vector3( _x [pid], _y [pid], _z [pid] ); }
+            inline Vector3  dir   ( size_t pid )        const { return Vector3( _nx[pid], _ny[pid], _nz[pid] ); }
+            inline GidT     gid   ( size_t pid )        const { return _gid[pid]; }
+
+            //! \brief Changes a position. Not thread-safe together with #getSearchCloud() and #getSpatialIndex().
+            template <typename Derived>
+            inline void     setPos( size_t pid, Derived const& pos ) { _x [pid] = pos(0); _y [pid] = pos(1); _z [pid] = pos(2); this->outdatePositions(); }
+            template <typename Derived>
+            inline void     setDir( size_t pid, Derived const& dir ) { _nx[pid] = dir(0); _ny[pid] = dir(1); _nz[pid] = dir(2); }
+            inline void     setGid( size_t pid, GidT const gid )     { _gid[pid] = gid; }
+
+            inline Scalar const*            x   () const { return _x.data(); }
+            inline Scalar const*            y   () const { return _y.data(); }
+            inline Scalar const*            z   () const { return _z.data(); }
+            inline std::vector<GidT> const& gids() const { return _gid; }
+
+            // ____________________NANOFLANN____________________
+            inline size_t   kdtree_get_point_count()                    const { return _x.size(); }
+            inline Scalar   kdtree_get_pt( size_t idx, int dim )        const { return dim == 0 ? _x[idx] : (dim == 1 ? _y[idx] : _z[idx]); }
+            template <class BBOX>
+            inline bool     kdtree_get_bbox( BBOX & /*bb*/ )            const { return false; }
+
+            // ____________________PCL____________________
+            /*! \brief  Returns a pcl::PointXYZ cloud of the positions, built on first call, and reused until a position changes.
+             *          pcl::search::KdTree needs an array-of-structures input, so this is the one copy all trees built over the store share.
+             *          The cloud is shared, treat it as read-only.
+             *  \warning Call once outside of parallel regions before sharing the store between threads.
+             */
+            inline SearchCloudPtrT getSearchCloud() const
+            {
+                if ( !_searchCloud )
+                {
+                    SearchCloudPtrT cloud( new SearchCloudT() );
+                    cloud->resize( _x.size() );
+#                   pragma omp parallel for
+                    for ( long pid = 0; pid < static_cast<long>(_x.size()); ++pid )
+                    {
+                        SearchPointT &pnt = cloud->points[pid];
+                        pnt.x = _x[pid]; pnt.y = _y[pid]; pnt.z = _z[pid];
+                    }
+                    _searchCloud = cloud;
+                }
+                return _searchCloud;
+            } //...getSearchCloud()
+
+            /*! \brief  Returns the neighbour index of the positions, built on first call, and reused until a position changes.
+             *          Every stage working on the same store shares this index, and so do copies of the store. Any query radius is answered exactly,
+             *          \p cellSize is only used, when the index is built.
+             *  \warning Call once outside of parallel regions before sharing the store between threads.
+             */
+            inline processing::SpatialHash<Scalar> const& getSpatialIndex( Scalar const cellSize ) const
+            {
+                static const processing::SpatialHash<Scalar> emptyIndex;
+                if ( this->empty() )
+                    return emptyIndex;
+
+                if ( !_spatialIndex )
+                {
+                    std::shared_ptr< processing::SpatialHash<Scalar> > index( new processing::SpatialHash<Scalar>() );
+                    index->build( *this, cellSize );
+                    _spatialIndex = index;
+                }
+                return *_spatialIndex;
+            } //...getSpatialIndex()
+
+        protected:
+            inline void outdatePositions()
+            {
+                _searchCloud.reset();
+                _spatialIndex.reset();
+            }
+
+            std::vector<Scalar>     _x, _y, _z;     //!< \brief Positions.
+            std::vector<Scalar>     _nx, _ny, _nz;  //!< \brief Orientations.
+            std::vector<GidT>       _gid;           //!< \brief Group ids, PointPrimitive::TAGS::GID.
+            mutable SearchCloudPtrT _searchCloud;                   //!< \brief Lazily built positions for pcl search trees.
+            mutable std::shared_ptr<processing::SpatialHash<Scalar> const> _spatialIndex; //!< \brief Lazily built neighbour index, shared by copies.
+    }; //...class PointStore
+
+} //...ns rapter
+
+#endif // __RAPTER_POINTSTORE_H__
@@ -11,6 +11,10 @@ namespace rapter
      *
      *             The types are hard-coded to speed up compilation,
      *             and because we don't know how many types we will need later.
+     *
+     *             The keys used by the pipeline (GID, DIR_GID, PID, LID, STATUS, GEN_ANGLE, USER_ID1..5)
+     *             are stored in fixed inline slots, so that a tag lookup is an array access and a
+     *             PointPrimitive does not allocate on the heap. Any other key goes to a lazily allocated overflow map.
      */
     template <typename _Scalar>
     class Taggable
@@ -29,6 +33,19 @@ namespace rapter
                 , USER_ID5 = 14 //!< additional flag to store processing attributes (values only in the generation scope)
             }; //...TAGS
 
+            //! \brief Layout of the inline tag block.
+            enum SLOTS {
+                  LONG_BUILTIN_COUNT = 4                                      //!< long keys [0..3]: Primitive::TAGS::GID/DIR_GID, PointPrimitive::TAGS::PID/GID/LID/LID0
+                , LONG_SLOT_COUNT    = LONG_BUILTIN_COUNT + USER_ID5 - USER_ID1 + 1 //!< builtin keys + USER_ID1..5
+                , CHAR_SLOT_COUNT    = 4                                      //!< char keys [0..3]: Primitive::TAGS::STATUS
+                , SCALAR_SLOT_KEY    = 3                                      //!< the only inline scalar key: Primitive::TAGS::GEN_ANGLE
+            };
+
+            Taggable();
+            Taggable( Taggable const& other );
+            ~Taggable();
+            Taggable& operator=( Taggable const& other );
+
             /*! \brief              Stores long tag for int key. Mostly used by the enum typedefs.
               * \param[in] key      Key to store \p value at.
               * \param[in] value    Value to store.
@@ -94,15 +111,35 @@ namespace rapter
             int
             copyTagsFrom( Taggable const& other );
 
-
         protected:
-            std::map<rapter::GidT, rapter::GidT>         _longValuedTags;     //!< \brief Stores long,int and char values for int keys.
-            std::map<char,char>         _charValuedTags;
-            std::map<_Scalar,_Scalar>   _scalarValuedTags;   //!< \brief Stores values for int keys with value float/double.
+            //! \brief Holds the tags, that don't have an inline slot. Allocated on first use only.
+            struct OverflowTags
+            {
+                std::map<rapter::GidT, rapter::GidT>    _longValuedTags;
+                std::map<char,char>                     _charValuedTags;
+                std::map<_Scalar,_Scalar>               _scalarValuedTags;
+            };
+
+            //! \brief  Maps a long key to its inline slot.
+            //! \return Slot index in #_longSlots, or -1, if the key lives in the overflow map.
+            static inline int longSlot( rapter::GidT key )
+            {
+                if ( key >= 0 && key < LONG_BUILTIN_COUNT )
+                    return static_cast<int>( key );
+                if ( key >= USER_ID1 && key <= USER_ID5 )
+                    return static_cast<int>( LONG_BUILTIN_COUNT + key - USER_ID1 );
+                return -1;
+            }
+
+            OverflowTags& overflow();
+
+            rapter::GidT    _longSlots[ LONG_SLOT_COUNT ];   //!< \brief Inline storage of long,int and size_t values for the known int keys.
+            _Scalar         _scalarSlot;                     //!< \brief Inline storage for #SCALAR_SLOT_KEY (GEN_ANGLE).
+            char            _charSlots[ CHAR_SLOT_COUNT ];   //!< \brief Inline storage of char values for char keys [0..3].
+            OverflowTags   *_overflow;                       //!< \brief Stores values for all other keys. NULL, until needed.
             //std::map<std::string,int>   _str_tags;           //!< \brief Stores values for string keys.
     }; // ... cls Taggable
 } // ... ns rapter
 
 #endif // __GO_TAGGABLE_H__
 
-
@@ -0,0 +1,200 @@
+#ifndef RAPTER_BOXBVH_HPP
+#define RAPTER_BOXBVH_HPP
+
+#include <vector>
+#include <algorithm>     // sort, nth_element
+#include <queue>         // priority_queue
+#include <functional>    // greater
+#include "Eigen/Dense"
+#include "Eigen/Geometry" // AlignedBox
+#include "rapter/simpleTypes.h" // LidT
+
+namespace rapter {
+namespace processing {
+
+/*! \brief  Bounding volume hierarchy over axis aligned boxes, to find the boxes overlapping a query box, or the closest object to a point.
+ *
+ *          Built top-down by splitting at the median box center along the widest axis, until at most LEAF_SIZE boxes remain.
+ *          Like \ref DirectionIndex::query(), queries return ids in ascending order, so callers visit the surviving pairs in their original order.
+ *          Built once, then queried from any number of threads.
+ *  \tparam _Scalar Concept: float.
+ */
+template <typename _Scalar>
+class BoxBvh
+{
+    public:
+        typedef Eigen::AlignedBox<_Scalar,3>    BoxT;
+        enum { LEAF_SIZE = 4 };
+
+        //! \brief Adds \p box with \p id. Empty boxes are never reported.
+        inline void insert( LidT const id, BoxT const& box )
+        {
+            _ids  .push_back( id  );
+            _boxes.push_back( box );
+        }
+
+        //! \brief Builds the hierarchy over the inserted boxes.
+        inline void build()
+        {
+            _nodes.clear();
+            _order.resize( _ids.size() );
+            for ( size_t i = 0; i != _order.size(); ++i )
+                _order[i] = i;
+            if ( _order.size() )
+                this->buildNode( 0, _order.size() );
+        } //...build()
+
+        /*! \brief              Lists the ids larger than \p after, whose box intersects \p box, in ascending order.
+         *  \param[out] out     Cleared first.
+         *  \param[in] box      Query box, does not need to be inserted.
+         *  \param[in] after    Only ids larger than this are listed, -1 for all.
+         */
+        inline void query( std::vector<LidT> &out, BoxT const& box, LidT const after ) const
+        {
+            out.clear();
+            if ( _nodes.empty() || box.isEmpty() ) return;
+
+            std::vector<int> stack( 1, 0 );
+            while ( !stack.empty() )
+            {
+                Node const& node = _nodes[ stack.back() ];
+                stack.pop_back();
+                if ( !node.box.intersects(box) )
+                    continue;
+
+                if ( node.left < 0 )
+                {
+                    for ( size_t i = node.begin; i != node.end; ++i )
+                        if ( (_ids[_order[i]] > after) && _boxes[_order[i]].intersects(box) )
+                            out.push_back( _ids[_order[i]] );
+                }
+                else
+                {
+                    stack.push_back( node.left  );
+                    stack.push_back( node.right );
+                }
+            }
+
+            std::sort( out.begin(), out.end() );
+        } //...query()
+
+        /*! \brief              Finds the id with the smallest \p distance below \p maxDist, ties go to the smaller id, like a scan in id order would.
+         *
+         *                      Visits nodes closest first, and stops, when the closest unvisited box is farther, than the best distance so far.
+         *  \tparam _DistanceT  Concept: _Scalar (LidT id), distance of \p pos from the object of \p id, not smaller, than from its box.
+         *  \param[in] pos      Query point.
+         *  \param[in] distance Functor to evaluate the candidates.
+         *  \param[in] maxDist  Only distances below this are accepted.
+         *  \param[out] minDist Optional output of the distance of the returned id.
+         *  \return             The closest id, or -1, if none is closer than \p maxDist.
+         */
+        template <class _DistanceT>
+        inline LidT nearest( typename BoxT::VectorType const& pos, _DistanceT distance, _Scalar const maxDist, _Scalar *minDist = NULL ) const
+        {
+            typedef std::pair<_Scalar,int> EntryT; // < box distance, node >
+            LidT    best     = -1;
+            _Scalar bestDist = maxDist;
+            if ( !_nodes.empty() && !_nodes[0].box.isEmpty() )
+            {
+                std::priority_queue< EntryT, std::vector<EntryT>, std::greater<EntryT> > queue;
+                queue.push( EntryT(_nodes[0].box.exteriorDistance(pos), 0) );
+                while ( !queue.empty() && !(queue.top().first > bestDist) )
+                {
+                    Node const& node = _nodes[ queue.top().second ];
+                    queue.pop();
+
+                    if ( node.left < 0 )
+                    {
+                        for ( size_t i = node.begin; i != node.end; ++i )
+                        {
+                            BoxT const& box = _boxes[ _order[i] ];
+                            if ( box.isEmpty() || (box.exteriorDistance(pos) > bestDist) )
+                                continue;
+                            const LidT    id   = _ids[ _order[i] ];
+                            const _Scalar dist = distance( id );
+                            if ( (dist < bestDist) || ((dist == bestDist) && (best >= 0) && (id < best)) )
+                            {
+                                best     = id;
+                                bestDist = dist;
+                            }
+                        }
+                    }
+                    else
+                    {
+                        const int children[2] = { node.left, node.right };
+                        for ( int c = 0; c != 2; ++c )
+                            if ( !_nodes[children[c]].box.isEmpty() )
+                                queue.push( EntryT(_nodes[children[c]].box.exteriorDistance(pos), children[c]) );
+                    }
+                }
+            }
+
+            if ( minDist && (best >= 0) )
+                *minDist = bestDist;
+            return best;
+        } //...nearest()
+
+        inline size_t       size ()                   const { return _ids.size(); }
+        inline BoxT const&  box  ( size_t const i )   const { return _boxes[i]; } //!< \brief i-th inserted box.
+
+    protected:
+        struct Node
+        {
+            BoxT    box;
+            int     left, right;    //!< \brief Children, -1 for leaves.
+            size_t  begin, end;     //!< \brief Range in _order.
+        };
+
+        //! \brief Builds the node over _order[begin..end), and returns its index.
+        inline int buildNode( size_t const begin, size_t const end )
+        {
+            const int id = _nodes.size();
+            _nodes.push_back( Node() );
+
+            BoxT box, centers;
+            for ( size_t i = begin; i != end; ++i )
+            {
+                BoxT const& b = _boxes[ _order[i] ];
+                if ( b.isEmpty() ) continue;
+                box    .extend( b );
+                centers.extend( b.center() );
+            }
+
+            int left = -1, right = -1;
+            if ( (end - begin > LEAF_SIZE) && !centers.isEmpty() && (centers.sizes().maxCoeff() > _Scalar(0.)) )
+            {
+                int axis = 0;
+                centers.sizes().maxCoeff( &axis );
+                const size_t mid = begin + (end - begin) / 2;
+                std::vector<BoxT> const& boxes = _boxes;
+                std::nth_element( _order.begin() + begin, _order.begin() + mid, _order.begin() + end,
+                                  [&boxes,axis]( size_t a, size_t b )
+                                  {
+                                      // empty boxes have no center, they are never reported anyway
+                                      const _Scalar ca = boxes[a].isEmpty() ? _Scalar(0.) : boxes[a].center()(axis);
+                                      const _Scalar cb = boxes[b].isEmpty() ? _Scalar(0.) : boxes[b].center()(axis);
+                                      return ca < cb;
+                                  } );
+                left  = this->buildNode( begin, mid );
+                right = this->buildNode( mid  , end );
+            }
+
+            Node &node = _nodes[id]; // buildNode() might have reallocated
+            node.box   = box;
+            node.left  = left;
+            node.right = right;
+            node.begin = begin;
+            node.end   = end;
+            return id;
+        } //...buildNode()
+
+        std::vector<LidT>   _ids;
+        std::vector<BoxT>   _boxes;
+        std::vector<size_t> _order;     //!< \brief Box indices, leaves cover contiguous ranges.
+        std::vector<Node>   _nodes;     //!< \brief Root first.
+}; //...BoxBvh
+
+} //...ns processing
+} //...ns rapter
+
+#endif // RAPTER_BOXBVH_HPP
@@ -0,0 +1,227 @@
+#ifndef RAPTER_DIRECTIONINDEX_HPP
+#define RAPTER_DIRECTIONINDEX_HPP
+
+#include <vector>
+#include <algorithm>     // sort, min, max
+#include <cmath>         // acos, floor
+#include <limits>
+#include "Eigen/Dense"
+#include "rapter/simpleTypes.h" // LidT
+
+namespace rapter {
+namespace processing {
+
+/*! \brief  Gauss sphere grid over the directions of primitives, to visit only pairs, that can pass an angle test.
+ *
+ *          Directions are binned into the cells of a cube map (6 faces of N x N cells). For every pair of occupied cells, the angle between
+ *          any two of their members lies within the angle of the cell centers +- the two cell radii. A pair of cells is compatible, if
+ *          this interval comes closer than angleLimit to one of the allowed angles, i.e. if a member pair could pass
+ *          \ref MyPrimitivePrimitiveAngleFunctor::eval() < angleLimit. The test is conservative, so no passing pair is lost,
+ *          and query() returns ids in ascending order, so callers visit the surviving pairs in their original order.
+ *
+ *          Zero length, or NaN directions have an angle of 0 to anything, so they are compatible with every cell.
+ *          Built once, then queried from any number of threads.
+ *  \tparam _Scalar Concept: float.
+ */
+template <typename _Scalar>
+class DirectionIndex
+{
+    public:
+        typedef Eigen::Matrix<double,3,1> Vector3;
+
+        DirectionIndex() : _resolution( 1 ) {}
+
+        //! \brief Adds direction \p dir with \p id. Ids have to be added in ascending order. \tparam _DirT Concept: Eigen::Vector3f.
+        template <class _DirT>
+        inline void insert( LidT const id, _DirT const& dir )
+        {
+            _ids .push_back( id );
+            _dirs.push_back( dir.template cast<double>() );
+        }
+
+        /*! \brief              Bins the inserted directions, and finds the compatible cell pairs.
+         *  \param[in] angles   Allowed angles in radians, as used by the angle test.
+         *  \param[in] angleLimit Angle test threshold in radians.
+         */
+        template <class _AnglesT>
+        inline void build( _AnglesT const& angles, _Scalar const angleLimit )
+        {
+            _angles.assign( angles.begin(), angles.end() );
+            _angleLimit = angleLimit;
+
+            // refine, until about 4 directions share a cell, or the cell pairs get too many to check.
+            // Directions of 2D lines only occupy the equator, so they get a finer grid.
+            const size_t targetCells = std::max( size_t(1), std::min(size_t(2048), _dirs.size() / 4) );
+            for ( _resolution = 1; _resolution < 256; _resolution *= 2 )
+            {
+                std::vector<int> cells;
+                cells.reserve( _dirs.size() );
+                for ( size_t i = 0; i != _dirs.size(); ++i )
+                    cells.push_back( this->cellOf(_dirs[i]) );
+                std::sort( cells.begin(), cells.end() );
+                if ( size_t(std::unique(cells.begin(), cells.end()) - cells.begin()) >= targetCells )
+                    break;
+            }
+
+            std::vector<int> cellOfDir( _dirs.size() );
+            std::vector<int> occupied;
+            {
+                std::vector<int> slot( 6 * _resolution * _resolution, -1 );
+                for ( size_t i = 0; i != _dirs.size(); ++i )
+                {
+                    const int cell = this->cellOf( _dirs[i] );
+                    if ( cell < 0 )
+                        _always.push_back( _ids[i] );
+                    else if ( slot[cell] < 0 )
+                    {
+                        slot[cell] = occupied.size();
+                        occupied.push_back( cell );
+                    }
+                    cellOfDir[i] = cell < 0 ? -1 : slot[cell];
+                }
+                _slots.swap( slot );
+            }
+
+            _members.assign( occupied.size(), std::vector<LidT>() );
+            for ( size_t i = 0; i != _dirs.size(); ++i )
+                if ( cellOfDir[i] >= 0 )
+                    _members[ cellOfDir[i] ].push_back( _ids[i] );
+
+            _centers.resize( occupied.size() );
+            _radii  .resize( occupied.size() );
+            for ( size_t c = 0; c != occupied.size(); ++c )
+                this->cellGeometry( _centers[c], _radii[c], occupied[c] );
+
+            _compatible.assign( occupied.size(), std::vector<int>() );
+            for ( size_t c0 = 0; c0 != occupied.size(); ++c0 )
+                for ( size_t c1 = c0; c1 != occupied.size(); ++c1 )
+                    if ( this->compatible(_centers[c0], _radii[c0], _centers[c1], _radii[c1]) )
+                    {
+                        _compatible[c0].push_back( c1 );
+                        if ( c1 != c0 )
+                            _compatible[c1].push_back( c0 );
+                    }
+        } //...build()
+
+        /*! \brief              Lists the ids larger than \p after, that might pass the angle test with \p dir, in ascending order.
+         *  \param[out] out     Cleared first.
+         *  \param[in] dir      Query direction, does not need to be inserted.
+         *  \param[in] after    Only ids larger than this are listed, -1 for all.
+         */
+        template <class _DirT>
+        inline void query( std::vector<LidT> &out, _DirT const& dir, LidT const after ) const
+        {
+            out.clear();
+            const Vector3 d    = dir.template cast<double>();
+            const int     cell = this->cellOf( d );
+
+            if ( cell < 0 ) // degenerate, compatible with everything
+            {
+                for ( size_t c = 0; c != _members.size(); ++c )
+                    this->append( out, _members[c], after );
+            }
+            else if ( _slots[cell] >= 0 )
+            {
+                std::vector<int> const& compatible = _compatible[ _slots[cell] ];
+                for ( size_t k = 0; k != compatible.size(); ++k )
+                    this->append( out, _members[compatible[k]], after );
+            }
+            else // direction not inserted, check cells on the fly
+            {
+                Vector3 center; double radius;
+                this->cellGeometry( center, radius, cell );
+                for ( size_t c = 0; c != _members.size(); ++c )
+                    if ( this->compatible(center, radius, _centers[c], _radii[c]) )
+                        this->append( out, _members[c], after );
+            }
+            this->append( out, _always, after );
+
+            std::sort( out.begin(), out.end() );
+        } //...query()
+
+        inline size_t size     () const { return _ids.size(); }
+        inline size_t cellCount() const { return _members.size(); } //!< \brief Occupied cells.
+
+    protected:
+        //! \brief Cube map cell of \p d, or -1, if it has no direction.
+        inline int cellOf( Vector3 const& d ) const
+        {
+            const Vector3 a = d.cwiseAbs();
+            if ( !(a.array() < std::numeric_limits<double>::infinity()).all() || !(a.maxCoeff() > 0.) ) // NaN, inf or zero
+                return -1;
+
+            int axis = 0;
+            if ( a(1) > a(axis) ) axis = 1;
+            if ( a(2) > a(axis) ) axis = 2;
+            const int face = 2 * axis + (d(axis) < 0.);
+            const double s = d( (axis+1) % 3 ) / a(axis), t = d( (axis+2) % 3 ) / a(axis);
+            const int i = std::min( _resolution - 1, int(std::floor((s + 1.) * .5 * _resolution)) );
+            const int j = std::min( _resolution - 1, int(std::floor((t + 1.) * .5 * _resolution)) );
+            return (face * _resolution + i) * _resolution + j;
+        } //...cellOf()
+
+        //! \brief Unit direction of face coordinates (s,t) of \p face.
+        inline Vector3 faceDir( int const face, double const s, double const t ) const
+        {
+            const int axis = face / 2;
+            Vector3 d;
+            d( axis )         = (face % 2) ? -1. : 1.;
+            d( (axis+1) % 3 ) = s;
+            d( (axis+2) % 3 ) = t;
+            return d.normalized();
+        } //...faceDir()
+
+        //! \brief Center direction, and the largest angle from it to the cell's corners, that bounds the angle to any point in the cell.
+        inline void cellGeometry( Vector3 &center, double &radius, int const cell ) const
+        {
+            const int    face = cell / (_resolution * _resolution);
+            const int    i    = (cell / _resolution) % _resolution;
+            const int    j    = cell % _resolution;
+            const double step = 2. / _resolution;
+            const double s0   = -1. + i * step, t0 = -1. + j * step;
+
+            center = this->faceDir( face, s0 + .5 * step, t0 + .5 * step );
+            radius = 0.;
+            for ( int corner = 0; corner != 4; ++corner )
+            {
+                const Vector3 c = this->faceDir( face, s0 + (corner & 1) * step, t0 + (corner >> 1) * step );
+                radius = std::max( radius, std::acos(std::max(-1., std::min(1., center.dot(c)))) );
+            }
+        } //...cellGeometry()
+
+        //! \brief True, if two directions from these cells can have an angle closer than _angleLimit to an allowed angle.
+        inline bool compatible( Vector3 const& center0, double const radius0, Vector3 const& center1, double const radius1 ) const
+        {
+            static const double slack = 1.e-4; // the angle test runs in _Scalar
+
+            const double angle  = std::acos( std::max(-1., std::min(1., center0.dot(center1))) );
+            const double spread = radius0 + radius1 + double(_angleLimit) + slack;
+            for ( size_t a = 0; a != _angles.size(); ++a )
+                if ( std::abs(angle - double(_angles[a])) < spread )
+                    return true;
+            return false;
+        } //...compatible()
+
+        //! \brief Appends ids of \p ids larger than \p after, ids are ascending.
+        static inline void append( std::vector<LidT> &out, std::vector<LidT> const& ids, LidT const after )
+        {
+            out.insert( out.end(), std::upper_bound(ids.begin(), ids.end(), after), ids.end() );
+        } //...append()
+
+        int                                 _resolution;    //!< \brief N, cells along a face edge.
+        std::vector<_Scalar>                _angles;
+        _Scalar                             _angleLimit;
+        std::vector<LidT>                   _ids;
+        std::vector<Vector3>                _dirs;
+        std::vector<int>                    _slots;         //!< \brief Occupied cell index per cube map cell, -1 if empty.
+        std::vector< std::vector<LidT> >    _members;       //!< \brief Ascending ids per occupied cell.
+        std::vector<Vector3>                _centers;
+        std::vector<double>                 _radii;
+        std::vector< std::vector<int> >     _compatible;    //!< \brief Compatible occupied cells per occupied cell.
+        std::vector<LidT>                   _always;        //!< \brief Ids of degenerate directions.
+}; //...DirectionIndex
+
+} //...ns processing
+} //...ns rapter
+
+#endif // RAPTER_DIRECTIONINDEX_HPP
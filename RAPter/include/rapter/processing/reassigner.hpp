@@ -0,0 +1,242 @@
+#ifndef RAPTER_REASSIGNER_HPP
+#define RAPTER_REASSIGNER_HPP
+
+#include <vector>
+#include <map>
+#include <algorithm>     // min, max, swap
+#include <cmath>         // abs
+#include <limits>
+#include <iostream>
+#include <cstdlib>       // EXIT_SUCCESS
+#include "omp.h"
+#include "Eigen/Dense"
+#include "rapter/simpleTypes.h"             // LidT, GidT, RAPTER_MAX_OMP_THREADS
+#include "rapter/processing/boxBvh.hpp"     // BoxBvh
+
+namespace rapter {
+namespace processing {
+
+/*! \brief  Lists the primitives, that can be closer than a threshold to a point, to reassign points without testing every primitive.
+ *
+ *          Primitives are infinite (\ref LinePrimitive::getDistance(), \ref PlanePrimitive::getDistance()), so their reach is clipped to a domain,
+ *          usually the bounding box of the points: a plane reaches the part of the domain within its slab of width 2 x threshold,
+ *          a line the box around its segment inside the domain, grown by the threshold. The reaches go into a \ref BoxBvh.
+ *          Like \ref BoxBvh::query(), candidates() returns ids in ascending order, so callers visit primitives in their original order.
+ *          Built once, then queried from any number of threads.
+ *  \tparam _Scalar Concept: float.
+ */
+template <typename _Scalar>
+class Reassigner
+{
+    public:
+        typedef BoxBvh<_Scalar>                 BvhT;
+        typedef typename BvhT::BoxT             BoxT;
+        typedef Eigen::Matrix<_Scalar,3,1>      Vector3;
+        //! \brief Sum of distances and point count per (previous point GID, new point GID).
+        typedef std::map< std::pair<GidT,GidT>, std::pair<_Scalar,LidT> > StatsT;
+
+        /*! \param[in] domain    Box containing every point, that will be queried.
+         *  \param[in] threshold Largest distance of a point from a primitive to be listed.
+         */
+        Reassigner( BoxT const& domain, _Scalar const threshold )
+            : _domain( domain ), _threshold( threshold ) {}
+
+        //! \brief Bounding box of the positions of \p points. \tparam _PointContainerT Concept: std::vector<PointPrimitive>.
+        template <class _PointContainerT>
+        static inline BoxT domainOf( _PointContainerT const& points )
+        {
+            BoxT box;
+            for ( size_t pid = 0; pid != points.size(); ++pid )
+                box.extend( points[pid].pos().template cast<_Scalar>() );
+            return box;
+        }
+
+        /*! \brief Adds the reach of \p prim with \p id. Ids have to be added in ascending order.
+         *  \tparam _PrimitiveT Concept: \ref LinePrimitive (EmbedSpaceDim 2), or \ref PlanePrimitive.
+         */
+        template <class _PrimitiveT>
+        inline void insert( LidT const id, _PrimitiveT const& prim )
+        {
+            const Vector3 pos = prim.pos().template cast<_Scalar>();
+            const Vector3 dir = prim.dir().template cast<_Scalar>();
+            _bvh.insert( id, _PrimitiveT::EmbedSpaceDim == 2 ? this->lineReach(pos, dir) : this->planeReach(pos, dir) );
+        }
+
+        inline void build() { _bvh.build(); } //!< \brief Call after the last insert().
+
+        //! \brief Lists the ids of the primitives, that can be closer than the threshold to \p pos, in ascending order.
+        template <class _PosT>
+        inline void candidates( std::vector<LidT> &out, _PosT const& pos ) const
+        {
+            _bvh.query( out, BoxT(pos.template cast<_Scalar>()), -1 );
+        }
+
+        inline _Scalar threshold() const { return _threshold; }
+
+        /*! \brief                  Assigns every point the GID of its closest primitive closer than the threshold, in parallel.
+         *
+         *                          Ties go to the earlier primitive, like testing every primitive in order would.
+         *  \param[in,out] points   Points to tag with the GID of their primitive.
+         *  \param[in] primitives   Primitives in the order of their insert() ids.
+         *  \param[in] gids         GID to assign per primitive.
+         *  \param[in] unassigned   GID of points with no primitive within the threshold. May be one of \p gids.
+         *  \param[out] stats       Optional statistics of (previous GID, new GID) of the points within the threshold, accumulated per thread, then merged.
+         *  \return                 EXIT_SUCCESS, or EXIT_FAILURE, if the ids don't match.
+         */
+        template <class _PointContainerT, class _PrimitiveT>
+        inline int assign( _PointContainerT                     & points
+                         , std::vector<_PrimitiveT const*> const& primitives
+                         , std::vector<GidT>               const& gids
+                         , GidT                            const  unassigned
+                         , StatsT                               * stats = NULL ) const
+        {
+            typedef typename _PointContainerT::value_type PointPrimitiveT;
+
+            if ( (primitives.size() != _bvh.size()) || (gids.size() != primitives.size()) )
+            {
+                std::cerr << "[" << __func__ << "]: " << "primitives (" << primitives.size() << "), gids (" << gids.size() << ") and index (" << _bvh.size() << ") sizes don't match" << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            std::vector<StatsT> localStats( stats ? RAPTER_MAX_OMP_THREADS : 0 );
+            #pragma omp parallel num_threads(RAPTER_MAX_OMP_THREADS)
+            {
+                std::vector<LidT> candidates;
+                StatsT *local = stats ? &localStats[ omp_get_thread_num() ] : NULL;
+
+                #pragma omp for schedule(dynamic,1024)
+                for ( LidT pid = 0; pid < LidT(points.size()); ++pid )
+                {
+                    this->candidates( candidates, points[pid].pos() );
+
+                    // found separately, since unassigned may well be a GID too
+                    _Scalar minDist = std::numeric_limits<_Scalar>::max();
+                    GidT    minGid  = unassigned;
+                    bool    found   = false;
+                    for ( size_t i = 0; i != candidates.size(); ++i )
+                    {
+                        const _Scalar dist = std::abs( primitives[candidates[i]]->getDistance(points[pid].pos()) );
+                        if ( (dist < minDist) && (dist < _threshold) )
+                        {
+                            minDist = dist;
+                            minGid  = gids[ candidates[i] ];
+                            found   = true;
+                        }
+                    }
+
+                    if ( local && found )
+                    {
+                        std::pair<_Scalar,LidT> &entry = (*local)[ std::pair<GidT,GidT>(points[pid].getTag(PointPrimitiveT::TAGS::GID), minGid) ];
+                        entry.first += minDist;
+                        ++entry.second;
+                    }
+                    points[pid].setTag( PointPrimitiveT::TAGS::GID, minGid );
+                } //...for points
+            } //...omp parallel
+
+            if ( stats )
+            {
+                stats->clear();
+                for ( size_t tid = 0; tid != localStats.size(); ++tid )
+                    for ( typename StatsT::const_iterator it = localStats[tid].begin(); it != localStats[tid].end(); ++it )
+                    {
+                        std::pair<_Scalar,LidT> &entry = (*stats)[ it->first ];
+                        entry.first  += it->second.first;
+                        entry.second += it->second.second;
+                    }
+            }
+
+            return EXIT_SUCCESS;
+        } //...assign()
+
+    protected:
+        //! \brief Box of the domain within the threshold of a plane through \p pos with normal \p normal.
+        inline BoxT planeReach( Vector3 const& pos, Vector3 const& normal ) const
+        {
+            const _Scalar norm = normal.norm();
+            if ( !(norm > _Scalar(0.)) || !(norm < std::numeric_limits<_Scalar>::infinity()) ) // getDistance() is 0 or NaN everywhere
+                return _domain;
+            // getDistance() is scaled by the normal's length
+            const Vector3 n = normal / norm;
+            const _Scalar t = _threshold / norm;
+
+            // the reach is convex, its vertices are the corners of the domain inside the slab, and the crossings of the domain's edges with the slab's sides
+            BoxT box;
+            for ( int corner = 0; corner != 8; ++corner )
+            {
+                const Vector3 a = _domain.corner( typename BoxT::CornerType(corner) );
+                const _Scalar fa = n.dot( a - pos );
+                if ( std::abs(fa) <= t )
+                    box.extend( a );
+                for ( int axis = 0; axis != 3; ++axis )
+                {
+                    if ( corner & (1 << axis) ) continue; // every edge once, from its lower corner
+                    const Vector3 b  = _domain.corner( typename BoxT::CornerType(corner | (1 << axis)) );
+                    const _Scalar fb = n.dot( b - pos );
+                    for ( int side = -1; side <= 1; side += 2 )
+                    {
+                        const _Scalar level = side * t;
+                        if ( (fa - level) * (fb - level) <= _Scalar(0.) && (fa != fb) )
+                            box.extend( a + (b - a) * ((level - fa) / (fb - fa)) );
+                    }
+                }
+            }
+            return this->pad( box );
+        } //...planeReach()
+
+        //! \brief Box around the part of the line through \p pos with direction \p dir inside the domain, grown by the threshold.
+        inline BoxT lineReach( Vector3 const& pos, Vector3 const& dir ) const
+        {
+            const _Scalar norm = dir.norm();
+            if ( !(norm > _Scalar(0.)) || !(norm < std::numeric_limits<_Scalar>::infinity()) )
+                return _domain;
+            // getDistance() is scaled by the direction's length
+            const Vector3 d = dir / norm;
+            const _Scalar t = _threshold / norm;
+
+            // clip the line to the domain grown by t (the closest line point of a point within t lies there)
+            _Scalar u0 = -std::numeric_limits<_Scalar>::max(), u1 = std::numeric_limits<_Scalar>::max();
+            for ( int axis = 0; axis != 3; ++axis )
+            {
+                const _Scalar lo = _domain.min()(axis) - t, hi = _domain.max()(axis) + t;
+                if ( d(axis) == _Scalar(0.) )
+                {
+                    if ( (pos(axis) < lo) || (pos(axis) > hi) )
+                        return BoxT();
+                    continue;
+                }
+                _Scalar a = (lo - pos(axis)) / d(axis), b = (hi - pos(axis)) / d(axis);
+                if ( a > b ) std::swap( a, b );
+                u0 = std::max( u0, a );
+                u1 = std::min( u1, b );
+            }
+            if ( u0 > u1 )
+                return BoxT();
+
+            BoxT box;
+            box.extend( pos + d * u0 );
+            box.extend( pos + d * u1 );
+            box.min().array() -= t;
+            box.max().array() += t;
+            return this->pad( box );
+        } //...lineReach()
+
+        //! \brief Grows \p box by a little, so that rounding in getDistance() can't drop a point.
+        inline BoxT pad( BoxT box ) const
+        {
+            if ( box.isEmpty() ) return box;
+            const _Scalar eps = _Scalar(1.e-4) * (_domain.sizes().norm() + _threshold);
+            box.min().array() -= eps;
+            box.max().array() += eps;
+            return box;
+        }
+
+        BoxT        _domain;
+        _Scalar     _threshold;
+        BvhT        _bvh;
+}; //...Reassigner
+
+} //...ns processing
+} //...ns rapter
+
+#endif // RAPTER_REASSIGNER_HPP
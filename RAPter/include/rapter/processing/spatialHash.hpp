@@ -0,0 +1,367 @@
+#ifndef RAPTER_SPATIALHASH_HPP
+#define RAPTER_SPATIALHASH_HPP
+
+#include <vector>
+#include <algorithm>     // sort, nth_element
+#include <unordered_map>
+#include <cmath>         // floor
+#include <limits>
+#include <iostream>
+#include <cstdlib>       // EXIT_SUCCESS
+#include <stdint.h>      // uint64_t
+#include "Eigen/Dense"
+#include "rapter/simpleTypes.h" // PidT, RAPTER_MAX_OMP_THREADS
+
+namespace rapter {
+namespace processing {
+
+/*! \brief Neighbourhoods of many points in compressed sparse row layout.
+ *         The neighbours of point i are indices[ offsets[i] .. offsets[i+1] ), sorted by distance.
+ */
+template <typename _Scalar>
+struct NeighbourhoodsCSR
+{
+    std::vector<size_t>     offsets;    //!< \brief size() + 1 entries.
+    std::vector<PidT>       indices;    //!< \brief Neighbour point ids.
+    std::vector<_Scalar>    sqrDists;   //!< \brief Squared distances, arranged as indices.
+
+    inline size_t       size ()                     const { return offsets.size() ? offsets.size() - 1 : 0; }
+    inline size_t       count( size_t pid )         const { return offsets[pid+1] - offsets[pid]; }
+    inline PidT const*  begin( size_t pid )         const { return indices.data() + offsets[pid]; }
+    inline PidT const*  end  ( size_t pid )         const { return indices.data() + offsets[pid+1]; }
+    inline _Scalar const* sqrDistsBegin( size_t pid ) const { return sqrDists.data() + offsets[pid]; }
+
+    //! \brief Copies neighbourhood \p pid to \p out. Used to feed functions taking std::vector<int> indices.
+    template <typename _IndexT>
+    inline void copyTo( size_t pid, std::vector<_IndexT> &out ) const { out.assign( this->begin(pid), this->end(pid) ); }
+}; //...NeighbourhoodsCSR
+
+/*! \brief  Uniform grid over a point cloud, hashed by integer cell coordinates.
+ *
+ *          Built once per cloud with a cell size close to the working scale, and queried from any number of threads.
+ *          Any query radius is answered exactly, the cell size only affects the speed.
+ *          Results are sorted by (squared distance, point id), so the query point itself comes first, like with pcl::search::KdTree.
+ *  \tparam _Scalar Concept: float.
+ */
+template <typename _Scalar>
+class SpatialHash
+{
+    public:
+        typedef _Scalar                           Scalar;
+        typedef Eigen::Matrix<_Scalar,3,1>        Vector3;
+        typedef std::pair<_Scalar,PidT>           DistPid;
+        typedef NeighbourhoodsCSR<_Scalar>        CSR;
+
+        SpatialHash() : _cellSize( 0 ) {}
+
+        inline bool     empty   () const { return _points.empty(); }
+        inline size_t   size    () const { return _points.size(); }
+        inline Scalar   cellSize() const { return _cellSize; }
+        inline Vector3  pos( PidT pid ) const { return _points[pid]; }
+
+        /*! \brief              Builds the grid from a container of points with a pos() getter.
+         *  \tparam _PointContainerT Concept: std::vector<\ref rapter::PointPrimitive>, or \ref rapter::PointStore.
+         *  \param[in] cellSize Edge length of a cell, usually the query radius. If <= 0, it is chosen to hold about 8 points per cell.
+         */
+        template <class _PointContainerT>
+        inline int build( _PointContainerT const& points, Scalar const cellSize )
+        {
+            _points.resize( points.size() );
+#           pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS)
+            for ( long pid = 0; pid < static_cast<long>(points.size()); ++pid )
+                _points[pid] = points[pid].template pos();
+
+            return this->_build( cellSize );
+        } //...build()
+
+        //! \brief Builds the grid from a pcl cloud. \tparam _CloudPtrT Concept: pcl::PointCloud<pcl::PointXYZ>::Ptr.
+        template <class _CloudPtrT>
+        inline int buildFromCloud( _CloudPtrT const& cloud, Scalar const cellSize )
+        {
+            _points.resize( cloud->size() );
+#           pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS)
+            for ( long pid = 0; pid < static_cast<long>(cloud->size()); ++pid )
+                _points[pid] = cloud->points[pid].getVector3fMap().template cast<Scalar>();
+
+            return this->_build( cellSize );
+        } //...buildFromCloud()
+
+        /*! \brief              Finds all points within \p radius of \p query. Thread-safe.
+         *  \param[in] maxNN    Keep only the \p maxNN closest, if > 0.
+         *  \return             Number of neighbours found.
+         */
+        inline int radiusSearch( Vector3 const& query, Scalar const radius, std::vector<int> &indices, std::vector<float> &sqrDists, int const maxNN = 0 ) const
+        {
+            std::vector<DistPid> found;
+            this->radiusSearch( query, radius, found, maxNN );
+            return copyResult( found, indices, sqrDists );
+        }
+
+        //! \brief Finds the \p K nearest points to \p query. Thread-safe.
+        inline int nearestKSearch( Vector3 const& query, int const K, std::vector<int> &indices, std::vector<float> &sqrDists ) const
+        {
+            std::vector<DistPid> found;
+            this->nearestKSearch( query, K, found );
+            return copyResult( found, indices, sqrDists );
+        }
+
+        //! \brief Radius search into a caller owned buffer, that can be reused between queries.
+        inline void radiusSearch( Vector3 const& query, Scalar const radius, std::vector<DistPid> &found, int const maxNN = 0 ) const
+        {
+            found.clear();
+            if ( _points.empty() || radius < Scalar(0) ) return;
+
+            const Scalar sqrRadius = radius * radius;
+            Eigen::Vector3i lo, hi;
+            for ( int d = 0; d != 3; ++d )
+            {
+                lo(d) = std::max( cellCoord(query(d) - radius), _minCell(d) );
+                hi(d) = std::min( cellCoord(query(d) + radius), _maxCell(d) );
+            }
+
+            for ( int x = lo(0); x <= hi(0); ++x )
+                for ( int y = lo(1); y <= hi(1); ++y )
+                    for ( int z = lo(2); z <= hi(2); ++z )
+                        this->collectCell( x, y, z, query, sqrRadius, found );
+
+            sortAndTruncate( found, maxNN );
+        } //...radiusSearch()
+
+        //! \brief kNN search into a caller owned buffer. Visits rings of cells around the query, until the K-th distance is closer than the next ring, or every point was found.
+        inline void nearestKSearch( Vector3 const& query, int const K, std::vector<DistPid> &found ) const
+        {
+            found.clear();
+            if ( _points.empty() || K <= 0 ) return;
+
+            // every point is a neighbour, no need to walk the grid
+            if ( static_cast<size_t>(K) >= _points.size() )
+            {
+                found.reserve( _points.size() );
+                for ( size_t pid = 0; pid != _points.size(); ++pid )
+                    found.push_back( DistPid((_points[pid] - query).squaredNorm(), pid) );
+                sortAndTruncate( found, K );
+                return;
+            }
+
+            const Scalar inf = std::numeric_limits<Scalar>::max();
+            const Eigen::Vector3i c( cellCoord(query(0)), cellCoord(query(1)), cellCoord(query(2)) );
+            const int maxRing = ( (_maxCell - c).cwiseAbs().cwiseMax((c - _minCell).cwiseAbs()) ).maxCoeff();
+            for ( int ring = 0; ring <= maxRing; ++ring )
+            {
+                for ( int x = c(0) - ring; x <= c(0) + ring; ++x )
+                    for ( int y = c(1) - ring; y <= c(1) + ring; ++y )
+                    {
+                        // only the shell of the cube at Chebyshev distance "ring"
+                        const bool onShell = (std::abs(x - c(0)) == ring) || (std::abs(y - c(1)) == ring);
+                        const int  zStep   = onShell ? 1 : std::max( 2 * ring, 1 );
+                        for ( int z = c(2) - ring; z <= c(2) + ring; z += zStep )
+                            this->collectCell( x, y, z, query, inf, found );
+                    }
+
+                // every point visited, when K exceeds the point count
+                if ( found.size() == _points.size() )
+                    break;
+
+                // every point outside the visited cubes is at least ring * cellSize away
+                if ( static_cast<int>(found.size()) >= K )
+                {
+                    std::nth_element( found.begin(), found.begin() + (K-1), found.end() );
+                    const Scalar safe = ring * _cellSize;
+                    if ( found[K-1].first <= safe * safe )
+                        break;
+                }
+            }
+
+            sortAndTruncate( found, K );
+        } //...nearestKSearch()
+
+        /*! \brief              Batched radius search for all points of the index, run in parallel.
+         *  \param[out] csr     Neighbourhood of every point, sorted by distance, the point itself first.
+         *  \param[in]  maxNN   Keep only the \p maxNN closest, if > 0.
+         */
+        inline void radiusSearchAll( CSR &csr, Scalar const radius, int const maxNN = 0 ) const
+        {
+            this->batch( csr, [this,radius,maxNN]( PidT pid, std::vector<DistPid> &found ) { this->radiusSearch( _points[pid], radius, found, maxNN ); } );
+        }
+
+        //! \brief Batched kNN search for all points of the index, run in parallel.
+        inline void nearestKSearchAll( CSR &csr, int const K ) const
+        {
+            this->batch( csr, [this,K]( PidT pid, std::vector<DistPid> &found ) { this->nearestKSearch( _points[pid], K, found ); } );
+        }
+
+        /*! \brief                  Batched neighbourhood query with the semantics of \ref getNeighbourhoodIndices().
+         *  \param[in] K            kNN count, used if \p radius <= 0.
+         *  \param[in] radius       Radius, all neighbours are returned, if > 0.
+         *  \param[in] soft_radius  Fall back to the 3 nearest neighbours, if less than 2 were found in \p radius.
+         */
+        inline void neighbourhoods( CSR &csr, int const K, Scalar const radius, bool const soft_radius ) const
+        {
+            this->batch( csr, [this,K,radius,soft_radius]( PidT pid, std::vector<DistPid> &found )
+            {
+                if ( radius > Scalar(0) ) this->radiusSearch  ( _points[pid], radius, found );
+                else                      this->nearestKSearch( _points[pid], K     , found );
+
+                if ( (found.size() < 2) && soft_radius )
+                    this->nearestKSearch( _points[pid], 3, found );
+            } );
+        } //...neighbourhoods()
+
+    protected:
+        inline int cellCoord( Scalar v ) const { return static_cast<int>( std::floor(v / _cellSize) ); }
+
+        //! \brief Packs cell coordinates to a key. Far away cells might share a key, which only costs extra distance checks.
+        static inline uint64_t cellKey( int x, int y, int z )
+        {
+            return   (static_cast<uint64_t>(x & 0x1FFFFF) << 42)
+                   | (static_cast<uint64_t>(y & 0x1FFFFF) << 21)
+                   |  static_cast<uint64_t>(z & 0x1FFFFF);
+        }
+
+        inline void collectCell( int x, int y, int z, Vector3 const& query, Scalar const sqrRadius, std::vector<DistPid> &found ) const
+        {
+            typename std::unordered_map<uint64_t,size_t>::const_iterator it = _cells.find( cellKey(x,y,z) );
+            if ( it == _cells.end() ) return;
+
+            for ( size_t i = _cellOffsets[it->second]; i != _cellOffsets[it->second+1]; ++i )
+            {
+                const PidT   pid  = _pids[i];
+                const Scalar sqrD = (_points[pid] - query).squaredNorm();
+                if ( sqrD <= sqrRadius )
+                    found.push_back( DistPid(sqrD, pid) );
+            }
+        } //...collectCell()
+
+        static inline void sortAndTruncate( std::vector<DistPid> &found, int const maxNN )
+        {
+            if ( (maxNN > 0) && (static_cast<int>(found.size()) > maxNN) )
+            {
+                std::partial_sort( found.begin(), found.begin() + maxNN, found.end() );
+                found.resize( maxNN );
+            }
+            else
+                std::sort( found.begin(), found.end() );
+        }
+
+        static inline int copyResult( std::vector<DistPid> const& found, std::vector<int> &indices, std::vector<float> &sqrDists )
+        {
+            indices .resize( found.size() );
+            sqrDists.resize( found.size() );
+            for ( size_t i = 0; i != found.size(); ++i )
+            {
+                indices [i] = found[i].second;
+                sqrDists[i] = found[i].first;
+            }
+            return found.size();
+        }
+
+        //! \brief Runs \p query for every point on contiguous blocks per thread, and concatenates the blocks in order.
+        template <class _QueryFunctorT>
+        inline void batch( CSR &csr, _QueryFunctorT query ) const
+        {
+            const long N          = _points.size();
+            const int  blockCount = std::max( 1, std::min<int>( RAPTER_MAX_OMP_THREADS * 4, N ) );
+            std::vector< std::vector<PidT>    > blockIndices ( blockCount );
+            std::vector< std::vector<_Scalar> > blockSqrDists( blockCount );
+
+            csr.offsets.assign( N + 1, 0 );
+#           pragma omp parallel num_threads(RAPTER_MAX_OMP_THREADS)
+            {
+                std::vector<DistPid> found;
+#               pragma omp for schedule(dynamic,1)
+                for ( int block = 0; block < blockCount; ++block )
+                {
+                    const long start = N *  block      / blockCount;
+                    const long stop  = N * (block + 1) / blockCount;
+                    for ( long pid = start; pid < stop; ++pid )
+                    {
+                        query( pid, found );
+                        csr.offsets[pid+1] = found.size();
+                        for ( size_t i = 0; i != found.size(); ++i )
+                        {
+                            blockIndices [block].push_back( found[i].second );
+                            blockSqrDists[block].push_back( found[i].first  );
+                        }
+                    }
+                }
+            }
+
+            for ( long pid = 0; pid < N; ++pid )
+                csr.offsets[pid+1] += csr.offsets[pid];
+
+            csr.indices .resize( csr.offsets[N] );
+            csr.sqrDists.resize( csr.offsets[N] );
+#           pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS)
+            for ( int block = 0; block < blockCount; ++block )
+            {
+                const size_t start = csr.offsets[ N * block / blockCount ];
+                std::copy( blockIndices [block].begin(), blockIndices [block].end(), csr.indices .begin() + start );
+                std::copy( blockSqrDists[block].begin(), blockSqrDists[block].end(), csr.sqrDists.begin() + start );
+            }
+        } //...batch()
+
+        //! \brief Sorts the point ids by cell, and records the range of each cell.
+        inline int _build( Scalar const cellSize )
+        {
+            _cells.clear(); _cellOffsets.clear(); _pids.clear();
+            _cellSize = cellSize;
+            if ( _points.empty() ) { if ( _cellSize <= Scalar(0) ) _cellSize = Scalar(1); return EXIT_SUCCESS; }
+
+            Vector3 minPt( _points[0] ), maxPt( _points[0] );
+            for ( size_t pid = 1; pid < _points.size(); ++pid )
+            {
+                minPt = minPt.cwiseMin( _points[pid] );
+                maxPt = maxPt.cwiseMax( _points[pid] );
+            }
+            const Scalar span = (maxPt - minPt).maxCoeff();
+
+            // about 8 points per cell, if the points filled the bounding cube
+            if ( _cellSize <= Scalar(0) )
+                _cellSize = span * std::pow( Scalar(8) / _points.size(), Scalar(1)/Scalar(3) );
+            if ( _cellSize <= Scalar(0) )
+                _cellSize = Scalar(1);
+
+            // coarsen the grid, if the cloud spans more cells than a key can tell apart, so that no two visited cells alias
+            const Scalar maxSpan = Scalar( (1 << 21) - 4 );
+            if ( span / _cellSize > maxSpan )
+                _cellSize = span / maxSpan;
+
+            std::vector< std::pair<uint64_t,PidT> > keys( _points.size() );
+            _minCell.setConstant( std::numeric_limits<int>::max() );
+            _maxCell.setConstant( std::numeric_limits<int>::min() );
+            for ( size_t pid = 0; pid != _points.size(); ++pid )
+            {
+                const Eigen::Vector3i c( cellCoord(_points[pid](0)), cellCoord(_points[pid](1)), cellCoord(_points[pid](2)) );
+                _minCell = _minCell.cwiseMin( c );
+                _maxCell = _maxCell.cwiseMax( c );
+                keys[pid] = std::make_pair( cellKey(c(0),c(1),c(2)), static_cast<PidT>(pid) );
+            }
+            std::sort( keys.begin(), keys.end() );
+
+            _pids.resize( keys.size() );
+            for ( size_t i = 0; i != keys.size(); ++i )
+            {
+                if ( !i || (keys[i].first != keys[i-1].first) )
+                {
+                    _cells[ keys[i].first ] = _cellOffsets.size();
+                    _cellOffsets.push_back( i );
+                }
+                _pids[i] = keys[i].second;
+            }
+            _cellOffsets.push_back( keys.size() );
+
+            return EXIT_SUCCESS;
+        } //..._build()
+
+        Scalar                              _cellSize;
+        std::vector<Vector3>                _points;        //!< \brief Positions, copied at build time.
+        std::vector<PidT>                   _pids;          //!< \brief Point ids ordered by cell.
+        std::vector<size_t>                 _cellOffsets;   //!< \brief Cell c holds _pids[ _cellOffsets[c] .. _cellOffsets[c+1] ).
+        std::unordered_map<uint64_t,size_t> _cells;         //!< \brief Cell key to cell index.
+        Eigen::Vector3i                     _minCell, _maxCell;
+}; //...SpatialHash
+
+} //...ns processing
+} //...ns rapter
+
+#endif // RAPTER_SPATIALHASH_HPP
@@ -5,9 +5,13 @@
 #include <set>
 #include <vector>
 #include <algorithm>
+#include <cmath>                      // atan2
+#include <limits>
 #include "Eigen/Dense"
 #include "rapter/util/containers.hpp" // add()
 #include "rapter/simpleTypes.h"      // GidT
+#include "rapter/primitives/pointStore.h"
+#include "rapter/processing/spatialHash.hpp" // SpatialHash, NeighbourhoodsCSR
 #include "pcl/search/kdtree.h"
 #include "rapter/simpleTypes.h"
 
@@ -66,6 +70,17 @@ namespace rapter {
             return EXIT_SUCCESS;
         } //...getPopulations
 
+        //! \brief Same as above, but scans the contiguous GID array of a \ref rapter::PointStore.
+        template <class _GidIntSetMap, class _PointPrimitiveT > inline int
+        getPopulations( _GidIntSetMap & populations, PointStore<_PointPrimitiveT> const& points )
+        {
+            std::vector<GidT> const& gids = points.gids();
+            for ( size_t pid = 0; pid != gids.size(); ++pid )
+                containers::add( populations, gids[pid], static_cast<PidT>(pid) );
+
+            return EXIT_SUCCESS;
+        } //...getPopulations
+
         /*! \brief Calculate the number of points that are assigned to the GID (group id).
          *
          *  \tparam _PidContainerT  Concept: vector<int>: list of point ids that have that GID \p gid. (\#points assigned to a group id (GID).
@@ -506,6 +521,33 @@ namespace rapter {
             return EXIT_SUCCESS;
         } // ... fitline
         
+        /*! \brief                   Batched, parallel neighbourhood queries on a prebuilt index.
+         *  \param[out] neighbours  Neighbourhood of each point of \p index, sorted by distance.
+         *  \param[in ] index       Neighbour index, usually shared, see \ref PointStore::getSpatialIndex().
+         *  \param[in ] K           Neighbour count, used if \p radius <= 0.
+         *  \param[in ] radius      Optional, all neighbours inside are returned.
+         *  \param[in ] soft_radius Return the 3 nearest neighbours, if less than 2 were found in \p radius.
+         */
+        template <typename _Scalar>
+        inline int
+        getNeighbourhoodIndices( NeighbourhoodsCSR<_Scalar>         & neighbours
+                               , SpatialHash<_Scalar>          const& index
+                               , int                                  K           = 15
+                               , _Scalar                              radius      = -1.f
+                               , bool                                 soft_radius = false
+                               )
+        {
+            index.neighbourhoods( neighbours, K, radius, soft_radius );
+
+            PidT crowded = 0;
+            for ( size_t pid = 0; pid != neighbours.size(); ++pid )
+                crowded += ( neighbours.count(pid) > 1000 );
+            if ( crowded )
+                std::cerr << "[" << __func__ << "]: " << "[WARNING] Found too many neighbours (>1000) for " << crowded << " points, decrease scale!" << std::endl;
+
+            return EXIT_SUCCESS;
+        } //...getNeighbourhoodIndices()
+
         /*!
          * @brief                           Get's a list of neighbours for each point in pointcloud/indices_arg, indices untested
          * @param[out] neighbour_indices    List of list of neighbour indices. One list for each point in cloud.
@@ -527,6 +569,26 @@ namespace rapter {
                                 , bool                                                       soft_radius        = false
                                 )
         {
+            // without a selection, use a grid over the whole cloud, and query it in parallel
+            if ( !indices_arg )
+            {
+                SpatialHash<float>       index;
+                NeighbourhoodsCSR<float> csr;
+                index.buildFromCloud( cloud, radius );
+                getNeighbourhoodIndices( csr, index, K, radius, soft_radius );
+
+                neighbour_indices.resize( csr.size() );
+                if ( p_distances )    p_distances->resize( csr.size() );
+                for ( size_t pid = 0; pid != csr.size(); ++pid )
+                {
+                    csr.copyTo( pid, neighbour_indices[pid] );
+                    if ( p_distances )
+                        p_distances->at(pid).assign( csr.sqrDistsBegin(pid), csr.sqrDistsBegin(pid) + csr.count(pid) );
+                }
+
+                return EXIT_SUCCESS;
+            }
+
             // prepare output
             const PidT   N              = indices_arg ? indices_arg->size() : cloud->size();
             const bool  doRadiusSearch = radius > 0.f;
@@ -588,6 +650,7 @@ namespace rapter {
             return EXIT_SUCCESS;
         }
 
+
         /*! \brief Columnwise min for vectors. The Eigen implementation, that PCL calls successfully did not seem to work. Possibly an alignment issue.
          *  \tparam        Scalar Floating point precision. Concept: float.
          *  \tparam        Dim    Vector dimensionality. Concept: 3.
@@ -859,6 +922,102 @@ namespace rapter {
             return EXIT_SUCCESS;
         } //...cloud2Local()
 
+        /*! \brief Computes the 2D convex hull of \p points with Andrew's monotone chain in O(n log n).
+         * \tparam _Scalar      Floating point type.
+         * \param[out] hull     Hull vertices in counter-clockwise order, collinear points dropped. Has less than 3 entries for degenerate input.
+         * \param[in]  points   Input points, reordered (sorted) in place.
+         * \return EXIT_SUCCESS.
+         */
+        template <typename _Scalar> inline int
+        convexHull2D( std::vector< Eigen::Matrix<_Scalar,2,1> >       & hull
+                    , std::vector< Eigen::Matrix<_Scalar,2,1> >       & points )
+        {
+            typedef Eigen::Matrix<_Scalar,2,1> Position2;
+            struct Less  { inline bool operator()( Position2 const& a, Position2 const& b ) const { return (a(0) < b(0)) || ((a(0) == b(0)) && (a(1) < b(1))); } };
+            struct Equal { inline bool operator()( Position2 const& a, Position2 const& b ) const { return (a(0) == b(0)) && (a(1) == b(1)); } };
+            struct Cross { static inline _Scalar eval( Position2 const& o, Position2 const& a, Position2 const& b ) { return (a(0)-o(0)) * (b(1)-o(1)) - (a(1)-o(1)) * (b(0)-o(0)); } };
+
+            std::sort( points.begin(), points.end(), Less() );
+            points.erase( std::unique(points.begin(), points.end(), Equal()), points.end() );
+
+            hull.clear();
+            if ( points.size() < 3 )
+            {
+                hull = points;
+                return EXIT_SUCCESS;
+            }
+
+            hull.resize( 2 * points.size() );
+            size_t k = 0;
+            // lower hull
+            for ( size_t i = 0; i != points.size(); ++i )
+            {
+                while ( (k >= 2) && (Cross::eval(hull[k-2], hull[k-1], points[i]) <= _Scalar(0)) ) --k;
+                hull[k++] = points[i];
+            }
+            // upper hull
+            for ( size_t i = points.size() - 1, t = k + 1; i > 0; --i )
+            {
+                while ( (k >= t) && (Cross::eval(hull[k-2], hull[k-1], points[i-1]) <= _Scalar(0)) ) --k;
+                hull[k++] = points[i-1];
+            }
+            hull.resize( k - 1 ); // last point is the first one
+
+            return EXIT_SUCCESS;
+        } //...convexHull2D()
+
+        /*! \brief Finds the orientation of the minimum area bounding rectangle of a convex polygon with rotating calipers in O(n).
+         *         The rectangle has one side collinear with a hull edge, so only the hull edge directions are tested.
+         * \tparam _Scalar      Floating point type.
+         * \param[in]  hull     Convex polygon in counter-clockwise order, see \ref convexHull2D().
+         * \param[out] area     Optional output of the area of the rectangle.
+         * \return The angle of the rectangle's first axis to the x axis in radians, in [-pi/4, pi/4).
+         */
+        template <typename _Scalar> inline _Scalar
+        minAreaRectAngle( std::vector< Eigen::Matrix<_Scalar,2,1> > const& hull
+                        , _Scalar                                        * area = NULL )
+        {
+            typedef Eigen::Matrix<_Scalar,2,1> Position2;
+
+            _Scalar angle( 0 ), minArea( 0 );
+            const size_t n = hull.size();
+            if ( n == 2 )
+                angle = std::atan2( hull[1](1) - hull[0](1), hull[1](0) - hull[0](0) );
+            else if ( n > 2 )
+            {
+                minArea = std::numeric_limits<_Scalar>::max();
+                size_t right = 0, top = 0, left = 0; // support points in +edge, +normal and -edge directions
+                for ( size_t i = 0; i != n; ++i )
+                {
+                    const Position2 edge   = (hull[(i+1) % n] - hull[i]).normalized();
+                    const Position2 normal( -edge(1), edge(0) ); // points inside for a counter-clockwise hull
+
+                    if ( !i ) right = top = left = 1 % n;
+                    // the support points advance monotonically with the edge direction
+                    while ( (hull[(right+1) % n] - hull[right]).dot(edge  ) > _Scalar(0) ) right = (right+1) % n;
+                    if ( !i ) top = right;
+                    while ( (hull[(top  +1) % n] - hull[top  ]).dot(normal) > _Scalar(0) ) top   = (top  +1) % n;
+                    if ( !i ) left = top;
+                    while ( (hull[(left +1) % n] - hull[left ]).dot(edge  ) < _Scalar(0) ) left  = (left +1) % n;
+
+                    const _Scalar width  = (hull[right] - hull[left]).dot( edge   );
+                    const _Scalar height = (hull[top  ] - hull[i   ]).dot( normal );
+                    if ( width * height < minArea )
+                    {
+                        minArea = width * height;
+                        angle   = std::atan2( edge(1), edge(0) );
+                    }
+                }
+            }
+
+            // a rectangle is symmetric under quarter turns, return the orientation closest to the x axis
+            while ( angle >= _Scalar(M_PI_4) ) angle -= _Scalar(M_PI_2);
+            while ( angle < -_Scalar(M_PI_4) ) angle += _Scalar(M_PI_2);
+
+            if ( area ) *area = minArea;
+            return angle;
+        } //...minAreaRectAngle()
+
     } //...ns processing
 } //...ns rapter
 
@@ -3,8 +3,10 @@
 
 #include <utility> // pair
 #include <vector>
+#include "rapter/util/threads.hpp"
 
-#define RAPTER_MAX_OMP_THREADS (1)
+//! \brief Team size of all parallel regions. Set at runtime by --threads or $RAPTER_THREADS, see \ref rapter::threads.
+#define RAPTER_MAX_OMP_THREADS (rapter::threads::get())
 
 namespace rapter
 {
@@ -8,6 +8,7 @@
 #include "pcl/point_cloud.h"
 #include "pcl/search/kdtree.h"
 #include <numeric>
+#include "rapter/primitives/pointStore.h"
 
 namespace rapter {
     namespace pclutil {
@@ -58,6 +59,16 @@ namespace rapter {
             return tree;
         } //...buildANN
 
+        //! \brief Builds the search tree on the cached position cloud of \p points, instead of copying them again.
+        template <class _PointPrimitiveT>
+        inline PclSearchTreePtrT buildANN( PointStore<_PointPrimitiveT> const& points )
+        {
+            PclSearchTreePtrT tree( new PclSearchTreeT() );
+            tree->setInputCloud( points.getSearchCloud() );
+
+            return tree;
+        } //...buildANN
+
         template <int Dim>
         struct PCLPointAllocator
         {
@@ -0,0 +1,85 @@
+#ifndef RAPTER_THREADS_HPP
+#define RAPTER_THREADS_HPP
+
+#include <cstdlib> // getenv, atoi
+#include <string>
+#ifdef _OPENMP
+#   include "omp.h"
+#endif
+
+namespace rapter {
+//! \brief Process-wide thread count used by all parallel regions (see RAPTER_MAX_OMP_THREADS).
+namespace threads {
+
+//! \brief Name of the environment variable read, if --threads was not given.
+static const char* const ENV_NAME = "RAPTER_THREADS";
+
+//! \brief Number of cores OpenMP would use by default, 1 without OpenMP.
+inline int
+available()
+{
+#ifdef _OPENMP
+    return omp_get_num_procs();
+#else
+    return 1;
+#endif
+}
+
+//! \brief Storage of the current setting. 0 means not yet initialized.
+inline int&
+_count()
+{
+    static int count = 0;
+    return count;
+}
+
+/*! \brief          Sets the thread count for every stage, and the default OpenMP team size.
+ *  \param[in] n    Thread count. Values < 1 select all available cores.
+ *  \return         The thread count in use.
+ */
+inline int
+set( int n )
+{
+    _count() = (n > 0) ? n : available();
+#ifdef _OPENMP
+    omp_set_num_threads( _count() );
+#endif
+    return _count();
+}
+
+/*! \brief  Returns the thread count. Initialized from $RAPTER_THREADS on first call, or to all available cores, if that is unset.
+ *
+ *          The OpenMP team size of regions without num_threads is only changed by an explicit setting.
+ *          Stages give the same output at any thread count, scripts/checkThreads.sh checks that.
+ */
+inline int
+get()
+{
+    if ( !_count() )
+    {
+        const char* env = std::getenv( ENV_NAME );
+        if ( env )
+            set( std::atoi(env) );
+        else
+            _count() = available();
+    }
+    return _count();
+}
+
+/*! \brief          Applies "--threads N" from the command line, falls back to $RAPTER_THREADS.
+ *  \return         The thread count in use.
+ */
+inline int
+parseCli( int argc, char** argv )
+{
+    for ( int i = 1; i < argc - 1; ++i )
+        if ( std::string("--threads") == argv[i] )
+            return set( std::atoi(argv[i+1]) );
+
+    return get();
+}
+
+} //...ns threads
+} //...ns rapter
+
+#endif // RAPTER_THREADS_HPP
@@ -0,0 +1,41 @@
+#!/bin/bash
+# Compares the energy and runtime of the bonmin, gco (alpha-expansion) and local solvers on the same formulate output.
+# Run from a scene folder containing cloud.ply, candidates_it0.csv and points_primitives.csv (e.g. after generate).
+# The problem is formulated once, every solver works in its own copy of it, so the outputs can be diffed afterwards.
+
+function print_usage() {
+        echo -e "usage:\t benchGco.sh rapter scale [pw] [cmp] [3D]"
+        echo -e "example:\t benchGco.sh ../rapter 0.03 1 0.1 3D"
+}
+
+if [[ -z "$2" ]]; then print_usage; exit 1; fi
+executable=`readlink -f $1`
+scale=$2
+if [ -n "$3" ]; then pw=$3;      else pw=1; fi
+if [ -n "$4" ]; then cmp=$4;     else cmp=0; fi
+if [ -n "$5" ]; then flag3D=$5;  else flag3D=""; fi
+poplimit=5
+anglegens="0,90"
+
+# runs "$2" in folder $1, appends "solver wall[s]" to $1/bench.log
+function bench_exec() {
+    echo "[CALLING] $2"
+    ( cd $1 && /usr/bin/time -f "$3 %e" -a -o bench.log $2 > /dev/null )
+    local status=$?
+    if [ "$status" -ne "0" ]; then
+        echo "Error detected ($status). ABORT."
+        exit 1
+    fi
+}
+
+rm -rf bench_problem; mkdir bench_problem
+cp cloud.ply candidates_it0.csv points_primitives.csv bench_problem/
+bench_exec bench_problem "$executable --formulate$flag3D --scale $scale --cloud cloud.ply --unary 100000 --pw $pw --cmp $cmp --constr-mode patch --patch-pop-limit $poplimit --angle-gens $anglegens --candidates candidates_it0.csv -a points_primitives.csv --no-clusters --rod problem" "formulate"
+
+echo -e "solver\twall[s]\tE\tdata\tpw"
+for solver in bonmin gco local; do
+    dir="bench_$solver"
+    rm -rf $dir; cp -r bench_problem $dir; rm -f $dir/bench.log $dir/problem/energy.csv
+    bench_exec $dir "$executable --solver$flag3D $solver --problem problem/ --candidates candidates_it0.csv --cmp $cmp --time -1" "$solver" > /dev/null
+    echo -e "`cat $dir/bench.log | awk '{ printf "%s\t%s", $1, $2 }'`\t`tail -n 1 $dir/problem/energy.csv | awk -F, '{ printf "%s\t%s\t%s", $1, $2, $3 }'`"
+done
@@ -0,0 +1,42 @@
+#!/bin/bash
+# Compares runtime and peak memory of two rapter builds (e.g. before and after a change to the tag storage in Taggable)
+# on the segment and formulate stages. Run from a scene folder containing cloud.ply.
+# Each binary works in its own copy of the folder, so the outputs can be diffed afterwards.
+
+function print_usage() {
+        echo -e "usage:\t benchTags.sh oldRapter newRapter scale anglelimit [3D]"
+        echo -e "example:\t benchTags.sh ../rapter.maps ../rapter 0.03 0.2 3D"
+}
+
+if [[ -z "$4" ]]; then print_usage; exit 1; fi
+oldExec=`readlink -f $1`
+newExec=`readlink -f $2`
+scale=$3
+anglelimit=$4
+if [ -n "$5" ]; then flag3D=$5; else flag3D=""; fi
+poplimit=5
+anglegens="0,90"
+
+# runs "$2" in folder $1, appends "stage wall[s] maxRSS[kB]" to $1/bench.log
+function bench_exec() {
+    echo "[CALLING] $2"
+    ( cd $1 && /usr/bin/time -f "$3 %e %M" -a -o bench.log $2 > /dev/null )
+    local status=$?
+    if [ "$status" -ne "0" ]; then
+        echo "Error detected ($status). ABORT."
+        exit 1
+    fi
+}
+
+for variant in old new; do
+    if [ "$variant" = "old" ]; then executable=$oldExec; else executable=$newExec; fi
+    dir="bench_$variant"
+    rm -rf $dir; mkdir $dir
+    cp cloud.ply $dir/
+    bench_exec $dir "$executable --segment$flag3D --patch-pop-limit $poplimit --angle-limit $anglelimit --scale $scale --angle-gens $anglegens" "segment"
+    bench_exec $dir "$executable --generate$flag3D -sc $scale -al $anglelimit --patch-pop-limit $poplimit -p patches.csv --assoc points_primitives.csv --angle-gens 0 --small-thresh-mult 0" "generate"
+    bench_exec $dir "$executable --formulate$flag3D --scale $scale --cloud cloud.ply --unary 100000 --pw 1 --cmp 0 --constr-mode patch --patch-pop-limit $poplimit --angle-gens $anglegens --candidates candidates_it0.csv -a points_primitives.csv --no-clusters" "formulate"
+done
+
+echo -e "stage\told[s]\tnew[s]\told[kB]\tnew[kB]"
+paste bench_old/bench.log bench_new/bench.log | awk '{ printf "%s\t%s\t%s\t%s\t%s\n", $1, $2, $5, $3, $6 }'
@@ -0,0 +1,60 @@
+#!/bin/bash
+# Runs the segment, generate and formulate stages once with --threads 1 and once with --threads N,
+# and checks, that each stage writes identical outputs (patches.csv, points_primitives.csv, candidates_it0.csv, problem).
+# All cores are the default thread count, so a stage must not be parallelized further, unless this passes.
+# Run from a scene folder containing cloud.ply.
+
+function print_usage() {
+        echo -e "usage:\t checkThreads.sh rapter scale anglelimit [threads] [3D]"
+        echo -e "example:\t checkThreads.sh ../rapter 0.03 0.2 8 3D"
+}
+
+if [[ -z "$3" ]]; then print_usage; exit 1; fi
+executable=`readlink -f $1`
+scale=$2
+anglelimit=$3
+if [ -n "$4" ]; then threads=$4; else threads=`nproc`; fi
+if [ -n "$5" ]; then flag3D=$5; else flag3D=""; fi
+poplimit=5
+anglegens="0,90"
+
+# runs "$2" in folder $1
+function run_exec() {
+    echo "[CALLING] $2"
+    ( cd $1 && $2 > run.log 2>&1 )
+    local status=$?
+    if [ "$status" -ne "0" ]; then
+        echo "Error detected ($status), see $1/run.log. ABORT."
+        exit 1
+    fi
+}
+
+# compares file $1 in thr_1 and thr_N
+failed=0
+function compare() {
+    if cmp -s thr_1/$1 thr_$threads/$1; then
+        echo -e "[SAME]\t$1"
+    else
+        echo -e "[DIFF]\t$1"
+        failed=1
+    fi
+}
+
+for t in 1 $threads; do
+    dir="thr_$t"
+    rm -rf $dir; mkdir $dir
+    cp cloud.ply $dir/
+    run_exec $dir "$executable --segment$flag3D --threads $t --patch-pop-limit $poplimit --angle-limit $anglelimit --scale $scale --angle-gens $anglegens"
+    run_exec $dir "$executable --generate$flag3D --threads $t -sc $scale -al $anglelimit --patch-pop-limit $poplimit -p patches.csv --assoc points_primitives.csv --angle-gens 0 --small-thresh-mult 0"
+    run_exec $dir "$executable --formulate$flag3D --threads $t --scale $scale --cloud cloud.ply --unary 100000 --pw 1 --cmp 0 --constr-mode patch --patch-pop-limit $poplimit --angle-gens $anglegens --candidates candidates_it0.csv -a points_primitives.csv --no-clusters"
+done
+
+compare patches.csv
+compare points_primitives.csv
+compare candidates_it0.csv
+for f in `cd thr_1 && find problem -type f | sort`; do
+    compare $f
+done
+
+if [ "$failed" -ne "0" ]; then echo "outputs differ between 1 and $threads threads"; exit 1; fi
+echo "outputs identical at 1 and $threads threads"
@@ -91,6 +91,7 @@ useAngleGen=""              # Values: [ "", "--use-angle-gen" ] (Flag which make
 formParams="$noClusters $useAngleGen --spat-weight $spatWeight --trunc-angle $truncAngle --spat-dist-mult 2."
 
 pwCostFunc="spatsqrt"       # Spatial cost function.
+incremental="--incremental formulate_cache.bin" # Values: [ "", "--incremental formulate_cache.bin" ] (Reuse unchanged data costs and proximities of the previous iteration's formulate)
 
 visdefparam="--angle-gens $anglegens --use-tags --no-clusters --statuses -1,1 --no-pop --dir-colours --no-rel --no-scale --bg-colour 1.,1.,1." #"--use-tags --no-clusters" #--ids
 iterationConstrMode="patch" # what to add in the second iteration formulate. Default: 0 (everyPatchNeedsDirection), experimental: 2 (largePatchesNeedDirection).
@@ -129,6 +130,8 @@ fi
 
 # Backup energy.csv
 mv energy.csv energy.csv.bak
+# Don't warm start from a previous run
+rm -f formulate_cache.bin
 
 input="patches.csv";
 assoc="points_primitives.csv";
@@ -218,7 +221,7 @@ do
         if [ $myresult -ne "0" ]; then decrease_level=false; fi
 
         # Formulate optimization problem. OUT: "problem" directory. --constr-mode 2: largePatchesNeedDirectionConstraint
-        my_exec "$executable --formulate$flag3D --collapse-angle-deg $collapseThreshDeg --scale $scale --cloud cloud.ply --unary $unary --pw $pw --cmp $cmp --constr-mode $iterationConstrMode --dir-bias $dirbias --patch-pop-limit $poplimit --angle-gens $anglegens --candidates candidates_it$c.csv -a $assoc --freq-weight $freqweight  --cost-fn $pwCostFunc $formParams"
+        my_exec "$executable --formulate$flag3D --collapse-angle-deg $collapseThreshDeg --scale $scale --cloud cloud.ply --unary $unary --pw $pw --cmp $cmp --constr-mode $iterationConstrMode --dir-bias $dirbias --patch-pop-limit $poplimit --angle-gens $anglegens --candidates candidates_it$c.csv -a $assoc --freq-weight $freqweight  --cost-fn $pwCostFunc $formParams $incremental"
 
         # Solve optimization problem. OUT: primitives_it$c.bonmin.csv
         my_exec "$executable --solver$flag3D bonmin --problem problem -v --time -1 --bmode $algCode --angle-gens $anglegens --candidates candidates_it$c.csv"
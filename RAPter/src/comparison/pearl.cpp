@@ -89,6 +89,8 @@ int pearlCli( int argc, char **argv )
         pcl::console::parse_argument( argc, argv, "--int-mult", params.int_mult );
         pcl::console::parse_argument( argc, argv, "--cmp"  , params.beta );
         valid_input &= pcl::console::parse_argument( argc, argv, "--pw"  , params.lambdas(2) ) >= 0;
+        params.sparse = rapter::console::find_switch( argc, argv, "--sparse" );
+        pcl::console::parse_argument( argc, argv, "--sparse-dist-mult", params.sparse_dist_mult );
 
         if (     !valid_input
               || (rapter::console::find_switch(argc,argv,"-h"    ))
@@ -103,6 +105,8 @@ int pearlCli( int argc, char **argv )
                       << "\t --cmp " << params.beta << "\n"
                       << "\t --unary " << params.lambdas(0) << "\n"
                       << "\t --int-mult " << params.int_mult << "\n"
+                      << "\t [--sparse] " << "only evaluate labels closer than sparse-dist-mult * scale to a point" << "\n"
+                      << "\t --sparse-dist-mult " << params.sparse_dist_mult << "\n"
                       << "\n\t Example: ../pearl --scale 0.03 --cloud cloud.ply -p patches.csv --pw 1000 --cmp 1000 --int-mult 1000\n"
                       << "\n";
 
@@ -5,6 +5,7 @@
 #include "rapter/io/io.h"         // readPrimitives, readPoints
 #include "rapter/util/containers.hpp" // add
 #include "rapter/processing/util.hpp" // getpop
+#include "rapter/processing/reassigner.hpp" // Reassigner
 #include "schnabelEnv.h"
 #include "../../src/schnabelEnv.cpp"
 
@@ -297,45 +298,30 @@ template < class _PrimitiveContainerT
          >
 inline int reassign( _PointContainerT &points, _PrimitiveContainerT const& primitives, _Scalar const scale/*, _PrimitiveMapT const& patches*/ )
 {
-    typedef typename _PointContainerT::value_type PointPrimitiveT;
+    typedef typename _PrimitiveContainerT::value_type       PrimitiveT;
+    typedef          rapter::processing::Reassigner<_Scalar> ReassignerT;
 
-#if 1
     std::cout << "starting assignment" << std::endl; fflush( stdout );
 
-    // distances between a point patch (point.gid), and a new primitive (primitive.gid)
-    std::map< std::pair<int,int>, std::pair<_Scalar,int> > dists; // < <point.gid, primitives.gid>, <sumdist,|points|> >
-
     TIC
-    #pragma omp for schedule(dynamic,8)
-    for ( int pid = 0; pid < points.size(); ++pid )
+    ReassignerT                     reassigner( ReassignerT::domainOf(points), scale );
+    std::vector<PrimitiveT const*>  prims;
+    std::vector<rapter::GidT>       gids;
+    for ( size_t gid = 0; gid != primitives.size(); ++gid )
     {
-        float min_dist = FLT_MAX, tmp;
-        int   min_gid = 0;
-        for ( int gid = 0; gid != primitives.size(); ++gid )
-        {
-            tmp = std::abs( primitives[gid].getDistance(points[pid].template pos()) );
-            if ( tmp < 0.f )
-                std::cerr << "asdf: " << tmp << std::endl;
-            std::pair<int,int> key( points[pid].getTag(PointPrimitiveT::TAGS::GID), gid );
-            #pragma omp critical
-            {
-                dists[ key ].first += tmp;
-                dists[ key ].second++;
-            }
-
-            if ( (tmp < min_dist) && (tmp < scale) )
-            {
-                min_dist = tmp;
-                min_gid = gid;
-            }
-        }
-        points[pid].setTag( PointPrimitiveT::TAGS::GID, min_gid );
+        reassigner.insert( gid, primitives[gid] );
+        prims.push_back( &primitives[gid] );
+        gids .push_back( gid );
     }
+    reassigner.build();
+
+    // distances between a point patch (point.gid), and its new primitive (primitive.gid)
+    typename ReassignerT::StatsT dists; // < <point.gid, primitives.gid>, <sumdist,|points|> >
+    int err = reassigner.assign( points, prims, gids, /* unassigned: */ 0, &dists );
     TOC("reassign omp",1)
     std::cout << "finishing assignment" << std::endl;
-    #endif
 
-    return 0;
+    return err;
 }
 
 template < typename _PointContainerT
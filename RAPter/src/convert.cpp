@@ -0,0 +1,68 @@
+#include "rapter/io/io.h"                               // readPrimitives, savePrimitives, readAssociations, writeAssociations
+
+#include "rapter/typedefs.h"                            // _2d::PrimitiveT, _3d::PrimitiveT
+#include "rapter/util/parse.h"                          // find_switch, parse_argument
+#include "rapter/primitives/impl/planePrimitive.hpp"
+
+namespace rapter
+{
+    //! \brief Reads primitives in either format, and writes them in the format of \p out_path's extension.
+    template <class _PrimitiveContainerT, class _PrimitiveT>
+    inline int convertPrimitives( std::string const& in_path, std::string const& out_path )
+    {
+        typedef typename _PrimitiveContainerT::value_type   InnerContainerT;
+        typedef typename InnerContainerT::const_iterator    InnerConstIteratorT;
+
+        _PrimitiveContainerT primitives;
+        if ( EXIT_SUCCESS != io::readPrimitives<_PrimitiveT, InnerContainerT>(primitives, in_path) )
+        {
+            std::cerr << "[" << __func__ << "]: " << "could not read " << in_path << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        return io::savePrimitives<_PrimitiveT, InnerConstIteratorT>( primitives, out_path, /* verbose: */ true );
+    } //...convertPrimitives()
+} //...ns rapter
+
+//! \brief Converts primitives and point associations between the csv and the binary columnar (".bin") format.
+int convert( int argc, char** argv )
+{
+    std::string prims_in, prims_out, assoc_in, assoc_out;
+    rapter::console::parse_argument( argc, argv, "--prims"    , prims_in  );
+    rapter::console::parse_argument( argc, argv, "--prims-out", prims_out );
+    rapter::console::parse_argument( argc, argv, "--assoc"    , assoc_in  );
+    rapter::console::parse_argument( argc, argv, "--assoc-out", assoc_out );
+
+    if (    rapter::console::find_switch(argc,argv,"-h") || rapter::console::find_switch(argc,argv,"--help")
+         || ((prims_in.empty() || prims_out.empty()) && (assoc_in.empty() || assoc_out.empty())) )
+    {
+        std::cout << "[Usage]: " << argv[0] << "\n"
+                  << "\t--convert[3D]\n"
+                  << "\t[--prims primitives.csv --prims-out primitives.bin]\n"
+                  << "\t[--assoc points_primitives.csv --assoc-out points_primitives.bin]\n"
+                  << "\tThe output format is chosen by the extension, \".bin\" is binary, anything else is csv.\n"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int err = EXIT_SUCCESS;
+    if ( !prims_in.empty() && !prims_out.empty() )
+    {
+        if ( rapter::console::find_switch(argc,argv,"--convert3D") )
+            err = rapter::convertPrimitives<rapter::_3d::PrimitiveContainerT, rapter::_3d::PrimitiveT>( prims_in, prims_out );
+        else
+            err = rapter::convertPrimitives<rapter::_2d::PrimitiveContainerT, rapter::_2d::PrimitiveT>( prims_in, prims_out );
+    }
+
+    if ( (EXIT_SUCCESS == err) && !assoc_in.empty() && !assoc_out.empty() )
+    {
+        std::vector<std::pair<rapter::PidT,rapter::LidT> > points_primitives;
+        err = rapter::io::readAssociations( points_primitives, assoc_in, NULL );
+        if ( EXIT_SUCCESS == err )
+            err = rapter::io::writeAssociations( points_primitives, assoc_out );
+        if ( EXIT_SUCCESS == err )
+            std::cout << "[" << __func__ << "]: " << "wrote to " << assoc_out << std::endl;
+    }
+
+    return err;
+} //...convert()
@@ -3,7 +3,8 @@
 
 #include "rapter/optimization/candidateGenerator.h"
 
-int generate( int argc, char** argv )
+//! \brief Returns the count of the small patches left to promote in \p remaining, if not NULL, see rapter::CandidateGenerator::generateCli().
+int generate( int argc, char** argv, int *remaining )
 {
     if ( rapter::console::find_switch(argc,argv,"--generate") )
     {
@@ -12,10 +13,15 @@ int generate( int argc, char** argv )
                                                    , rapter::Scalar
                                                    , rapter::PointPrimitiveT
                                                    , rapter::_2d::PrimitiveT
-                                                   >( argc, argv );
+                                                   >( argc, argv, remaining );
     }
     else
         std::cerr << "[" << __func__ << "]: " << "switched to wrong place " << std::endl;
 
     return EXIT_FAILURE;
 }
+
+int generate( int argc, char** argv )
+{
+    return generate( argc, argv, NULL );
+}
@@ -4,7 +4,8 @@
 #include "rapter/optimization/candidateGenerator.h"
 #include "rapter/primitives/impl/planePrimitive.hpp"
 
-int generate3D( int argc, char** argv )
+//! \brief Returns the count of the small patches left to promote in \p remaining, if not NULL, see rapter::CandidateGenerator::generateCli().
+int generate3D( int argc, char** argv, int *remaining )
 {
     if ( rapter::console::find_switch(argc,argv,"--generate3D") )
     {
@@ -13,10 +14,15 @@ int generate3D( int argc, char** argv )
                                                    , rapter::Scalar
                                                    , rapter::PointPrimitiveT
                                                    , rapter::_3d::PrimitiveT
-                                                   >( argc, argv );
+                                                   >( argc, argv, remaining );
     }
     else
         std::cerr << "[" << __func__ << "]: " << "switched to wrong place..." << std::endl;
 
     return EXIT_FAILURE;
 }
+
+int generate3D( int argc, char** argv )
+{
+    return generate3D( argc, argv, NULL );
+}
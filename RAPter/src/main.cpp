@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "rapter/util/parse.h"
+#include "rapter/util/threads.hpp"
 
 int subsample ( int argc, char** argv ); // subsample.cpp
 int segment   ( int argc, char** argv ); // segment.cpp
@@ -11,12 +12,17 @@ int formulate3D( int argc, char** argv ); // problemSetup.cpp
 int solve     ( int argc, char** argv ); // solve.cpp
 int solve3D   ( int argc, char** argv ); // solve3D.cpp
 int merge     ( int argc, char** argv ); // merge.cpp
+int convert   ( int argc, char** argv ); // convert.cpp
+int pipeline  ( int argc, char** argv ); // pipeline.cpp
 //int datafit   ( int argc, char** argv ); // datafit.cpp
 //int reassign  ( int argc, char** argv );
 int represent ( int argc, char** argv ); // represent.cpp
 
 int main( int argc, char *argv[] )
 {
+    // thread count of all stages: --threads N, or $RAPTER_THREADS
+    rapter::threads::parseCli( argc, argv );
+
     if ( (argc == 2) &&
          (   (rapter::console::find_switch(argc,argv,"--help"))
           || (rapter::console::find_switch(argc,argv,"-h"    ))
@@ -24,22 +30,29 @@ int main( int argc, char *argv[] )
        )
     {
         std::cout << "[Usage]:\n"
+                  << "\t--pipeline params.txt\t All stages in one process\n"
                   << "\t--generate\n"
                   << "\t--generate3D\n"
                   << "\t--formulate\n"
                   << "\t--formulate3D\n"
-                  << "\t--solver mosek|bonmin|gurobi\n"
-                  << "\t--solver3D mosek|bonmin|gurobi\n"
+                  << "\t--solver mosek|bonmin|gurobi|local|gco\n"
+                  << "\t--solver3D mosek|bonmin|gurobi|local|gco\n"
                   << "\t--merge\n"
                   << "\t--merge3D\n"
                   << "\t--datafit\n"
                   << "\t--corresp\n"
-                  << "\t--represent[3D]"
+                  << "\t--represent[3D]\n"
+                  << "\t--convert[3D]\t csv <-> binary (.bin) primitives and associations\n"
+                  << "\t[--threads N]\t Thread count of all stages, default: $" << rapter::threads::ENV_NAME << " or all cores"
                   //<< "\t--show\n"
                   << std::endl;
 
         return EXIT_SUCCESS;
     }
+    else if ( rapter::console::find_switch(argc,argv,"--pipeline") )
+    {
+        return pipeline( argc, argv );
+    }
     else if ( rapter::console::find_switch(argc,argv,"--segment") || rapter::console::find_switch(argc,argv,"--segment3D") )
     {
        return segment( argc, argv );
@@ -80,6 +93,10 @@ int main( int argc, char *argv[] )
     {
         return merge(argc, argv);
     }
+    else if ( rapter::console::find_switch(argc,argv,"--convert") || rapter::console::find_switch(argc,argv,"--convert3D") )
+    {
+        return convert( argc, argv );
+    }
     else if ( rapter::console::find_switch(argc,argv,"--show") )
     {
         std::cerr << "[" << __func__ << "]: " << "the show option has been moved to a separate executable, please use thatt one" << std::endl;
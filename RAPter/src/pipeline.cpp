@@ -0,0 +1,503 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>                                      // setprecision
+#include <cmath>                                        // M_PI
+#include <boost/filesystem.hpp>
+
+#include "rapter/typedefs.h"                            // PointPrimitiveT, PointContainerT, Scalar
+#include "rapter/util/parse.h"                          // find_switch, parse_argument
+#include "rapter/io/io.h"                               // readPoints, ResidentCloud, ResidentFiles
+#include "rapter/primitives/extentCache.h"
+#include "rapter/optimization/problemSetup.h"      // problemSetup::OptProblemT
+
+int segment    ( int argc, char** argv ); // segment.cpp
+int generate   ( int argc, char** argv, int *remaining ); // generate.cpp
+int generate3D ( int argc, char** argv, int *remaining ); // generate3D.cpp
+int formulate  ( int argc, char** argv, rapter::problemSetup::OptProblemT       *problem ); // problemSetup.cpp
+int formulate3D( int argc, char** argv, rapter::problemSetup::OptProblemT       *problem ); // problemSetup3D.cpp
+int solve      ( int argc, char** argv, rapter::problemSetup::OptProblemT       *problem ); // solve.cpp
+int solve3D    ( int argc, char** argv, rapter::problemSetup::OptProblemT       *problem ); // solve3D.cpp
+int merge      ( int argc, char** argv ); // merge.cpp
+int represent  ( int argc, char** argv ); // represent.cpp
+
+namespace rapter
+{
+    //! \brief Parameters of --pipeline. Read from a "key value" per line file, '#' starts a comment. Names and defaults follow scripts/rapter.py.
+    struct PipelineParams
+    {
+        PipelineParams()
+            : cloud( "cloud.ply" ), scale( -1. ), angleLimitDeg( 15. ), pw( 1. ), spatial( -1. ), data( 1e5 ), smallThreshMult( 4. )
+            , angleGens( "0,90" ), iterations( 15 ), popLimit( 5 ), variableLimit( 1000 ), segmentScaleMult( 1. ), angleLimitDivisor( 1. )
+            , algCode( 0 ), lines( false ), solver( "bonmin" ), keepFiles( false ), output( "." )
+        {}
+
+        std::string cloud;              //!< \brief Point cloud, binary or ascii ply/pcd.
+        double      scale;              //!< \brief Smallest feature size to preserve, required.
+        double      angleLimitDeg;      //!< \brief Angle threshold in degrees.
+        double      pw;                 //!< \brief Pairwise weight.
+        double      spatial;            //!< \brief Spatial weight, pw/10 if not set.
+        double      data;               //!< \brief Data weight.
+        double      smallThreshMult;    //!< \brief Start with primitives, that are scale * smallThreshMult large.
+        std::string angleGens;          //!< \brief Angle generators in degrees, comma separated.
+        int         iterations;         //!< \brief Iteration count.
+        int         popLimit;           //!< \brief Patch population limit.
+        int         variableLimit;      //!< \brief Maximum number of candidates.
+        double      segmentScaleMult;   //!< \brief Multiplies scale for the segmentation.
+        double      angleLimitDivisor;  //!< \brief Divides the angle threshold for candidate generation.
+        int         algCode;            //!< \brief Bonmin algorithm code.
+        bool        lines;              //!< \brief 2D, if true.
+        std::string solver;             //!< \brief Solver of --solver[3D].
+        std::string primitives, assoc;  //!< \brief Existing segmentation, segments the cloud, if not given.
+        bool        keepFiles;          //!< \brief Write every intermediate file next to the output, instead of a scratch directory.
+        std::string output;             //!< \brief Directory of the results.
+
+        //! \return EXIT_SUCCESS, or EXIT_FAILURE, if the file can't be read, or has an unknown key.
+        inline int read( std::string const& path )
+        {
+            std::ifstream f( path.c_str() );
+            if ( !f.is_open() ) { std::cerr << "[" << __func__ << "]: " << "could not open " << path << std::endl; return EXIT_FAILURE; }
+
+            std::string line;
+            while ( std::getline(f, line) )
+            {
+                std::istringstream iss( line.substr(0, line.find('#')) );
+                std::string key;
+                if ( !(iss >> key) ) continue;
+
+                if      ( key == "cloud"                ) iss >> cloud;
+                else if ( key == "scale"                ) iss >> scale;
+                else if ( key == "angle-limit"          ) iss >> angleLimitDeg;
+                else if ( key == "pw"                   ) iss >> pw;
+                else if ( key == "spatial"              ) iss >> spatial;
+                else if ( key == "data"                 ) iss >> data;
+                else if ( key == "area-thresh-start"    ) iss >> smallThreshMult;
+                else if ( key == "angle-gens"           ) iss >> angleGens;
+                else if ( key == "iterations"           ) iss >> iterations;
+                else if ( key == "pop-limit"            ) iss >> popLimit;
+                else if ( key == "var-limit"            ) iss >> variableLimit;
+                else if ( key == "segment-scale-mult"   ) iss >> segmentScaleMult;
+                else if ( key == "angle-limit-divisor"  ) iss >> angleLimitDivisor;
+                else if ( key == "alg-code"             ) iss >> algCode;
+                else if ( key == "lines"                ) iss >> lines;
+                else if ( key == "solver"               ) iss >> solver;
+                else if ( key == "primitives"           ) iss >> primitives;
+                else if ( key == "assoc"                ) iss >> assoc;
+                else if ( key == "keep-files"           ) iss >> keepFiles;
+                else if ( key == "output"               ) iss >> output;
+                else
+                {
+                    std::cerr << "[" << __func__ << "]: " << "unknown key \"" << key << "\" in " << path << std::endl;
+                    return EXIT_FAILURE;
+                }
+
+                if ( iss.fail() )
+                {
+                    std::cerr << "[" << __func__ << "]: " << "could not parse \"" << line << "\" in " << path << std::endl;
+                    return EXIT_FAILURE;
+                }
+            }
+
+            if ( spatial < 0. )
+                spatial = pw / 10.;
+
+            return EXIT_SUCCESS;
+        } //...read()
+    }; //...PipelineParams
+
+    //! \brief Command line of one stage call, built the way scripts/rapter.py formats it.
+    class StageArgs
+    {
+        public:
+            explicit StageArgs( std::string const& stageSwitch ) { _args.push_back( "rapter" ); _args.push_back( stageSwitch ); }
+
+            inline StageArgs& operator()( std::string const& flag ) { if ( !flag.empty() ) _args.push_back( flag ); return *this; }
+
+            template <typename _T>
+            inline StageArgs& operator()( std::string const& key, _T const& value )
+            {
+                std::ostringstream oss;
+                oss << std::setprecision( 9 ) << value;
+                _args.push_back( key );
+                _args.push_back( oss.str() );
+                return *this;
+            }
+
+            //! \brief Calls \p stage with these arguments, and logs the call to \p log. \tparam _StageT Callable as int(int argc, char** argv).
+            template <class _StageT>
+            inline int run( _StageT stage, std::ostream &log ) const
+            {
+                std::vector< std::vector<char> > buffers( _args.size() );
+                std::vector<char*>               argv   ( _args.size() + 1, static_cast<char*>(NULL) );
+                for ( size_t i = 0; i != _args.size(); ++i )
+                {
+                    buffers[i].assign( _args[i].begin(), _args[i].end() );
+                    buffers[i].push_back( '\0' );
+                    argv[i] = buffers[i].data();
+                }
+
+                std::ostringstream cmd;
+                for ( size_t i = 0; i != _args.size(); ++i )
+                    cmd << (i ? " " : "") << _args[i];
+                std::cout << "__________________________________________________________\n"
+                          << "[CALLING] " << cmd.str() << std::endl;
+                log << cmd.str() << "\n" << std::endl;
+
+                return stage( static_cast<int>(_args.size()), argv.data() );
+            } //...run()
+
+        protected:
+            std::vector<std::string> _args;
+    }; //...StageArgs
+
+    namespace pipeline
+    {
+        namespace fs = boost::filesystem;
+
+        //! \brief Renames \p from to \p to, if \p from exists, in memory (\ref io::ResidentFiles) and on disk.
+        inline void moveIfExists( std::string const& from, std::string const& to )
+        {
+            io::ResidentFiles::instance().rename( from, to );
+            boost::system::error_code ec;
+            if ( fs::exists(from) ) fs::rename( from, to, ec );
+        }
+
+        //! \brief Copies \p from to \p to, overwriting. Files in memory (\ref io::ResidentFiles) are copied there, and on disk only, if persistent.
+        inline int copy( std::string const& from, std::string const& to )
+        {
+            io::ResidentFiles &resident = io::ResidentFiles::instance();
+            if ( resident.copy(from, to) && !resident.persistent() )
+                return EXIT_SUCCESS;
+
+            boost::system::error_code ec;
+            fs::copy_file( from, to, fs::copy_options::overwrite_existing, ec );
+            if ( ec ) { std::cerr << "[" << __func__ << "]: " << "could not copy " << from << " to " << to << ": " << ec.message() << std::endl; return EXIT_FAILURE; }
+            return EXIT_SUCCESS;
+        }
+
+        //! \brief Directory for the intermediate files: in memory (/dev/shm), if available.
+        inline fs::path scratchDirectory()
+        {
+            fs::path parent = fs::is_directory("/dev/shm") ? fs::path("/dev/shm") : fs::temp_directory_path();
+            return parent / fs::unique_path( "rapter-%%%%-%%%%-%%%%" );
+        }
+    } //...ns pipeline
+
+    /*! \brief              Runs segmentation and the multi-scale generate-formulate-solve-represent-merge iterations of scripts/rapter.py in one process.
+     *
+     *                      The stages hand over their results in memory: the cloud is parsed once, and its points, neighbour index (\ref io::ResidentCloud),
+     *                      the primitives and point associations the stages save (\ref io::ResidentFiles), and the primitive extents (\ref ExtentCache)
+     *                      stay in memory between the stages. The formulated problem goes to the solver in memory, the problem matrices are not written as csv.
+     *                      Only "keep-files 1" writes every primitive and association file to "output". Otherwise the remaining small files go to a
+     *                      scratch directory in memory (/dev/shm), and only the segmentation and the final primitives and associations are written to "output".
+     *
+     *  \param params       Parsed from the file given by --pipeline params.txt.
+     *  \return             EXIT_SUCCESS, or the error of the first failing stage.
+     */
+    inline int runPipeline( PipelineParams const& params )
+    {
+        namespace fs = boost::filesystem;
+        using namespace pipeline;
+
+        const bool        is3D        = !params.lines;
+        const std::string flag3D      = is3D ? "3D" : "";
+        const std::string tripletSafe = is3D ? "--triplet-safe" : "";
+        const double      angleLimit  = params.angleLimitDeg / 180. * M_PI;
+        int (*const generate2Or3D )(int, char**, int                            *) = is3D ? &generate3D  : &generate;
+        int (*const formulate2Or3D)(int, char**, problemSetup::OptProblemT      *) = is3D ? &formulate3D : &formulate;
+        int (*const solve2Or3D    )(int, char**, problemSetup::OptProblemT      *) = is3D ? &solve3D     : &solve;
+
+        // generate returns its error, and the count of the small patches left to promote separately
+        int promRem = 0, reprRem = 0;
+        auto generateStage     = [&]( int argc, char** argv ) { return generate2Or3D( argc, argv, &promRem ); };
+        auto generateReprStage = [&]( int argc, char** argv ) { return generate2Or3D( argc, argv, &reprRem ); };
+
+        // the formulated problem is handed to the solver in memory, and dumped to problem.bin only with keep-files
+        problemSetup::OptProblemT problem;
+        auto formulateStage = [&]( int argc, char** argv ) { problem = problemSetup::OptProblemT(); return formulate2Or3D( argc, argv, &problem ); };
+        auto solveStage     = [&]( int argc, char** argv ) { return solve2Or3D( argc, argv, &problem ); };
+        const std::string problemPath = params.keepFiles ? "problem.bin" : "problem";
+
+        // work directory, the stages read and write relative to the cloud
+        const fs::path outDir   = fs::absolute( params.output );
+        const fs::path cloud    = fs::absolute( params.cloud  );
+        const fs::path workDir  = params.keepFiles ? outDir : scratchDirectory();
+        const std::string cloudName = "cloud" + cloud.extension().string();
+        const fs::path oldCwd   = fs::current_path();
+        {
+            boost::system::error_code ec;
+            fs::create_directories( workDir, ec );
+            if ( !fs::exists(workDir / cloudName) )
+                fs::create_symlink( cloud, workDir / cloudName, ec );
+            if ( ec ) { std::cerr << "[" << __func__ << "]: " << "could not prepare " << workDir << ": " << ec.message() << std::endl; return EXIT_FAILURE; }
+            fs::current_path( workDir );
+            if (    (!params.primitives.empty() && (EXIT_SUCCESS != copy((oldCwd / params.primitives).string(), "patches.csv"          )))
+                 || (!params.assoc     .empty() && (EXIT_SUCCESS != copy((oldCwd / params.assoc     ).string(), "points_primitives.csv"))) )
+            {
+                fs::current_path( oldCwd );
+                if ( !params.keepFiles ) fs::remove_all( workDir, ec );
+                return EXIT_FAILURE;
+            }
+        }
+        std::ofstream log( (outDir / "lastRun.log").string().c_str() );
+
+        // keep the cloud, its neighbour index, the primitives, the associations and the extents in memory
+        io::ResidentCloud<PointPrimitiveT>::instance().setEnabled( true );
+        io::ResidentFiles::instance().setEnabled( true );
+        io::ResidentFiles::instance().setPersistent( params.keepFiles );
+        ExtentCache<Scalar>::instance().setPersistent( params.keepFiles );
+        int err = EXIT_SUCCESS;
+        {
+            PointContainerT points;
+            err = io::readPoints<PointPrimitiveT>( points, cloudName );
+            if ( EXIT_SUCCESS == err )
+                io::ResidentCloud<PointPrimitiveT>::instance().find( cloudName )->store.getSpatialIndex( params.scale );
+        }
+
+        // (1) Segment
+        if ( (EXIT_SUCCESS == err) && (params.primitives.empty() || params.assoc.empty()) )
+        {
+            err = StageArgs( "--segment" + flag3D )
+                  ( "--scale", params.scale )( "--angle-limit", angleLimit )( "--angle-gens", params.angleGens )
+                  ( "--patch-pop-limit", params.popLimit )( "--dist-limit-mult", params.segmentScaleMult )( "--cloud", cloudName )
+                  .run( &segment, log );
+        }
+        if ( EXIT_SUCCESS == err )
+        {
+            err = copy( "patches.csv", "segments.csv" );
+            if ( EXIT_SUCCESS == err )
+                err = copy( "points_primitives.csv", "points_segments.csv" );
+        }
+
+        std::string angleGens     = "0";
+        std::string candAngleGens = "0";              // used to mirror angleGens, but keep const "0" for generate
+        std::string primitives    = "patches.csv";
+        std::string associations  = "points_primitives.csv";
+        std::string keepSingles   = "--keep-singles";
+        std::string allowPromoted = "--allow-promoted";
+        const double smallThreshDiv   = 2.;           // area threshold stepsize
+        const double smallThreshLimit = 0.;           // when to stop decreasing area threshold
+        const double collapseThreshDeg = 0.4;         // initialize optimisation with the closest two orientations merged
+        double      smallThreshMult = params.smallThreshMult;
+        int         nbIterations    = params.iterations;
+        int         useAllGens      = is3D ? std::min( 5, nbIterations - 1 ) : 0; // start with parallel generation only
+        int         adopt           = 0;
+        bool        adoptChanged    = false;
+        bool        decreaseLevel   = false;
+        int         iteration       = 0;
+
+        for ( ; (EXIT_SUCCESS == err) && (iteration <= nbIterations); ++iteration )
+        {
+            // decrease, unless there is more to do on the same level
+            if ( decreaseLevel )
+                smallThreshMult = static_cast<int>( smallThreshMult / smallThreshDiv );
+
+            // if we reached the bottom working scale
+            if ( smallThreshMult <= smallThreshLimit )
+            {
+                smallThreshMult = static_cast<int>( smallThreshLimit );
+                if ( decreaseLevel )
+                {
+                    adopt = 1;                                              // if we promoted all patches, we can allow points to get re-assigned
+                    if ( !adoptChanged )
+                    {
+                        adoptChanged = true;
+                        useAllGens   = iteration + 2;                       // if we promoted all patches in the scene, do a 90 round
+                        nbIterations = std::max( nbIterations, useAllGens + 3 ); // do k more rounds after the 90 round
+                    }
+                }
+            }
+            decreaseLevel = true;
+
+            std::cout << "smallThreshMult: " << smallThreshMult << "\n"
+                      << "__________________________________________________________\n"
+                      << "Start iteration " << iteration << std::endl;
+
+            if ( iteration > 0 )
+            {
+                std::ostringstream p, a;
+                p << "primitives_merged_it" << iteration - 1 << ".csv";
+                a << "points_primitives_it" << iteration - 1 << ".csv";
+                primitives   = p.str();
+                associations = a.str();
+            }
+
+            std::ostringstream candidates, bonmin;
+            candidates << "candidates_it" << iteration << ".csv";
+            bonmin     << "primitives_it" << iteration << "." << params.solver << ".csv";
+
+            // (2) Generate, sets the count of remaining small patches to promote
+            err = StageArgs( "--generate" + flag3D )
+                  ( "-sc", params.scale )( "-al", angleLimit )( "-ald", params.angleLimitDivisor )( "--patch-pop-limit", params.popLimit )
+                  ( "-p", primitives )( "--assoc", associations )( "--cloud", cloudName )( "--angle-gens", candAngleGens )
+                  ( "--small-thresh-mult", smallThreshMult )( "--var-limit", params.variableLimit )( "--small-mode", 0 )
+                  ( tripletSafe )( keepSingles )( allowPromoted )
+                  .run( generateStage, log );
+            std::cout << "[" << __func__ << "]: " << "Remaining smalls to promote: " << promRem << std::endl;
+            if ( promRem != 0 )
+                decreaseLevel = false;
+
+            // (3) Formulate
+            if ( EXIT_SUCCESS == err )
+                err = StageArgs( "--formulate" + flag3D )
+                      ( "--scale", params.scale )( "--unary", params.data )( "--pw", params.pw )( "--spat-weight", params.spatial )( "--spat-dist-mult", 2. )
+                      ( "--patch-pop-limit", params.popLimit )( "--angle-gens", angleGens )( "--cloud", cloudName )( "--candidates", candidates.str() )
+                      ( "-a", associations )( "--collapse-angle-deg", collapseThreshDeg )( "--trunc-angle", angleLimit )( "--constr-mode", "patch" )
+                      ( "--dir-bias", 0 )( "--no-clusters" )( "--cmp", 0 )( "--freq-weight", 0 )( "--cost-fn", "spatsqrt" )( "--rod", problemPath )
+                      .run( formulateStage, log );
+
+            // (4) Solve
+            if ( EXIT_SUCCESS == err )
+                err = StageArgs( "--solver" + flag3D )( params.solver )
+                      ( "--problem", problemPath )( "-v" )( "--time", -1 )( "--bmode", params.algCode )( "--angle-gens", angleGens )
+                      ( "--candidates", candidates.str() )( "--cloud", cloudName )
+                      .run( solveStage, log );
+
+            if ( iteration == useAllGens )
+            {
+                angleGens     = params.angleGens;
+                candAngleGens = angleGens;
+            }
+
+            // (5) Representatives: optimize one representative per direction, and apply them back
+            if ( EXIT_SUCCESS == err )
+            {
+                std::ostringstream repr, reprAssoc, reprCands, reprOpt, nextCands, diag;
+                repr      << "representatives_it"            << iteration << ".csv";
+                reprAssoc << "points_representatives_it"     << iteration << ".csv";
+                reprCands << "candidates_representatives_it" << iteration << ".csv";
+                reprOpt   << "representatives_it"            << iteration << "." << params.solver << ".csv";
+                nextCands << "candidates_it"                 << iteration + 1 << ".csv";
+                diag      << "diag_it"                       << iteration << ".gv";
+                const std::string bonminBak = bonmin.str().substr( 0, bonmin.str().size() - params.solver.size() - 5 ) + "_rprtmp.csv";
+                const std::string primBak   = bonmin.str().substr( 0, bonmin.str().size() - 4  ) + ".lvl1.csv";
+
+                err = StageArgs( "--represent" + flag3D )
+                      ( "-p", bonmin.str() )( "-a", associations )( "-sc", params.scale )( "--cloud", cloudName )( "--angle-gens", angleGens )
+                      .run( &represent, log );
+                moveIfExists( "representatives.csv"       , repr.str()      );
+                moveIfExists( "points_representatives.csv", reprAssoc.str() );
+
+                // generate writes candidates_it<next>, which is not ours yet
+                moveIfExists( nextCands.str(), nextCands.str() + ".tmp" );
+                if ( EXIT_SUCCESS == err )
+                    err = StageArgs( "--generate" + flag3D )
+                          ( "-sc", params.scale )( "--cloud", cloudName )( "-al", angleLimit )( "-ald", 1. )( "--patch-pop-limit", params.popLimit )
+                          ( "-p", repr.str() )( "--assoc", reprAssoc.str() )( "--angle-gens", candAngleGens )( "--small-thresh-mult", smallThreshMult )
+                          ( "--small-mode", 0 )( tripletSafe )( keepSingles )
+                          .run( generateReprStage, log );
+                moveIfExists( nextCands.str()         , reprCands.str() );
+                moveIfExists( nextCands.str() + ".tmp", nextCands.str() );
+
+                if ( EXIT_SUCCESS == err )
+                    err = StageArgs( "--formulate" + flag3D )
+                          ( "--scale", params.scale )( "--unary", params.data )( "--pw", params.pw )( "--spat-weight", params.spatial )( "--spat-dist-mult", 2. )
+                          ( "--patch-pop-limit", params.popLimit )( "--angle-gens", angleGens )( "--cloud", cloudName )( "--candidates", reprCands.str() )
+                          ( "-a", reprAssoc.str() )( "--collapse-angle-deg", collapseThreshDeg )( "--trunc-angle", angleLimit )( "--constr-mode", "patch" )
+                          ( "--dir-bias", 0 )( "--no-clusters" )( "--cmp", 0 )( "--freq-weight", 0 )( "--cost-fn", "spatsqrt" )( "--rod", problemPath )
+                          .run( formulateStage, log );
+
+                // the solver writes primitives_it<iteration>.<solver>.csv again, keep the first level
+                if ( EXIT_SUCCESS == err )
+                    err = copy( bonmin.str(), bonminBak );
+                moveIfExists( diag.str(), diag.str() + "RprTmp" );
+                if ( EXIT_SUCCESS == err )
+                    err = StageArgs( "--solver" + flag3D )( params.solver )
+                          ( "--problem", problemPath )( "-v" )( "--time", -1 )( "--angle-gens", angleGens )( "--bmode", params.algCode )
+                          ( "--candidates", reprCands.str() )
+                          .run( solveStage, log );
+                if ( EXIT_SUCCESS == err )
+                    err = copy( bonmin.str(), reprOpt.str() );
+                if ( EXIT_SUCCESS == err )
+                    err = copy( bonminBak   , bonmin.str()  );
+                std::ostringstream diagLvl2; diagLvl2 << "diag_it" << iteration << ".lvl2.gv";
+                moveIfExists( diag.str(), diagLvl2.str() );
+                moveIfExists( diag.str() + "RprTmp", diag.str() );
+
+                if ( EXIT_SUCCESS == err )
+                    err = StageArgs( "--representBack" + flag3D )
+                          ( "--repr", reprOpt.str() )( "-p", bonmin.str() )( "-a", associations )( "-sc", params.scale )( "--cloud", cloudName )
+                          ( "--angle-gens", angleGens )
+                          .run( &represent, log );
+                if ( EXIT_SUCCESS == err )
+                {
+                    moveIfExists( bonmin.str(), primBak      );
+                    moveIfExists( "subs.csv"  , bonmin.str() );
+                }
+            } //...representatives
+
+            // (6) Merge coplanar primitives
+            if ( EXIT_SUCCESS == err )
+                err = StageArgs( "--merge" + flag3D )
+                      ( "--scale", params.scale )( "--adopt", adopt )( "--prims", bonmin.str() )( "-a", associations )( "--angle-gens", angleGens )
+                      ( "--patch-pop-limit", params.popLimit )( "--cloud", cloudName )
+                      .run( &merge, log );
+
+            // Don't copy promoted patches' directions to other patches after 4 iterations, since they are not reliable anymore
+            if ( iteration == 3 ) allowPromoted = "";
+            // Don't throw away single directions before the 3rd iteration
+            if ( iteration == 1 ) keepSingles   = "";
+            // If we are still promoting small patches on this working scale, make sure to run more iterations
+            if ( (iteration == nbIterations) && (promRem != 0) )
+                ++nbIterations;
+        } //...for iterations
+
+        // results
+        fs::current_path( oldCwd );
+        io::ResidentCloud<PointPrimitiveT>::instance().clear();
+        if ( !params.keepFiles )
+        {
+            io::ResidentFiles &resident = io::ResidentFiles::instance();
+            const int last = iteration - 1;
+            std::vector<std::string> results;
+            results.push_back( "segments.csv" );
+            results.push_back( "points_segments.csv" );
+            std::ostringstream bonmin, merged, assoc;
+            bonmin << "primitives_it"        << last << "." << params.solver << ".csv";  results.push_back( bonmin.str() );
+            merged << "primitives_merged_it" << last << ".csv";         results.push_back( merged.str() );
+            assoc  << "points_primitives_it" << last << ".csv";         results.push_back( assoc .str() );
+            for ( size_t i = 0; i != results.size(); ++i )
+            {
+                if ( resident.contains(results[i]) )
+                {
+                    if ( EXIT_SUCCESS != resident.save(results[i], (outDir / results[i]).string()) )
+                    {
+                        std::cerr << "[" << __func__ << "]: " << "could not write " << (outDir / results[i]) << std::endl;
+                        err = EXIT_FAILURE;
+                    }
+                }
+                else if ( fs::exists(workDir / results[i]) && (EXIT_SUCCESS != copy((workDir / results[i]).string(), (outDir / results[i]).string())) )
+                    err = EXIT_FAILURE;
+            }
+
+            boost::system::error_code ec;
+            fs::remove_all( workDir, ec );
+        }
+        io::ResidentFiles::instance().clear();
+        std::cout << "[" << __func__ << "]: " << "finished after " << iteration << " iterations with " << (err == EXIT_SUCCESS ? "success" : "error") << ", results in " << outDir << std::endl;
+
+        return err;
+    } //...runPipeline()
+} //...ns rapter
+
+int pipeline( int argc, char** argv )
+{
+    std::string paramsPath;
+    rapter::PipelineParams params;
+    if (    (rapter::console::parse_argument(argc, argv, "--pipeline", paramsPath) < 0)
+         || (EXIT_SUCCESS != params.read(paramsPath))
+         || (params.scale <= 0.) )
+    {
+        std::cout << "[Usage]: " << argv[0] << " --pipeline params.txt\n"
+                  << "\tparams.txt holds one \"key value\" per line:\n"
+                  << "\t  scale 0.01                    (required)\n"
+                  << "\t  [cloud cloud.ply] [angle-limit 15] [pw 1] [spatial pw/10] [data 1e5] [area-thresh-start 4]\n"
+                  << "\t  [angle-gens 0,90] [iterations 15] [pop-limit 5] [var-limit 1000] [segment-scale-mult 1]\n"
+                  << "\t  [angle-limit-divisor 1] [alg-code 0] [lines 0] [solver bonmin] [primitives segments.csv assoc points_segments.csv]\n"
+                  << "\t  [output .] [keep-files 0]\n"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return rapter::runPipeline( params );
+} //...pipeline()
@@ -4,7 +4,8 @@
 #include "rapter/optimization/problemSetup.h"
 #include "rapter/optimization/impl/problemSetup.hpp"
 
-int formulate( int argc, char** argv )
+//! \brief Formulates into \p problem in memory, if not NULL, see rapter::ProblemSetup::formulateCli().
+int formulate( int argc, char** argv, rapter::problemSetup::OptProblemT *problem )
 {
     if ( rapter::console::find_switch(argc,argv,"--formulate") )
     {
@@ -13,7 +14,7 @@ int formulate( int argc, char** argv )
                                               , rapter::_2d::PrimitiveT
                                               , rapter::PointPrimitiveT
                                               , rapter::_2d::MyFiniteLineToFiniteLineCompatFunctor
-                                              >( argc, argv );
+                                              >( argc, argv, problem );
     } //...if find_switch
     else
     {
@@ -23,3 +24,8 @@ int formulate( int argc, char** argv )
 
     return EXIT_SUCCESS;
 }
+
+int formulate( int argc, char** argv )
+{
+    return formulate( argc, argv, NULL );
+}
@@ -5,7 +5,8 @@
 #include "rapter/optimization/impl/problemSetup.hpp"
 #include "rapter/primitives/impl/planePrimitive.hpp"
 
-int formulate3D( int argc, char** argv )
+//! \brief Formulates into \p problem in memory, if not NULL, see rapter::ProblemSetup::formulateCli().
+int formulate3D( int argc, char** argv, rapter::problemSetup::OptProblemT *problem )
 {
     if ( rapter::console::find_switch(argc,argv,"--formulate3D") )
     {
@@ -14,7 +15,7 @@ int formulate3D( int argc, char** argv )
                                               , rapter::_3d::PrimitiveT
                                               , rapter::PointPrimitiveT
                                               , rapter::_3d::MyFinitePlaneToFinitePlaneCompatFunctor
-                                              >( argc, argv );
+                                              >( argc, argv, problem );
     }
     else
     {
@@ -23,3 +24,7 @@ int formulate3D( int argc, char** argv )
     }
 }
 
+int formulate3D( int argc, char** argv )
+{
+    return formulate3D( argc, argv, NULL );
+}
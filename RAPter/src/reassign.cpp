@@ -6,6 +6,7 @@
 #include "rapter/typedefs.h"
 #include "rapter/io/io.h"
 #include "rapter/simpleTypes.h"
+#include "rapter/processing/reassigner.hpp" // Reassigner
 
 int reassign( int argc, char** argv )
 {
@@ -74,28 +75,19 @@ int reassign( int argc, char** argv )
 
     // assign points
     std::cout << "starting assignment" << std::endl; fflush( stdout );
-    for ( size_t pid = 0; pid != points.size(); ++pid )
-    {
-        float min_dist = FLT_MAX, tmp; int min_gid = 0;
-        for ( size_t lid = 0; lid != planes.size(); ++lid )
+    typedef rapter::processing::Reassigner<float> ReassignerT;
+    ReassignerT                     reassigner( ReassignerT::domainOf(points), scale );
+    std::vector<PrimitiveT const*>  prims;
+    std::vector<rapter::GidT>       gids;
+    for ( size_t lid = 0; lid != planes.size(); ++lid )
+        for ( size_t lid1 = 0; lid1 != planes[lid].size(); ++lid1 )
         {
-            int gid = -2;
-            for ( size_t lid1 = 0; lid1 != planes[lid].size(); ++lid1 )
-            {
-                if ( !lid1 ) gid = planes[lid][lid1].getTag(PrimitiveT::TAGS::GID);
-
-                tmp = planes[lid][lid1].getDistance( points[pid].pos() );
-
-                if ( (tmp < min_dist) && (tmp < scale) )
-                {
-                    min_dist = tmp;
-                    min_gid = gid;
-                }
-            }
+            reassigner.insert( prims.size(), planes[lid][lid1] );
+            prims.push_back( &planes[lid][lid1] );
+            gids .push_back( planes[lid][0].getTag(PrimitiveT::TAGS::GID) );
         }
-        //pidGid[ pid ] = min_gid;
-        points[pid].setTag( PointPrimitiveT::TAGS::GID, min_gid );
-    }
+    reassigner.build();
+    err = reassigner.assign( points, prims, gids, /* unassigned: */ 0 );
     std::cout << "finishing assignment" << std::endl;
     rapter::io::writeAssociations<PointPrimitiveT>( points, "./points_primitives.schnabel.csv" );
 
@@ -129,200 +129,236 @@ namespace rapter
         return EXIT_SUCCESS;
     } //...refitSimple()
 
-    template < class _PrimitiveMapT
+    //! \brief Runs the solver on a built datafit problem. \return The solver's return code, problem.getOkCode() on success.
+    template <class _OptProblemT, typename _OptScalar>
+    typename _OptProblemT::ReturnType solveDatafit( _OptProblemT &problem, std::vector<_OptScalar> &x_out )
+    {
+        typename _OptProblemT::ReturnType r = problem.update();
+        if ( r == problem.getOkCode() )
+        {
+            r = problem.optimize( &x_out, _OptProblemT::OBJ_SENSE::MINIMIZE );
+            if ( r != problem.getOkCode() )
+                std::cerr << "[" << __func__ << "]: " << "ooo...optimize didn't work with code " << r << std::endl;
+        }
+        else
+            std::cerr << "[" << __func__ << "]: " << "update didn't work with code " << r << std::endl;
+        return r;
+    } //...solveDatafit()
+
+    /*! \brief                  Builds and solves the datafit problem of one connected component of the constraint graph, see refitNonLin().
+     *  \param[out] outPrims    Refit primitive per member, in the order of \p members. Left empty, if the solver returned no solution.
+     *  \param[in] prims        Every primitive, in iteration order.
+     *  \param[in] members      Ascending indices into \p prims of the primitives in this component.
+     *  \param[in] local        Index of each primitive within its component.
+     *  \param[in] constraints  Pair constraints between the members, indices into \p prims.
+     *  \param[in] samples      Sampled point ids per primitive.
+     *  \param[in] concurrentSolve Run the solver outside the critical section, only safe, if the Ipopt build's linear solver is reentrant.
+     */
+    template < int Dims
+             , class _PrimitiveT
              , class _PointContainerT
+             , class _ConstraintT
              >
-    int refitNonLin( _PrimitiveMapT             & outPrims
-                   , _PrimitiveMapT        const& primitives
-                   , _PointContainerT      const& points
-                   , rapter::GidPidVectorMap  const& populations
-                   , PidT                  const  targetPop
-                   , bool                  const  verbose      = false )
+    int refitComponent( std::vector<_PrimitiveT>              & outPrims
+                      , std::vector<_PrimitiveT const*>  const& prims
+                      , std::vector<LidT>                const& members
+                      , std::vector<LidT>                const& local
+                      , std::vector<_ConstraintT>        const& constraints
+                      , std::vector< std::vector<PidT> > const& samples
+                      , _PointContainerT                 const& points
+                      , std::string                      const& problemPath
+                      , bool                             const  verbose         = false
+                      , bool                             const  concurrentSolve = false )
     {
-
-        typedef typename _PrimitiveMapT::PrimitiveT                         PrimitiveT;
-//        typedef typename _PrimitiveMapT::InnerContainerT                    InnerContainerT;
-//        typedef typename std::vector<InnerContainerT>                       PrimitiveVectorT;
-        typedef typename PrimitiveT::Scalar                                 Scalar;
-//        typedef typename _PointContainerT::PrimitiveT                       PointPrimitiveT;
-//        typedef typename _PclCloudT::Ptr                                    PclCloudPtrT;
-        typedef typename PrimitiveT::Position                               Position;
-//        typedef          Eigen::Map< Position >                             PositionMap;
-
+        typedef typename _PrimitiveT::Scalar                                Scalar;
+        typedef typename _PrimitiveT::Position                              Position;
         typedef double                        OptScalar;
         typedef qcqpcpp::BonminOpt<OptScalar> OptProblemT;
         OptProblemT problem;
 
-        const int Dims = 2; // 2: nx,ny, 3: +nz
-        typedef          std::pair<LidT,LidT>                        LIdPair;
-        typedef          std::map<LIdPair, std::vector<LidT> >       PrimsVarsT;
-
-        std::vector<std::pair<std::string,Scalar> >     starting_values;    // [var_id] = < var_name, x0 >
-        PrimsVarsT                                      prims_vars;         // < <lid,lid1>, var_id >, associates primitives to variables
-
+        std::vector<Scalar>                             starting_values;    // [var_id] = x0
         char                                            name[255];          // variable name
         const Position                                  origin( Position::Zero() ); // to calculate d
+        // variables of member m are [ m * (Dims+1), (m+1) * (Dims+1) ): nx, ny, (nz), d
+        auto var = [&local]( LidT const primId, int const dim ) { return local[primId] * (Dims+1) + dim; };
 
         // add variables
+        for ( size_t m = 0; m != members.size(); ++m )
         {
-            for ( typename _PrimitiveMapT::ConstIterator it(primitives); it.hasNext(); it.step() )
-            {
-                const LidT          lId0    = it.getLid0();
-                const LidT          lId1    = it.getLid1();
-                const GidT          gId     = it.getGid();
-                const DidT          dId     = it.getDid();
-                const PrimitiveT&   prim    = *it;
-                const LIdPair       varKey  = LIdPair( lId0, lId1 );
-
-
-                Position normal = prim.template normal();
-                std::cout << "line_" << gId << "_" << dId << ".n = " << normal.transpose() << std::endl;
-
-                sprintf( name, "nx_%ld_%ld", gId, dId );
-                prims_vars[ varKey ].push_back( problem.addVariable(OptProblemT::BOUND::RANGE, -problem.getINF(), problem.getINF(), OptProblemT::VAR_TYPE::CONTINUOUS, OptProblemT::LINEAR, name) );
-                starting_values.push_back( std::pair<std::string,Scalar>(name,normal(0)) );
-
-                sprintf( name, "ny_%ld_%ld", gId, dId );
-                prims_vars[ varKey ].push_back( problem.addVariable(OptProblemT::BOUND::RANGE, -problem.getINF(), problem.getINF(), OptProblemT::VAR_TYPE::CONTINUOUS, OptProblemT::LINEAR, name) );
-                starting_values.push_back( std::pair<std::string,Scalar>(name,normal(1)) );
+            const _PrimitiveT&  prim    = *prims[ members[m] ];
+            const GidT          gId     = prim.getTag( _PrimitiveT::TAGS::GID     );
+            const DidT          dId     = prim.getTag( _PrimitiveT::TAGS::DIR_GID );
 
-                if ( Dims > 2 )
-                {
-                    sprintf( name, "nz_%ld_%ld", gId, dId );
-                    prims_vars[ varKey ].push_back( problem.addVariable(OptProblemT::BOUND::RANGE, -problem.getINF(), problem.getINF(), OptProblemT::VAR_TYPE::CONTINUOUS, OptProblemT::LINEAR, name) );
-                    starting_values.push_back( std::pair<std::string,Scalar>(name,normal(2)) );
-                }
+            Position normal = prim.template normal();
+            const char* dimNames[3] = { "nx", "ny", "nz" };
+            for ( int dim = 0; dim != Dims; ++dim )
+            {
+                sprintf( name, "%s_%ld_%ld", dimNames[dim], gId, dId );
+                problem.addVariable( OptProblemT::BOUND::RANGE, -problem.getINF(), problem.getINF(), OptProblemT::VAR_TYPE::CONTINUOUS, OptProblemT::LINEAR, name );
+                starting_values.push_back( normal(dim) );
+            }
 
-                sprintf( name, "d_%ld_%ld", gId, dId );
-                Scalar d = Scalar(-1.) * prim.getDistance( origin );
-                std::cout << "line_" << gId << "_" << dId << ".d = " << d << std::endl;
-                prims_vars[ varKey ].push_back( problem.addVariable(OptProblemT::BOUND::RANGE, -problem.getINF(), problem.getINF(), OptProblemT::VAR_TYPE::CONTINUOUS, OptProblemT::LINEAR, name) );
-                starting_values.push_back( std::pair<std::string,Scalar>(name,d) );
-            } //...for primitives
+            sprintf( name, "d_%ld_%ld", gId, dId );
+            problem.addVariable( OptProblemT::BOUND::RANGE, -problem.getINF(), problem.getINF(), OptProblemT::VAR_TYPE::CONTINUOUS, OptProblemT::LINEAR, name );
+            starting_values.push_back( Scalar(-1.) * prim.getDistance(origin) );
         } //...add variables
 
-        // add constraints: |normal|^2 = 1
+        // add constraints: |normal|^2 = 1, as triplets: 1 * nx * nx + 1 * ny * ny + 1 *  nz * nz
+        for ( size_t m = 0; m != members.size(); ++m )
         {
-            for ( typename _PrimitiveMapT::ConstIterator it(primitives); it.hasNext(); it.step() )
-            {
-                const LidT          lId0    = it.getLid0();
-                const LidT          lId1    = it.getLid1();
-        //                const GidT          gId     = it.getGid();
-        //                const DidT          dId     = it.getDid();
-        //                const PrimitiveT&   prim    = *it;
-                const LIdPair       varKey  = LIdPair( lId0, lId1 );
-
-                // sparse quadratic matrix
-                OptProblemT::SparseMatrix norm_constraint( problem.getVarCount(), problem.getVarCount() );
-
-                // 1 * nx * nx + 1 * ny * ny + 1 *  nz * nz
-                for ( int dim = 0; dim != Dims; ++dim )
-                    norm_constraint.insert( prims_vars[varKey][dim]
-                                          , prims_vars[varKey][dim] ) = Scalar( 1. );
-
-                // add constraint instance
-                problem.addConstraint  ( OptProblemT::BOUND::EQUAL, /* >= 1 */ Scalar(1.), /* <= 1 */ Scalar(1.), /* linear constraint coeffs: */ NULL );
-                // add quadratic coefficients
-                problem.addQConstraints( norm_constraint );
-            } //...for primitives
+            problem.addConstraint( OptProblemT::BOUND::EQUAL, /* >= 1 */ Scalar(1.), /* <= 1 */ Scalar(1.), /* linear constraint coeffs: */ NULL );
+            const LidT constrId = problem.getConstraintCount() - 1;
+            for ( int dim = 0; dim != Dims; ++dim )
+                problem.addQConstraint( constrId, var(members[m],dim), var(members[m],dim), Scalar(1.) );
         } //...constraints
 
         /// cost -> objective: minimize \sum_n \sum_p ((n_j . p_i) + d)^2  where point p_i is assigned to line with normal n_j
-        //if ( Dims == 3 ) throw new std::runtime_error("datafit unimplemented for 3D");
         // n0^2 p0^2 + n1^2 p1^2 + n2^2 p2^2 +
         // 2 n0 p0 d + 2 n1 p1 d + 2 n2 p2 d +
         // 2 n0 n1 p0 p1 + d^2 +
         // 2 n0 n2 p0 p2 + 2 n1 n2 p1 p2
+        for ( size_t m = 0; m != members.size(); ++m )
         {
-            // for each line
+            const LidT primId = members[m];
             Scalar coeff = Scalar( 0. );
-            for ( typename _PrimitiveMapT::ConstIterator it(primitives); it.hasNext(); it.step() )
+            for ( size_t pIdId = 0; pIdId != samples[primId].size(); ++pIdId )
             {
-                const LidT          lId0    = it.getLid0();
-                const LidT          lId1    = it.getLid1();
-                const GidT          gId     = it.getGid();
-        //                const DidT          dId     = it.getDid();
-        //                const PrimitiveT&   prim    = *it;
-                const LIdPair       varKey  = LIdPair( lId0, lId1 );
-
-                // for each assigned point
-                Scalar rat = std::min( Scalar(1.), targetPop / Scalar(populations.at(gId).size()) );
-                for ( size_t pIdId = 0; pIdId != populations.at(gId).size(); ++pIdId )
+                const PidT pid = samples[primId][pIdId];
+                if ( verbose ) std::cout << "[" << __func__ << "]: " << "adding pid " << pid << " -> " << "prims[" << primId << "]" << std::endl;
+
+                for ( int dim = 0; dim != Dims; ++dim )
                 {
-                    if ( randf<Scalar>() > rat ) continue;
-                    const PidT pid = populations.at(gId)[pIdId];
-
-                    // debug
-                    if ( verbose ) std::cout << "[" << __func__ << "]: " << "adding pid " << pid << " -> " << "lines[" << lId0 << "][" << lId1 << "]" << std::endl;
-
-                    // for each dimension: x,y,z
-                    for ( int dim = 0; dim != Dims; ++dim )
-                    {
-                        // (p_x)^2 . (n_x)^2
-                        coeff = points[pid].pos()( dim );                                                   // (p_x)
-                        coeff *= coeff;                                                                     // (p_x)^2
-                        problem.addQObjective( prims_vars[varKey][dim], prims_vars[varKey][dim], coeff );   // (p_x)^2 . (n_x)^2
-
-                        // debug
-                        if ( verbose ) std::cout << "added qterm(pid: " << pid << "): "
-                                                    << coeff << " * "
-                                                    << problem.getVarName( prims_vars[varKey][dim] ) << " * "
-                                                    << problem.getVarName( prims_vars[varKey][dim] )
-                                                    << std::endl;
-
-                        // 2 . p_x . n_x . d
-                        coeff = Scalar(2.) * points[pid].pos()( dim );              // 2 . p_x
-                        problem.addQObjective( /* n_x: */ prims_vars[varKey][dim]
-                                             , /*   d: */ prims_vars[varKey][Dims]
-                                             ,            coeff );                  // 2 . p_x . n_x . d
-
-                        // debbug
-                        if ( verbose ) std::cout << "added qterm(pid: " << pid << "): "
-                                                 << coeff << " * "
-                                                 << problem.getVarName( prims_vars[varKey][dim] ) << " * "
-                                                 << problem.getVarName( prims_vars[varKey][Dims] )
-                                                 << std::endl;
-                    }
-
-                    // d^2
-                    coeff = Scalar(1);
-                    problem.addQObjective( /* d: */ prims_vars[varKey][Dims], /* d: */ prims_vars[varKey][Dims], coeff );
-
-                    // debug
-                    if ( verbose ) std::cout << "added qterm(pid: " << pid << "): "
-                                             << coeff << " * "
-                                             << problem.getVarName( prims_vars[varKey][Dims] ) << " * "
-                                             << problem.getVarName( prims_vars[varKey][Dims] )
-                                             << std::endl;
-
-                    // 2 . px . py . nx . ny
-                    coeff = Scalar(2.) * points[pid].pos()(0) * points[pid].pos()(1);
-                    problem.addQObjective( prims_vars[varKey][0], prims_vars[varKey][1], coeff );
-
-                    // debug
-                    if ( verbose ) std::cout << "added qterm(pid: " << pid << "): "
-                                                << coeff << " * "
-                                                << problem.getVarName( prims_vars[varKey][0] ) << " * "
-                                                << problem.getVarName( prims_vars[varKey][1] )
-                                                << std::endl;
-
-                    // 2 n0 n2 p0 p2 + 2 n1 n2 p1 p2
-                    if ( Dims > 2 )
-                    {
-                        // 2 n0 n2 p0 p2
-                        coeff = Scalar(2.) * points[pid].pos()(0) * points[pid].pos()(2);
-                        problem.addQObjective( prims_vars[varKey][0], prims_vars[varKey][2], coeff );
-                        // 2 n1 n2 p1 p2
-                        coeff = Scalar(2.) * points[pid].pos()(1) * points[pid].pos()(2);
-                        problem.addQObjective( prims_vars[varKey][1], prims_vars[varKey][2], coeff );
-                    }
-                } // for points
-            } //...for primitives
+                    // (p_x)^2 . (n_x)^2
+                    coeff = points[pid].pos()( dim );
+                    coeff *= coeff;
+                    problem.addQObjective( var(primId,dim), var(primId,dim), coeff );
+                    // 2 . p_x . n_x . d
+                    coeff = Scalar(2.) * points[pid].pos()( dim );
+                    problem.addQObjective( var(primId,dim), var(primId,Dims), coeff );
+                }
+
+                // d^2
+                problem.addQObjective( var(primId,Dims), var(primId,Dims), Scalar(1.) );
+
+                // 2 . px . py . nx . ny
+                coeff = Scalar(2.) * points[pid].pos()(0) * points[pid].pos()(1);
+                problem.addQObjective( var(primId,0), var(primId,1), coeff );
+
+                // 2 n0 n2 p0 p2 + 2 n1 n2 p1 p2
+                if ( Dims > 2 )
+                {
+                    coeff = Scalar(2.) * points[pid].pos()(0) * points[pid].pos()(2);
+                    problem.addQObjective( var(primId,0), var(primId,2), coeff );
+                    coeff = Scalar(2.) * points[pid].pos()(1) * points[pid].pos()(2);
+                    problem.addQObjective( var(primId,1), var(primId,2), coeff );
+                }
+            } //...for points
         } //...add objective
 
+        // pair constraints, as triplets: 1 * nx0 * nx1 + 1 * ny0 * ny1 = 1/0
+        for ( size_t i = 0; i != constraints.size(); ++i )
+        {
+            problem.addConstraint( OptProblemT::BOUND::EQUAL, constraints[i].rhs, constraints[i].rhs, /* linear constraint coeffs: */ NULL );
+            const LidT constrId = problem.getConstraintCount() - 1;
+            for ( int dim = 0; dim != Dims; ++dim )
+                problem.addQConstraint( constrId, var(constraints[i].prim1,dim), var(constraints[i].prim0,dim), Scalar(1.) ); // reverse order for lower triangular
+        }
+
+        // starting point
+        {
+            OptProblemT::SparseMatrix x0( problem.getVarCount(), 1 );
+            for ( LidT i = 0; i != LidT(starting_values.size()); ++i )
+                x0.insert( i, 0 ) = starting_values[i];
+            problem.setStartingPoint( x0 );
+        } //...starting values
+
+        // save
+        if ( !problemPath.empty() )
+            problem.write( problemPath );
+
+        // solve, one component at a time, unless the linear solver is known to be reentrant (MUMPS is not)
+        OptProblemT::ReturnType r;
+        std::vector<OptScalar> x_out;
+        if ( concurrentSolve )
+            r = solveDatafit( problem, x_out );
+        else
+        {
+            #pragma omp critical (REFIT_NONLIN_SOLVE)
+            r = solveDatafit( problem, x_out );
+        }
+
+        // output result
+        outPrims.clear();
+        for ( size_t m = 0; m != members.size() && var(members[m],Dims) < LidT(x_out.size()); ++m )
+        {
+            _PrimitiveT outPrim;
+            Position normal( Position::Zero() );
+            for ( int d = 0; d != Dims; ++d )
+                normal(d) = x_out[ var(members[m],d) ];
+            _PrimitiveT::generateFrom( outPrim, (normal).eval(), Scalar(x_out[var(members[m],Dims)]) );
+            outPrim.copyTagsFrom( *prims[members[m]] );
+            outPrims.push_back( outPrim );
+        }
+
+        return r == problem.getOkCode() ? EXIT_SUCCESS : int(r);
+    } //...refitComponent()
+
+    /*! \brief Refits primitives to their points, keeping near parallel and perpendicular pairs of the same direction group exact.
+     *
+     *         Pairs are searched only within the same DIR_GID, and pruned to a spanning tree. The primitives connected by the kept pairs
+     *         don't share variables with the rest, so every connected component is solved as its own small problem.
+     *         Components are formulated in parallel, and solved one at a time, unless \p concurrentSolve is set.
+     *         Each component gets its own solver instance, so \p concurrentSolve is only safe, if the linear solver of the Ipopt build is reentrant.
+     */
+    template < class _PrimitiveMapT
+             , class _PointContainerT
+             >
+    int refitNonLin( _PrimitiveMapT             & outPrims
+                   , _PrimitiveMapT        const& primitives
+                   , _PointContainerT      const& points
+                   , rapter::GidPidVectorMap  const& populations
+                   , PidT                  const  targetPop
+                   , bool                  const  verbose         = false
+                   , bool                  const  concurrentSolve = false )
+    {
+
+        typedef typename _PrimitiveMapT::PrimitiveT                         PrimitiveT;
+        typedef typename PrimitiveT::Scalar                                 Scalar;
+
+        const int Dims = 2; // 2: nx,ny, 3: +nz
+
+        // flatten, and bucket by direction group
+        std::vector<PrimitiveT const*>              prims;
+        std::vector<GidT>                           gids;
+        std::vector<DidT>                           dids;
+        std::vector<LidT>                           lid1s;
+        std::map< DidT, std::vector<LidT> >         dirBuckets; // < did, ascending primitive indices >
+        for ( typename _PrimitiveMapT::ConstIterator it(primitives); it.hasNext(); it.step() )
+        {
+            dirBuckets[ it.getDid() ].push_back( prims.size() );
+            prims.push_back( &(*it)        );
+            gids .push_back( it.getGid()  );
+            dids .push_back( it.getDid()  );
+            lid1s.push_back( it.getLid1() );
+            std::cout << "line_" << it.getGid() << "_" << it.getDid() << ".n = " << it->template normal().transpose() << std::endl;
+        }
+
+        // sample points up front in iteration order, randf() is not thread safe
+        std::vector< std::vector<PidT> > samples( prims.size() );
+        for ( size_t id = 0; id != prims.size(); ++id )
+        {
+            std::vector<PidT> const& population = populations.at( gids[id] );
+            Scalar rat = std::min( Scalar(1.), targetPop / Scalar(population.size()) );
+            for ( size_t pIdId = 0; pIdId != population.size(); ++pIdId )
+            {
+                if ( randf<Scalar>() > rat ) continue;
+                samples[id].push_back( population[pIdId] );
+            }
+        }
+
         // add perpendicular constraints
-        struct Triplet { LIdPair prim0, prim1; Scalar rhs;
-                         Triplet( LIdPair const& prim0, LIdPair const& prim1, Scalar rhs )
+        struct Triplet { LidT prim0, prim1; Scalar rhs;
+                         Triplet( LidT prim0, LidT prim1, Scalar rhs )
                             : prim0(prim0), prim1(prim1), rhs(rhs) {}
                        };
 
@@ -332,165 +368,114 @@ namespace rapter
 
         EdgeListT edgeList;
 
-
         const Scalar angTolRad = 0.01 / 180. * M_PI;
         std::vector< Triplet > constraints;
-        int perpCount = 0, paralCount = 0;
-        for ( typename _PrimitiveMapT::ConstIterator it0(primitives); it0.hasNext(); it0.step() )
-            for ( typename _PrimitiveMapT::ConstIterator it1(primitives); it1.hasNext(); it1.step() )
+        for ( LidT id0 = 0; id0 != LidT(prims.size()); ++id0 )
+        {
+            // only the same direction group can be constrained
+            std::vector<LidT> const& bucket = dirBuckets[ dids[id0] ];
+            for ( size_t k = 0; k != bucket.size(); ++k )
             {
-                // skip not same groupID ones
-                if ( it0.getDid() != it1.getDid() ) continue;
-                if ( it0.getGid() > it1.getGid() ) continue; // increasing order
-                if ( it0.getGid() == it1.getGid() &&
-                     it0.getLid1() == it1.getLid1() ) continue;
+                const LidT id1 = bucket[k];
+                if ( gids[id0] > gids[id1] ) continue; // increasing order
+                if ( gids[id0] == gids[id1] &&
+                     lid1s[id0] == lid1s[id1] ) continue;
 
-                Scalar angle = std::abs( rapter::angleInRad(it0->template dir(), it1->template dir()) );
+                Scalar angle = std::abs( rapter::angleInRad(prims[id0]->template dir(), prims[id1]->template dir()) );
                 while ( angle > M_PI ) angle -= M_PI;
-                if ( !perpCount && std::abs( M_PI_2 - angle ) < angTolRad ) // 90degs
+                if ( std::abs( M_PI_2 - angle ) < angTolRad ) // 90degs
                 {
-                    constraints.push_back( Triplet( LIdPair(it0.getLid0(),it0.getLid1()),
-                                                    LIdPair(it1.getLid0(),it1.getLid1()),
-                                                    0.) );
-                    //++perpCount;
-                    edgeList.insert( EdgeT(it0.getGid(), it1.getGid(), 20.)  );
-                    std::cout << "perpconstr: <"
-                              << constraints.back().prim0.first << ","
-                              << constraints.back().prim0.second << ","
-                              << prims_vars.at( constraints.back().prim0 ).at(0) << ","
-                              << prims_vars.at( constraints.back().prim0 ).at(1)
-                              << "> . "
-                              << constraints.back().prim1.first << ","
-                              << constraints.back().prim1.second << ","
-                              << prims_vars.at( constraints.back().prim1 ).at(0) << ","
-                              << prims_vars.at( constraints.back().prim1 ).at(1)
-                              << "> ==  "
-                              << constraints.back().rhs
-                              << " (angle: " << angle * 180.0 / M_PI << ")"
-                              << std::endl;
+                    constraints.push_back( Triplet(id0, id1, 0.) );
+                    edgeList.insert( EdgeT(gids[id0], gids[id1], 20.) );
                 }
-                else if ( paralCount < 1 &&
-                          ( (angle < angTolRad) || (std::abs(M_PI-angle) < angTolRad) )
-                        ) // parallel
+                else if ( (angle < angTolRad) || (std::abs(M_PI-angle) < angTolRad) ) // parallel
                 {
-                    constraints.push_back( Triplet( LIdPair(it0.getLid0(),it0.getLid1()),
-                                                    LIdPair(it1.getLid0(),it1.getLid1()),
-                                                    1.) );
-                    //++paralCount;
-                    edgeList.insert( EdgeT(it0.getGid(), it1.getGid(), 1.)  );
-                    std::cout << "paralconstr: <"
-                              << constraints.back().prim0.first << ","
-                              << constraints.back().prim0.second << ","
-                              << prims_vars.at( constraints.back().prim0 ).at(0) << ","
-                              << prims_vars.at( constraints.back().prim0 ).at(1)
-                              << "> . "
-                              << constraints.back().prim1.first << ","
-                              << constraints.back().prim1.second << ","
-                              << prims_vars.at( constraints.back().prim1 ).at(0) << ","
-                              << prims_vars.at( constraints.back().prim1 ).at(1)
-                              << "> ==  "
-                              << constraints.back().rhs
-                              << " (angle: " << angle * 180.0 / M_PI << ")"
-                              << std::endl;
+                    constraints.push_back( Triplet(id0, id1, 1.) );
+                    edgeList.insert( EdgeT(gids[id0], gids[id1], 1.) );
                 }
-            }
+                else
+                    continue;
+
+                std::cout << (constraints.back().rhs == Scalar(0.) ? "perpconstr: <" : "paralconstr: <")
+                          << gids[id0] << "," << lid1s[id0] << "> . <"
+                          << gids[id1] << "," << lid1s[id1] << "> ==  "
+                          << constraints.back().rhs
+                          << " (angle: " << angle * 180.0 / M_PI << ")"
+                          << std::endl;
+            } //...for bucket
+        } //...for prims
 
         GraphT g(edgeList);
         typedef std::pair<GidT,GidT> GidPair;
         std::set< GidPair > mstEdges;
         g.spanningTree( mstEdges );
 
-        for ( size_t i = 0; i != constraints.size(); ++i ) // perps.size()
+        // connected components of the kept constraints
+        std::vector<LidT> parent( prims.size() );
+        for ( size_t id = 0; id != parent.size(); ++id )
+            parent[id] = id;
+        auto root = [&parent]( LidT id ) { while ( parent[id] != id ) id = parent[id] = parent[parent[id]]; return id; };
+
+        std::vector< Triplet > kept;
+        for ( size_t i = 0; i != constraints.size(); ++i )
         {
-            OptProblemT::SparseMatrix perp_constraint( problem.getVarCount(), problem.getVarCount() );
-            const std::vector<LidT>& prim0VarIds = prims_vars.at( constraints[i].prim0 );
-            const std::vector<LidT>& prim1VarIds = prims_vars.at( constraints[i].prim1 );
-            auto getGid = [&primitives]( LidT const lid0, LidT const lid1 ) {
-                auto it = primitives.begin();
-                std::advance( it, lid0 );
-                return it->second.at( lid1 );
-            };
-            const GidT gid0 = getGid( constraints[i].prim0.first, constraints[i].prim0.second ).getTag( PrimitiveT::TAGS::GID );
-            const GidT gid1 = getGid( constraints[i].prim1.first, constraints[i].prim1.second ).getTag( PrimitiveT::TAGS::GID );
+            const GidT gid0 = gids[ constraints[i].prim0 ];
+            const GidT gid1 = gids[ constraints[i].prim1 ];
             if ( mstEdges.find( GidPair(std::min(gid0,gid1), std::max(gid0,gid1) ) ) == mstEdges.end() )
                 continue;
             std::cout << "constraint: " << gid0 << " - " << gid1 << " = " << constraints[i].rhs << std::endl;
 
-            // 1 * nx0 * nx1 + 1 * ny0 * ny1 = 1/0
-            for ( int dim = 0; dim != Dims; ++dim )
-                perp_constraint.insert( prim1VarIds.at(dim), prim0VarIds.at(dim) ) = Scalar( 1. ); // reverse order for lower triangular
-
-            // add constraint instance
-            problem.addConstraint  ( OptProblemT::BOUND::EQUAL, constraints[i].rhs, constraints[i].rhs, /* linear constraint coeffs: */ NULL );
-            // add quadratic coefficients
-            problem.addQConstraints( perp_constraint );
+            kept.push_back( constraints[i] );
+            const LidT root0 = root( constraints[i].prim0 ), root1 = root( constraints[i].prim1 );
+            if ( root0 != root1 )
+                parent[ std::max(root0,root1) ] = std::min( root0, root1 );
         }
 
-        // starting point
+        std::vector<LidT>                       component( prims.size() ), local( prims.size() );
+        std::vector< std::vector<LidT> >        members;
+        std::vector< std::vector<Triplet> >     componentConstraints;
         {
-            if ( starting_values.size() != problem.getVarCount() )
-            {
-                std::cerr << "[" << __func__ << "]: " << "starting_values.size() " << starting_values.size() << " != " << problem.getVarCount() << " problem.getVarCount()" << std::endl;
-                return EXIT_FAILURE;
-            }
-
-            OptProblemT::SparseMatrix x0( problem.getVarCount(), 1 );
-            for ( LidT i = 0; i != starting_values.size(); ++i )
+            std::vector<LidT> componentOfRoot( prims.size(), -1 );
+            for ( LidT id = 0; id != LidT(prims.size()); ++id )
             {
-                x0.insert( i, 0 ) = starting_values[i].second;
+                const LidT r = root( id );
+                if ( componentOfRoot[r] < 0 )
+                {
+                    componentOfRoot[r] = members.size();
+                    members.push_back( std::vector<LidT>() );
+                }
+                component[id] = componentOfRoot[r];
+                local    [id] = members[ component[id] ].size();
+                members[ component[id] ].push_back( id );
             }
-            problem.setStartingPoint( x0 );
-        } //...starting values
-
-        // save
-        {
-            problem.write( "./datafit_problem" );
+            componentConstraints.resize( members.size() );
+            for ( size_t i = 0; i != kept.size(); ++i )
+                componentConstraints[ component[kept[i].prim0] ].push_back( kept[i] );
         }
+        std::cout << "[" << __func__ << "]: " << "solving " << members.size() << " components of " << prims.size() << " primitives" << std::endl;
 
-        int err = EXIT_SUCCESS;
         // solve
+        int err = EXIT_SUCCESS;
+        std::vector< std::vector<PrimitiveT> > refit( members.size() );
+        #pragma omp parallel for num_threads(RAPTER_MAX_OMP_THREADS) schedule(dynamic)
+        for ( LidT c = 0; c < LidT(members.size()); ++c )
         {
-            OptProblemT::ReturnType r = problem.getOkCode();
-
-            if ( problem.getOkCode() == r )
+            // save the whole problem, when there is only one
+            const std::string problemPath = members.size() == 1 ? "./datafit_problem" : "";
+            const int r = refitComponent<Dims>( refit[c], prims, members[c], local, componentConstraints[c], samples, points, problemPath, verbose, concurrentSolve );
+            if ( r != EXIT_SUCCESS )
             {
-                if ( verbose ) { std::cout << "[" << __func__ << "]: " << "calling problem optimize...\n"; fflush(stdout); }
-                r = problem.update();
-                if ( verbose ) { std::cout << "[" << __func__ << "]: " << "finished problem optimize...\n"; fflush(stdout); }
+                #pragma omp critical (REFIT_NONLIN_ERR)
+                err = r;
             }
+        }
 
-            // optimize
-            std::vector<OptScalar> x_out;
-            if ( r == problem.getOkCode() )
-            {
-                // log
-                if ( verbose ) { std::cout << "[" << __func__ << "]: " << "calling problem optimize...\n"; fflush(stdout); }
-
-                // work
-                r = problem.optimize( &x_out, OptProblemT::OBJ_SENSE::MINIMIZE );
-
-                // check result
-                if ( r != problem.getOkCode() )
-                {
-                    std::cerr << "[" << __func__ << "]: " << "ooo...optimize didn't work with code " << r << std::endl; fflush(stderr);
-                    err = r;
-                }
-
-                // output result
-                //for ( LidT i = 0; i < x_out.size(); i += 4 )
-                LidT i = 0;
-                for ( typename _PrimitiveMapT::ConstIterator it(primitives); it.hasNext() && i < x_out.size(); it.step(), i += (Dims+1) )
-                {
-                    PrimitiveT outPrim;
-                    Position normal( Position::Zero() );
-                    for ( int d = 0; d != Dims; ++d )
-                        normal(d) = x_out[ i+d ];
-                    PrimitiveT::generateFrom( outPrim, (normal).eval(), Scalar(x_out[i+Dims]) );
-                    outPrim.copyTagsFrom( *it );
-                    rapter::containers::add( outPrims, it.getGid(), outPrim );
-                }
-            } //...optimize
-        } //...solve
+        // output result in iteration order, keep the input of unsolved components
+        for ( size_t id = 0; id != prims.size(); ++id )
+        {
+            std::vector<PrimitiveT> const& solved = refit[ component[id] ];
+            rapter::containers::add( outPrims, gids[id], local[id] < LidT(solved.size()) ? solved[ local[id] ] : *prims[id] );
+        }
 
         return err;
     } //...refitNonLin()
@@ -532,7 +517,7 @@ namespace rapter
         PclCloudPtrT            pclCloud;
         PrimitiveVectorT        primitivesVector;
         _PrimitiveMapT          primitives;
-        bool                    valid_input = true, simple = false;
+        bool                    valid_input = true, simple = false, concurrentSolve = false;
         struct Params { Scalar scale; } params;
 
         // parse
@@ -552,6 +537,9 @@ namespace rapter
             simple = rapter::console::find_switch( argc, argv, "--simple" );
             std::cout << "[" << __func__ << "]: " << "performint simple fitting: " << ( simple ? "YES" : "NO" ) << std::endl;
 
+            concurrentSolve = rapter::console::find_switch( argc, argv, "--concurrent-solve" );
+            std::cout << "[" << __func__ << "]: " << "solving components concurrently: " << ( concurrentSolve ? "YES" : "NO, the Ipopt linear solver needs to be reentrant for --concurrent-solve" ) << std::endl;
+
             primsPath = rapter::parsePrimitivesPath( argc, argv );
             assocPath = rapter::parseAssocPath     ( argc, argv );
         }
@@ -563,7 +551,7 @@ namespace rapter
         // WORK
         _PrimitiveMapT outPrims;
         if ( !simple )
-            refitNonLin( outPrims, primitives, points, populations, targetPop, verbose );
+            refitNonLin( outPrims, primitives, points, populations, targetPop, verbose, concurrentSolve );
         else
             refitSimple( outPrims, primitives, points, populations, targetPop, verbose );
 
@@ -603,6 +591,9 @@ namespace rapter
 
 int main( int argc, char** argv )
 {
+    // components are formulated in parallel: --threads N, or $RAPTER_THREADS. Solved in parallel only with --concurrent-solve
+    rapter::threads::parseCli( argc, argv );
+
 //    typedef float                                                           Scalar;
 //    typedef GF2::graph::EdgeT<Scalar>                                       EdgeT;
 //    typedef GF2::graph::EdgeListT<Scalar>                                   EdgeListT;
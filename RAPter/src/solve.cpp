@@ -3,14 +3,15 @@
 
 #include "rapter/optimization/solver.h"
 
-int solve( int argc, char** argv )
+//! \brief Solves \p problem from memory, if not NULL, see rapter::Solver::solve().
+int solve( int argc, char** argv, rapter::problemSetup::OptProblemT       *problem )
 {
     if ( rapter::console::find_switch(argc,argv,"--solver") )
     {
         return rapter::Solver::solve< rapter::_2d::PrimitiveContainerT
                                  , rapter::_2d::InnerPrimitiveContainerT
                                  , rapter::_2d::PrimitiveT
-                                 >( argc, argv );
+                                 >( argc, argv, problem );
     } //...if find_switch
     else
     {
@@ -18,3 +19,8 @@ int solve( int argc, char** argv )
         return EXIT_FAILURE;
     }
 }
+
+int solve( int argc, char** argv )
+{
+    return solve( argc, argv, NULL );
+}
@@ -5,14 +5,15 @@
 #include "rapter/primitives/impl/planePrimitive.hpp"
 
 
-int solve3D( int argc, char** argv )
+//! \brief Solves \p problem from memory, if not NULL, see rapter::Solver::solve().
+int solve3D( int argc, char** argv, rapter::problemSetup::OptProblemT       *problem )
 {
     if ( rapter::console::find_switch(argc,argv,"--solver3D") )
     {
         return rapter::Solver::solve< rapter::_3d::PrimitiveContainerT
                                  , rapter::_3d::InnerPrimitiveContainerT
                                  , rapter::_3d::PrimitiveT
-                                 >( argc, argv );
+                                 >( argc, argv, problem );
     }
     else
         std::cerr << "[" << __func__ << "]: " << "wrong switch" << std::endl;
@@ -20,3 +21,7 @@ int solve3D( int argc, char** argv )
     return EXIT_FAILURE;
 }
 
+int solve3D( int argc, char** argv )
+{
+    return solve3D( argc, argv, NULL );
+}
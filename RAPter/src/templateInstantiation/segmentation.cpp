@@ -32,7 +32,8 @@ namespace rapter
                               ( rapter::PointContainerT       &points
                               , rapter::Scalar          const  scale
                               , int                  const  nn_K
-                              , int                  const  verbose );
+                              , int                  const  verbose
+                              , rapter::PointStore<rapter::PointPrimitiveT> *pointStore );
 
     template int
     Segmentation::orientPoints< rapter::PointPrimitiveT
@@ -43,7 +44,8 @@ namespace rapter
                               ( rapter::PointContainerT       &points
                               , rapter::Scalar          const  scale
                               , int                  const  nn_K
-                              , int                  const  verbose );
+                              , int                  const  verbose
+                              , rapter::PointStore<rapter::PointPrimitiveT> *pointStore );
 
 
     template int
@@ -61,6 +63,7 @@ namespace rapter
             , int                                      const  nn_K
             , int                                      const  verbose
             , size_t                                   const  patchPopLimit
+            , rapter::PointStore<rapter::PointPrimitiveT> const* pointStore
             );
 
     template int
@@ -78,6 +81,7 @@ namespace rapter
                           , int                                      const  nn_K
                           , int                                      const  verbose
                           , size_t                                   const  patchPopLimit
+                          , rapter::PointStore<rapter::PointPrimitiveT> const* pointStore
                           );
 
     namespace segm_templinst
@@ -108,6 +112,7 @@ namespace rapter
                               , GidT                        const  gid_tag_name              //= _PointT::GID
                               , int                         const  nn_K
                               , bool                        const  verbose
+                              , rapter::PointStore<rapter::PointPrimitiveT> const* pointStore
                               );
     template int
     Segmentation::regionGrow  < rapter::_3d::PrimitiveT
@@ -124,6 +129,7 @@ namespace rapter
                               , GidT                        const  gid_tag_name              //= _PointT::GID
                               , int                         const  nn_K
                               , bool                        const  verbose
+                              , rapter::PointStore<rapter::PointPrimitiveT> const* pointStore
                               );
 
     template int
@@ -135,6 +141,7 @@ namespace rapter
                             , bool                 const  soft_radius
                             , std::vector<PidT>         * mapping
                             , int                  const  verbose
+                            , processing::SpatialHash<float> const* index
                             );
 
     template int
@@ -146,6 +153,7 @@ namespace rapter
                             , bool                 const  soft_radius
                             , std::vector<PidT>         * mapping
                             , int                  const  verbose
+                            , processing::SpatialHash<float> const* index
                             );
 
     template int